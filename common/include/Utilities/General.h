@@ -248,6 +248,13 @@ extern void MemProtect(void *baseaddr, size_t size, const PageProtectionMode &mo
 
 extern void Munmap(void *base, size_t size);
 
+// Shared memory objects, for mapping the same memory at several addresses.  Views are
+// mapped over existing reservations (reset them with MmapResetPtr).  Not available on
+// Windows: CreateSharedMemory returns -1.
+extern int CreateSharedMemory(const char *name, size_t size);
+extern void DestroySharedMemory(int handle);
+extern bool MapSharedMemory(int handle, size_t offset, void *baseaddr, size_t size, const PageProtectionMode &mode);
+
 template <uint size>
 void MemProtectStatic(u8 (&arr)[size], const PageProtectionMode &mode)
 {
@@ -30,10 +30,12 @@
 struct PageFaultInfo
 {
     uptr addr;
+    uptr pc; // address of the faulting instruction, 0 where the platform doesn't tell
 
-    PageFaultInfo(uptr address)
+    PageFaultInfo(uptr address, uptr faultpc = 0)
     {
         addr = address;
+        pc = faultpc;
     }
 };
 
@@ -105,12 +107,28 @@ class SrcType_PageFault : public EventSource<IEventListener_PageFault>
 protected:
     typedef EventSource<IEventListener_PageFault> _parent;
 
+public:
+    // Called once the faulting instruction has been executed, with the param given to
+    // RequestStep().  Runs under the PageFault_Mutex, from the faulting thread.
+    typedef void StepCallback(uptr param);
+
 protected:
     bool m_handled;
+    bool m_canStep;
+    bool m_canResume;
+
+    StepCallback *m_stepCallback;
+    uptr m_stepParam;
+    uptr m_resumePC;
 
 public:
     SrcType_PageFault()
         : m_handled(false)
+        , m_canStep(false)
+        , m_canResume(false)
+        , m_stepCallback(NULL)
+        , m_stepParam(0)
+        , m_resumePC(0)
     {
     }
     virtual ~SrcType_PageFault() = default;
@@ -118,6 +136,30 @@ public:
     bool WasHandled() const { return m_handled; }
     virtual void Dispatch(const PageFaultInfo &params);
 
+    // Single-stepping lets a listener unprotect a page for the faulting instruction only:
+    // the instruction is resumed with the trap flag set and the callback gets to protect
+    // the page again right after it.  Only valid from OnPageFaultEvent, on platforms
+    // where CanStep() is true.
+    bool CanStep() const { return m_canStep; }
+    void EnableStep() { m_canStep = true; }
+    void RequestStep(StepCallback *callback, uptr param)
+    {
+        m_stepCallback = callback;
+        m_stepParam = param;
+    }
+
+    StepCallback *GetStepCallback() const { return m_stepCallback; }
+    uptr GetStepParam() const { return m_stepParam; }
+
+    // Lets a listener resume the faulting thread somewhere else than at the faulting
+    // instruction (PageFaultInfo::pc).  Only valid from OnPageFaultEvent, on platforms
+    // where CanResume() is true.
+    bool CanResume() const { return m_canResume; }
+    void EnableResume() { m_canResume = true; }
+    void RequestResume(uptr pc) { m_resumePC = pc; }
+
+    uptr GetResumePC() const { return m_resumePC; }
+
 protected:
     virtual void _DispatchRaw(ListenerIterator iter, const ListenerIterator &iend, const PageFaultInfo &evt);
 };
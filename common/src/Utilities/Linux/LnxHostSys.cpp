@@ -21,7 +21,9 @@
 
 #include <sys/mman.h>
 #include <signal.h>
+#include <ucontext.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 // Apple uses the MAP_ANON define instead of MAP_ANONYMOUS, but they mean
@@ -32,10 +34,68 @@
 
 extern void SignalExit(int sig);
 
-static const uptr m_pagemask = getpagesize() - 1;
+// Listeners asking to single-step the faulting instruction.  An unaligned access can fault
+// on two pages before it completes, hence more than one entry.
+struct PendingStep
+{
+    SrcType_PageFault::StepCallback *callback;
+    uptr param;
+};
+
+static thread_local PendingStep s_pendingSteps[4];
+static thread_local uint s_pendingStepCount = 0;
+
+#if (defined(__linux__) && (defined(__x86_64__) || defined(__i386__))) || \
+    ((defined(__APPLE__) || defined(__FreeBSD__)) && defined(__x86_64__))
+#define HAS_TRAP_FLAG 1
+#else
+#define HAS_TRAP_FLAG 0
+#endif
+
+// Sets or clears the x86 trap flag in the context the signal handler returns to.
+static void SetTrapFlag(void *context, bool enable)
+{
+#if HAS_TRAP_FLAG
+    ucontext_t *uc = (ucontext_t *)context;
+#if defined(__APPLE__)
+    auto &flags = uc->uc_mcontext->__ss.__rflags;
+#elif defined(__FreeBSD__)
+    auto &flags = uc->uc_mcontext.mc_rflags;
+#else
+    auto &flags = uc->uc_mcontext.gregs[REG_EFL];
+#endif
+    if (enable)
+        flags |= 0x100;
+    else
+        flags &= ~0x100;
+#endif
+}
+
+#if (defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)) && defined(__x86_64__)
+#define HAS_CONTEXT_PC 1
+#else
+#define HAS_CONTEXT_PC 0
+#endif
+
+// Instruction pointer of the context the signal handler returns to.
+static uptr *ContextPC(void *context)
+{
+#if HAS_CONTEXT_PC
+    ucontext_t *uc = (ucontext_t *)context;
+#if defined(__APPLE__)
+    return (uptr *)&uc->uc_mcontext->__ss.__rip;
+#elif defined(__FreeBSD__)
+    return (uptr *)&uc->uc_mcontext.mc_rip;
+#else
+    return (uptr *)&uc->uc_mcontext.gregs[REG_RIP];
+#endif
+#else
+    return NULL;
+#endif
+}
 
 // Linux implementation of SIGSEGV handler.  Bind it using sigaction().
-static void SysPageFaultSignalFilter(int signal, siginfo_t *siginfo, void *)
+static void SysPageFaultSignalFilter(int signal, siginfo_t *siginfo, void *context)
 {
     // [TODO] : Add a thread ID filter to the Linux Signal handler here.
     // Rationale: On windows, the __try/__except model allows per-thread specific behavior
@@ -59,12 +119,24 @@ static void SysPageFaultSignalFilter(int signal, siginfo_t *siginfo, void *)
     // so for now we lock this exception code unless someone can fix this better...
     Threading::ScopedLock lock(PageFault_Mutex);
 
-    Source_PageFault->Dispatch(PageFaultInfo((uptr)siginfo->si_addr & ~m_pagemask));
+    uptr *pc = ContextPC(context);
+    Source_PageFault->Dispatch(PageFaultInfo((uptr)siginfo->si_addr, pc ? *pc : 0));
 
     // resumes execution right where we left off (re-executes instruction that
-    // caused the SIGSEGV).
-    if (Source_PageFault->WasHandled())
+    // caused the SIGSEGV), unless a listener asked to go somewhere else.
+    if (Source_PageFault->WasHandled()) {
+        if (uptr resume = Source_PageFault->GetResumePC())
+            *pc = resume;
+
+        if (SrcType_PageFault::StepCallback *callback = Source_PageFault->GetStepCallback()) {
+            pxAssert(s_pendingStepCount < ArraySize(s_pendingSteps));
+            s_pendingSteps[s_pendingStepCount].callback = callback;
+            s_pendingSteps[s_pendingStepCount].param = Source_PageFault->GetStepParam();
+            s_pendingStepCount++;
+            SetTrapFlag(context, true);
+        }
         return;
+    }
 
     if (!wxThread::IsMain()) {
         pxFailRel(pxsFmt("Unhandled page fault @ 0x%08x", siginfo->si_addr));
@@ -78,6 +150,28 @@ static void SysPageFaultSignalFilter(int signal, siginfo_t *siginfo, void *)
         raise(SIGKILL);
 }
 
+// SIGTRAP handler, raised once an instruction resumed with the trap flag has executed.
+static void SysSingleStepSignalFilter(int signal, siginfo_t *siginfo, void *context)
+{
+    if (!s_pendingStepCount) {
+        // Not ours (a pxTrap outside of a debugger): fall back to the default action.
+        struct sigaction sa;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = 0;
+        sa.sa_handler = SIG_DFL;
+        sigaction(SIGTRAP, &sa, NULL);
+        raise(SIGTRAP);
+        return;
+    }
+
+    Threading::ScopedLock lock(PageFault_Mutex);
+
+    SetTrapFlag(context, false);
+    for (uint i = 0; i < s_pendingStepCount; i++)
+        s_pendingSteps[i].callback(s_pendingSteps[i].param);
+    s_pendingStepCount = 0;
+}
+
 void _platform_InstallSignalHandler()
 {
     Console.WriteLn("Installing POSIX SIGSEGV handler...");
@@ -92,6 +186,15 @@ void _platform_InstallSignalHandler()
 #else
     sigaction(SIGSEGV, &sa, NULL);
 #endif
+
+    if (HAS_TRAP_FLAG) {
+        sa.sa_sigaction = SysSingleStepSignalFilter;
+        sigaction(SIGTRAP, &sa, NULL);
+        Source_PageFault->EnableStep();
+    }
+
+    if (HAS_CONTEXT_PC)
+        Source_PageFault->EnableResume();
 }
 
 static __ri void PageSizeAssertionTest(size_t size)
@@ -218,6 +321,50 @@ void HostSys::Munmap(uptr base, size_t size)
     munmap((void *)base, size);
 }
 
+int HostSys::CreateSharedMemory(const char *name, size_t size)
+{
+    PageSizeAssertionTest(size);
+
+    // The name is only needed until the object is opened, unlink it right away so that
+    // nothing is left behind if we crash.
+    char path[64];
+    snprintf(path, sizeof(path), "/pcsx2_%s_%d", name, (int)getpid());
+
+    int fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+        return -1;
+
+    shm_unlink(path);
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void HostSys::DestroySharedMemory(int handle)
+{
+    if (handle >= 0)
+        close(handle);
+}
+
+bool HostSys::MapSharedMemory(int handle, size_t offset, void *baseaddr, size_t size, const PageProtectionMode &mode)
+{
+    PageSizeAssertionTest(size);
+
+    uint lnxmode = 0;
+
+    if (mode.CanWrite())
+        lnxmode |= PROT_WRITE;
+    if (mode.CanRead())
+        lnxmode |= PROT_READ;
+    if (mode.CanExecute())
+        lnxmode |= PROT_EXEC | PROT_READ;
+
+    void *result = mmap(baseaddr, size, lnxmode, MAP_SHARED | MAP_FIXED, handle, offset);
+    return result == baseaddr;
+}
+
 void HostSys::MemProtect(void *baseaddr, size_t size, const PageProtectionMode &mode)
 {
     if (!_memprotect(baseaddr, size, mode)) {
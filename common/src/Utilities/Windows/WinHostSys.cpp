@@ -19,8 +19,36 @@
 
 #include <winnt.h>
 
+// Listeners asking to single-step the faulting instruction.  An unaligned access can fault
+// on two pages before it completes, hence more than one entry.
+struct PendingStep
+{
+    SrcType_PageFault::StepCallback *callback;
+    uptr param;
+};
+
+static thread_local PendingStep s_pendingSteps[4];
+static thread_local uint s_pendingStepCount = 0;
+
+static long DoSysSingleStepExceptionFilter(EXCEPTION_POINTERS *eps)
+{
+    if (!s_pendingStepCount)
+        return EXCEPTION_CONTINUE_SEARCH;
+
+    Threading::ScopedLock lock(PageFault_Mutex);
+
+    eps->ContextRecord->EFlags &= ~0x100;
+    for (uint i = 0; i < s_pendingStepCount; i++)
+        s_pendingSteps[i].callback(s_pendingSteps[i].param);
+    s_pendingStepCount = 0;
+    return EXCEPTION_CONTINUE_EXECUTION;
+}
+
 static long DoSysPageFaultExceptionFilter(EXCEPTION_POINTERS *eps)
 {
+    if (eps->ExceptionRecord->ExceptionCode == EXCEPTION_SINGLE_STEP)
+        return DoSysSingleStepExceptionFilter(eps);
+
     if (eps->ExceptionRecord->ExceptionCode != EXCEPTION_ACCESS_VIOLATION)
         return EXCEPTION_CONTINUE_SEARCH;
 
@@ -28,8 +56,26 @@ static long DoSysPageFaultExceptionFilter(EXCEPTION_POINTERS *eps)
     // Source_PageFault is a global variable with its own state information
     // so for now we lock this exception code unless someone can fix this better...
     Threading::ScopedLock lock(PageFault_Mutex);
-    Source_PageFault->Dispatch(PageFaultInfo((uptr)eps->ExceptionRecord->ExceptionInformation[1]));
-    return Source_PageFault->WasHandled() ? EXCEPTION_CONTINUE_EXECUTION : EXCEPTION_CONTINUE_SEARCH;
+#ifdef _WIN64
+    uptr *pc = (uptr *)&eps->ContextRecord->Rip;
+#else
+    uptr *pc = (uptr *)&eps->ContextRecord->Eip;
+#endif
+    Source_PageFault->Dispatch(PageFaultInfo((uptr)eps->ExceptionRecord->ExceptionInformation[1], *pc));
+    if (!Source_PageFault->WasHandled())
+        return EXCEPTION_CONTINUE_SEARCH;
+
+    if (uptr resume = Source_PageFault->GetResumePC())
+        *pc = resume;
+
+    if (SrcType_PageFault::StepCallback *callback = Source_PageFault->GetStepCallback()) {
+        pxAssert(s_pendingStepCount < ArraySize(s_pendingSteps));
+        s_pendingSteps[s_pendingStepCount].callback = callback;
+        s_pendingSteps[s_pendingStepCount].param = Source_PageFault->GetStepParam();
+        s_pendingStepCount++;
+        eps->ContextRecord->EFlags |= 0x100;
+    }
+    return EXCEPTION_CONTINUE_EXECUTION;
 }
 
 long __stdcall SysPageFaultExceptionFilter(EXCEPTION_POINTERS *eps)
@@ -52,6 +98,8 @@ void _platform_InstallSignalHandler()
 #ifdef _WIN64 // We don't handle SEH properly on Win64 so use a vectored exception handler instead
     AddVectoredExceptionHandler(true, SysPageFaultExceptionFilter);
 #endif
+    Source_PageFault->EnableStep();
+    Source_PageFault->EnableResume();
 }
 
 
@@ -133,6 +181,22 @@ void HostSys::Munmap(uptr base, size_t size)
     VirtualFree((void *)base, 0, MEM_RELEASE);
 }
 
+// Mapping views at fixed addresses of a reservation needs the placeholder APIs of
+// Windows 10 1803+, which aren't used yet.
+int HostSys::CreateSharedMemory(const char *name, size_t size)
+{
+    return -1;
+}
+
+void HostSys::DestroySharedMemory(int handle)
+{
+}
+
+bool HostSys::MapSharedMemory(int handle, size_t offset, void *baseaddr, size_t size, const PageProtectionMode &mode)
+{
+    return false;
+}
+
 void HostSys::MemProtect(void *baseaddr, size_t size, const PageProtectionMode &mode)
 {
     pxAssertDev(((size & (__pagesize - 1)) == 0), pxsFmt(
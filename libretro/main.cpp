@@ -22,8 +22,12 @@
 #include "input.h"
 #include "svnrev.h"
 #include "SPU2/Global.h"
+#include "SPU2/spu2.h"
+#include "SaveState.h"
 #include "ps2/BiosTools.h"
 #include "MTVU.h"
+#include "PipelineStats.h"
+#include "BlockProfiler.h"
 
 #ifdef PERF_TEST
 static struct retro_perf_callback perf_cb;
@@ -65,6 +69,9 @@ GfxOption<std::string> renderer("pcsx2_renderer", "Renderer", {"Auto",
 static GfxOption<bool> frameskip("pcsx2_frameskip", "Frameskip", false);
 static GfxOption<int> frames_to_draw("pcsx2_frames_to_draw", "Frameskip: Frames to Draw", 1, 10);
 static GfxOption<int> frames_to_skip("pcsx2_frames_to_skip", "Frameskip: Frames to Skip", 1, 10);
+
+// Not a setting: every change of it dumps the block profiler tables (Profiler.RecBlocks_*).
+static Option<bool> block_profiler_dump("pcsx2_block_profiler_dump", "Block Profiler: Dump Hottest Blocks (toggle to dump)", false);
 } // namespace Options
 
 // renderswitch - tells GSdx to go into dx9 sw if "renderswitch" is set.
@@ -511,9 +518,50 @@ void retro_unload_game(void)
 }
 
 
+#ifdef PERF_TEST
+// Publishes the EE/MTGS/MTVU stall statistics (Profiler.Pipeline) as perf counters, so they
+// show up in the perf log: call_cnt is the number of stalls, and total the time spent
+// stalled in microseconds (not in perf counter ticks).  Along with them goes the time spent
+// running the IOP, which gives the IOP time per frame of a headless frontend run (e.g. a
+// savestate loaded and run for a fixed number of frames).
+static void UpdatePipelineCounters()
+{
+	static retro_perf_counter counters[PipelineStats::StallType_Count] = {
+		{"pipeline_ee_waitgs"},
+		{"pipeline_ee_vsync_queue"},
+		{"pipeline_ee_gs_ring_full"},
+		{"pipeline_mtvu_waitgs"},
+		{"pipeline_ee_waitvu"},
+		{"pipeline_ee_vu_ring_full"},
+	};
+
+	if (!PipelineStats::IsEnabled())
+		return;
+
+	PipelineStats::Stats totals;
+	PipelineStats::GetTotals(totals);
+	for (int i = 0; i < PipelineStats::StallType_Count; i++)
+	{
+		if (!counters[i].registered)
+			perf_cb.perf_register(&counters[i]);
+		counters[i].call_cnt = totals.stalls[i].count;
+		counters[i].total = totals.stalls[i].us;
+	}
+
+	// call_cnt is the number of frames here, so the average is the IOP time per frame.
+	static retro_perf_counter iop_counter = {"pipeline_iop_execute"};
+	if (!iop_counter.registered)
+		perf_cb.perf_register(&iop_counter);
+	iop_counter.call_cnt = totals.frames;
+	iop_counter.total = (retro_perf_tick_t)(totals.iopTicks * 1000000.0 / GetTickFrequency());
+}
+#endif
+
 void retro_run(void)
 {
 	Options::CheckVariables();
+	if (Options::block_profiler_dump.Updated())
+		BlockProfiler::Dump();
 	SetGSConfig().FrameSkipEnable = Options::frameskip;
 	SetGSConfig().FramesToDraw = Options::frames_to_draw;
 	SetGSConfig().FramesToSkip = Options::frames_to_skip;
@@ -539,20 +587,134 @@ void retro_run(void)
 	GetMTGS().ExecuteTaskInThread();
 
 	RETRO_PERFORMANCE_STOP(pcsx2_run);
+#ifdef PERF_TEST
+	UpdatePipelineCounters();
+#endif
+}
+
+// Rewind, run-ahead and netplay save the state every frame, so states are kept entirely in
+// memory: the VM is frozen straight into a buffer that is allocated once and reused, and the
+// zip/compression pipeline used for savestate files is never involved.
+static VmStateBuffer state_buffer(L"Libretro Savestate");
+static size_t state_size = 0;
+
+// The EE runs on its own thread and can be a couple of vsyncs ahead of the GS, which lives on
+// this thread. Stop it at its next vsync, then drain whatever it queued so the GS plugin state
+// matches the frozen core state.
+static void PauseForState()
+{
+	GetMTGS().FinishTaskInThread();
+	GetCoreThread().Pause();
+	GetMTGS().FlushTaskInThread();
+}
+
+static void FreezeState(SaveStateBase& state)
+{
+	u32 version = g_SaveVersion;
+	state.Freeze(version);
+	if (state.IsLoading() && version != g_SaveVersion)
+		throw Exception::SaveStateLoadError();
+
+	state.FreezeAll();
+	SPU2DoFreeze(state);
+}
+
+static bool SaveStateToBuffer()
+{
+	try
+	{
+		memSavingState saveme(state_buffer);
+		FreezeState(saveme);
+		state_size = std::max<size_t>(state_size, saveme.GetCurrentPos());
+		return true;
+	}
+	catch (BaseException& ex)
+	{
+		log_cb(RETRO_LOG_ERROR, "Failed to save state: %s\n", (const char*)ex.FormatDiagnosticMessage());
+	}
+	catch (std::exception& ex)
+	{
+		// SPU2DoFreeze reports its errors with std::runtime_error.
+		log_cb(RETRO_LOG_ERROR, "Failed to save state: %s\n", ex.what());
+	}
+	return false;
 }
 
 size_t retro_serialize_size(void)
 {
-	return 0;
+	if (!state_size && SysHasValidState())
+	{
+		// The size of a state only depends on the VM configuration, so measure it once by
+		// saving a real one. This also sizes state_buffer for every following call.
+		PauseForState();
+		SaveStateToBuffer();
+		GetCoreThread().Resume();
+	}
+
+	return state_size;
 }
 
 bool retro_serialize(void* data, size_t size)
 {
-	return false;
+	if (!SysHasValidState())
+		return false;
+
+	RETRO_PERFORMANCE_INIT(pcsx2_serialize);
+	RETRO_PERFORMANCE_START(pcsx2_serialize);
+
+	PauseForState();
+	bool saved = SaveStateToBuffer();
+	GetCoreThread().Resume();
+
+	if (saved && state_size <= size)
+		memcpy(data, state_buffer.GetPtr(), state_size);
+
+	RETRO_PERFORMANCE_STOP(pcsx2_serialize);
+
+	return saved && state_size <= size;
 }
+
 bool retro_unserialize(const void* data, size_t size)
 {
-	return false;
+	if (!SysHasValidState())
+		return false;
+
+	RETRO_PERFORMANCE_INIT(pcsx2_unserialize);
+	RETRO_PERFORMANCE_START(pcsx2_unserialize);
+
+	PauseForState();
+
+	// The frontend doesn't have to ask for the size before loading (e.g. a state loaded right
+	// after startup), measure it the same way retro_serialize_size does. The current state is
+	// about to be replaced anyway.
+	if (!state_size)
+		SaveStateToBuffer();
+
+	bool loaded = false;
+	if (state_size && size >= state_size)
+	{
+		try
+		{
+			memcpy(state_buffer.GetPtr(), data, state_size);
+			memLoadingState loadme(state_buffer);
+			FreezeState(loadme);
+			loaded = true;
+		}
+		catch (BaseException& ex)
+		{
+			log_cb(RETRO_LOG_ERROR, "Failed to load state: %s\n", (const char*)ex.FormatDiagnosticMessage());
+		}
+		catch (std::exception& ex)
+		{
+			log_cb(RETRO_LOG_ERROR, "Failed to load state: %s\n", ex.what());
+		}
+	}
+
+	GetCoreThread().Resume();
+
+	RETRO_PERFORMANCE_STOP(pcsx2_unserialize);
+
+	return loaded;
 }
 
 unsigned retro_get_region(void)
@@ -46,6 +46,10 @@ public:
 	virtual int FinishRead(void)=0;
 	virtual void CancelRead(void)=0;
 
+	// Hint that the given sectors are likely to be read soon (sequential access).
+	// Readers with expensive reads (compressed images) can prepare them in the background.
+	virtual void ReadAhead(uint sector, uint count) {}
+
 	virtual void Close(void)=0;
 
 	virtual uint GetBlockCount(void) const=0;
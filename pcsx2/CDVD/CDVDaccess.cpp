@@ -35,6 +35,7 @@
 
 #include "DebugTools/SymbolMap.h"
 #include "AppConfig.h"
+#include "Timeline.h"
 
 CDVD_API* CDVD = NULL;
 
@@ -472,6 +473,7 @@ s32 DoCDVDreadSector(u8* buffer, u32 lsn, int mode)
 s32 DoCDVDreadTrack(u32 lsn, int mode)
 {
 	CheckNullCDVD();
+	Timeline::Scope span(Timeline::Span_CDVDReadTrack);
 
 	// TEMP: until all the plugins use the new CDVDgetBuffer style
 	// TODO: The CDVD api only uses the new getBuffer style. Why is this temp?
@@ -500,6 +502,7 @@ s32 DoCDVDreadTrack(u32 lsn, int mode)
 s32 DoCDVDgetBuffer(u8* buffer)
 {
 	CheckNullCDVD();
+	Timeline::Scope span(Timeline::Span_CDVDGetBuffer);
 	const int ret = CDVD->getBuffer(buffer);
 
 	if (ret == 0 && blockDumpFile.IsOpened())
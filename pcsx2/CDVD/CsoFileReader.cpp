@@ -156,6 +156,9 @@ bool CsoFileReader::InitializeBuffers()
 	m_zlibBuffer = new u8[m_frameSize + (1 << m_indexShift)];
 	m_zlibBufferFrame = numFrames;
 
+	// Other recently decompressed frames go to the frame cache (if it can be allocated).
+	m_cache.Init(m_frameSize);
+
 	const u32 indexSize = numFrames + 1;
 	m_index = new u32[indexSize];
 	if (fread(m_index, sizeof(u32), indexSize, m_src) != indexSize)
@@ -164,36 +167,97 @@ bool CsoFileReader::InitializeBuffers()
 		return false;
 	}
 
-	m_z_stream = new z_stream;
-	m_z_stream->zalloc = Z_NULL;
-	m_z_stream->zfree = Z_NULL;
-	m_z_stream->opaque = Z_NULL;
-	if (inflateInit2(m_z_stream, -15) != Z_OK)
+	m_z_stream = CreateZStream();
+	if (!m_z_stream)
 	{
 		Console.Error("Unable to initialize zlib for CSO decompression.");
 		return false;
 	}
 
+	StartReadAhead();
 	return true;
 }
 
+z_stream* CsoFileReader::CreateZStream()
+{
+	z_stream* z = new z_stream;
+	z->zalloc = Z_NULL;
+	z->zfree = Z_NULL;
+	z->opaque = Z_NULL;
+	if (inflateInit2(z, -15) != Z_OK)
+	{
+		delete z;
+		return NULL;
+	}
+	return z;
+}
+
+void CsoFileReader::DestroyZStream(z_stream*& z)
+{
+	if (z)
+	{
+		inflateEnd(z);
+		delete z;
+		z = NULL;
+	}
+}
+
+void CsoFileReader::StartReadAhead()
+{
+	// Without the cache there's nowhere to put read-ahead frames.
+	if (!m_cache.IsEnabled())
+		return;
+
+	for (uint i = 0; i < CSO_READAHEAD_THREADS; i++)
+	{
+		Inflater inf;
+		inf.z = CreateZStream();
+		if (!inf.z)
+			break;
+		inf.readBuffer = new u8[m_frameSize + (1 << m_indexShift)];
+		inf.frameBuffer = new u8[m_frameSize];
+		m_inflaters.push_back(inf);
+	}
+
+	m_readAheadBegin = m_readAheadNext = 0;
+	if (!m_inflaters.empty())
+		m_readAhead.Start((uint)m_inflaters.size(), [this](uint worker, u64 frame) { ReadAheadFrame(worker, (u32)frame); });
+}
+
+void CsoFileReader::StopReadAhead()
+{
+	m_readAhead.Stop();
+
+	for (Inflater& inf : m_inflaters)
+	{
+		DestroyZStream(inf.z);
+		delete[] inf.readBuffer;
+		delete[] inf.frameBuffer;
+	}
+	m_inflaters.clear();
+}
+
 void CsoFileReader::Close()
 {
 	m_filename.Empty();
-#if CSO_USE_CHUNKSCACHE
-	m_cache.Clear();
-#endif
+	StopReadAhead();
+
+	if (m_cache.IsEnabled())
+	{
+		const u64 lookups = m_cache.GetHits() + m_cache.GetMisses();
+		if (lookups)
+			DevCon.WriteLn(Color_Gray, "CSO frame cache: %llu hits, %llu misses (%.1f%% hit rate)",
+						   (unsigned long long)m_cache.GetHits(), (unsigned long long)m_cache.GetMisses(),
+						   100.0 * m_cache.GetHits() / lookups);
+		m_cache.Free();
+	}
 
 	if (m_src)
 	{
 		fclose(m_src);
 		m_src = NULL;
 	}
-	if (m_z_stream)
-	{
-		inflateEnd(m_z_stream);
-		m_z_stream = NULL;
-	}
+	DestroyZStream(m_z_stream);
 
 	if (m_readBuffer)
 	{
@@ -230,29 +294,11 @@ int CsoFileReader::ReadSync(void* pBuffer, uint sector, uint count)
 
 	while (remaining > 0)
 	{
-		int readBytes;
-
-#if CSO_USE_CHUNKSCACHE
-		// Try first to read from the cache.
-		readBytes = m_cache.Read(dest + bytes, pos + bytes, remaining);
-#else
-		readBytes = -1;
-#endif
-		if (readBytes < 0)
+		int readBytes = ReadFromFrame(dest + bytes, pos + bytes, remaining);
+		if (readBytes == 0)
 		{
-			readBytes = ReadFromFrame(dest + bytes, pos + bytes, remaining);
-			if (readBytes == 0)
-			{
-				// We hit EOF.
-				break;
-			}
-
-#if CSO_USE_CHUNKSCACHE
-			// Add the bytes into the cache.  We need to allocate a buffer for it.
-			void* cached = malloc(readBytes);
-			memcpy(cached, dest + bytes, readBytes);
-			m_cache.Take(cached, pos + bytes, readBytes, readBytes);
-#endif
+			// We hit EOF.
+			break;
 		}
 
 		bytes += readBytes;
@@ -277,16 +323,13 @@ int CsoFileReader::ReadFromFrame(u8* dest, u64 pos, int maxBytes)
 
 	// Grab the index data for the frame we're about to read.
 	const bool compressed = (m_index[frame + 0] & 0x80000000) == 0;
-	const u32 index0 = m_index[frame + 0] & 0x7FFFFFFF;
-	const u32 index1 = m_index[frame + 1] & 0x7FFFFFFF;
-
-	// Calculate where the compressed payload is (if compressed.)
-	const u64 frameRawPos = (u64)index0 << m_indexShift;
-	const u64 frameRawSize = (u64)(index1 - index0) << m_indexShift;
 
 	if (!compressed)
 	{
+		const u64 frameRawPos = (u64)(m_index[frame + 0] & 0x7FFFFFFF) << m_indexShift;
+
 		// Just read directly, easy.
+		std::lock_guard<std::mutex> guard(m_fileLock);
 		if (PX_fseeko(m_src, m_dataoffset + frameRawPos + offset, SEEK_SET) != 0)
 		{
 			Console.Error("Unable to seek to uncompressed CSO data.");
@@ -294,53 +337,147 @@ int CsoFileReader::ReadFromFrame(u8* dest, u64 pos, int maxBytes)
 		}
 		return fread(dest, 1, bytes, m_src);
 	}
-	else
+
+	// We don't need to decompress if we already did this same frame last time.
+	if (m_zlibBufferFrame == frame)
+	{
+		memcpy(dest, m_zlibBuffer + offset, bytes);
+		return bytes;
+	}
+
+	if (m_cache.IsEnabled())
 	{
-		// We don't need to decompress if we already did this same frame last time.
-		if (m_zlibBufferFrame != frame)
+		// Or if it's still cached, or was decompressed ahead by a worker.
 		{
-			if (PX_fseeko(m_src, m_dataoffset + frameRawPos, SEEK_SET) != 0)
+			std::lock_guard<std::mutex> guard(m_cacheLock);
+			if (const u8* cached = m_cache.Lookup(frame))
 			{
-				Console.Error("Unable to seek to compressed CSO data.");
-				return 0;
+				memcpy(dest, cached + offset, bytes);
+				return bytes;
 			}
-			// This might be less bytes than frameRawSize in case of padding on the last frame.
-			// This is because the index positions must be aligned.
-			const u32 readRawBytes = fread(m_readBuffer, 1, frameRawSize, m_src);
-			if (!DecompressFrame(frame, readRawBytes))
+		}
+
+		if (m_readAhead.Claim(frame))
+		{
+			std::lock_guard<std::mutex> guard(m_cacheLock);
+			if (const u8* cached = m_cache.Find(frame))
 			{
-				return 0;
+				memcpy(dest, cached + offset, bytes);
+				return bytes;
 			}
 		}
+	}
 
-		// Now we just copy the offset data from the cache.
-		memcpy(dest, m_zlibBuffer + offset, bytes);
+	if (!ReadCompressedFrame(frame, m_z_stream, m_readBuffer, m_zlibBuffer))
+	{
+		m_zlibBufferFrame = (u32)-1;
+		return 0;
+	}
+	m_zlibBufferFrame = frame;
+
+	if (m_cache.IsEnabled())
+	{
+		std::lock_guard<std::mutex> guard(m_cacheLock);
+		m_cache.Store(frame, m_zlibBuffer, m_frameSize);
 	}
 
+	// Now we just copy the offset data from the buffer.
+	memcpy(dest, m_zlibBuffer + offset, bytes);
 	return bytes;
 }
 
-bool CsoFileReader::DecompressFrame(u32 frame, u32 readBufferSize)
+bool CsoFileReader::ReadCompressedFrame(u32 frame, z_stream* z, u8* readBuffer, u8* dest)
+{
+	const u32 index0 = m_index[frame + 0] & 0x7FFFFFFF;
+	const u32 index1 = m_index[frame + 1] & 0x7FFFFFFF;
+
+	// Calculate where the compressed payload is.
+	const u64 frameRawPos = (u64)index0 << m_indexShift;
+	const u64 frameRawSize = (u64)(index1 - index0) << m_indexShift;
+
+	u32 readRawBytes;
+	{
+		std::lock_guard<std::mutex> guard(m_fileLock);
+		if (PX_fseeko(m_src, m_dataoffset + frameRawPos, SEEK_SET) != 0)
+		{
+			Console.Error("Unable to seek to compressed CSO data.");
+			return false;
+		}
+		// This might be less bytes than frameRawSize in case of padding on the last frame.
+		// This is because the index positions must be aligned.
+		readRawBytes = fread(readBuffer, 1, frameRawSize, m_src);
+	}
+
+	return DecompressFrame(z, readBuffer, readRawBytes, dest);
+}
+
+void CsoFileReader::ReadAheadFrame(uint worker, u64 frame)
+{
+	Inflater& inf = m_inflaters[worker];
+
+	{
+		std::lock_guard<std::mutex> guard(m_cacheLock);
+		if (m_cache.Find(frame))
+			return;
+	}
+
+	if (!ReadCompressedFrame((u32)frame, inf.z, inf.readBuffer, inf.frameBuffer))
+		return;
+
+	std::lock_guard<std::mutex> guard(m_cacheLock);
+	m_cache.Store(frame, inf.frameBuffer, m_frameSize);
+}
+
+void CsoFileReader::ReadAhead(uint sector, uint count)
 {
-	m_z_stream->next_in = m_readBuffer;
-	m_z_stream->avail_in = readBufferSize;
-	m_z_stream->next_out = m_zlibBuffer;
-	m_z_stream->avail_out = m_frameSize;
+	if (!m_readAhead.IsRunning() || !count)
+		return;
+
+	const u64 pos = (u64)sector * m_blocksize;
+	if (pos >= m_totalSize)
+		return;
 
-	int status = inflate(m_z_stream, Z_FINISH);
-	bool success = status == Z_STREAM_END && m_z_stream->total_out == m_frameSize;
-	if (success)
+	const u64 end = std::min<u64>(pos + (u64)count * m_blocksize, m_totalSize);
+	const u32 first = (u32)(pos >> m_frameShift);
+	const u32 last = (u32)((end - 1) >> m_frameShift);
+
+	// Sequential reads slide the window forward, only queue the frames which entered it.
+	u32 frame = first;
+	if (first >= m_readAheadBegin && first < m_readAheadNext)
 	{
-		// Our buffer now contains this frame.
-		m_zlibBufferFrame = frame;
+		frame = m_readAheadNext;
 	}
 	else
+	{
+		// Seeked elsewhere, the frames queued for the old position aren't needed anymore.
+		m_readAhead.Cancel();
+		m_readAheadBegin = m_readAheadNext = first;
+	}
+
+	for (; frame <= last; frame++)
+	{
+		// Uncompressed frames are read directly from the file.
+		if ((m_index[frame] & 0x80000000) == 0)
+			m_readAhead.Request(frame);
+	}
+	m_readAheadNext = std::max(m_readAheadNext, last + 1);
+}
+
+bool CsoFileReader::DecompressFrame(z_stream* z, u8* src, u32 srcSize, u8* dest)
+{
+	z->next_in = src;
+	z->avail_in = srcSize;
+	z->next_out = dest;
+	z->avail_out = m_frameSize;
+
+	int status = inflate(z, Z_FINISH);
+	bool success = status == Z_STREAM_END && z->total_out == m_frameSize;
+	if (!success)
 	{
 		Console.Error("Unable to decompress CSO frame using zlib.");
-		m_zlibBufferFrame = (u32)-1;
 	}
 
-	inflateReset(m_z_stream);
+	inflateReset(z);
 	return success;
 }
 
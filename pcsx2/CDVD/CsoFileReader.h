@@ -15,22 +15,16 @@
 
 #pragma once
 
-// Based on testing, the overhead of using this cache is high.
-//
-// The test was done with CSO files using a block size of 16KB.
-// Cache hit rates were observed in the range of 25%.
-// Cache overhead added 35% to the overall read time.
-//
-// For this reason, it's currently disabled.
-#define CSO_USE_CHUNKSCACHE 0
-
 #include "AsyncFileReader.h"
-#include "ChunksCache.h"
+#include "FrameCache.h"
+#include "ReadAheadPool.h"
+#include <mutex>
 
 struct CsoHeader;
 typedef struct z_stream_s z_stream;
 
-static const uint CSO_CHUNKCACHE_SIZE_MB = 200;
+static const uint CSO_FRAMECACHE_SIZE_MB = 200;
+static const uint CSO_READAHEAD_THREADS = 2;
 
 class CsoFileReader : public AsyncFileReader
 {
@@ -48,12 +42,10 @@ public:
 		, m_totalSize(0)
 		, m_src(0)
 		, m_z_stream(0)
-		,
-#if CSO_USE_CHUNKSCACHE
-		m_cache(CSO_CHUNKCACHE_SIZE_MB)
-		,
-#endif
-		m_bytesRead(0)
+		, m_cache(CSO_FRAMECACHE_SIZE_MB)
+		, m_readAheadBegin(0)
+		, m_readAheadNext(0)
+		, m_bytesRead(0)
 	{
 		m_blocksize = 2048;
 	};
@@ -69,6 +61,8 @@ public:
 	virtual int FinishRead(void);
 	virtual void CancelRead(void);
 
+	virtual void ReadAhead(uint sector, uint count);
+
 	virtual void Close(void);
 
 	virtual uint GetBlockCount(void) const
@@ -84,7 +78,22 @@ private:
 	bool ReadFileHeader();
 	bool InitializeBuffers();
 	int ReadFromFrame(u8* dest, u64 pos, int maxBytes);
-	bool DecompressFrame(u32 frame, u32 readBufferSize);
+	bool ReadCompressedFrame(u32 frame, z_stream* z, u8* readBuffer, u8* dest);
+	bool DecompressFrame(z_stream* z, u8* src, u32 srcSize, u8* dest);
+	static z_stream* CreateZStream();
+	static void DestroyZStream(z_stream*& z);
+
+	void StartReadAhead();
+	void StopReadAhead();
+	void ReadAheadFrame(uint worker, u64 frame);
+
+	// zlib state and buffers of a read-ahead worker.
+	struct Inflater
+	{
+		z_stream* z;
+		u8* readBuffer;
+		u8* frameBuffer;
+	};
 
 	u32 m_frameSize;
 	u8 m_frameShift;
@@ -98,9 +107,18 @@ private:
 	FILE* m_src;
 	z_stream* m_z_stream;
 
-#if CSO_USE_CHUNKSCACHE
-	ChunksCache m_cache;
-#endif
+	// Serializes seek+read on m_src between the reader and the read-ahead workers.
+	std::mutex m_fileLock;
+
+	// Recently decompressed frames, shared with the read-ahead workers (locked by m_cacheLock).
+	// m_zlibBuffer holds the last frame decompressed on the reading thread.
+	FrameCache m_cache;
+	std::mutex m_cacheLock;
+
+	ReadAheadPool m_readAhead;
+	std::vector<Inflater> m_inflaters;
+	u32 m_readAheadBegin; // frames [m_readAheadBegin, m_readAheadNext) were already requested
+	u32 m_readAheadNext;
 
 	// The result of a read is stored here between BeginRead() and FinishRead().
 	int m_bytesRead;
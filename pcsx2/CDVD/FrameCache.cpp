@@ -0,0 +1,213 @@
+/*  PCSX2 - PS2 Emulator for PCs
+*  Copyright (C) 2002-2021  PCSX2 Dev Team
+*
+*  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+*  of the GNU Lesser General Public License as published by the Free Software Found-
+*  ation, either version 3 of the License, or (at your option) any later version.
+*
+*  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+*  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+*  PURPOSE.  See the GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License along with PCSX2.
+*  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PrecompiledHeader.h"
+#include "FrameCache.h"
+
+FrameCache::FrameCache(uint limitMb)
+	: m_limit((u64)limitMb * 1024 * 1024)
+	, m_frameSize(0)
+	, m_numSlots(0)
+	, m_hashMask(0)
+	, m_hashShift(0)
+	, m_arena(NULL)
+	, m_slots(NULL)
+	, m_table(NULL)
+	, m_hand(0)
+	, m_pending(EMPTY)
+	, m_lastSlot(EMPTY)
+	, m_hits(0)
+	, m_misses(0)
+{
+}
+
+bool FrameCache::Init(u32 frameSize)
+{
+	Free();
+
+	// Keep a few frames even with huge frame sizes, so sequential reads still hit.
+	m_frameSize = frameSize;
+	m_numSlots = (u32)std::max<u64>(m_limit / frameSize, 4);
+
+	// At most 50% load factor keeps the probe sequences short.
+	u32 tableSize = 1;
+	m_hashShift = 64;
+	while (tableSize < m_numSlots * 2)
+	{
+		tableSize <<= 1;
+		m_hashShift--;
+	}
+	m_hashMask = tableSize - 1;
+
+	m_arena = (u8*)_aligned_malloc((size_t)m_numSlots * frameSize, 64);
+	m_slots = new Slot[m_numSlots];
+	m_table = new u32[tableSize];
+	if (!m_arena)
+	{
+		Console.Warning("Unable to allocate %u MB for the decompressed frame cache.", (uint)(m_limit / _1mb));
+		Free();
+		return false;
+	}
+
+	Clear();
+	return true;
+}
+
+void FrameCache::Free()
+{
+	safe_aligned_free(m_arena);
+	safe_delete_array(m_slots);
+	safe_delete_array(m_table);
+	m_numSlots = 0;
+	m_hits = m_misses = 0;
+}
+
+void FrameCache::Clear()
+{
+	if (!m_arena)
+		return;
+
+	memset(m_table, 0xFF, (m_hashMask + 1) * sizeof(u32));
+	for (u32 i = 0; i < m_numSlots; i++)
+	{
+		m_slots[i].used = false;
+		m_slots[i].referenced = false;
+	}
+	m_hand = 0;
+	m_pending = EMPTY;
+	m_lastSlot = EMPTY;
+}
+
+u32 FrameCache::FindPos(u64 frame) const
+{
+	for (u32 pos = Home(frame);; pos = (pos + 1) & m_hashMask)
+	{
+		const u32 slot = m_table[pos];
+		if (slot == EMPTY || m_slots[slot].frame == frame)
+			return pos;
+	}
+}
+
+const u8* FrameCache::Find(u64 frame, u32* size)
+{
+	if (!m_arena)
+		return NULL;
+
+	u32 slot = m_lastSlot;
+	if (slot == EMPTY || !m_slots[slot].used || m_slots[slot].frame != frame)
+	{
+		slot = m_table[FindPos(frame)];
+		if (slot == EMPTY)
+			return NULL;
+		m_lastSlot = slot;
+	}
+
+	m_slots[slot].referenced = true;
+	if (size)
+		*size = m_slots[slot].size;
+	return m_arena + (size_t)slot * m_frameSize;
+}
+
+const u8* FrameCache::Lookup(u64 frame, u32* size)
+{
+	if (!m_arena)
+		return NULL;
+
+	const u8* data = Find(frame, size);
+	if (data)
+		m_hits++;
+	else
+		m_misses++;
+	return data;
+}
+
+// Removes a slot from the table, shifting back the following entries of the cluster
+// so no tombstones are needed.
+void FrameCache::Unlink(u32 slot)
+{
+	u32 hole = FindPos(m_slots[slot].frame);
+	m_slots[slot].used = false;
+
+	for (u32 pos = (hole + 1) & m_hashMask;; pos = (pos + 1) & m_hashMask)
+	{
+		const u32 other = m_table[pos];
+		if (other == EMPTY)
+			break;
+
+		// Move the entry into the hole unless its home lies cyclically in (hole, pos].
+		const u32 home = Home(m_slots[other].frame);
+		if (((pos - home) & m_hashMask) >= ((pos - hole) & m_hashMask))
+		{
+			m_table[hole] = other;
+			hole = pos;
+		}
+	}
+	m_table[hole] = EMPTY;
+}
+
+u8* FrameCache::Reserve()
+{
+	if (!m_arena)
+		return NULL;
+
+	// CLOCK: skip (and clear) recently referenced slots, evict the first one which isn't.
+	for (;;)
+	{
+		Slot& s = m_slots[m_hand];
+		const u32 slot = m_hand;
+		m_hand = (m_hand + 1 == m_numSlots) ? 0 : m_hand + 1;
+
+		if (s.used && s.referenced)
+		{
+			s.referenced = false;
+			continue;
+		}
+
+		if (s.used)
+			Unlink(slot);
+
+		m_pending = slot;
+		return m_arena + (size_t)slot * m_frameSize;
+	}
+}
+
+void FrameCache::Commit(u64 frame, u32 size)
+{
+	pxAssert(m_pending != EMPTY && size <= m_frameSize);
+
+	const u32 slot = m_pending;
+	m_pending = EMPTY;
+
+	const u32 pos = FindPos(frame);
+	if (m_table[pos] != EMPTY)
+		Unlink(m_table[pos]);
+
+	Slot& s = m_slots[slot];
+	s.frame = frame;
+	s.size = size;
+	s.used = true;
+	s.referenced = false;
+	m_table[FindPos(frame)] = slot;
+}
+
+void FrameCache::Store(u64 frame, const void* data, u32 size)
+{
+	u8* dest = Reserve();
+	if (!dest)
+		return;
+
+	memcpy(dest, data, size);
+	Commit(frame, size);
+}
@@ -0,0 +1,103 @@
+/*  PCSX2 - PS2 Emulator for PCs
+*  Copyright (C) 2002-2021  PCSX2 Dev Team
+*
+*  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+*  of the GNU Lesser General Public License as published by the Free Software Found-
+*  ation, either version 3 of the License, or (at your option) any later version.
+*
+*  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+*  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+*  PURPOSE.  See the GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License along with PCSX2.
+*  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "CompressedFileReaderUtils.h"
+
+// Cache for decompressed frames of compressed ISO formats (CSO frames, gzip chunks).
+//
+// All frames have the same size and are keyed by their frame index, so the cache can
+// live in a single arena which is allocated once per opened file.  Lookups go through a
+// small open-addressed (linear probing) table, and eviction uses the CLOCK algorithm,
+// so neither a hit nor a miss allocates or walks a list.
+//
+// The cache isn't thread safe, readers with read-ahead workers need to lock around it.
+class FrameCache
+{
+	DeclareNoncopyableObject(FrameCache);
+
+public:
+	FrameCache(uint limitMb);
+	~FrameCache() { Free(); }
+
+	// Allocates the arena for frames of frameSize bytes. Returns false if out of memory.
+	bool Init(u32 frameSize);
+	void Free();
+
+	// Drops all cached frames, but keeps the arena.
+	void Clear();
+
+	bool IsEnabled() const { return m_arena != NULL; }
+	u32 GetFrameSize() const { return m_frameSize; }
+
+	// Returns the cached data of the frame, or NULL. size receives the number of valid
+	// bytes in the frame (can be less than the frame size at the end of the file).
+	const u8* Lookup(u64 frame, u32* size = NULL);
+
+	// Same as Lookup(), but doesn't count towards the hit/miss statistics.
+	const u8* Find(u64 frame, u32* size = NULL);
+
+	// Evicts a slot and returns its buffer, to be filled by the caller and then published
+	// with Commit(). Nothing is cached if Commit() is not called (failed decompression).
+	u8* Reserve();
+	void Commit(u64 frame, u32 size);
+
+	// Copies size bytes of data into the cache as the given frame.
+	void Store(u64 frame, const void* data, u32 size);
+
+	u64 GetHits() const { return m_hits; }
+	u64 GetMisses() const { return m_misses; }
+	void ResetStats() { m_hits = m_misses = 0; }
+
+	static int CopyAvailable(const void* pSrc, PX_off_t srcOffset, int srcSize,
+							 void* pDst, PX_off_t dstOffset, int maxCopySize)
+	{
+		int available = std::min(maxCopySize, std::max(0, (int)(srcOffset + srcSize - dstOffset)));
+		memcpy(pDst, (const u8*)pSrc + (dstOffset - srcOffset), available);
+		return available;
+	}
+
+private:
+	struct Slot
+	{
+		u64 frame;
+		u32 size;
+		bool used;
+		bool referenced;
+	};
+
+	static const u32 EMPTY = 0xFFFFFFFF;
+
+	u32 Home(u64 frame) const { return (u32)((frame * 0x9E3779B97F4A7C15ull) >> m_hashShift); }
+	u32 FindPos(u64 frame) const;
+	void Unlink(u32 slot);
+
+	u64 m_limit;
+	u32 m_frameSize;
+	u32 m_numSlots;
+	u32 m_hashMask;
+	u8 m_hashShift;
+
+	u8* m_arena;     // m_numSlots frames of m_frameSize bytes
+	Slot* m_slots;
+	u32* m_table;    // open-addressed frame -> slot table, m_hashMask + 1 entries
+	u32 m_hand;      // CLOCK hand
+	u32 m_pending;   // slot returned by Reserve(), EMPTY if none
+	u32 m_lastSlot;  // most recent hit, readers usually hit the same frame repeatedly
+
+	u64 m_hits;
+	u64 m_misses;
+};
@@ -17,7 +17,7 @@
 #include <fstream>
 #include <wx/stdpaths.h>
 #include "AppConfig.h"
-#include "ChunksCache.h"
+#include "FrameCache.h"
 #include "CompressedFileReaderUtils.h"
 #include "GzippedFileReader.h"
 #include "zlib_indexed.h"
@@ -194,6 +194,8 @@ GzippedFileReader::GzippedFileReader(void)
 	, m_zstates(0)
 	, m_src(0)
 	, m_cache(GZFILE_CACHE_SIZE_MB)
+	, m_readAheadBegin(0)
+	, m_readAheadNext(0)
 {
 	m_blocksize = 2048;
 	AsyncPrefetchReset();
@@ -362,6 +364,14 @@ bool GzippedFileReader::Open(const wxString& fileName)
 	};
 
 	AsyncPrefetchOpen();
+
+	// Extraction has to be sequential within a span, so a single worker extracts the
+	// chunks following sequential reads while the emulator consumes the current one.
+	if (m_cache.Init(GZFILE_READ_CHUNK_SIZE))
+	{
+		m_readAheadBegin = m_readAheadNext = 0;
+		m_readAhead.Start(1, [this](uint, u64 chunk) { ReadAheadChunk(chunk); });
+	}
 	return true;
 };
 
@@ -434,12 +444,94 @@ int GzippedFileReader::_ReadSync(void* pBuffer, PX_off_t offset, uint bytesToRea
 
 	// From here onwards it's guarenteed that the request is inside a single GZFILE_READ_CHUNK_SIZE boundaries
 
-	int res = m_cache.Read(pBuffer, offset, bytesToRead);
-	if (res >= 0)
-		return res;
+	const u64 chunk = offset / GZFILE_READ_CHUNK_SIZE;
+	{
+		std::lock_guard<std::mutex> guard(m_cacheLock);
+		int res = ReadFromCache(pBuffer, offset, bytesToRead, true);
+		if (res >= 0)
+			return res;
+	}
+
+	// The read-ahead worker might be extracting it right now.
+	if (m_readAhead.Claim(chunk))
+	{
+		std::lock_guard<std::mutex> guard(m_cacheLock);
+		int res = ReadFromCache(pBuffer, offset, bytesToRead, false);
+		if (res >= 0)
+			return res;
+	}
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	{
+		// Might have been extracted together with a previous read-ahead chunk.
+		std::lock_guard<std::mutex> guard(m_cacheLock);
+		int res = ReadFromCache(pBuffer, offset, bytesToRead, false);
+		if (res >= 0)
+			return res;
+	}
+	return ExtractChunks(pBuffer, offset, bytesToRead);
+}
+
+void GzippedFileReader::ReadAheadChunk(u64 chunk)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	{
+		std::lock_guard<std::mutex> guard(m_cacheLock);
+		if (m_cache.Find(chunk))
+			return;
+	}
+
+	u8 dummy;
+	ExtractChunks(&dummy, chunk * GZFILE_READ_CHUNK_SIZE, 1);
+}
+
+void GzippedFileReader::ReadAhead(uint sector, uint count)
+{
+	if (!m_readAhead.IsRunning() || !count)
+		return;
+
+	const PX_off_t offset = (s64)sector * m_blocksize + m_dataoffset;
+	const PX_off_t end = std::min<PX_off_t>(offset + (s64)count * m_blocksize, m_pIndex->uncompressed_size);
+	if (offset >= end)
+		return;
+
+	const u64 first = offset / GZFILE_READ_CHUNK_SIZE;
+	const u64 last = (end - 1) / GZFILE_READ_CHUNK_SIZE;
+
+	// Sequential reads slide the window forward, only queue the chunks which entered it.
+	u64 chunk = first;
+	if (first >= m_readAheadBegin && first < m_readAheadNext)
+	{
+		chunk = m_readAheadNext;
+	}
+	else
+	{
+		m_readAhead.Cancel();
+		m_readAheadBegin = m_readAheadNext = first;
+	}
+
+	for (; chunk <= last; chunk++)
+		m_readAhead.Request(chunk);
+	m_readAheadNext = std::max(m_readAheadNext, last + 1);
+}
+
+int GzippedFileReader::ReadFromCache(void* pBuffer, PX_off_t offset, uint bytesToRead, bool countStats)
+{
+	u32 cachedSize;
+	const u64 chunk = offset / GZFILE_READ_CHUNK_SIZE;
+	const u8* cached = countStats ? m_cache.Lookup(chunk, &cachedSize) : m_cache.Find(chunk, &cachedSize);
+	if (!cached)
+		return -1;
+
+	return FrameCache::CopyAvailable(cached, chunk * GZFILE_READ_CHUNK_SIZE, cachedSize, pBuffer, offset, bytesToRead);
+}
+
+// Decompress from optimal starting point in GZFILE_READ_CHUNK_SIZE chunks and cache each chunk.
+// The request must be inside a single chunk. Must be called with m_lock held.
+int GzippedFileReader::ExtractChunks(void* pBuffer, PX_off_t offset, uint bytesToRead)
+{
+	uint maxInChunk = GZFILE_READ_CHUNK_SIZE - offset % GZFILE_READ_CHUNK_SIZE;
 
-	// Not available from cache. Decompress from optimal starting
-	// point in GZFILE_READ_CHUNK_SIZE chunks and cache each chunk.
 	PTT s = NOW();
 	PX_off_t extractOffset = GetOptimalExtractionStart(offset); // guaranteed in GZFILE_READ_CHUNK_SIZE boundaries
 	int size = offset + maxInChunk - extractOffset;
@@ -448,7 +540,7 @@ int GzippedFileReader::_ReadSync(void* pBuffer, PX_off_t offset, uint bytesToRea
 	int span = m_pIndex->span;
 	int spanix = extractOffset / span;
 	AsyncPrefetchCancel();
-	res = extract(m_src, m_pIndex, extractOffset, extracted, size, &(m_zstates[spanix].state));
+	int res = extract(m_src, m_pIndex, extractOffset, extracted, size, &(m_zstates[spanix].state));
 	if (res < 0)
 	{
 		free(extracted);
@@ -456,7 +548,7 @@ int GzippedFileReader::_ReadSync(void* pBuffer, PX_off_t offset, uint bytesToRea
 	}
 	AsyncPrefetchChunk(getInOffset(&(m_zstates[spanix].state)));
 
-	int copied = ChunksCache::CopyAvailable(extracted, extractOffset, res, pBuffer, offset, bytesToRead);
+	int copied = FrameCache::CopyAvailable(extracted, extractOffset, res, pBuffer, offset, bytesToRead);
 
 	if (m_zstates[spanix].state.isValid && (extractOffset + res) / span != offset / span)
 	{
@@ -473,20 +565,16 @@ int GzippedFileReader::_ReadSync(void* pBuffer, PX_off_t offset, uint bytesToRea
 		m_zstates[spanix].Kill();
 	}
 
-	if (size <= GZFILE_READ_CHUNK_SIZE)
-		m_cache.Take(extracted, extractOffset, res, size);
-	else
-	{ // split into cacheable chunks
+	// split into cacheable chunks
+	{
+		std::lock_guard<std::mutex> guard(m_cacheLock);
 		for (int i = 0; i < size; i += GZFILE_READ_CHUNK_SIZE)
 		{
 			int available = CLAMP(res - i, 0, GZFILE_READ_CHUNK_SIZE);
-			void* chunk = available ? malloc(available) : 0;
-			if (available)
-				memcpy(chunk, extracted + i, available);
-			m_cache.Take(chunk, extractOffset + i, available, std::min(size - i, GZFILE_READ_CHUNK_SIZE));
+			m_cache.Store((extractOffset + i) / GZFILE_READ_CHUNK_SIZE, extracted + i, available);
 		}
-		free(extracted);
 	}
+	free(extracted);
 
 	int duration = NOW() - s;
 	if (duration > 10)
@@ -501,6 +589,8 @@ int GzippedFileReader::_ReadSync(void* pBuffer, PX_off_t offset, uint bytesToRea
 
 void GzippedFileReader::Close()
 {
+	m_readAhead.Stop();
+
 	m_filename.Empty();
 	if (m_pIndex)
 	{
@@ -509,7 +599,13 @@ void GzippedFileReader::Close()
 	}
 
 	InitZstates(); // results in delete because no index
-	m_cache.Clear();
+
+	const u64 lookups = m_cache.GetHits() + m_cache.GetMisses();
+	if (lookups)
+		DevCon.WriteLn(Color_Gray, "gzip chunk cache: %llu hits, %llu misses (%.1f%% hit rate)",
+					   (unsigned long long)m_cache.GetHits(), (unsigned long long)m_cache.GetMisses(),
+					   100.0 * m_cache.GetHits() / lookups);
+	m_cache.Free();
 
 	if (m_src)
 	{
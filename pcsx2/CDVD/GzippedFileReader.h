@@ -18,7 +18,8 @@
 typedef struct zstate Zstate;
 
 #include "AsyncFileReader.h"
-#include "ChunksCache.h"
+#include "FrameCache.h"
+#include "ReadAheadPool.h"
 #include "zlib_indexed.h"
 
 #define GZFILE_SPAN_DEFAULT (1048576L * 4)  /* distance between direct access points when creating a new index */
@@ -43,6 +44,8 @@ public:
 	virtual int FinishRead(void);
 	virtual void CancelRead(void){};
 
+	virtual void ReadAhead(uint sector, uint count);
+
 	virtual void Close(void);
 
 	virtual uint GetBlockCount(void) const
@@ -73,6 +76,9 @@ private:
 	bool OkIndex(); // Verifies that we have an index, or try to create one
 	PX_off_t GetOptimalExtractionStart(PX_off_t offset);
 	int _ReadSync(void* pBuffer, PX_off_t offset, uint bytesToRead);
+	int ReadFromCache(void* pBuffer, PX_off_t offset, uint bytesToRead, bool countStats);
+	int ExtractChunks(void* pBuffer, PX_off_t offset, uint bytesToRead);
+	void ReadAheadChunk(u64 chunk);
 	void InitZstates();
 
 	int mBytesRead;   // Temp sync read result when simulating async read
@@ -80,7 +86,15 @@ private:
 	Czstate* m_zstates;
 	FILE* m_src;
 
-	ChunksCache m_cache;
+	// Protects the zlib states, the index and m_src against the read-ahead worker.
+	std::mutex m_lock;
+
+	FrameCache m_cache; // extracted GZFILE_READ_CHUNK_SIZE chunks, keyed by chunk index
+	std::mutex m_cacheLock;
+
+	ReadAheadPool m_readAhead;
+	u64 m_readAheadBegin; // chunks [m_readAheadBegin, m_readAheadNext) were already requested
+	u64 m_readAheadNext;
 
 #ifdef _WIN32
 	// Used by async prefetch
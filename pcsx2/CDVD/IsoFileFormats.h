@@ -41,6 +41,9 @@ class InputIsoFile
 
 	static const uint MaxReadUnit = 128;
 
+	// Number of sectors hinted to the reader ahead of sequential reads (512KB of 2048 bytes sectors).
+	static const uint ReadAheadSectors = 256;
+
 protected:
 	uint ReadUnit;
 
@@ -97,6 +100,8 @@ protected:
 	void FindParts();
 };
 
+extern void BenchmarkIsoRead(const wxString& srcfile);
+
 class OutputIsoFile
 {
 	DeclareNoncopyableObject(OutputIsoFile);
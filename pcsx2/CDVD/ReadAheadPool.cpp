@@ -0,0 +1,112 @@
+/*  PCSX2 - PS2 Emulator for PCs
+*  Copyright (C) 2002-2021  PCSX2 Dev Team
+*
+*  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+*  of the GNU Lesser General Public License as published by the Free Software Found-
+*  ation, either version 3 of the License, or (at your option) any later version.
+*
+*  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+*  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+*  PURPOSE.  See the GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License along with PCSX2.
+*  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PrecompiledHeader.h"
+#include "ReadAheadPool.h"
+
+#include <algorithm>
+
+ReadAheadPool::ReadAheadPool()
+	: m_quit(false)
+{
+}
+
+void ReadAheadPool::Start(uint threads, const Job& job)
+{
+	Stop();
+
+	m_job = job;
+	m_quit = false;
+	for (uint i = 0; i < threads; i++)
+		m_threads.emplace_back(&ReadAheadPool::WorkerThread, this, i);
+}
+
+void ReadAheadPool::Stop()
+{
+	if (m_threads.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_quit = true;
+		m_queue.clear();
+	}
+	m_wake.notify_all();
+
+	for (std::thread& t : m_threads)
+		t.join();
+	m_threads.clear();
+	m_running.clear();
+}
+
+void ReadAheadPool::Request(u64 unit)
+{
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		if (std::find(m_queue.begin(), m_queue.end(), unit) != m_queue.end() ||
+			std::find(m_running.begin(), m_running.end(), unit) != m_running.end())
+			return;
+
+		m_queue.push_back(unit);
+	}
+	m_wake.notify_one();
+}
+
+void ReadAheadPool::Cancel()
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	m_queue.clear();
+}
+
+bool ReadAheadPool::Claim(u64 unit)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	auto queued = std::find(m_queue.begin(), m_queue.end(), unit);
+	if (queued != m_queue.end())
+	{
+		m_queue.erase(queued);
+		return false;
+	}
+
+	if (std::find(m_running.begin(), m_running.end(), unit) == m_running.end())
+		return false;
+
+	m_done.wait(lock, [&] { return std::find(m_running.begin(), m_running.end(), unit) == m_running.end(); });
+	return true;
+}
+
+void ReadAheadPool::WorkerThread(uint worker)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+
+	while (true)
+	{
+		m_wake.wait(lock, [&] { return m_quit || !m_queue.empty(); });
+		if (m_quit)
+			break;
+
+		const u64 unit = m_queue.front();
+		m_queue.pop_front();
+		m_running.push_back(unit);
+
+		lock.unlock();
+		m_job(worker, unit);
+		lock.lock();
+
+		m_running.erase(std::find(m_running.begin(), m_running.end(), unit));
+		m_done.notify_all();
+	}
+}
@@ -0,0 +1,71 @@
+/*  PCSX2 - PS2 Emulator for PCs
+*  Copyright (C) 2002-2021  PCSX2 Dev Team
+*
+*  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+*  of the GNU Lesser General Public License as published by the Free Software Found-
+*  ation, either version 3 of the License, or (at your option) any later version.
+*
+*  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+*  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+*  PURPOSE.  See the GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License along with PCSX2.
+*  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small pool of worker threads used by the compressed ISO readers to decompress the
+// frames/chunks following a sequential read before they're requested, so the CDVD
+// thread finds them in the reader's cache instead of waiting for inflate.
+//
+// Work items are plain unit indices (a CSO frame, a gzip chunk); the reader supplies the
+// function which decompresses one unit and caches it.  The function also receives the
+// index of the worker running it, so readers can keep per-worker zlib state.
+class ReadAheadPool
+{
+	DeclareNoncopyableObject(ReadAheadPool);
+
+public:
+	typedef std::function<void(uint worker, u64 unit)> Job;
+
+	ReadAheadPool();
+	~ReadAheadPool() { Stop(); }
+
+	void Start(uint threads, const Job& job);
+	void Stop();
+
+	bool IsRunning() const { return !m_threads.empty(); }
+	uint GetThreadCount() const { return (uint)m_threads.size(); }
+
+	// Queues a unit, unless it's already queued or being processed.
+	void Request(u64 unit);
+
+	// Drops all queued units (units already being processed are completed).
+	void Cancel();
+
+	// Called by the reader before processing a unit itself: removes it from the queue,
+	// or waits for it to complete if a worker is processing it.  Returns true if the
+	// unit was completed by a worker.
+	bool Claim(u64 unit);
+
+private:
+	void WorkerThread(uint worker);
+
+	std::vector<std::thread> m_threads;
+	Job m_job;
+
+	std::mutex m_lock;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	std::deque<u64> m_queue;
+	std::vector<u64> m_running;
+	bool m_quit;
+};
@@ -17,6 +17,7 @@
 #include "PrecompiledHeader.h"
 #include "Common.h"
 #include "COP0.h"
+#include "Cache.h"
 
 u32 s_iLastCOP0Cycle = 0;
 u32 s_iLastPERFCycle[2] = { 0, 0 };
@@ -326,6 +327,7 @@ void WriteTLB(int i)
 	tlb[i].S = cpuRegs.CP0.n.EntryLo0&0x80000000;
 
 	MapTLB(i);
+	updateCachedPages();
 }
 
 namespace R5900 {
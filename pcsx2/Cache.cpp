@@ -49,8 +49,8 @@ namespace
 
 		enum Flags : decltype(rawValue)
 		{
-			DIRTY_FLAG = 0x40,
-			VALID_FLAG = 0x20,
+			DIRTY_FLAG = CacheTagDirty,
+			VALID_FLAG = CacheTagValid,
 			LRF_FLAG = 0x10,
 			LOCK_FLAG = 0x8,
 			ALL_FLAGS = 0xFFF
@@ -138,15 +138,15 @@ namespace
 		}
 	};
 
-	struct CacheSet
-	{
-		CacheTag tags[2];
-		CacheData data[2];
-	};
+	typedef CacheTag CacheSetTags[2];
 
-	struct Cache
+	// The tags are kept apart from the line data, so the two ways of a set share 16 bytes
+	// and the whole tag array fits in a few host cache lines.  The recompiler's inline
+	// lookup depends on this layout (see Cache.h).
+	struct alignas(64) Cache
 	{
-		CacheSet sets[64];
+		CacheSetTags tags[64];
+		CacheData data[64][2];
 
 		int setIdxFor(u32 vaddr) const
 		{
@@ -155,24 +155,56 @@ namespace
 
 		CacheLine lineAt(int idx, int way)
 		{
-			return { sets[idx].tags[way], sets[idx].data[way], idx };
+			return { tags[idx][way], data[idx][way], idx };
 		}
 	};
 
+	static_assert(sizeof(CacheTag) == sizeof(uptr), "Cache tags must be a single uptr");
+	static_assert(offsetof(Cache, data) == CacheDataOffset, "Cache data offset mismatch");
+
 	static Cache cache;
 
 }
 
+u8 cachedPageMap[0x100000];
+
+static void markCachedPages(u32 pfn, u32 mask)
+{
+	const u32 last = (u32)(std::min<u64>((u64)pfn + mask, 0xFFFFFFFFULL) >> 12);
+
+	for (u32 page = pfn >> 12; page <= last; page++)
+		cachedPageMap[page] = 1;
+}
+
+void updateCachedPages()
+{
+	memzero(cachedPageMap);
+
+	for (int i = 1; i < 48; i++)
+	{
+		if (((tlb[i].EntryLo0 & 0x38) >> 3) == 0x3)
+			markCachedPages(tlb[i].PFN0, tlb[i].PageMask);
+		if (((tlb[i].EntryLo1 & 0x38) >> 3) == 0x3)
+			markCachedPages(tlb[i].PFN1, tlb[i].PageMask);
+	}
+}
+
+void* getCacheBase()
+{
+	return &cache;
+}
+
 void resetCache()
 {
 	memzero(cache);
+	updateCachedPages();
 }
 
-static bool findInCache(const CacheSet& set, uptr ppf, int* way)
+static bool findInCache(const CacheSetTags& tags, uptr ppf, int* way)
 {
 	auto check = [&](int checkWay) -> bool
 	{
-		if (!set.tags[checkWay].matches(ppf))
+		if (!tags[checkWay].matches(ppf))
 			return false;
 
 		*way = checkWay;
@@ -185,7 +217,7 @@ static bool findInCache(const CacheSet& set, uptr ppf, int* way)
 static int getFreeCache(u32 mem, int* way)
 {
 	const int setIdx = cache.setIdxFor(mem);
-	CacheSet& set = cache.sets[setIdx];
+	CacheSetTags& tags = cache.tags[setIdx];
 	VTLBVirtual vmv = vtlbdata.vmap[mem >> VTLB_PAGE_BITS];
 	pxAssertMsg(!vmv.isHandler(mem), "Cache currently only supports non-handler addresses!");
 	uptr ppf = vmv.assumePtr(mem);
@@ -193,14 +225,14 @@ static int getFreeCache(u32 mem, int* way)
 	if((cpuRegs.CP0.n.Config & 0x10000) == 0)
 		CACHE_LOG("Cache off!");
 
-	if (findInCache(set, ppf, way))
+	if (findInCache(tags, ppf, way))
 	{
-		if (set.tags[*way].isLocked())
+		if (tags[*way].isLocked())
 			CACHE_LOG("Index %x Way %x Locked!!", setIdx, *way);
 	}
 	else
 	{
-		int newWay = set.tags[0].lrf() ^ set.tags[1].lrf();
+		int newWay = tags[0].lrf() ^ tags[1].lrf();
 		*way = newWay;
 		CacheLine line = cache.lineAt(setIdx, newWay);
 
@@ -295,18 +327,18 @@ template <typename Op>
 void doCacheHitOp(u32 addr, const char* name, Op op)
 {
 	const int index = cache.setIdxFor(addr);
-	CacheSet& set = cache.sets[index];
+	CacheSetTags& tags = cache.tags[index];
 	VTLBVirtual vmv = vtlbdata.vmap[addr >> VTLB_PAGE_BITS];
 	uptr ppf = vmv.assumePtr(addr);
 	int way;
 
-	if (!findInCache(set, ppf, &way))
+	if (!findInCache(tags, ppf, &way))
 	{
-		CACHE_LOG("CACHE %s NO HIT addr %x, index %d, tag0 %zx tag1 %zx", name, addr, index, set.tags[0].rawValue, set.tags[1].rawValue);
+		CACHE_LOG("CACHE %s NO HIT addr %x, index %d, tag0 %zx tag1 %zx", name, addr, index, tags[0].rawValue, tags[1].rawValue);
 		return;
 	}
 
-	CACHE_LOG("CACHE %s addr %x, index %d, way %d, flags %x OP %x", name, addr, index, way, set.tags[way].flags(), cpuRegs.code);
+	CACHE_LOG("CACHE %s addr %x, index %d, way %d, flags %x OP %x", name, addr, index, way, tags[way].flags(), cpuRegs.code);
 
 	op(cache.lineAt(index, way));
 }
@@ -18,6 +18,22 @@
 
 #include "Common.h"
 
+// Layout shared with the recompiler's inline cache lookup (see recVTLB.cpp).  The tags of
+// the two ways of a set are adjacent uptrs at getCacheBase() + set*16 + way*8, holding the
+// host address of the line (& CacheTagAddrMask) and its flags.  The line data itself sits
+// at getCacheBase() + CacheDataOffset + (tag offset)*8.
+static const uint CacheDataOffset = 64 * 2 * sizeof(uptr);
+static const uptr CacheTagAddrMask = ~(uptr)0xFFF;
+static const uptr CacheTagDirty = 0x40;
+static const uptr CacheTagValid = 0x20;
+
+// Non-zero for each 4k page covered by a cached TLB entry (used by CheckCache).  Rebuilt
+// by updateCachedPages() whenever the TLB changes.
+extern u8 cachedPageMap[0x100000];
+
+void updateCachedPages();
+void* getCacheBase();
+
 void resetCache();
 void writeCache8(u32 mem, u8 value);
 void writeCache16(u32 mem, u16 value);
@@ -194,24 +194,29 @@ struct Pcsx2Config
 		BITFIELD32()
 			bool
 				Enabled:1,			// universal toggle for the profiler.
-				RecBlocks_EE:1,		// Enables per-block profiling for the EE recompiler [unimplemented]
-				RecBlocks_IOP:1,	// Enables per-block profiling for the IOP recompiler [unimplemented]
-				RecBlocks_VU0:1,	// Enables per-block profiling for the VU0 recompiler [unimplemented]
-				RecBlocks_VU1:1;	// Enables per-block profiling for the VU1 recompiler [unimplemented]
+				RecBlocks_EE:1,		// Enables per-block profiling for the EE recompiler
+				RecBlocks_IOP:1,	// Enables per-block profiling for the IOP recompiler
+				RecBlocks_VU0:1,	// Enables per-block profiling for the VU0 recompiler
+				RecBlocks_VU1:1,	// Enables per-block profiling for the VU1 recompiler
+				Pipeline:1,			// Enables the MTGS/MTVU stall statistics (see PipelineStats.h)
+				Timeline:1;			// Enables the timeline capture (see Timeline.h)
 		BITFIELD_END
 
+		u32		TimelineFirstFrame;	// Frame the timeline capture starts at
+		u32		TimelineFrames;		// Frames captured
+
 		// Default is Disabled, with all recs enabled underneath.
-		ProfilerOptions() : bitset( 0xfffffffe ) {}
+		ProfilerOptions() : bitset( 0xfffffffe ), TimelineFirstFrame( 600 ), TimelineFrames( 10 ) {}
 		void LoadSave( IniInterface& conf );
 
 		bool operator ==( const ProfilerOptions& right ) const
 		{
-			return OpEqu( bitset );
+			return OpEqu( bitset ) && OpEqu( TimelineFirstFrame ) && OpEqu( TimelineFrames );
 		}
 
 		bool operator !=( const ProfilerOptions& right ) const
 		{
-			return !OpEqu( bitset );
+			return !this->operator ==( right );
 		}
 	};
 
@@ -246,6 +251,16 @@ struct Pcsx2Config
 				PreBlockCheckIOP:1;
 			bool
 				EnableEECache   :1;
+			bool
+				EnableVUProgramCache:1,
+				VUBackgroundCompile:1;
+			bool
+				EESubPageProtection:1,
+				EESuperblocks	:1,
+				EEGenerationalCache:1,
+				EEFastmem		:1;
+			bool
+				IOPBlockAnalysis:1;
 		BITFIELD_END
 
 		RecompilerOptions();
@@ -297,6 +312,13 @@ struct Pcsx2Config
 
 		int		VsyncQueueSize;
 
+		// Synchronizes the MTGS ring with atomics only: both threads spin briefly before
+		// sleeping, and the EE batches its wakeups of a sleeping MTGS.
+		bool	LockFreeMTGS;
+
+		// MTGS ring buffer size as a power of 2, in qwords (applied when the MTGS starts).
+		int		RingBufferSizeFactor;
+
 		bool		FrameLimitEnable;
 		bool		FrameSkipEnable;
 		VsyncMode	VsyncEnable;
@@ -318,6 +340,8 @@ struct Pcsx2Config
 			return
 				OpEqu( SynchronousMTGS )		&&
 				OpEqu( VsyncQueueSize )			&&
+				OpEqu( LockFreeMTGS )			&&
+				OpEqu( RingBufferSizeFactor )	&&
 				
 				OpEqu( FrameSkipEnable )		&&
 				OpEqu( FrameLimitEnable )		&&
@@ -531,7 +555,14 @@ TraceLogFilters&				SetTraceConfig();
 #define CHECK_MICROVU1				(EmuConfig.Cpu.Recompiler.UseMicroVU1)
 #define CHECK_EEREC					(EmuConfig.Cpu.Recompiler.EnableEE && GetCpuProviders().IsRecAvailable_EE())
 #define CHECK_CACHE					(EmuConfig.Cpu.Recompiler.EnableEECache)
+#define CHECK_VU_PROGCACHE			(EmuConfig.Cpu.Recompiler.EnableVUProgramCache)
+#define CHECK_VU_BGCOMPILE			(EmuConfig.Cpu.Recompiler.VUBackgroundCompile)
+#define CHECK_EE_SUBPAGE			(EmuConfig.Cpu.Recompiler.EESubPageProtection)
+#define CHECK_EE_SUPERBLOCKS		(EmuConfig.Cpu.Recompiler.EESuperblocks)
+#define CHECK_EE_GENCACHE			(EmuConfig.Cpu.Recompiler.EEGenerationalCache)
+#define CHECK_EE_FASTMEM			(EmuConfig.Cpu.Recompiler.EEFastmem)
 #define CHECK_IOPREC				(EmuConfig.Cpu.Recompiler.EnableIOP && GetCpuProviders().IsRecAvailable_IOP())
+#define CHECK_IOP_ANALYSIS			(EmuConfig.Cpu.Recompiler.IOPBlockAnalysis)
 
 //------------ SPECIAL GAME FIXES!!! ---------------
 #define CHECK_VUADDSUBHACK			(EmuConfig.Gamefixes.VuAddSubHack)	 // Special Fix for Tri-ace games, they use an encryption algorithm that requires VU addi opcode to be bit-accurate.
@@ -27,6 +27,7 @@
 
 #include "GS.h"
 #include "VUmicro.h"
+#include "Timeline.h"
 
 #include "ps2/HwInternal.h"
 
@@ -444,6 +445,9 @@ static __fi void frameLimit()
 
 static __fi void VSyncStart(u32 sCycle)
 {
+	Timeline::VSync(g_FrameCount);
+	Timeline::Scope span(Timeline::Span_VSyncStart);
+
 	GetCoreThread().VsyncInThread();
 	Cpu->CheckExecutionState();
 
@@ -658,6 +662,8 @@ static __fi void _cpuTestOverflow( int i )
 // well forceinline it!
 __fi void rcntUpdate()
 {
+	Timeline::Scope span(Timeline::Span_rcntUpdate);
+
 	rcntUpdate_vSync();
 
 	// Update counters so that we can perform overflow and target tests.
@@ -18,6 +18,8 @@
 #include "Common.h"
 #include "System/SysThreads.h"
 #include "Gif.h"
+#include <condition_variable>
+#include <mutex>
 
 extern Fixed100 GetVerticalFrequency();
 extern __aligned16 u8 g_RealGSMem[Ps2MemSize::GSregs];
@@ -344,6 +346,22 @@ public:
 	// has more than one command in it when the thread is kicked.
 	int				m_CopyDataTally;
 
+	// Lock-free mode (EmuConfig.GS.LockFreeMTGS), latched when the MTGS starts.  The ring
+	// busy mutexes are unused then: the MTGS flags itself before sleeping on m_sem_event so
+	// the EE only posts when needed, and WaitGS sleeps on m_cv_Progress once it has spun
+	// for a while, which the MTGS only signals when someone registered in m_ProgressWaiters.
+	bool				m_LockFree;
+	std::atomic<bool>	m_GSSleeping;
+	std::atomic<int>	m_ProgressWaiters;
+	std::mutex			m_mtx_Progress;
+	std::condition_variable m_cv_Progress;
+
+	// Queued qwords before the EE wakes up a sleeping MTGS.  Fixed in the default mode,
+	// adapted at every vsync in lock-free mode.
+	uint			m_WakeThreshold;
+	uint			m_WakesThisFrame;
+	bool			m_StalledThisFrame;
+
 	Semaphore			m_sem_OpenDone;
 	std::atomic<bool>	m_PluginOpened;
 
@@ -354,6 +372,10 @@ public:
 	uint			m_packet_size;		// size of the packet (data only, ie. not including the 16 byte command!)
 	uint			m_packet_writepos;	// index of the data location in the ringbuffer.
 
+#ifdef __LIBRETRO__
+	bool			m_FlushingRing;		// set while FlushTaskInThread drains the ring outside of retro_run
+#endif
+
 #ifdef RINGBUF_DEBUG_STACK
 	Threading::Mutex m_lock_Stack;
 #endif
@@ -378,6 +400,7 @@ public:
 	void SendPointerPacket( MTGS_RingCommand type, u32 data0, void* data1 );
 
 	u8* GetDataPacketPtr() const;
+	uint GetRingUsed() const;
 	void SetEvent();
 	void PostVsyncStart();
 
@@ -385,6 +408,9 @@ public:
 
 	void ExecuteTaskInThread();
 	void FinishTaskInThread();
+#ifdef __LIBRETRO__
+	void FlushTaskInThread();
+#endif
 	void OpenPlugin();
 	void ClosePlugin();
 
@@ -399,6 +425,12 @@ protected:
 
 	void GenericStall( uint size );
 
+	// Lock-free mode helpers
+	void WakeGS();
+	void WaitForRingData();
+	void NotifyProgress();
+	template< typename Cond > void WaitForProgress( const Cond& done );
+
 	// Used internally by SendSimplePacket type functions
 	void _FinishSimplePacket();
 };
@@ -464,21 +496,27 @@ extern int g_nLeftGSFrames;
 #endif
 
 // Size of the ringbuffer as a power of 2 -- size is a multiple of simd128s.
-// (actual size is 1<<m_RingBufferSizeFactor simd vectors [128-bit values])
+// (actual size is 1<<EmuConfig.GS.RingBufferSizeFactor simd vectors [128-bit values],
+// clamped to the range below and applied when the MTGS starts)
 // A value of 19 is a 8meg ring buffer.  18 would be 4 megs, and 20 would be 16 megs.
 // Default was 2mb, but some games with lots of MTGS activity want 8mb to run fast (rama)
-static const uint RingBufferSizeFactor = 19;
+static const uint RingBufferSizeFactorMin = 16;
+static const uint RingBufferSizeFactorMax = 20;
+
+// Storage reserved for the largest ringbuffer, in simd128's.  Only the part in use is
+// ever touched, so the rest doesn't cost any memory.
+static const uint RingBufferMaxSize = 1<<RingBufferSizeFactorMax;
 
 // size of the ringbuffer in simd128's.
-static const uint RingBufferSize = 1<<RingBufferSizeFactor;
+extern uint RingBufferSize;
 
 // Mask to apply to ring buffer indices to wrap the pointer from end to
 // start (the wrapping is what makes it a ringbuffer, yo!)
-static const uint RingBufferMask = RingBufferSize - 1;
+extern uint RingBufferMask;
 
 struct MTGS_BufferedData
 {
-	u128		m_Ring[RingBufferSize];
+	u128		m_Ring[RingBufferMaxSize];
 	u8			Regs[Ps2MemSize::GSregs];
 
 	MTGS_BufferedData() {}
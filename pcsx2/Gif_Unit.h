@@ -156,10 +156,10 @@ static __fi void incTag(u32& offset, u32& size, u32 incAmount) {
 struct Gif_Path_MTVU {
 	u32   fakePackets; // Fake packets pending to be sent to MTGS
 	GS_Packet fakePacket;
-	// Set a size based on MTGS but keep a factor 2 to avoid too waste to much
-	// memory overhead. Note the struct is instantied 3 times (for each gif
-	// path)
-	ringbuffer_base<GS_Packet, RingBufferSize / 2> gsPackQueue;
+	// Set a size based on the largest MTGS ring but keep a factor 2 to avoid
+	// too waste to much memory overhead. Note the struct is instantied 3 times
+	// (for each gif path)
+	ringbuffer_base<GS_Packet, RingBufferMaxSize / 2> gsPackQueue;
 	Gif_Path_MTVU() { Reset(); }
 	void Reset()    { fakePackets = 0;
 		gsPackQueue.reset();
@@ -23,6 +23,8 @@
 #include "Gif_Unit.h"
 #include "MTVU.h"
 #include "Elfheader.h"
+#include "PipelineStats.h"
+#include "Timeline.h"
 
 
 // Uncomment this to enable profiling of the GS RingBufferCopy function.
@@ -41,8 +43,21 @@ using namespace Threading;
 // =====================================================================================================
 
 __aligned(32) MTGS_BufferedData RingBuffer;
+uint RingBufferSize = 1<<19;
+uint RingBufferMask = (1<<19) - 1;
 extern bool renderswitch;
 
+// Lock-free mode tuning.  Spins are pause instructions, a few dozen microseconds at most,
+// which is about how long the EE takes to follow up on a packet when it's busy drawing.
+static const uint MTGS_SpinCount = 1000;
+
+// Qwords queued before the EE wakes up a sleeping MTGS (always used in the default mode),
+// and how far the lock-free mode may lower it.  It gets raised (up to 1/16 of the ring)
+// once the MTGS is woken up more than MTGS_WakesPerFrame times in a frame.
+static const uint MTGS_WakeThreshold = 0x2000;
+static const uint MTGS_WakeThresholdMin = 0x400;
+static const uint MTGS_WakesPerFrame = 32;
+
 
 #ifdef RINGBUF_DEBUG_STACK
 #include <list>
@@ -80,6 +95,23 @@ void SysMtgsThread::OnStart()
 	m_SignalRingPosition  = 0;
 
 	m_CopyDataTally		= 0;
+#ifdef __LIBRETRO__
+	m_FlushingRing		= false;
+#endif
+
+	// The ring is empty at this point, so it can be resized.
+	const int sizeFactor = std::min<int>(std::max<int>(EmuConfig.GS.RingBufferSizeFactor, RingBufferSizeFactorMin), RingBufferSizeFactorMax);
+	RingBufferSize		= 1 << sizeFactor;
+	RingBufferMask		= RingBufferSize - 1;
+
+	m_LockFree			= EmuConfig.GS.LockFreeMTGS;
+	m_GSSleeping		= false;
+	m_ProgressWaiters	= 0;
+	m_WakeThreshold		= m_LockFree ? std::min(MTGS_WakeThreshold, RingBufferSize / 16) : MTGS_WakeThreshold;
+	m_WakesThisFrame	= 0;
+	m_StalledThisFrame	= false;
+
+	PipelineStats::Reset();
 
 	_parent::OnStart();
 }
@@ -146,6 +178,22 @@ void SysMtgsThread::PostVsyncStart()
 	// Vsyncs should always start the GS thread, regardless of how little has actually be queued.
 	if (m_CopyDataTally != 0) SetEvent();
 
+	// Lock-free mode: wake up the MTGS less often if it kept getting woken up during the last
+	// frame, and sooner again once the EE had to wait on a full ring.
+	if (m_LockFree)
+	{
+		if (m_StalledThisFrame)
+			m_WakeThreshold = std::max(m_WakeThreshold / 2, MTGS_WakeThresholdMin);
+		else if (m_WakesThisFrame > MTGS_WakesPerFrame)
+			m_WakeThreshold = std::min(m_WakeThreshold * 2, std::max(RingBufferSize / 16, MTGS_WakeThresholdMin));
+
+		m_WakesThisFrame   = 0;
+		m_StalledThisFrame = false;
+	}
+
+	if (PipelineStats::IsEnabled())
+		PipelineStats::EndFrame(GetRingUsed(), m_QueuedFrameCount.load(std::memory_order_relaxed));
+
 	// If the MTGS is allowed to queue a lot of frames in advance, it creates input lag.
 	// Use the Queued FrameCount to stall the EE if another vsync (or two) are already queued
 	// in the ringbuffer.  The queue limit is disabled when both FrameLimiting and Vsync are
@@ -168,6 +216,7 @@ void SysMtgsThread::PostVsyncStart()
 	// So let's ensure the ring doesn't sleep
 	m_sem_event.Post();
 
+	PipelineStats::ScopedStall stall(PipelineStats::Stall_GSVsync);
 	m_sem_Vsync.WaitNoCancel();
 }
 
@@ -244,6 +293,7 @@ void SysMtgsThread::OpenPlugin()
 	GSsetGameCRC( ElfCRC, 0 );
 }
 
+// Does nothing in lock-free mode: no mutexes are taken and the ring never gets flagged busy.
 class RingBufferLock {
 	ScopedLock     m_lock1;
 	ScopedLock     m_lock2;
@@ -252,10 +302,10 @@ class RingBufferLock {
 	public:
 
 	RingBufferLock(SysMtgsThread& mtgs)
-		: m_lock1(mtgs.m_mtx_RingBufferBusy),
-		  m_lock2(mtgs.m_mtx_RingBufferBusy2),
+		: m_lock1(mtgs.m_LockFree ? NULL : &mtgs.m_mtx_RingBufferBusy),
+		  m_lock2(mtgs.m_LockFree ? NULL : &mtgs.m_mtx_RingBufferBusy2),
 		  m_mtgs(mtgs) {
-		m_mtgs.m_RingBufferIsBusy.store(true, std::memory_order_relaxed);
+		m_mtgs.m_RingBufferIsBusy.store(!m_mtgs.m_LockFree, std::memory_order_relaxed);
 	}
 	virtual ~RingBufferLock() {
 		m_mtgs.m_RingBufferIsBusy.store(false, std::memory_order_relaxed);
@@ -263,7 +313,7 @@ class RingBufferLock {
 	void Acquire() {
 		m_lock1.Acquire();
 		m_lock2.Acquire();
-		m_mtgs.m_RingBufferIsBusy.store(true, std::memory_order_relaxed);
+		m_mtgs.m_RingBufferIsBusy.store(!m_mtgs.m_LockFree, std::memory_order_relaxed);
 	}
 	void Release() {
 		m_mtgs.m_RingBufferIsBusy.store(false, std::memory_order_relaxed);
@@ -287,6 +337,8 @@ void SysMtgsThread::ExecuteTaskInThread()
 	// Threading info: run in MTGS thread
 	// m_ReadPos is only update by the MTGS thread so it is safe to load it with a relaxed atomic
 
+	Timeline::SetThreadName("MTGS");
+
 #ifdef RINGBUF_DEBUG_STACK
 	PacketTagType prevCmd;
 #endif
@@ -304,17 +356,25 @@ void SysMtgsThread::ExecuteTaskInThread()
 		while (wxTheApp->HasPendingEvents())
 			wxTheApp->ProcessPendingEvents();
 
-		while (!m_sem_event.WaitWithoutYield(wxTimeSpan::Millisecond()))
+		if (!m_FlushingRing)
 		{
-			while (wxTheApp->HasPendingEvents())
-				wxTheApp->ProcessPendingEvents();
+			if (m_LockFree)
+				WaitForRingData();
+			else while (!m_sem_event.WaitWithoutYield(wxTimeSpan::Millisecond()))
+			{
+				while (wxTheApp->HasPendingEvents())
+					wxTheApp->ProcessPendingEvents();
+			}
 		}
 #else
 		// Performance note: Both of these perform cancellation tests, but pthread_testcancel
 		// is very optimized (only 1 instruction test in most cases), so no point in trying
 		// to avoid it.
 
-		m_sem_event.WaitWithoutYield();
+		if (m_LockFree)
+			WaitForRingData();
+		else
+			m_sem_event.WaitWithoutYield();
 #endif
 		StateCheckInThread();
 #ifndef __LIBRETRO__
@@ -335,6 +395,8 @@ void SysMtgsThread::ExecuteTaskInThread()
 			const PacketTagType& tag = (PacketTagType&)RingBuffer[local_ReadPos];
 			u32 ringposinc = 1;
 
+			Timeline::Scope span(tag.command == GS_RINGTYPE_VSYNC ? Timeline::Span_MTGSVsync : Timeline::Span_MTGSPacket);
+
 #ifdef RINGBUF_DEBUG_STACK
 			// pop a ringpos off the stack.  It should match this one!
 
@@ -443,6 +505,7 @@ void SysMtgsThread::ExecuteTaskInThread()
 #ifndef __LIBRETRO__
 					busy.PartialRelease();
 #endif
+					if (m_LockFree) NotifyProgress(); // weak WaitGS() callers may go on now
 					// Wait for MTVU to complete vu1 program
 					vu1Thread.semaXGkick.WaitWithoutYield();
 #ifndef __LIBRETRO__
@@ -453,6 +516,7 @@ void SysMtgsThread::ExecuteTaskInThread()
 					if (gsPack.size) GSgifTransfer((u32*)&path.buffer[gsPack.offset], gsPack.size/16);
 					path.readAmount.fetch_sub(gsPack.size + gsPack.readAmount, std::memory_order_acq_rel);
 					path.PopGSPacketMTVU(); // Should be done last, for proper Gif_MTGS_Wait()
+					if (m_LockFree) NotifyProgress();
 					break;
 				}
 
@@ -483,6 +547,9 @@ void SysMtgsThread::ExecuteTaskInThread()
 							GSvsync(((u32&)RingBuffer.Regs[0x1000]) & 0x2000);
 							gsFrameSkip();
 
+							if (PipelineStats::IsEnabled())
+								PipelineStats::UpdateOsd();
+
 							// if we're not using GSOpen2, then the GS window is on this thread (MTGS thread),
 							// so we need to call PADupdate from here.
 							if( (GSopen2 == NULL) && (PADupdate != NULL) )
@@ -587,7 +654,7 @@ void SysMtgsThread::ExecuteTaskInThread()
 				}
 			}
 #ifdef __LIBRETRO__
-			if(tag.command == GS_RINGTYPE_VSYNC)
+			if(tag.command == GS_RINGTYPE_VSYNC && !m_FlushingRing)
 			{
 #ifndef __LIBRETRO__
 				busy.Release();
@@ -598,13 +665,19 @@ void SysMtgsThread::ExecuteTaskInThread()
 					m_SignalRingPosition.store(0, std::memory_order_release);
 					m_sem_OnRingReset.Post();
 				}
+				if (m_LockFree) NotifyProgress();
 				return;
 			}
 #endif
 		}
 
+		if (m_LockFree) NotifyProgress();
+
 #ifndef __LIBRETRO__
 		busy.Release();
+#else
+		if (m_FlushingRing)
+			return;
 #endif
 
 		// Safety valve in case standard signals fail for some reason -- this ensures the EEcore
@@ -637,6 +710,23 @@ void SysMtgsThread::FinishTaskInThread()
 		m_sem_Vsync.Post();
 }
 
+#ifdef __LIBRETRO__
+// Processes everything the EE has queued so far, vsyncs included, and returns as soon as
+// the ring is empty instead of waiting for the next vsync.  Only meaningful while the EE
+// is paused, otherwise the ring may never drain.
+void SysMtgsThread::FlushTaskInThread()
+{
+	pxAssert(IsSelf());
+
+	m_FlushingRing = true;
+	if (m_ReadPos.load(std::memory_order_relaxed) != m_WritePos.load(std::memory_order_acquire))
+		ExecuteTaskInThread();
+	m_FlushingRing = false;
+
+	FinishTaskInThread();
+}
+#endif
+
 void SysMtgsThread::ClosePlugin()
 {
 	if( !m_PluginOpened ) return;
@@ -663,10 +753,95 @@ void SysMtgsThread::OnResumeInThread( bool isSuspended )
 
 void SysMtgsThread::OnCleanupInThread()
 {
+	if (PipelineStats::IsEnabled())
+		PipelineStats::Dump();
+
 	ClosePlugin();
 	_parent::OnCleanupInThread();
 }
 
+// Lock-free mode: posts m_sem_event only if the MTGS is (about to be) sleeping on it.
+// The fence orders the caller's m_WritePos store before the m_GSSleeping load, pairing
+// with the one in WaitForRingData(): either the MTGS sees the new data or we see it sleep.
+void SysMtgsThread::WakeGS()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_GSSleeping.load(std::memory_order_relaxed) && m_GSSleeping.exchange(false))
+	{
+		++m_WakesThisFrame;
+		m_sem_event.Post();
+	}
+}
+
+// Lock-free mode: waits in the MTGS thread for the EE to queue something.  Spins first,
+// since the EE usually follows up soon and that is cheaper than a sleep/wake round trip.
+void SysMtgsThread::WaitForRingData()
+{
+	auto ringEmpty = [this]() {
+		return m_ReadPos.load(std::memory_order_relaxed) == m_WritePos.load(std::memory_order_acquire);
+	};
+
+	for (uint spins = 0; spins < MTGS_SpinCount; ++spins)
+	{
+		if (!ringEmpty()) return;
+		SpinWait();
+	}
+
+	m_GSSleeping.store(true, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+#ifdef __LIBRETRO__
+	while (ringEmpty() && !m_sem_event.WaitWithoutYield(wxTimeSpan::Millisecond()))
+	{
+		while (wxTheApp->HasPendingEvents())
+			wxTheApp->ProcessPendingEvents();
+	}
+#else
+	if (ringEmpty())
+		m_sem_event.WaitWithoutYield();
+#endif
+
+	// A wakeup posted after this point is only a spurious one for the next wait.
+	m_GSSleeping.store(false, std::memory_order_relaxed);
+}
+
+// Lock-free mode: wakes up the WaitGS() callers sleeping on m_cv_Progress, if any.  The
+// fence pairs with the one in WaitForProgress(), same as in WakeGS().
+__fi void SysMtgsThread::NotifyProgress()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_ProgressWaiters.load(std::memory_order_relaxed) == 0) return;
+
+	std::lock_guard<std::mutex> lock(m_mtx_Progress);
+	m_cv_Progress.notify_all();
+}
+
+// Lock-free mode: waits outside of the MTGS thread until done() holds.  The timeout is
+// a safety valve only, so that MTGS exceptions get rethrown even if nobody notifies.
+template< typename Cond >
+void SysMtgsThread::WaitForProgress( const Cond& done )
+{
+	for (uint spins = 0; !done(); )
+	{
+		RethrowException();
+		if (spins < MTGS_SpinCount)
+		{
+			++spins;
+			SpinWait();
+			continue;
+		}
+
+		m_ProgressWaiters.fetch_add(1);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		{
+			std::unique_lock<std::mutex> lock(m_mtx_Progress);
+			m_cv_Progress.wait_for(lock, std::chrono::milliseconds(1), done);
+		}
+		m_ProgressWaiters.fetch_sub(1);
+	}
+	RethrowException();
+}
+
 // Waits for the GS to empty out the entire ring buffer contents.
 // If syncRegs, then writes pcsx2's gs regs to MTGS's internal copy
 // If weakWait, then this function is allowed to exit after MTGS finished a path1 packet
@@ -685,21 +860,29 @@ void SysMtgsThread::WaitGS(bool syncRegs, bool weakWait, bool isMTVU)
 	// we don't want to access the content of the queue
 
 	if (isMTVU || m_ReadPos.load(std::memory_order_relaxed) != m_WritePos.load(std::memory_order_relaxed)) {
-		SetEvent();
-		RethrowException();
-		for(;;) {
-			if (weakWait) m_mtx_RingBufferBusy2.Wait();
-			else          m_mtx_RingBufferBusy .Wait();
-			RethrowException();
-			if(!isMTVU && m_ReadPos.load(std::memory_order_relaxed) == m_WritePos.load(std::memory_order_relaxed)) break;
-			u32 curP1Packs = weakWait ? path.GetPendingGSPackets() : 0;
-			if (weakWait && ((startP1Packs-curP1Packs) || !curP1Packs)) break;
+		auto done = [&]() -> bool {
+			if(!isMTVU && m_ReadPos.load(std::memory_order_acquire) == m_WritePos.load(std::memory_order_relaxed)) return true;
 			// On weakWait we will stop waiting on the MTGS thread if the
 			// MTGS thread has processed a vu1 xgkick packet, or is pending on
 			// its final vu1 xgkick packet (!curP1Packs)...
 			// Note: m_WritePos doesn't seem to have proper atomic write
 			// code, so reading it from the MTVU thread might be dangerous;
 			// hence it has been avoided...
+			u32 curP1Packs = weakWait ? path.GetPendingGSPackets() : 0;
+			return weakWait && ((startP1Packs-curP1Packs) || !curP1Packs);
+		};
+
+		PipelineStats::ScopedStall stall(isMTVU ? PipelineStats::Stall_MTVUWaitGS : PipelineStats::Stall_WaitGS);
+
+		SetEvent();
+		RethrowException();
+		if (m_LockFree)
+			WaitForProgress(done);
+		else for(;;) {
+			if (weakWait) m_mtx_RingBufferBusy2.Wait();
+			else          m_mtx_RingBufferBusy .Wait();
+			RethrowException();
+			if (done()) break;
 		}
 	}
 
@@ -714,12 +897,20 @@ void SysMtgsThread::WaitGS(bool syncRegs, bool weakWait, bool isMTVU)
 // For use in loops that wait on the GS thread to do certain things.
 void SysMtgsThread::SetEvent()
 {
-	if(!m_RingBufferIsBusy.load(std::memory_order_relaxed))
+	if (m_LockFree)
+		WakeGS();
+	else if(!m_RingBufferIsBusy.load(std::memory_order_relaxed))
 		m_sem_event.Post();
 
 	m_CopyDataTally = 0;
 }
 
+// Qwords queued in the ring and not processed by the MTGS yet.
+uint SysMtgsThread::GetRingUsed() const
+{
+	return (m_WritePos.load(std::memory_order_relaxed) - m_ReadPos.load(std::memory_order_relaxed)) & RingBufferMask;
+}
+
 u8* SysMtgsThread::GetDataPacketPtr() const
 {
 	return (u8*)&RingBuffer[m_packet_writepos & RingBufferMask];
@@ -740,6 +931,9 @@ void SysMtgsThread::SendDataPacket()
 
 	m_WritePos.store(m_packet_writepos, std::memory_order_release);
 
+	if (PipelineStats::IsEnabled())
+		PipelineStats::AddPacket(m_packet_size, GetRingUsed());
+
 	if(EmuConfig.GS.SynchronousMTGS)
 	{
 		WaitGS();
@@ -747,7 +941,7 @@ void SysMtgsThread::SendDataPacket()
 	else if(!m_RingBufferIsBusy.load(std::memory_order_relaxed))
 	{
 		m_CopyDataTally += m_packet_size;
-		if( m_CopyDataTally > 0x2000 ) SetEvent();
+		if( m_CopyDataTally > (int)m_WakeThreshold ) SetEvent();
 	}
 
 	m_packet_size = 0;
@@ -781,6 +975,9 @@ void SysMtgsThread::GenericStall( uint size )
 
 	if (freeroom <= size)
 	{
+		PipelineStats::ScopedStall stall(PipelineStats::Stall_GSRingFull);
+		m_StalledThisFrame = true;
+
 		// writepos will overlap readpos if we commit the data, so we need to wait until
 		// readpos is out past the end of the future write pos, or until it wraps around
 		// (in which case writepos will be >= readpos).
@@ -874,6 +1071,9 @@ __fi void SysMtgsThread::_FinishSimplePacket()
 	pxAssert( future_writepos != m_ReadPos.load(std::memory_order_acquire) );
 	m_WritePos.store(future_writepos, std::memory_order_release);
 
+	if (PipelineStats::IsEnabled())
+		PipelineStats::AddPacket(1, GetRingUsed());
+
 	if( EmuConfig.GS.SynchronousMTGS )
 		WaitGS();
 	else
@@ -899,10 +1099,13 @@ void SysMtgsThread::SendSimpleGSPacket(MTGS_RingCommand type, u32 offset, u32 si
 {
 	SendSimplePacket(type, (int)offset, (int)size, (int)path);
 
+	if (PipelineStats::IsEnabled())
+		PipelineStats::AddData(size / 16);
+
 	if(!EmuConfig.GS.SynchronousMTGS) {
 		if(!m_RingBufferIsBusy.load(std::memory_order_relaxed)) {
 			m_CopyDataTally += size / 16;
-			if (m_CopyDataTally > 0x2000) SetEvent();
+			if (m_CopyDataTally > (int)m_WakeThreshold) SetEvent();
 		}
 	}
 }
@@ -16,8 +16,10 @@
 #include "PrecompiledHeader.h"
 #include "Common.h"
 #include "MTVU.h"
+#include "Timeline.h"
 #include "newVif.h"
 #include "Gif_Unit.h"
+#include "PipelineStats.h"
 
 __aligned16 VU_Thread vu1Thread(CpuVU1, VU1);
 
@@ -30,6 +32,7 @@ static __fi u32 size_u32(u32 x) { return (x + 3) >> 2; }
 enum MTVU_EVENT {
 	MTVU_VU_EXECUTE,     // Execute VU program
 	MTVU_VU_WRITE_MICRO, // Write to VU micro-mem
+	MTVU_VU_WRITE_MPG,   // Write to VU micro-mem (completes an MPG transfer)
 	MTVU_VU_WRITE_DATA,  // Write to VU data-mem
 	MTVU_VIF_WRITE_COL,  // Write to Vif col reg
 	MTVU_VIF_WRITE_ROW,  // Write to Vif row reg
@@ -102,6 +105,8 @@ void VU_Thread::ExecuteTaskInThread()
 
 void VU_Thread::ExecuteRingBuffer()
 {
+	Timeline::SetThreadName("MTVU");
+
 	for(;;) {
 		semaEvent.WaitWithoutYield();
 		ScopedLockBool lock(mtxBusy, isBusy);
@@ -115,18 +120,22 @@ void VU_Thread::ExecuteRingBuffer()
 					vifRegs.itop = Read();
 
 					if (addr != -1) vuRegs.VI[REG_TPC].UL = addr;
+					const u64 span = Timeline::Begin();
 					vuCPU->Execute(vu1RunCycles);
+					Timeline::End(Timeline::Span_MTVUProgram, span);
 					gifUnit.gifPath[GIF_PATH_1].FinishGSPacketMTVU();
 					semaXGkick.Post(); // Tell MTGS a path1 packet is complete
 					vuCycles[vuCycleIdx].store(vuRegs.cycle, std::memory_order_release);
 					vuCycleIdx  = (vuCycleIdx + 1) & 3;
 					break;
 				}
-				case MTVU_VU_WRITE_MICRO: {
+				case MTVU_VU_WRITE_MICRO:
+				case MTVU_VU_WRITE_MPG: {
 					u32 vu_micro_addr = Read();
 					u32 size = Read();
 					vuCPU->Clear(vu_micro_addr, size);
 					Read(&vuRegs.Micro[vu_micro_addr], size);
+					if (tag == MTVU_VU_WRITE_MPG) vuCPU->MicroUploaded(vu_micro_addr, size);
 					break;
 				}
 				case MTVU_VU_WRITE_DATA: {
@@ -165,24 +174,28 @@ void VU_Thread::ExecuteRingBuffer()
 // Should only be called by ReserveSpace()
 __ri void VU_Thread::WaitOnSize(s32 size)
 {
-	for(;;) {
+	auto hasSpace = [&]() {
 		s32 readPos  = GetReadPos();
-		if (readPos <= m_write_pos) break; // MTVU is reading in back of write_pos
+		if (readPos <= m_write_pos) return true; // MTVU is reading in back of write_pos
 		// FIXME greg: there is a bug somewhere in the queue pointer
 		// management. It creates a deadlock/corruption in SotC intro (before
 		// the first menu). I added a 4KB safety net which seem to avoid to
 		// trigger the bug.
 		// Note: a wait lock instead of a yield also helps to avoid the bug.
-		if (readPos >  m_write_pos + size + _4kb) break; // Enough free front space
-		{ // Let MTVU run to free up buffer space
-			KickStart();
-			// Locking might trigger a full flush of the ring buffer. Yield
-			// will be more aggressive, and only flush the minimal size.
-			// Performance will be smoother but it will consume extra CPU cycle
-			// on the EE thread (not an issue on 4 cores).
-			std::this_thread::yield();
-		}
-	}
+		return readPos > m_write_pos + size + _4kb; // Enough free front space
+	};
+
+	if (hasSpace()) return;
+
+	PipelineStats::ScopedStall stall(PipelineStats::Stall_VURingFull);
+	do { // Let MTVU run to free up buffer space
+		KickStart();
+		// Locking might trigger a full flush of the ring buffer. Yield
+		// will be more aggressive, and only flush the minimal size.
+		// Performance will be smoother but it will consume extra CPU cycle
+		// on the EE thread (not an issue on 4 cores).
+		std::this_thread::yield();
+	} while (!hasSpace());
 }
 
 // Makes sure theres enough room in the ring buffer
@@ -309,6 +322,9 @@ bool VU_Thread::IsDone()
 void VU_Thread::WaitVU()
 {
 	MTVU_LOG("MTVU - WaitVU!");
+	if (IsDone()) return;
+
+	PipelineStats::ScopedStall stall(PipelineStats::Stall_WaitVU);
 	for(;;) {
 		if (IsDone()) break;
 		//DevCon.WriteLn("WaitVU()");
@@ -349,11 +365,11 @@ void VU_Thread::VifUnpack(vifStruct& _vif, VIFregisters& _vifRegs, u8* data, u32
 	KickStart();
 }
 
-void VU_Thread::WriteMicroMem(u32 vu_micro_addr, void* data, u32 size)
+void VU_Thread::WriteMicroMem(u32 vu_micro_addr, void* data, u32 size, bool mpgEnd)
 {
 	MTVU_LOG("MTVU - WriteMicroMem!");
 	ReserveSpace(3 + size_u32(size));
-	Write(MTVU_VU_WRITE_MICRO);
+	Write(mpgEnd ? MTVU_VU_WRITE_MPG : MTVU_VU_WRITE_MICRO);
 	Write(vu_micro_addr);
 	Write(size);
 	Write(data, size);
@@ -66,8 +66,9 @@ public:
 
 	void VifUnpack(vifStruct& _vif, VIFregisters& _vifRegs, u8* data, u32 size);
 
-	// Writes to VU's Micro Memory (size in bytes)
-	void WriteMicroMem(u32 vu_micro_addr, void* data, u32 size);
+	// Writes to VU's Micro Memory (size in bytes), mpgEnd is set for the write which
+	// completes a VIF MPG transfer
+	void WriteMicroMem(u32 vu_micro_addr, void* data, u32 size, bool mpgEnd = false);
 
 	// Writes to VU's Data Memory (size in bytes)
 	void WriteDataMem(u32 vu_data_addr, void* data, u32 size);
@@ -743,6 +743,7 @@ void eeMemoryReserve::Reset()
 	memset(pCache,0,sizeof(_cacheS)*64);
 #endif
 
+	vtlb_FastmemReset();
 	vtlb_Init();
 
 	null_handler = vtlb_RegisterHandler(nullRead8, nullRead16, nullRead32, nullRead64, nullRead128,
@@ -854,6 +855,7 @@ void eeMemoryReserve::Reset()
 void eeMemoryReserve::Decommit()
 {
 	_parent::Decommit();
+	vtlb_FastmemRelease();
 	eeMem = NULL;
 }
 
@@ -904,6 +906,46 @@ struct vtlb_PageProtectionInfo
 
 static __aligned16 vtlb_PageProtectionInfo m_PageProtectInfo[Ps2MemSize::MainRam >> 12];
 
+// Sub-page write tracking (Recompiler.EESubPageProtection):
+// A write to a protected page doesn't switch the whole page to manual protection.  The
+// page is only unprotected for the faulting instruction (single-stepped by the fault
+// handler), the 64 byte chunks it wrote are recorded, and once it completed only the
+// blocks overlapping chunks that hold recompiled code are cleared before the page is
+// protected again.  Code and data sharing a page then only costs a fault per write,
+// instead of a memcmp of every block of the page each time one of them runs.
+//
+// Pages taking too many faults in a short time (data being streamed to them) fall back
+// to the page granular scheme above.
+
+static const uint SubPageShift = 6;		// 64 byte chunks, one bit each in a u64 per page
+static const uint SubPageFaultLimit = 32;	// faults per page and window before falling back
+
+struct vtlb_SubPageInfo
+{
+	u64 CodeChunks;		// chunks holding recompiled code
+	u64 DirtyChunks;	// chunks written by the faulting instruction(s) being stepped
+	u64 WindowStart;	// GetCPUTicks() at the start of the fault rate window
+	u32 WindowFaults;
+};
+
+struct vtlb_SubPageStats
+{
+	u64 Faults;			// writes trapped and stepped
+	u64 ChunksChecked;	// chunks written by those
+	u64 ChunksCleared;	// ... which held recompiled code, and had their blocks cleared
+	u64 Fallbacks;		// pages switched to manual protection for faulting too often
+};
+
+static __aligned16 vtlb_SubPageInfo m_SubPageInfo[Ps2MemSize::MainRam >> 12];
+static vtlb_SubPageStats m_SubPageStats;
+
+// Protects a ram page, along with its fastmem views.
+static void mmap_ProtectRamPage( uint rampage, const PageProtectionMode& mode )
+{
+	HostSys::MemProtect( &eeMem->Main[rampage<<12], __pagesize, mode );
+	vtlb_FastmemProtect( rampage<<12, __pagesize, mode );
+}
+
 
 // returns:
 //  ProtMode_NotRequired - unchecked block (resides in ROM, thus is integrity is constant)
@@ -944,13 +986,95 @@ void mmap_MarkCountedRamPage( u32 paddr )
 	if( m_PageProtectInfo[rampage].Mode == ProtMode_Write )
 		return;		// skip town if we're already protected.
 
+	// The page's blocks were all cleared when it lost its protection.
+	m_SubPageInfo[rampage].CodeChunks = 0;
+
 	eeRecPerfLog.Write( (m_PageProtectInfo[rampage].Mode == ProtMode_Manual) ?
 		"Re-protecting page @ 0x%05x" : "Protected page @ 0x%05x",
 		paddr>>12
 	);
 
 	m_PageProtectInfo[rampage].Mode = ProtMode_Write;
-	HostSys::MemProtect( &eeMem->Main[rampage<<12], __pagesize, PageAccess_ReadOnly() );
+	mmap_ProtectRamPage( rampage, PageAccess_ReadOnly() );
+}
+
+// paddr - physically mapped PS2 address of a block recompiled from a protected page.
+// Records the chunks holding it, for the sub-page write tracking.
+void mmap_MarkCodeRange( u32 paddr, u32 size )
+{
+	pxAssert( eeMem );
+
+	uptr offset = (uptr)PSM( paddr ) - (uptr)eeMem->Main;
+	if (offset >= Ps2MemSize::MainRam || !size)
+		return;
+
+	// note: blocks are guaranteed to reside within the confines of a single page.
+	uint first = (offset & 0xfff) >> SubPageShift;
+	uint last = std::min<uint>((offset & 0xfff) + size - 1, 0xfff) >> SubPageShift;
+	for (uint chunk = first; chunk <= last; chunk++)
+		m_SubPageInfo[offset >> 12].CodeChunks |= 1ULL << chunk;
+}
+
+// Step callback of mmap_SubPageFault: the write completed, clear the blocks it may have
+// modified and protect the page again.
+static void mmap_SubPageStep( uptr rampage )
+{
+	vtlb_SubPageInfo& info = m_SubPageInfo[rampage];
+
+	u64 dirty = info.DirtyChunks;
+	info.DirtyChunks = 0;
+
+	for (uint chunk = 0; dirty; chunk++, dirty >>= 1)
+	{
+		if (!(dirty & 1))
+			continue;
+
+		m_SubPageStats.ChunksChecked++;
+		if (!(info.CodeChunks & (1ULL << chunk)))
+			continue;
+
+		m_SubPageStats.ChunksCleared++;
+		info.CodeChunks &= ~(1ULL << chunk);
+		Cpu->Clear( m_PageProtectInfo[rampage].ReverseRamMap + (chunk << SubPageShift), (1 << SubPageShift) / 4 );
+	}
+
+	if (m_PageProtectInfo[rampage].Mode == ProtMode_Write)
+		mmap_ProtectRamPage( rampage, PageAccess_ReadOnly() );
+}
+
+// offset - offset of the written address relative to psM.
+// Returns false if the page should rather fall back to manual protection.
+static bool mmap_SubPageFault( uint offset )
+{
+	int rampage = offset >> 12;
+	vtlb_SubPageInfo& info = m_SubPageInfo[rampage];
+
+	u64 now = GetCPUTicks();
+	if (now - info.WindowStart > GetTickFrequency() / 60)
+	{
+		info.WindowStart = now;
+		info.WindowFaults = 0;
+	}
+
+	if (++info.WindowFaults > SubPageFaultLimit)
+	{
+		eeRecPerfLog.Write( "Sub-page protection: falling back to manual protection for page @ 0x%05x",
+			m_PageProtectInfo[rampage].ReverseRamMap>>12 );
+		m_SubPageStats.Fallbacks++;
+		return false;
+	}
+
+	// The fault only tells the first byte written: assume up to 64 of them (AVX-512 stores),
+	// stopping at the end of the page (the next page faults on its own if it's protected).
+	uint first = (offset & 0xfff) >> SubPageShift;
+	uint last = std::min<uint>((offset & 0xfff) + 63, 0xfff) >> SubPageShift;
+	for (uint chunk = first; chunk <= last; chunk++)
+		info.DirtyChunks |= 1ULL << chunk;
+
+	m_SubPageStats.Faults++;
+	mmap_ProtectRamPage( rampage, PageAccess_ReadWrite() );
+	Source_PageFault->RequestStep( mmap_SubPageStep, rampage );
+	return true;
 }
 
 // offset - offset of address relative to psM.
@@ -967,8 +1091,9 @@ static __fi void mmap_ClearCpuBlock( uint offset )
 	pxAssertMsg( m_PageProtectInfo[rampage].Mode != ProtMode_Manual,
 		"Attempted to clear a block that is already under manual protection." );
 
-	HostSys::MemProtect( &eeMem->Main[rampage<<12], __pagesize, PageAccess_ReadWrite() );
+	mmap_ProtectRamPage( rampage, PageAccess_ReadWrite() );
 	m_PageProtectInfo[rampage].Mode = ProtMode_Manual;
+	m_SubPageInfo[rampage].CodeChunks = 0;
 	Cpu->Clear( m_PageProtectInfo[rampage].ReverseRamMap, 0x400 );
 }
 
@@ -978,10 +1103,29 @@ void mmap_PageFaultHandler::OnPageFaultEvent( const PageFaultInfo& info, bool& h
 
 	// get bad virtual address
 	uptr offset = info.addr - (uptr)eeMem->Main;
-	if( offset >= Ps2MemSize::MainRam ) return;
+	if( offset >= Ps2MemSize::MainRam )
+	{
+		// Fastmem: a write to a view of a protected page is handled like a write to eeMem,
+		// any other fault is an access to a page which isn't a view of ram at all.
+		if( !vtlb_IsFastmemAddress( info.addr ) ) return;
+
+		offset = vtlb_FastmemViewOffset( info.addr );
+		if( offset >= Ps2MemSize::MainRam || m_PageProtectInfo[offset >> 12].Mode != ProtMode_Write )
+		{
+			if( uptr thunk = vtlb_FastmemBackpatch( info.pc ) )
+			{
+				Source_PageFault->RequestResume( thunk );
+				handled = true;
+			}
+			return;
+		}
+	}
 
-	mmap_ClearCpuBlock( offset );
 	handled = true;
+	if( CHECK_EE_SUBPAGE && Source_PageFault->CanStep() && mmap_SubPageFault( offset ) )
+		return;
+
+	mmap_ClearCpuBlock( offset );
 }
 
 // Clears all block tracking statuses, manual protection flags, and write protection.
@@ -991,6 +1135,17 @@ void mmap_PageFaultHandler::OnPageFaultEvent( const PageFaultInfo& info, bool& h
 void mmap_ResetBlockTracking()
 {
 	//DbgCon.WriteLn( "vtlb/mmap: Block Tracking reset..." );
+	if (EmuConfig.Profiler.Enabled && m_SubPageStats.Faults)
+	{
+		Console.WriteLn( Color_StrongBlue, "EE sub-page protection: %llu faults, %llu chunks checked, %llu cleared (%.1f%%), %llu pages fell back to manual protection",
+			(unsigned long long)m_SubPageStats.Faults, (unsigned long long)m_SubPageStats.ChunksChecked,
+			(unsigned long long)m_SubPageStats.ChunksCleared,
+			m_SubPageStats.ChunksCleared * 100.0 / std::max<u64>(m_SubPageStats.ChunksChecked, 1),
+			(unsigned long long)m_SubPageStats.Fallbacks );
+	}
+	memzero( m_SubPageStats );
+	memzero( m_SubPageInfo );
 	memzero( m_PageProtectInfo );
 	if (eeMem) HostSys::MemProtect( eeMem->Main, Ps2MemSize::MainRam, PageAccess_ReadWrite() );
+	vtlb_FastmemProtect( 0, Ps2MemSize::MainRam, PageAccess_ReadWrite() );
 }
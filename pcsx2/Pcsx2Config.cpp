@@ -77,6 +77,10 @@ void Pcsx2Config::ProfilerOptions::LoadSave( IniInterface& ini )
 	IniBitBool( RecBlocks_IOP );
 	IniBitBool( RecBlocks_VU0 );
 	IniBitBool( RecBlocks_VU1 );
+	IniBitBool( Pipeline );
+	IniBitBool( Timeline );
+	IniEntry( TimelineFirstFrame );
+	IniEntry( TimelineFrames );
 }
 
 Pcsx2Config::RecompilerOptions::RecompilerOptions()
@@ -90,7 +94,14 @@ Pcsx2Config::RecompilerOptions::RecompilerOptions()
 
 	EnableEE	= true;
 	EnableEECache = false;
+	EnableVUProgramCache = false;
+	VUBackgroundCompile = false;
+	EESubPageProtection = false;
+	EESuperblocks = false;
+	EEGenerationalCache = false;
+	EEFastmem = false;
 	EnableIOP	= true;
+	IOPBlockAnalysis = false;
 	EnableVU0	= true;
 	EnableVU1	= true;
 
@@ -147,7 +158,14 @@ void Pcsx2Config::RecompilerOptions::LoadSave( IniInterface& ini )
 
 	IniBitBool( EnableEE );
 	IniBitBool( EnableIOP );
+	IniBitBool( IOPBlockAnalysis );
 	IniBitBool( EnableEECache );
+	IniBitBool( EnableVUProgramCache );
+	IniBitBool( VUBackgroundCompile );
+	IniBitBool( EESubPageProtection );
+	IniBitBool( EESuperblocks );
+	IniBitBool( EEGenerationalCache );
+	IniBitBool( EEFastmem );
 	IniBitBool( EnableVU0 );
 	IniBitBool( EnableVU1 );
 
@@ -210,6 +228,8 @@ Pcsx2Config::GSOptions::GSOptions()
 
 	SynchronousMTGS			= false;
 	VsyncQueueSize			= 2;
+	LockFreeMTGS			= false;
+	RingBufferSizeFactor	= 19;
 
 	FramesToDraw			= 2;
 	FramesToSkip			= 2;
@@ -225,6 +245,8 @@ void Pcsx2Config::GSOptions::LoadSave( IniInterface& ini )
 
 	IniEntry( SynchronousMTGS );
 	IniEntry( VsyncQueueSize );
+	IniEntry( LockFreeMTGS );
+	IniEntry( RingBufferSizeFactor );
 
 	IniEntry( FrameLimitEnable );
 	IniEntry( FrameSkipEnable );
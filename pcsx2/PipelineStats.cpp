@@ -0,0 +1,217 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "Common.h"
+#include "GS.h"
+#include "PipelineStats.h"
+
+namespace PipelineStats
+{
+
+// s_frame's stalls are added from the EE and MTVU threads and are protected by s_lock,
+// like s_last and s_total.  Its packet counters are only touched by the MTGS producer.
+static Threading::Mutex s_lock;
+static Stats s_frame;
+static Stats s_last;
+static Stats s_total;
+
+static const char* const s_stallNames[StallType_Count] =
+{
+	"EE WaitGS",
+	"EE vsync queue",
+	"EE GS ring full",
+	"MTVU WaitGS",
+	"EE WaitVU",
+	"EE VU ring full",
+};
+
+const char* GetStallName(StallType type)
+{
+	return s_stallNames[type];
+}
+
+static void Accumulate(Stats& dest, const Stats& src)
+{
+	for (uint i = 0; i < StallType_Count; i++)
+	{
+		StallStats& d = dest.stalls[i];
+		const StallStats& s = src.stalls[i];
+		d.count += s.count;
+		d.us += s.us;
+		d.maxUs = std::max(d.maxUs, s.maxUs);
+		for (uint b = 0; b < StallBuckets; b++)
+			d.histogram[b] += s.histogram[b];
+	}
+
+	dest.frames += src.frames;
+	dest.packets += src.packets;
+	dest.copiedQwc += src.copiedQwc;
+	for (uint b = 0; b < RingBuckets; b++)
+		dest.ringHistogram[b] += src.ringHistogram[b];
+	dest.ringMax = std::max(dest.ringMax, src.ringMax);
+	dest.iopTicks += src.iopTicks;
+	dest.ringUsed = src.ringUsed;
+	dest.queuedFrames = src.queuedFrames;
+}
+
+void AddStall(StallType type, u64 ticks)
+{
+	const u64 us = ticks * 1000000 / GetTickFrequency();
+
+	uint bucket = 0;
+	while (bucket < StallBuckets - 1 && us >= (1ull << bucket))
+		bucket++;
+
+	ScopedLock lock(s_lock);
+	StallStats& stall = s_frame.stalls[type];
+	stall.count++;
+	stall.us += us;
+	stall.maxUs = std::max(stall.maxUs, us);
+	stall.histogram[bucket]++;
+}
+
+void AddPacket(u32 qwc, u32 ringUsed)
+{
+	s_frame.packets++;
+	s_frame.copiedQwc += qwc;
+	s_frame.ringMax = std::max(s_frame.ringMax, ringUsed);
+	s_frame.ringHistogram[std::min<uint>(ringUsed * RingBuckets / RingBufferSize, RingBuckets - 1)]++;
+}
+
+void AddData(u32 qwc)
+{
+	s_frame.copiedQwc += qwc;
+}
+
+void AddIopTime(u64 ticks)
+{
+	s_frame.iopTicks += ticks;
+}
+
+double GetIopMsPerFrame(const Stats& stats)
+{
+	if (!stats.frames)
+		return 0;
+	return stats.iopTicks * 1000.0 / GetTickFrequency() / stats.frames;
+}
+
+void EndFrame(u32 ringUsed, u32 queuedFrames)
+{
+	ScopedLock lock(s_lock);
+	s_frame.frames = 1;
+	s_frame.ringUsed = ringUsed;
+	s_frame.queuedFrames = queuedFrames;
+
+	s_last = s_frame;
+	Accumulate(s_total, s_frame);
+	memzero(s_frame);
+}
+
+void GetLastFrame(Stats& dest)
+{
+	ScopedLock lock(s_lock);
+	dest = s_last;
+}
+
+void GetTotals(Stats& dest)
+{
+	ScopedLock lock(s_lock);
+	dest = s_total;
+}
+
+void Reset()
+{
+	ScopedLock lock(s_lock);
+	memzero(s_frame);
+	memzero(s_last);
+	memzero(s_total);
+}
+
+static void OsdMonitor(const char* key, const char* value)
+{
+#ifndef BUILTIN_GS_PLUGIN
+	if (!GSosdMonitor)
+		return;
+#endif
+	GSosdMonitor(key, value, 0xffffffff);
+}
+
+void UpdateOsd()
+{
+	Stats frame;
+	GetLastFrame(frame);
+
+	char value[128];
+	snprintf(value, sizeof(value), "%u%% at vsync, %u%% max, %u vsyncs queued",
+			 frame.ringUsed * 100 / RingBufferSize, frame.ringMax * 100 / RingBufferSize, frame.queuedFrames);
+	OsdMonitor("MTGS ring", value);
+
+	snprintf(value, sizeof(value), "%llu packets, %llu KB",
+			 (unsigned long long)frame.packets, (unsigned long long)(frame.copiedQwc * 16 / 1024));
+	OsdMonitor("MTGS queued", value);
+
+	snprintf(value, sizeof(value), "%.2f ms", GetIopMsPerFrame(frame));
+	OsdMonitor("IOP time", value);
+
+	for (uint i = 0; i < StallType_Count; i++)
+	{
+		const StallStats& stall = frame.stalls[i];
+		snprintf(value, sizeof(value), "%llu stalls, %.2f ms (max %.2f ms)",
+				 (unsigned long long)stall.count, stall.us / 1000.0, stall.maxUs / 1000.0);
+		OsdMonitor(s_stallNames[i], value);
+	}
+}
+
+void Dump()
+{
+	Stats total;
+	GetTotals(total);
+	if (!total.frames)
+		return;
+
+	Console.WriteLn(Color_StrongBlue, "Pipeline stats over %llu frames: %.1f MTGS packets and %.1f KB per frame, ring max %u%%",
+					(unsigned long long)total.frames, (double)total.packets / total.frames,
+					total.copiedQwc * 16 / 1024.0 / total.frames, total.ringMax * 100 / RingBufferSize);
+	Console.WriteLn("  IOP time: %.3f ms per frame", GetIopMsPerFrame(total));
+
+	std::string line;
+	char buf[32];
+	for (uint b = 0; b < RingBuckets; b++)
+	{
+		snprintf(buf, sizeof(buf), " %llu", (unsigned long long)total.ringHistogram[b]);
+		line += buf;
+	}
+	Console.WriteLn("  MTGS ring occupancy (1/%u steps):%s", RingBuckets, line.c_str());
+
+	for (uint i = 0; i < StallType_Count; i++)
+	{
+		const StallStats& stall = total.stalls[i];
+		if (!stall.count)
+			continue;
+
+		line.clear();
+		for (uint b = 0; b < StallBuckets; b++)
+		{
+			snprintf(buf, sizeof(buf), " %llu", (unsigned long long)stall.histogram[b]);
+			line += buf;
+		}
+		Console.WriteLn("  %-16s %llu stalls, %.2f ms total, %.2f ms/frame, max %.2f ms; log2(us):%s",
+						s_stallNames[i], (unsigned long long)stall.count, stall.us / 1000.0,
+						stall.us / 1000.0 / total.frames, stall.maxUs / 1000.0, line.c_str());
+	}
+}
+
+}
@@ -0,0 +1,132 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Config.h"
+
+// --------------------------------------------------------------------------------------
+//  PipelineStats
+// --------------------------------------------------------------------------------------
+// Counts how often and for how long the EE (and the MTVU thread) block on the MTGS and
+// MTVU threads, along with the traffic going through the MTGS ring and the time the EE
+// thread spends running the IOP.  Enabled through the Profiler.Pipeline option.
+//
+// Stats are accumulated per frame and closed at every EE vsync.  The last frame can be
+// queried from any thread and is shown on the GS OSD monitor; the totals since the MTGS
+// started are dumped to the console when it shuts down.
+namespace PipelineStats
+{
+
+enum StallType
+{
+	Stall_WaitGS,     // EE waiting in SysMtgsThread::WaitGS()
+	Stall_GSVsync,    // EE waiting on the MTGS vsync queue (GS.VsyncQueueSize)
+	Stall_GSRingFull, // EE waiting for room in the MTGS ring
+	Stall_MTVUWaitGS, // MTVU thread waiting in SysMtgsThread::WaitGS()
+	Stall_WaitVU,     // EE waiting for the MTVU thread to finish
+	Stall_VURingFull, // EE waiting for room in the MTVU ring
+
+	StallType_Count
+};
+
+// Stall durations histogram: bucket 0 counts stalls under 1us, bucket N those under
+// 2^N us, and the last bucket everything longer.
+static const uint StallBuckets = 16;
+
+// MTGS ring occupancy histogram, in 1/16ths of the ring, sampled on every data packet.
+static const uint RingBuckets = 16;
+
+struct StallStats
+{
+	u64 count;
+	u64 us;    // total time stalled, in microseconds
+	u64 maxUs;
+	u64 histogram[StallBuckets];
+};
+
+struct Stats
+{
+	StallStats stalls[StallType_Count];
+
+	u64 frames;
+	u64 packets;   // packets queued in the MTGS ring
+	u64 copiedQwc; // qwords of GS data queued for the MTGS (what m_CopyDataTally counts)
+	u64 ringHistogram[RingBuckets];
+	u32 ringMax;   // highest MTGS ring occupancy seen, in qwords
+	u64 iopTicks;  // time spent in psxCpu->ExecuteBlock(), in GetCPUTicks() units
+
+	// Only meaningful for a single frame: state of the MTGS when the EE reached the vsync.
+	u32 ringUsed;
+	u32 queuedFrames;
+};
+
+__fi bool IsEnabled()
+{
+	return EmuConfig.Profiler.Enabled && EmuConfig.Profiler.Pipeline;
+}
+
+const char* GetStallName(StallType type);
+
+// Records a stall of the given type.  ticks are in GetCPUTicks() units.
+void AddStall(StallType type, u64 ticks);
+
+// Records a packet queued in the MTGS ring, and the ring occupancy after queuing it.
+// MTGS producer (EE) thread only.
+void AddPacket(u32 qwc, u32 ringUsed);
+
+// Records GS data queued for the MTGS outside of the ring (GS_RINGTYPE_GSPACKET).
+void AddData(u32 qwc);
+
+// Records time spent running the IOP.  EE thread only.
+void AddIopTime(u64 ticks);
+
+// Average IOP time per frame of the given stats, in milliseconds.
+double GetIopMsPerFrame(const Stats& stats);
+
+// Closes the current frame.  MTGS producer (EE) thread only, at the vsync.
+void EndFrame(u32 ringUsed, u32 queuedFrames);
+
+void GetLastFrame(Stats& dest);
+void GetTotals(Stats& dest);
+void Reset();
+
+// Shows the last frame on the GS OSD monitor.  GS thread only.
+void UpdateOsd();
+
+// Prints the totals and histograms to the console.
+void Dump();
+
+// Times a stall from construction to destruction, when the stats are enabled.
+class ScopedStall
+{
+	StallType m_type;
+	u64 m_start;
+
+public:
+	ScopedStall(StallType type)
+		: m_type(type)
+		, m_start(IsEnabled() ? GetCPUTicks() : 0)
+	{
+	}
+
+	~ScopedStall()
+	{
+		if (m_start)
+			AddStall(m_type, GetCPUTicks() - m_start);
+	}
+};
+
+}
@@ -22,7 +22,10 @@
 #include "ps2/pgif.h" // pgif init
 #include "VUmicro.h"
 #include "COP0.h"
+#include "Cache.h"
 #include "MTVU.h"
+#include "PipelineStats.h"
+#include "Timeline.h"
 
 #include "System/SysThreads.h"
 #include "R5900Exceptions.h"
@@ -56,6 +59,9 @@ static const uint eeWaitCycles = 3072;
 
 bool eeEventTestIsActive = false;
 
+// Timeline: end of the last event test, where the EE went back to running code
+static u64 eeRunStart = 0;
+
 u32 g_eeloadMain = 0, g_eeloadExec = 0, g_osdsys_str = 0;
 
 /* I don't know how much space for args there is in the memory block used for args in full boot mode,
@@ -80,6 +86,7 @@ void cpuReset()
 	memzero(cpuRegs);
 	memzero(fpuRegs);
 	memzero(tlb);
+	updateCachedPages();
 
 	cpuRegs.pc				= 0xbfc00000; //set pc reg to stack
 	cpuRegs.CP0.n.Config	= 0x440;
@@ -370,6 +377,11 @@ __fi void _cpuEventTest_Shared()
 	ScopedBool etest(eeEventTestIsActive);
 	g_nextEventCycle = cpuRegs.cycle + eeWaitCycles;
 
+	const u64 eventTestStart = Timeline::Begin();
+	if (eeRunStart && eventTestStart)
+		Timeline::AddSpan(Timeline::Span_EE, eeRunStart, eventTestStart);
+	eeRunStart = 0; // In case a vsync suspends the EE (it throws out of here)
+
 	// ---- INTC / DMAC (CPU-level Exceptions) -----------------
 	// Done first because exceptions raised during event tests need to be postponed a few
 	// cycles (fixes Grandia II [PAL], which does a spin loop on a vsync and expects to
@@ -422,8 +434,16 @@ __fi void _cpuEventTest_Shared()
 		//if( EEsCycle < -450 )
 		//	Console.WriteLn( " IOP ahead by: %d cycles", -EEsCycle );
 
+		const u64 iopStart = PipelineStats::IsEnabled() ? GetCPUTicks() : 0;
+		const u64 iopSpan = Timeline::Begin();
+
 		EEsCycle = psxCpu->ExecuteBlock( EEsCycle );
 
+		if( iopStart )
+			PipelineStats::AddIopTime( GetCPUTicks() - iopStart );
+		if( iopSpan )
+			Timeline::End( Timeline::Span_IOP, iopSpan );
+
 		iopEventAction = false;
 	}
 
@@ -456,6 +476,8 @@ __fi void _cpuEventTest_Shared()
 
 	// Apply vsync and other counter nextCycles
 	cpuSetNextEvent( nextsCounter, nextCounter );
+
+	eeRunStart = Timeline::End(Timeline::Span_EEEventTest, eventTestStart);
 }
 
 __ri void cpuTestINTCInts()
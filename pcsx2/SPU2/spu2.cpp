@@ -689,6 +689,31 @@ void SPU2DoFreezeOut(void* dest)
 		throw std::runtime_error(" * SPU2: Error saving state!\n");
 }
 
+// Loads or saves the SPU2 state inline with the rest of an uncompressed memory state.
+void SPU2DoFreeze(SaveStateBase& state)
+{
+	ScopedLock lock(mtx_SPU2Status);
+
+	freezeData fP = {0, nullptr};
+	if (SPU2freeze(FREEZE_SIZE, &fP) != 0)
+		fP.size = 0;
+
+	int fsize = fP.size;
+	state.Freeze(fsize);
+	if (state.IsLoading() && fsize != fP.size)
+		throw std::runtime_error(" * SPU2: Savestate size mismatch!\n");
+
+	if (!fsize)
+		return;
+
+	state.PrepBlock(fsize);
+	fP.data = (s8*)state.GetBlockPtr();
+
+	if (SPU2freeze(state.IsSaving() ? FREEZE_SAVE : FREEZE_LOAD, &fP) != 0)
+		throw std::runtime_error(state.IsSaving() ? " * SPU2: Error saving state!\n" : " * SPU2: Error loading state!\n");
+
+	state.CommitBlock(fsize);
+}
 
 void SPU2DoFreezeIn(pxInputStream& infp)
 {
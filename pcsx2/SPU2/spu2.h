@@ -44,6 +44,7 @@ void SPU2async(u32 cycles);
 s32 SPU2freeze(int mode, freezeData* data);
 void SPU2DoFreezeIn(pxInputStream& infp);
 void SPU2DoFreezeOut(void* dest);
+void SPU2DoFreeze(SaveStateBase& state);
 void SPU2configure();
 
 
@@ -26,6 +26,7 @@
 #include "IopDma.h"
 
 #include "spu2.h" // needed until I figure out a nice solution for irqcallback dependencies.
+#include "Timeline.h"
 
 s16* spu2regs = nullptr;
 s16* _spu2mem = nullptr;
@@ -418,6 +419,8 @@ __forceinline void TimeUpdate(u32 cClocks)
 	else
 		TickInterval = 768; // Reset to default, in case the user hotswitched from async to something else.
 #endif
+	const u64 mixStart = (dClocks >= TickInterval) ? Timeline::Begin() : 0;
+
 	//Update Mixing Progress
 	while (dClocks >= TickInterval)
 	{
@@ -485,6 +488,9 @@ __forceinline void TimeUpdate(u32 cClocks)
 		Mix();
 		//RestoreMMXRegs();
 	}
+
+	if (mixStart)
+		Timeline::End(Timeline::Span_SPU2Mix, mixStart);
 }
 
 __forceinline void UpdateSpdifMode()
@@ -29,6 +29,7 @@
 #include "Patch.h"
 #include "SysThreads.h"
 #include "MTVU.h"
+#include "Timeline.h"
 #include "IPC.h"
 #include "FW.h"
 #include "SPU2/spu2.h"
@@ -294,6 +295,7 @@ void SysCoreThread::ExecuteTaskInThread()
 	m_sem_event.WaitWithoutYield();
 
 	m_mxcsr_saved.bitmask = _mm_getcsr();
+	Timeline::SetThreadName("EE");
 
 	PCSX2_PAGEFAULT_PROTECT
 	{
@@ -332,6 +334,7 @@ void SysCoreThread::OnCleanupInThread()
 	m_hasActiveMachine = false;
 	m_resetVirtualMachine = true;
 
+	Timeline::Stop();
 	R3000A::ioman::reset();
 	// FIXME: temporary workaround for deadlock on exit, which actually should be a crash
 	vu1Thread.WaitVU();
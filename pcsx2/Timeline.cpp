@@ -0,0 +1,251 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "Common.h"
+#include "Timeline.h"
+
+#include "AppConfig.h"
+#include "Utilities/AsciiFile.h"
+
+namespace Timeline
+{
+
+// Spans kept per thread; older ones are overwritten when a capture records more.
+static const u32 BufferSize = 1 << 19;
+
+struct Span
+{
+	u64 begin;
+	u64 end;
+	SpanType type;
+};
+
+// Written by its thread only.  busy is set while the thread checks s_recording and adds a
+// span, so Finish() can wait for the threads which saw the capture running to be done.
+struct ThreadBuffer
+{
+	std::unique_ptr<Span[]> spans;
+	std::atomic<u32> pos;
+	std::atomic<bool> busy;
+	u32 tid;
+	const char* name;
+};
+
+std::atomic<bool> s_recording(false);
+
+static DeclareTls(ThreadBuffer*) s_buffer = NULL;
+static DeclareTls(const char*) s_threadName = NULL;
+
+// Buffers of every thread which recorded a span, kept across captures (threads keep a
+// pointer to theirs).  s_lock protects the list.
+static Threading::Mutex s_lock;
+static std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;
+
+// EE thread only
+static u32 s_firstFrame;
+static u32 s_frames;
+static bool s_captured;
+static std::vector<std::pair<u32, u64>> s_vsyncs; // frame, ticks
+
+static const char* const s_spanNames[SpanType_Count][2] =
+{
+	{"EE", "EE"},
+	{"EE event test", "EE"},
+	{"IOP", "IOP"},
+	{"rcntUpdate", "Counters"},
+	{"VSyncStart", "Counters"},
+	{"MTGS packet", "MTGS"},
+	{"MTGS vsync", "MTGS"},
+	{"MTVU program", "MTVU"},
+	{"SPU2 mix", "SPU2"},
+	{"CDVD readTrack", "CDVD"},
+	{"CDVD getBuffer", "CDVD"},
+};
+
+static ThreadBuffer* RegisterThread()
+{
+	Threading::ScopedLock lock(s_lock);
+
+	std::unique_ptr<ThreadBuffer> buf(new ThreadBuffer);
+	buf->spans.reset(new Span[BufferSize]);
+	buf->pos.store(0, std::memory_order_relaxed);
+	buf->busy.store(false, std::memory_order_relaxed);
+	buf->tid = s_buffers.size() + 1;
+	buf->name = s_threadName;
+
+	s_buffers.push_back(std::move(buf));
+	return s_buffers.back().get();
+}
+
+void AddSpan(SpanType type, u64 begin, u64 end)
+{
+	if (!s_buffer)
+		s_buffer = RegisterThread();
+
+	ThreadBuffer& buf = *s_buffer;
+	buf.busy.store(true, std::memory_order_seq_cst);
+	if (s_recording.load(std::memory_order_seq_cst))
+	{
+		const u32 pos = buf.pos.load(std::memory_order_relaxed);
+		Span& span = buf.spans[pos & (BufferSize - 1)];
+		span.begin = begin;
+		span.end = end;
+		span.type = type;
+		buf.pos.store(pos + 1, std::memory_order_release);
+	}
+	buf.busy.store(false, std::memory_order_release);
+}
+
+void SetThreadName(const char* name)
+{
+	s_threadName = name;
+	if (s_buffer)
+		s_buffer->name = name;
+}
+
+static void Start(u32 firstFrame, u32 frames)
+{
+	{
+		Threading::ScopedLock lock(s_lock);
+		for (auto& buf : s_buffers)
+			buf->pos.store(0, std::memory_order_relaxed);
+	}
+
+	s_firstFrame = firstFrame;
+	s_frames = frames;
+	s_vsyncs.clear();
+	// The start of the capture, taken before any thread can record a span
+	s_vsyncs.emplace_back(firstFrame, GetCPUTicks());
+	s_recording.store(true, std::memory_order_seq_cst);
+
+	Console.WriteLn(Color_StrongBlue, "Timeline: recording frames %u to %u", firstFrame, firstFrame + frames - 1);
+}
+
+static void Write(const wxString& filename, u64 start)
+{
+	AsciiFile file(filename, L"w");
+	if (!file.IsOpened())
+	{
+		Console.Error(L"Timeline: can't write %s", WX_STR(filename));
+		return;
+	}
+
+	const double us = 1000000.0 / GetTickFrequency();
+	u64 spans = 0, dropped = 0;
+
+	file.Printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	file.Printf("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"PCSX2\"}}");
+
+	for (const auto& pair : s_vsyncs)
+		file.Printf(",\n{\"name\":\"Frame %u\",\"cat\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}",
+					pair.first, (pair.second - start) * us);
+
+	Threading::ScopedLock lock(s_lock);
+	for (const auto& buf : s_buffers)
+	{
+		const u32 pos = buf->pos.load(std::memory_order_acquire);
+		if (!pos)
+			continue;
+
+		const u32 count = std::min(pos, BufferSize);
+		dropped += pos - count;
+
+		if (buf->name)
+			file.Printf(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", buf->tid, buf->name);
+		else
+			file.Printf(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}", buf->tid, buf->tid);
+		file.Printf(",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"sort_index\":%u}}", buf->tid, buf->tid);
+
+		for (u32 i = pos - count; i != pos; i++)
+		{
+			const Span& span = buf->spans[i & (BufferSize - 1)];
+			// Spans of other threads may have started before the capture, or even ended
+			// before it if they were added just after s_recording got set
+			if (span.end <= start)
+				continue;
+			const u64 begin = std::max(span.begin, start);
+			file.Printf(",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+						s_spanNames[span.type][0], s_spanNames[span.type][1], buf->tid,
+						(begin - start) * us, (span.end - begin) * us);
+			spans++;
+		}
+	}
+
+	file.Printf("\n]}\n");
+
+	Console.WriteLn(Color_StrongBlue, L"Timeline: wrote %llu spans to %s", (unsigned long long)spans, WX_STR(filename));
+	if (dropped)
+		Console.Warning("Timeline: %llu spans were dropped, record fewer frames", (unsigned long long)dropped);
+}
+
+static void Finish()
+{
+	s_recording.store(false, std::memory_order_seq_cst);
+
+	{
+		Threading::ScopedLock lock(s_lock);
+		for (auto& buf : s_buffers)
+		{
+			while (buf->busy.load(std::memory_order_acquire))
+				Threading::SpinWait();
+		}
+	}
+
+	if (s_vsyncs.empty())
+		return;
+
+	g_Conf->Folders.Logs.Mkdir();
+	Write(Path::Combine(g_Conf->Folders.Logs, wxsFormat(L"timeline_%u-%u.json", s_firstFrame, s_firstFrame + s_frames - 1)),
+		  s_vsyncs.front().second);
+
+	s_vsyncs.clear();
+}
+
+void VSync(u32 frame)
+{
+	const Pcsx2Config::ProfilerOptions& options = EmuConfig.Profiler;
+
+	if (!IsRecording())
+	{
+		// Once per run, unless the frame counter goes back (reset, savestate load)
+		if (frame < options.TimelineFirstFrame)
+			s_captured = false;
+		if (s_captured || !options.Enabled || !options.Timeline || !options.TimelineFrames || frame != options.TimelineFirstFrame)
+			return;
+
+		s_captured = true;
+		Start(frame, options.TimelineFrames);
+		return;
+	}
+
+	// Frames recorded after the requested range, so the MTGS (which runs up to
+	// GS.VsyncQueueSize frames behind the EE) and the MTVU thread get to the end of it too
+	if (frame >= s_firstFrame + s_frames + EmuConfig.GS.VsyncQueueSize + 1)
+	{
+		Finish();
+		return;
+	}
+
+	s_vsyncs.emplace_back(frame, GetCPUTicks());
+}
+
+void Stop()
+{
+	if (IsRecording())
+		Finish();
+}
+
+}
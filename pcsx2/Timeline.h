@@ -0,0 +1,108 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+
+// --------------------------------------------------------------------------------------
+//  Timeline
+// --------------------------------------------------------------------------------------
+// Records what each emulator thread is doing over a range of frames (EE code and event
+// tests, IOP, counters and vsync, MTGS packets, MTVU programs, SPU2 mixing, CDVD reads)
+// and writes it to the logs folder as a Chrome trace (chrome://tracing, Perfetto).
+//
+// Enabled through Profiler.Enabled + Profiler.Timeline; the capture starts at the EE vsync
+// of frame Profiler.TimelineFirstFrame and covers Profiler.TimelineFrames frames, plus a
+// few more so the MTGS and MTVU threads catch up with the last of them.
+//
+// Each thread records its spans into a ring buffer of its own, so nothing is shared between
+// threads while recording.  The buffers are only read once the capture is over.
+namespace Timeline
+{
+
+enum SpanType
+{
+	Span_EE,            // EE code between two event tests
+	Span_EEEventTest,   // _cpuEventTest_Shared()
+	Span_IOP,           // psxCpu->ExecuteBlock()
+	Span_rcntUpdate,
+	Span_VSyncStart,
+	Span_MTGSPacket,
+	Span_MTGSVsync,     // GSvsync(), the GS plugin presenting the frame
+	Span_MTVUProgram,
+	Span_SPU2Mix,       // TimeUpdate() mixing one or more samples
+	Span_CDVDReadTrack,
+	Span_CDVDGetBuffer,
+
+	SpanType_Count
+};
+
+extern std::atomic<bool> s_recording;
+
+__fi bool IsRecording()
+{
+	return s_recording.load(std::memory_order_relaxed);
+}
+
+// Start of a span, in GetCPUTicks() units.  0 when not recording.
+__fi u64 Begin()
+{
+	return IsRecording() ? GetCPUTicks() : 0;
+}
+
+void AddSpan(SpanType type, u64 begin, u64 end);
+
+// Ends a span started by Begin(), and returns the time it ended (or the time now if it
+// didn't start because the capture hadn't started yet).  0 when not recording.
+__fi u64 End(SpanType type, u64 begin)
+{
+	if (!begin)
+		return Begin();
+	const u64 end = GetCPUTicks();
+	AddSpan(type, begin, end);
+	return end;
+}
+
+// Names the calling thread in the trace (the name must be a string literal).
+void SetThreadName(const char* name);
+
+// Starts and ends the capture.  EE thread only, at the start of every vsync.
+void VSync(u32 frame);
+
+// Writes out a capture that is still running (emulation stopped before its last frame).
+void Stop();
+
+// Records a span from construction to destruction, when recording.
+class Scope
+{
+	SpanType m_type;
+	u64 m_begin;
+
+public:
+	Scope(SpanType type)
+		: m_type(type)
+		, m_begin(Begin())
+	{
+	}
+
+	~Scope()
+	{
+		if (m_begin)
+			End(m_type, m_begin);
+	}
+};
+
+}
@@ -152,6 +152,14 @@ public:
 	// there is another gif path 2/3 transfer already taking place.
 	// Use this method to resume execution of VU1.
 	virtual void ResumeXGkick() {}
+
+	// Called after a VIF MPG transfer finished writing micro memory (addr/size in bytes, of
+	// the last write).  Recompilers can use it to compile the program which is likely to be
+	// started next ahead of time.
+	//
+	// Thread Affinity:
+	//   Called from the thread owning micro memory (the VU thread when MTVU is enabled).
+	virtual void MicroUploaded(u32 addr, u32 size) {}
 };
 
 
@@ -241,6 +249,7 @@ public:
 	void Clear(u32 addr, u32 size);
 	void Vsync() noexcept;
 	void ResumeXGkick();
+	void MicroUploaded(u32 addr, u32 size);
 
 	uint GetCacheReserve() const;
 	void SetCacheReserve( uint reserveInMegs ) const;
@@ -257,7 +257,7 @@ vifOp(vifCode_Mark) {
 	return 1;
 }
 
-static __fi void _vifCode_MPG(int idx, u32 addr, const u32 *data, int size) {
+static __fi void _vifCode_MPG(int idx, u32 addr, const u32 *data, int size, bool last) {
 	VURegs& VUx = idx ? VU1 : VU0;
 	vifStruct& vifX = GetVifX;
 	u16 vuMemSize = idx ? 0x4000 : 0x1000;
@@ -266,7 +266,7 @@ static __fi void _vifCode_MPG(int idx, u32 addr, const u32 *data, int size) {
 	vifExecQueue(idx);
 
 	if (idx && THREAD_VU1) {
-		vu1Thread.WriteMicroMem(addr, (u8*)data, size*4);
+		vu1Thread.WriteMicroMem(addr, (u8*)data, size*4, last);
 		return;
 	}
 
@@ -319,7 +319,7 @@ vifOp(vifCode_MPG) {
 			if((vifX.tag.addr + vifX.vifpacketsize*4) > (idx ? 0x4000 : 0x1000)) {
 				//DevCon.Warning("Vif%d MPG Split Overflow", idx);
 			}
-			_vifCode_MPG(idx,    vifX.tag.addr, data, vifX.vifpacketsize);
+			_vifCode_MPG(idx,    vifX.tag.addr, data, vifX.vifpacketsize, false);
 			vifX.tag.size -= vifX.vifpacketsize; //We can do this first as its passed as a pointer
 			return vifX.vifpacketsize;
 		}
@@ -327,7 +327,7 @@ vifOp(vifCode_MPG) {
 			if((vifX.tag.addr + vifX.tag.size*4) > (idx ? 0x4000 : 0x1000)) {
 				//DevCon.Warning("Vif%d MPG Split Overflow full %x", idx, vifX.tag.addr + vifX.tag.size*4);
 			}
-			_vifCode_MPG(idx,  vifX.tag.addr, data, vifX.tag.size);
+			_vifCode_MPG(idx,  vifX.tag.addr, data, vifX.tag.size, true);
 			int ret = vifX.tag.size;
 			vifX.tag.size = 0;
 			vifX.cmd      = 0;
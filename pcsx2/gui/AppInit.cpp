@@ -21,6 +21,7 @@
 #include "ConsoleLogger.h"
 #include "MSWstuff.h"
 #include "MTVU.h" // for thread cancellation on shutdown
+#include "CDVD/IsoFileFormats.h"
 
 #include "Utilities/IniInterface.h"
 #ifndef __LIBRETRO__
@@ -271,6 +272,7 @@ void Pcsx2App::OnInitCmdLine( wxCmdLineParser& parser )
 	parser.AddSwitch( wxEmptyString,L"portable",	_("enables portable mode operation (requires admin/root access)") );
 
 	parser.AddSwitch( wxEmptyString,L"profiling",	_("update options to ease profiling (debug)") );
+	parser.AddSwitch( wxEmptyString,L"isobench",	_("measures the read speed of the specified IsoFile, then exits (debug)") );
 
 	ForPlugins([&] (const PluginInfo * pi) {
 		parser.AddOption( wxEmptyString, pi->GetShortname().Lower(),
@@ -363,6 +365,14 @@ bool Pcsx2App::OnCmdLineParsed( wxCmdLineParser& parser )
 	m_UseGUI	= !parser.Found(L"nogui");
 	m_NoGuiExitPrompt = parser.Found(L"noguiprompt"); // by default no prompt for exit with nogui.
 #endif
+
+	if (parser.Found(L"isobench"))
+	{
+		if (parser.GetParamCount() >= 1)
+			BenchmarkIsoRead(parser.GetParam(0));
+		return false;
+	}
+
 	if( !ParseOverrides(parser) ) return false;
 
 	// --- Parse Startup/Autoboot options ---
@@ -76,37 +76,25 @@ vtlb_private::VTLBVirtual::VTLBVirtual(VTLBPhysical phys, u32 paddr, u32 vaddr)
 	}
 }
 
+// The cached ranges of the TLB are flattened into cachedPageMap by updateCachedPages(),
+// so this is a table lookup rather than a walk over all 48 entries.
 __inline int CheckCache(u32 addr)
 {
-	u32 mask;
-
 	if(((cpuRegs.CP0.n.Config >> 16) & 0x1) == 0) 
 	{
 		//DevCon.Warning("Data Cache Disabled! %x", cpuRegs.CP0.n.Config);
 		return false;//
 	}
 
-	for(int i = 1; i < 48; i++)
-	{
-		if (((tlb[i].EntryLo1 & 0x38) >> 3) == 0x3) {
-			mask  = tlb[i].PageMask;
-			
-			if ((addr >= tlb[i].PFN1) && (addr <= tlb[i].PFN1 + mask)) {
-				//DevCon.Warning("Yay! Cache check cache addr=%x, mask=%x, addr+mask=%x, VPN2=%x PFN0=%x", addr, mask, (addr & mask), tlb[i].VPN2, tlb[i].PFN0); 
-				return true;
-			}
-		}
-		if (((tlb[i].EntryLo0 & 0x38) >> 3) == 0x3) {
-			mask  = tlb[i].PageMask;
-			
-			if ((addr >= tlb[i].PFN0) && (addr <= tlb[i].PFN0 + mask)) {
-				//DevCon.Warning("Yay! Cache check cache addr=%x, mask=%x, addr+mask=%x, VPN2=%x PFN0=%x", addr, mask, (addr & mask), tlb[i].VPN2, tlb[i].PFN0); 
-				return true;
-			}
-		}
-	}
-	return false;
+	return cachedPageMap[addr >> VTLB_PAGE_BITS];
+}
+// The EE recompiler emulates the data cache on x86-64 only (see recVTLB.cpp).  Elsewhere the
+// accessors it falls back on must bypass the cache as well, so both agree on memory contents.
+static __fi bool CheckCacheAccess()
+{
+	return sizeof(void*) == 8 || !CHECK_EEREC;
 }
+
 // --------------------------------------------------------------------------------------
 // Interpreter Implementations of VTLB Memory Operations.
 // --------------------------------------------------------------------------------------
@@ -120,7 +108,7 @@ DataType __fastcall vtlb_memRead(u32 addr)
 
 	if (!vmv.isHandler(addr))
 	{
-		if (!CHECK_EEREC) 
+		if (CheckCacheAccess()) 
 		{
 			if(CHECK_CACHE && CheckCache(addr)) 
 			{
@@ -170,7 +158,7 @@ void __fastcall vtlb_memRead64(u32 mem, mem64_t *out)
 
 	if (!vmv.isHandler(mem))
 	{
-		if (!CHECK_EEREC) {
+		if (CheckCacheAccess()) {
 			if(CHECK_CACHE && CheckCache(mem)) 
 			{
 				*out = readCache64(mem);
@@ -194,7 +182,7 @@ void __fastcall vtlb_memRead128(u32 mem, mem128_t *out)
 
 	if (!vmv.isHandler(mem))
 	{
-		if (!CHECK_EEREC) 
+		if (CheckCacheAccess()) 
 		{
 			if(CHECK_CACHE && CheckCache(mem)) 
 			{
@@ -224,7 +212,7 @@ void __fastcall vtlb_memWrite(u32 addr, DataType data)
 
 	if (!vmv.isHandler(addr))
 	{		
-		if (!CHECK_EEREC) 
+		if (CheckCacheAccess()) 
 		{
 			if(CHECK_CACHE && CheckCache(addr)) 
 			{
@@ -260,7 +248,7 @@ void __fastcall vtlb_memWrite64(u32 mem, const mem64_t* value)
 
 	if (!vmv.isHandler(mem))
 	{		
-		if (!CHECK_EEREC) 
+		if (CheckCacheAccess()) 
 		{
 			if(CHECK_CACHE && CheckCache(mem)) 
 			{
@@ -287,7 +275,7 @@ void __fastcall vtlb_memWrite128(u32 mem, const mem128_t *value)
 
 	if (!vmv.isHandler(mem))
 	{
-		if (!CHECK_EEREC) 
+		if (CheckCacheAccess()) 
 		{
 			if(CHECK_CACHE && CheckCache(mem)) 
 			{
@@ -658,6 +646,217 @@ __fi u32 vtlb_V2P(u32 vaddr)
 	return paddr;
 }
 
+// --------------------------------------------------------------------------------------
+//  Fastmem  (Recompiler.EEFastmem)
+// --------------------------------------------------------------------------------------
+// A 4GB host reservation mirrors the EE virtual address space.  Every page the vmap points
+// to main memory or the scratchpad is a view of the same (shared memory) pages as eeMem,
+// so the recompiler can access memory with a single base+address instruction.  All other
+// pages (handlers, ROMs, unmapped pages) are left inaccessible: the access faults, and the
+// recompiler patches it over to the vmap lookup (see recVTLB.cpp).
+//
+// The views follow the vmap (vtlb_VMap, vtlb_VMapBuffer and vtlb_VMapUnmap), and the write
+// protection of the pages holding recompiled code (vtlb_FastmemProtect).
+
+static const uint FastmemViewSize	= Ps2MemSize::MainRam + Ps2MemSize::Scratch;
+static const uint FastmemViewPages	= FastmemViewSize / VTLB_PAGE_SIZE;
+static const uint FastmemGuardSize	= _64kb;	// accesses running past the end of the address space
+
+struct FastmemState
+{
+	std::unique_ptr<VirtualMemoryManager> arena;
+	int shm = -1;			// shared memory behind eeMem->Main and Scratch
+	bool active = false;
+
+	std::vector<u16> view;	// arena page -> view page + 1, 0 if inaccessible
+	std::vector<u32> views[FastmemViewPages];	// arena pages viewing each page
+	bool readOnly[FastmemViewPages];	// write protection of the eeMem pages
+};
+
+static FastmemState s_fastmem;
+
+static u8* FastmemPage( u32 page )
+{
+	return (u8*)s_fastmem.arena->GetBase() + ((uptr)page << VTLB_PAGE_BITS);
+}
+
+static void vtlb_FastmemSetup()
+{
+	s_fastmem.shm = HostSys::CreateSharedMemory( "eemem", FastmemViewSize );
+	if (s_fastmem.shm < 0 || !HostSys::MapSharedMemory( s_fastmem.shm, 0, eeMem->Main, FastmemViewSize, PageAccess_ReadWrite() ))
+	{
+		Console.Warning( "(vtlb) Fastmem is not available on this host, using the vmap lookup." );
+		HostSys::DestroySharedMemory( s_fastmem.shm );
+		s_fastmem.shm = -1;
+		return;
+	}
+
+	s_fastmem.arena.reset( new VirtualMemoryManager( L"EE Fastmem", 0, _4gb + FastmemGuardSize ) );
+	if (!s_fastmem.arena->IsOk())
+	{
+		Console.Warning( "(vtlb) Fastmem could not reserve its address space, using the vmap lookup." );
+		s_fastmem.arena.reset();
+		return;
+	}
+
+	s_fastmem.view.resize( VTLB_VMAP_ITEMS );
+	memzero( s_fastmem.readOnly );
+}
+
+// Maps count arena pages to the view pages starting at first, or makes them inaccessible
+// if first is -1.  Pages whose view can't be mapped are left inaccessible as well, their
+// accesses just take the vmap lookup.
+static void vtlb_FastmemMapRun( u32 page, u32 count, s32 first )
+{
+	if (!count) return;
+
+	if (first >= 0 && HostSys::MapSharedMemory( s_fastmem.shm, (uptr)first << VTLB_PAGE_BITS,
+		FastmemPage(page), count << VTLB_PAGE_BITS, PageAccess_ReadWrite() ))
+	{
+		for (u32 i = 0; i < count; i++)
+		{
+			if (s_fastmem.readOnly[first + i])
+				HostSys::MemProtect( FastmemPage(page + i), VTLB_PAGE_SIZE, PageAccess_ReadOnly() );
+		}
+		return;
+	}
+
+	HostSys::MmapResetPtr( FastmemPage(page), count << VTLB_PAGE_BITS );
+	if (first < 0) return;
+
+	for (u32 i = 0; i < count; i++)
+	{
+		std::vector<u32>& views = s_fastmem.views[first + i];
+		views.erase( std::find( views.begin(), views.end(), page + i ) );
+		s_fastmem.view[page + i] = 0;
+	}
+}
+
+// Brings the arena pages of [vaddr, vaddr+size) in line with the vmap.
+static void vtlb_FastmemUpdate( u32 vaddr, u32 size )
+{
+	if (!s_fastmem.active) return;
+
+	const u32 end = (vaddr >> VTLB_PAGE_BITS) + (size >> VTLB_PAGE_BITS);
+	u32 runPage = 0, runCount = 0;
+	s32 runFirst = -1;
+
+	for (u32 page = vaddr >> VTLB_PAGE_BITS; page < end; page++)
+	{
+		const u32 addr = page << VTLB_PAGE_BITS;
+		const VTLBVirtual vmv = vtlbdata.vmap[page];
+
+		s32 view = -1;
+		if (!vmv.isHandler(addr))
+		{
+			const uptr offset = vmv.assumePtr(addr) - (uptr)eeMem->Main;
+			if (offset < FastmemViewSize) view = offset >> VTLB_PAGE_BITS;
+		}
+
+		u16& cur = s_fastmem.view[page];
+		if (cur == view + 1)
+		{
+			vtlb_FastmemMapRun( runPage, runCount, runFirst );
+			runCount = 0;
+			continue;
+		}
+
+		if (cur)
+		{
+			std::vector<u32>& views = s_fastmem.views[cur - 1];
+			views.erase( std::find( views.begin(), views.end(), page ) );
+		}
+		cur = view + 1;
+		if (view >= 0) s_fastmem.views[view].push_back( page );
+
+		// Contiguous pages of the same kind are mapped with a single call
+		if (runCount && (view < 0 ? runFirst < 0 : view == runFirst + (s32)runCount))
+		{
+			runCount++;
+			continue;
+		}
+
+		vtlb_FastmemMapRun( runPage, runCount, runFirst );
+		runPage = page;
+		runCount = 1;
+		runFirst = view;
+	}
+
+	vtlb_FastmemMapRun( runPage, runCount, runFirst );
+}
+
+// Latches Recompiler.EEFastmem, and starts out with an inaccessible arena (vtlb_Init fills
+// it in).  Called on every reset of EE memory.
+void vtlb_FastmemReset()
+{
+	const bool enable = CHECK_EE_FASTMEM && EmuConfig.Cpu.Recompiler.EnableEE && !CHECK_CACHE
+		&& (sizeof(uptr) == 8) && Source_PageFault->CanResume();
+
+	if (enable && !s_fastmem.arena)
+		vtlb_FastmemSetup();
+
+	s_fastmem.active = false;
+	if (!s_fastmem.arena) return;
+
+	HostSys::MmapResetPtr( s_fastmem.arena->GetBase(), _4gb );
+	std::fill( s_fastmem.view.begin(), s_fastmem.view.end(), 0 );
+	for (std::vector<u32>& views : s_fastmem.views)
+		views.clear();
+
+	// readOnly is left alone, eeMem->Main keeps its protection until the recompiler resets.
+	s_fastmem.active = enable;
+}
+
+// Called when EE memory is decommitted (eeMem->Main isn't shared memory anymore).
+void vtlb_FastmemRelease()
+{
+	s_fastmem.active = false;
+	s_fastmem.arena.reset();
+	HostSys::DestroySharedMemory( s_fastmem.shm );
+	s_fastmem.shm = -1;
+
+	std::vector<u16>().swap( s_fastmem.view );
+	for (std::vector<u32>& views : s_fastmem.views)
+		std::vector<u32>().swap( views );
+}
+
+u8* vtlb_GetFastmemBase()
+{
+	return s_fastmem.active ? (u8*)s_fastmem.arena->GetBase() : NULL;
+}
+
+// Also true while fastmem is off, for the accesses compiled before it was switched off.
+bool vtlb_IsFastmemAddress( uptr addr )
+{
+	return s_fastmem.arena && (addr - (uptr)s_fastmem.arena->GetBase()) < _4gb + FastmemGuardSize;
+}
+
+// Returns the offset into eeMem->Main of the page viewed at a fastmem address, or -1 if
+// the address isn't in a view.
+uptr vtlb_FastmemViewOffset( uptr addr )
+{
+	const uptr offset = addr - (uptr)s_fastmem.arena->GetBase();
+	if (offset >= _4gb || !s_fastmem.view[offset >> VTLB_PAGE_BITS])
+		return (uptr)-1;
+
+	return ((uptr)(s_fastmem.view[offset >> VTLB_PAGE_BITS] - 1) << VTLB_PAGE_BITS) | (offset & VTLB_PAGE_MASK);
+}
+
+// Applies a protection change of eeMem->Main pages to their views.
+void vtlb_FastmemProtect( u32 offset, u32 size, const PageProtectionMode& mode )
+{
+	if (!s_fastmem.active) return;
+
+	for (u32 i = offset >> VTLB_PAGE_BITS; i < (offset + size) >> VTLB_PAGE_BITS; i++)
+	{
+		if (s_fastmem.readOnly[i] == !mode.CanWrite()) continue;
+		s_fastmem.readOnly[i] = !mode.CanWrite();
+
+		for (u32 page : s_fastmem.views[i])
+			HostSys::MemProtect( FastmemPage(page), VTLB_PAGE_SIZE, mode );
+	}
+}
+
 //virtual mappings
 //TODO: Add invalid paddr checks
 void vtlb_VMap(u32 vaddr,u32 paddr,u32 size)
@@ -666,6 +865,7 @@ void vtlb_VMap(u32 vaddr,u32 paddr,u32 size)
 	verify(0==(paddr&VTLB_PAGE_MASK));
 	verify(0==(size&VTLB_PAGE_MASK) && size>0);
 
+	const u32 start = vaddr, len = size;
 	while (size > 0)
 	{
 		VTLBVirtual vmv;
@@ -688,6 +888,8 @@ void vtlb_VMap(u32 vaddr,u32 paddr,u32 size)
 		paddr += VTLB_PAGE_SIZE;
 		size -= VTLB_PAGE_SIZE;
 	}
+
+	vtlb_FastmemUpdate(start, len);
 }
 
 void vtlb_VMapBuffer(u32 vaddr,void* buffer,u32 size)
@@ -695,6 +897,7 @@ void vtlb_VMapBuffer(u32 vaddr,void* buffer,u32 size)
 	verify(0==(vaddr&VTLB_PAGE_MASK));
 	verify(0==(size&VTLB_PAGE_MASK) && size>0);
 
+	const u32 start = vaddr, len = size;
 	uptr bu8 = (uptr)buffer;
 	while (size > 0)
 	{
@@ -703,6 +906,8 @@ void vtlb_VMapBuffer(u32 vaddr,void* buffer,u32 size)
 		bu8 += VTLB_PAGE_SIZE;
 		size -= VTLB_PAGE_SIZE;
 	}
+
+	vtlb_FastmemUpdate(start, len);
 }
 
 void vtlb_VMapUnmap(u32 vaddr,u32 size)
@@ -710,6 +915,7 @@ void vtlb_VMapUnmap(u32 vaddr,u32 size)
 	verify(0==(vaddr&VTLB_PAGE_MASK));
 	verify(0==(size&VTLB_PAGE_MASK) && size>0);
 
+	const u32 start = vaddr, len = size;
 	while (size > 0)
 	{
 
@@ -724,6 +930,8 @@ void vtlb_VMapUnmap(u32 vaddr,u32 size)
 		vaddr += VTLB_PAGE_SIZE;
 		size -= VTLB_PAGE_SIZE;
 	}
+
+	vtlb_FastmemUpdate(start, len);
 }
 
 // vtlb_Init -- Clears vtlb handlers and memory mappings.
@@ -103,6 +103,19 @@ extern void vtlb_DynGenWrite_Const( u32 bits, u32 addr_const );
 extern void vtlb_DynGenRead64_Const( u32 bits, u32 addr_const );
 extern void vtlb_DynGenRead32_Const( u32 bits, bool sign, u32 addr_const );
 
+// Fastmem (Recompiler.EEFastmem)
+extern void vtlb_FastmemReset();
+extern void vtlb_FastmemRelease();
+extern u8*  vtlb_GetFastmemBase();
+extern bool vtlb_IsFastmemAddress( uptr addr );
+extern uptr vtlb_FastmemViewOffset( uptr addr );
+extern void vtlb_FastmemProtect( u32 offset, u32 size, const PageProtectionMode& mode );
+
+extern void vtlb_FastmemResetSites( u8* thunks, u32 size );
+extern void vtlb_FastmemClearSites( uptr start, uptr end );
+extern bool vtlb_FastmemThunksLow();
+extern uptr vtlb_FastmemBackpatch( uptr pc );
+
 // --------------------------------------------------------------------------------------
 //  VtlbMemoryReserve
 // --------------------------------------------------------------------------------------
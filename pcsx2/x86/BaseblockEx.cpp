@@ -17,13 +17,83 @@
 #include "PrecompiledHeader.h"
 #include "BaseblockEx.h"
 
+void BaseBlockLinks::Rehash(u32 size)
+{
+	std::vector<Bucket> old;
+	old.swap(m_table);
+
+	m_table.assign(size, Bucket{0, NONE});
+	m_shift = 64;
+	for (u32 i = size; i > 1; i >>= 1)
+		m_shift--;
+
+	for (const Bucket& bucket : old) {
+		if (bucket.head != NONE)
+			m_table[Find(bucket.pc)] = bucket;
+	}
+}
+
+void BaseBlockLinks::Add(u32 pc, uptr jumpptr)
+{
+	u32 pos = Find(pc);
+	if (m_table[pos].head == NONE) {
+		// Keep the load factor under 50%, probes stay short
+		if ((m_used + 1) * 2 > m_table.size()) {
+			Rehash((u32)m_table.size() * 2);
+			pos = Find(pc);
+		}
+		m_table[pos].pc = pc;
+		m_used++;
+	}
+
+	m_links.push_back(Link{jumpptr, m_table[pos].head});
+	m_table[pos].head = (u32)m_links.size() - 1;
+}
+
+void BaseBlockLinks::Remove(uptr start, uptr end)
+{
+	std::vector<Link> kept;
+	kept.reserve(m_links.size());
+
+	m_used = 0;
+	for (Bucket& bucket : m_table) {
+		if (bucket.head == NONE)
+			continue;
+
+		u32 head = NONE;
+		for (u32 link = bucket.head; link != NONE; link = m_links[link].next) {
+			const uptr jumpptr = m_links[link].jumpptr;
+			if (jumpptr >= start && jumpptr < end)
+				continue;
+			kept.push_back(Link{jumpptr, head});
+			head = (u32)kept.size() - 1;
+		}
+
+		bucket.head = head;
+		if (head != NONE)
+			m_used++;
+	}
+
+	m_links.swap(kept);
+
+	// Emptied buckets would break the probe sequences, rebuild the table without them.
+	Rehash((u32)m_table.size());
+}
+
+void BaseBlockLinks::Clear()
+{
+	std::fill(m_table.begin(), m_table.end(), Bucket{0, NONE});
+	m_links.clear();
+	m_used = 0;
+}
+
 BASEBLOCKEX* BaseBlocks::New(u32 startpc, uptr fnptr)
 {
-	std::pair<linkiter_t, linkiter_t> range = links.equal_range(startpc);
-	for (linkiter_t i = range.first; i != range.second; ++i)
-		*(u32*)i->second = fnptr - (i->second + 4);
-	
-	return blocks.insert(startpc, fnptr);;
+	links.ForEach(startpc, [fnptr](uptr jumpptr) {
+		*(u32*)jumpptr = fnptr - (jumpptr + 4);
+	});
+
+	return blocks.insert(startpc, fnptr);
 }
 
 int BaseBlocks::LastIndex(u32 startpc) const
@@ -77,6 +147,6 @@ void BaseBlocks::Link(u32 pc, s32* jumpptr)
 		*jumpptr = (s32)(targetblock->fnptr - (sptr)(jumpptr + 1));
 	else
 		*jumpptr = (s32)(recompiler - (sptr)(jumpptr + 1));
-	links.insert(std::pair<u32, uptr>(pc, (uptr)jumpptr));
+	links.Add(pc, (uptr)jumpptr);
 }
 
@@ -15,7 +15,7 @@
 
 #pragma once
 
-#include <map>			// used by BaseBlockEx
+#include <vector>
 
 // Every potential jump point in the PS2's addressable memory has a BASEBLOCK
 // associated with it. So that means a BASEBLOCK for every 4 bytes of PS2
@@ -44,26 +44,37 @@ struct BASEBLOCKEX
 
 };
 
+// Blocks sorted by startpc.  The free space of the array is kept as a gap at the position
+// of the last insertion/removal: recompiling after a clear (self-modifying code) or
+// compiling neighbouring code only has to move the blocks between the old and the new
+// position of the gap, instead of the whole tail of the array for every block.
 class BaseBlockArray {
 	s32 _Reserved;
 	s32 _Size;
+	s32 _GapStart;
 	BASEBLOCKEX *blocks;
 
-	__fi void resize(s32 size)
+	__fi s32 gapSize() const { return _Reserved - _Size; }
+
+	void moveGap(s32 pos)
+	{
+		if (pos < _GapStart)
+			memmove(blocks + pos + gapSize(), blocks + pos, (_GapStart - pos) * sizeof(BASEBLOCKEX));
+		else if (pos > _GapStart)
+			memmove(blocks + _GapStart, blocks + _GapStart + gapSize(), (pos - _GapStart) * sizeof(BASEBLOCKEX));
+		_GapStart = pos;
+	}
+
+	void reserve(s32 size)
 	{
 		pxAssert(size > 0);
 		BASEBLOCKEX *newMem = new BASEBLOCKEX[size];
 		if(blocks) {
-			memcpy(newMem, blocks, _Reserved * sizeof(BASEBLOCKEX));
+			moveGap(_Size);
+			memcpy(newMem, blocks, _Size * sizeof(BASEBLOCKEX));
 			delete[] blocks;
 		}
 		blocks = newMem;
-		pxAssert(blocks != NULL);
-	}
-
-	void reserve(u32 size)
-	{
-		resize(size);
 		_Reserved = size;
 	}
 public:
@@ -75,7 +86,7 @@ public:
 	}
 
 	BaseBlockArray (s32 size) : _Reserved(0),
-		_Size(0), blocks(NULL)
+		_Size(0), _GapStart(0), blocks(NULL)
 	{
 		reserve(size);
 	}
@@ -83,7 +94,7 @@ public:
 	BASEBLOCKEX *insert(u32 startpc, uptr fnptr)
 	{
 		if(_Size + 1 >= _Reserved) {
-			reserve(_Reserved + 0x2000); // some games requires even more!
+			reserve(_Reserved * 2); // some games requires even more!
 		}
 
 		// Insert the the new BASEBLOCKEX by startpc order
@@ -92,35 +103,34 @@ public:
 		while (imin < imax) {
 			imid = (imin+imax)>>1;
 
-			if (blocks[imid].startpc > startpc)
+			if ((*this)[imid].startpc > startpc)
 				imax = imid;
 			else
 				imin = imid + 1;
 		}
-	
-		pxAssert(imin == _Size || blocks[imin].startpc > startpc);
 
-		if(imin < _Size) {
-			// make a hole for a new block.
-			memmove(blocks + imin + 1, blocks + imin, (_Size - imin) * sizeof(BASEBLOCKEX));
-		}
+		pxAssert(imin == _Size || (*this)[imin].startpc > startpc);
 
+		// fill the start of the gap with the new block.
+		moveGap(imin);
 		memset((blocks + imin), 0, sizeof(BASEBLOCKEX));
 		blocks[imin].startpc = startpc;
 		blocks[imin].fnptr = fnptr;
 
+		_GapStart++;
 		_Size++;
 		return &blocks[imin];
 	}
 
 	__fi BASEBLOCKEX &operator[](int idx) const
 	{
-		return *(blocks + idx);
+		return *(blocks + (idx < _GapStart ? idx : idx + gapSize()));
 	}
 
 	void clear()
 	{
 		_Size = 0;
+		_GapStart = 0;
 	}
 
 	__fi u32 size() const
@@ -130,23 +140,79 @@ public:
 
 	__fi void erase(s32 first, s32 last)
 	{
-		int range = last - first;
+		// the erased blocks become part of the gap.
+		moveGap(last);
+		_GapStart = first;
+		_Size -= last - first;
+	}
+};
 
-		if(last < _Size) {
-			memmove(blocks + first, blocks + last, (_Size - last) * sizeof(BASEBLOCKEX));
-		}
+// Jump links to block start pcs: every static jump emitted to a block is recorded here,
+// so it can be patched when the target block is compiled or cleared.  Links are only
+// ever added (while compiling) and dropped all at once on reset, or by range when the
+// code holding them is evicted, so the index is an open-addressed pc table whose
+// buckets head a chain in a flat array of jump pointers.
+class BaseBlockLinks
+{
+	struct Bucket
+	{
+		u32 pc;
+		u32 head; // first link of the pc, NONE if the bucket is empty
+	};
+
+	struct Link
+	{
+		uptr jumpptr;
+		u32  next;
+	};
+
+	static const u32 NONE = 0xffffffff;
+
+	std::vector<Bucket> m_table;
+	std::vector<Link> m_links;
+	u32 m_used;
+	u8  m_shift;
 
-		_Size -= range;
+	__fi u32 Home(u32 pc) const { return (u32)(((pc >> 2) * 0x9E3779B97F4A7C15ull) >> m_shift); }
+
+	__fi u32 Find(u32 pc) const
+	{
+		const u32 mask = (u32)m_table.size() - 1;
+		u32 pos = Home(pc);
+		while (m_table[pos].head != NONE && m_table[pos].pc != pc)
+			pos = (pos + 1) & mask;
+		return pos;
+	}
+
+	void Rehash(u32 size);
+
+public:
+	BaseBlockLinks()
+		: m_used(0)
+		, m_shift(0)
+	{
+		Rehash(0x4000);
+	}
+
+	void Add(u32 pc, uptr jumpptr);
+	void Remove(uptr start, uptr end);
+	void Clear();
+
+	__fi u32 size() const { return (u32)m_links.size(); }
+
+	// Calls func(jumpptr) for every link to pc.
+	template<typename Fn>
+	__fi void ForEach(u32 pc, const Fn& func) const
+	{
+		for (u32 link = m_table[Find(pc)].head; link != NONE; link = m_links[link].next)
+			func(m_links[link].jumpptr);
 	}
 };
 
 class BaseBlocks
 {
 protected:
-	typedef std::multimap<u32, uptr>::iterator linkiter_t;
-
-	// switch to a hash map later?
-	std::multimap<u32, uptr> links;
+	BaseBlockLinks links;
 	uptr recompiler;
 	BaseBlockArray blocks;
 
@@ -193,14 +259,14 @@ public:
 	__fi void Remove(int first, int last)
 	{
 		pxAssert(first <= last);
+		const uptr recompiler_ = recompiler;
 		int idx = first;
 		do{
 			pxAssert(idx <= last);
 
-			//u32 startpc = blocks[idx].startpc;
-			std::pair<linkiter_t, linkiter_t> range = links.equal_range(blocks[idx].startpc);
-			for (linkiter_t i = range.first; i != range.second; ++i)
-				*(u32*)i->second = recompiler - (i->second + 4);
+			links.ForEach(blocks[idx].startpc, [recompiler_](uptr jumpptr) {
+				*(u32*)jumpptr = recompiler_ - (jumpptr + 4);
+			});
 
 			if( IsDevBuild )
 			{
@@ -221,10 +287,16 @@ public:
 
 	void Link(u32 pc, s32* jumpptr);
 
+	// Drops the links whose jump lies in [start, end), the code there is being reused.
+	void RemoveLinks(uptr start, uptr end)
+	{
+		links.Remove(start, end);
+	}
+
 	__fi void Reset()
 	{
 		blocks.clear();
-		links.clear();
+		links.Clear();
 	}
 };
 
@@ -0,0 +1,138 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "BlockProfiler.h"
+
+#include "x86emitter/x86emitter.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace x86Emitter;
+
+namespace BlockProfiler
+{
+
+Table ee("EE");
+Table iop("IOP");
+Table vu0("VU0");
+Table vu1("VU1");
+
+Table::Table(const char* name)
+	: m_name(name)
+	, m_enabled(false)
+{
+}
+
+void Table::Reset(bool enabled)
+{
+	Threading::ScopedLock lock(m_lock);
+	m_blocks.clear();
+	m_index.clear();
+	m_enabled = enabled;
+}
+
+BlockStats* Table::Begin(u32 startpc, u32 prog)
+{
+	if (!m_enabled)
+		return NULL;
+
+	BlockStats* stats;
+	{
+		Threading::ScopedLock lock(m_lock);
+		BlockStats*& entry = m_index[(u64)prog << 32 | startpc];
+		if (!entry)
+		{
+			m_blocks.emplace_back();
+			entry = &m_blocks.back();
+			memzero(*entry);
+			entry->startpc = startpc;
+			entry->prog = prog;
+		}
+		stats = entry;
+
+		// The new code may cost a different number of cycles per run.
+		stats->prevCycles = stats->GetCycles();
+		stats->prevCount = stats->count;
+		stats->compiles++;
+	}
+
+	// The counters are on the heap, possibly further than 2GB from the recompiled code, so
+	// their address goes through rax (free at the start of a block in all the recompilers).
+	xLoadFarAddr(rax, &stats->count);
+	xADD(ptr32[rax], 1);
+	xADC(ptr32[rax + 4], 0);
+
+	return stats;
+}
+
+void Table::End(BlockStats* stats, u32 guestsize, u32 x86size, u32 blockcycles)
+{
+	if (!stats)
+		return;
+
+	stats->guestsize = guestsize;
+	stats->x86size = x86size;
+	stats->blockcycles = blockcycles;
+}
+
+void Table::Dump(uint topN)
+{
+	Threading::ScopedLock lock(m_lock);
+
+	if (m_blocks.empty())
+		return;
+
+	std::vector<const BlockStats*> v;
+	v.reserve(m_blocks.size());
+
+	u64 total = 0;
+	for (const BlockStats& b : m_blocks)
+	{
+		if (!b.count)
+			continue;
+		total += b.GetCycles();
+		v.push_back(&b);
+	}
+
+	if (!total)
+		return;
+
+	const uint n = std::min<uint>(topN, v.size());
+	std::partial_sort(v.begin(), v.begin() + n, v.end(), [](const BlockStats* a, const BlockStats* b) {
+		return a->GetCycles() > b->GetCycles();
+	});
+
+	Console.WriteLn("%s Block Profiler: %u blocks executed, top %u by guest cycles:", m_name, (uint)v.size(), n);
+	for (uint i = 0; i < n; i++)
+	{
+		const BlockStats& b = *v[i];
+		const u64 cycles = b.GetCycles();
+		Console.WriteLn("  [%3.4f%%] pc=0x%08x prog=%-4u count=%-12llu cycles=%-14llu insts=%-5u x86=%u bytes compiles=%u",
+			(double)cycles / (double)total * 100.0, b.startpc, b.prog,
+			(unsigned long long)b.count, (unsigned long long)cycles, b.guestsize, b.x86size, b.compiles);
+	}
+}
+
+void Dump(uint topN)
+{
+	ee.Dump(topN);
+	iop.Dump(topN);
+	vu0.Dump(topN);
+	vu1.Dump(topN);
+}
+
+}
@@ -0,0 +1,90 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <deque>
+#include <unordered_map>
+#include "Utilities/Threading.h"
+
+// --------------------------------------------------------------------------------------
+//  BlockProfiler
+// --------------------------------------------------------------------------------------
+// Per-block execution counters for the EE, IOP and microVU recompilers, enabled through
+// the Profiler.RecBlocks_* options.  When enabled, every recompiled block gets a small
+// counter update emitted at its entry point; the tables can then be dumped on demand to
+// find the guest loops a game spends its time in (the libretro core does it when the
+// pcsx2_block_profiler_dump option is toggled).
+//
+// Counters live in a deque so their addresses stay valid for the recompiled code while
+// new blocks are added.  A block compiled again (after a clear, or for another microVU
+// pipeline state) keeps counting in the entry of its startpc and program, so the tables
+// only grow with the guest code.  They are reset together with their recompiler's cache.
+namespace BlockProfiler
+{
+
+struct BlockStats
+{
+	u64 count;       // number of times the block was entered
+	u64 prevCount;   // count when the block was last compiled again
+	u64 prevCycles;  // guest cycles of the first prevCount runs
+	u32 startpc;     // guest start pc of the block
+	u32 prog;        // microVU program index (0 for the EE/IOP)
+	u32 blockcycles; // scaled guest cycles charged per run of the block
+	u32 guestsize;   // number of guest instructions
+	u32 x86size;     // size of the recompiled code, in bytes
+	u32 compiles;    // number of times the block was compiled
+
+	// Runs since the latest compile are charged at its cost.
+	u64 GetCycles() const { return prevCycles + (count - prevCount) * blockcycles; }
+};
+
+class Table
+{
+	Threading::Mutex m_lock;
+	std::deque<BlockStats> m_blocks;
+	std::unordered_map<u64, BlockStats*> m_index; // by prog << 32 | startpc
+	const char* m_name;
+	bool m_enabled;
+
+public:
+	Table(const char* name);
+
+	bool IsEnabled() const { return m_enabled; }
+
+	// Clears all counters, and latches whether blocks compiled from now on are profiled.
+	void Reset(bool enabled);
+
+	// Registers a block (or finds its entry if it was compiled before) and emits its entry
+	// counter at the current x86 pointer, which clobbers rax and the flags.  Returns NULL
+	// when profiling is disabled.
+	BlockStats* Begin(u32 startpc, u32 prog = 0);
+
+	// Fills the static block information once recompilation is done.  Blocks have a
+	// fixed cycle cost, so the guest cycles spent in a block are count * blockcycles.
+	void End(BlockStats* stats, u32 guestsize, u32 x86size, u32 blockcycles);
+
+	// Prints the topN hottest blocks (by guest cycles) to the console.
+	void Dump(uint topN);
+};
+
+// Dumps every table that has profiling enabled.
+void Dump(uint topN = 32);
+
+extern Table ee;
+extern Table iop;
+extern Table vu0;
+extern Table vu1;
+}
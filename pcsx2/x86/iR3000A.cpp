@@ -22,6 +22,7 @@
 
 #include "iR3000A.h"
 #include "BaseblockEx.h"
+#include "BlockProfiler.h"
 #include "System/RecTypes.h"
 
 #include <time.h>
@@ -67,6 +68,7 @@ static u32 s_nInstCacheSize = 0;
 
 static BASEBLOCK* s_pCurBlock = NULL;
 static BASEBLOCKEX* s_pCurBlockEx = NULL;
+static BlockProfiler::BlockStats* s_pCurBlockStats = NULL;
 
 static u32 s_nEndBlock = 0; // what psxpc the current block ends
 static u32 s_branchTo;
@@ -472,11 +474,36 @@ void _psxOnWriteReg(int reg)
 	PSX_DEL_CONST(reg);
 }
 
+// rpsxpropBSC's liveness clears EEINST_LIVE0 for a register when the rest of the block
+// overwrites it before reading it.  Everything is live at the end of the block, and before the
+// instructions that can leave it early (syscall, break and the irx import stubs), so skipping
+// such a write is never visible outside of the block.
+bool _psxIsDeadWrite(int reg)
+{
+	return CHECK_IOP_ANALYSIS && !(g_pCurInstInfo->regs[reg] & EEINST_LIVE0);
+}
+
+// Drops the constants the current instruction, or one after it, overwrites before they are
+// read, so they are never flushed to psxRegs.  Called before the instruction is recompiled:
+// g_pCurInstInfo[-1] holds the liveness on entry to it.
+static void _psxDropDeadConstRegs()
+{
+	for (int i = 1; i < 32; ++i) {
+		if ((g_psxHasConstReg & (1 << i)) && !(g_pCurInstInfo[-1].regs[i] & EEINST_LIVE0))
+			g_psxHasConstReg &= ~(1 << i);
+	}
+}
+
 // rd = rs op rt
 void psxRecompileCodeConst0(R3000AFNPTR constcode, R3000AFNPTR_INFO constscode, R3000AFNPTR_INFO consttcode, R3000AFNPTR_INFO noconstcode)
 {
 	if ( ! _Rd_ ) return;
 
+	if( _psxIsDeadWrite(_Rd_) ) {
+		_psxDeleteReg(_Rd_, 0);
+		return;
+	}
+
 	// for now, don't support xmm
 
 	_deleteX86reg(X86TYPE_PSX, _Rs_, 1);
@@ -555,6 +582,11 @@ void psxRecompileCodeConst1(R3000AFNPTR constcode, R3000AFNPTR_INFO noconstcode)
         return;
     }
 
+	if( _psxIsDeadWrite(_Rt_) ) {
+		_psxDeleteReg(_Rt_, 0);
+		return;
+	}
+
 	// for now, don't support xmm
 
 	_deleteX86reg(X86TYPE_PSX, _Rs_, 1);
@@ -575,6 +607,11 @@ void psxRecompileCodeConst2(R3000AFNPTR constcode, R3000AFNPTR_INFO noconstcode)
 {
 	if ( ! _Rd_ ) return;
 
+	if( _psxIsDeadWrite(_Rd_) ) {
+		_psxDeleteReg(_Rd_, 0);
+		return;
+	}
+
 	// for now, don't support xmm
 
 	_deleteX86reg(X86TYPE_PSX, _Rt_, 1);
@@ -593,6 +630,13 @@ void psxRecompileCodeConst2(R3000AFNPTR constcode, R3000AFNPTR_INFO noconstcode)
 // rd = rt MULT rs  (SPECIAL)
 void psxRecompileCodeConst3(R3000AFNPTR constcode, R3000AFNPTR_INFO constscode, R3000AFNPTR_INFO consttcode, R3000AFNPTR_INFO noconstcode, int LOHI)
 {
+	// mult/div results nobody reads only cost their cycle penalty
+	if( LOHI && _psxIsDeadWrite(PSX_HI) && _psxIsDeadWrite(PSX_LO) ) {
+		_deleteX86reg(X86TYPE_PSX, PSX_HI, 2);
+		_deleteX86reg(X86TYPE_PSX, PSX_LO, 2);
+		return;
+	}
+
 	_deleteX86reg(X86TYPE_PSX, _Rs_, 1);
 	_deleteX86reg(X86TYPE_PSX, _Rt_, 1);
 
@@ -685,6 +729,8 @@ void recResetIOP()
 	DevCon.WriteLn( "iR3000A Recompiler reset." );
 
 	Perf::iop.reset();
+	BlockProfiler::iop.Dump(32);
+	BlockProfiler::iop.Reset(EmuConfig.Profiler.Enabled && EmuConfig.Profiler.RecBlocks_IOP);
 
 	recAlloc();
 	recMem->Reset();
@@ -750,6 +796,9 @@ static void recShutdown()
 	safe_free( s_pInstCache );
 	s_nInstCacheSize = 0;
 
+	BlockProfiler::iop.Dump(32);
+	BlockProfiler::iop.Reset(false);
+
 	// FIXME Warning thread unsafe
 	Perf::dump();
 }
@@ -851,6 +900,16 @@ static __fi u32 psxRecClearMem(u32 pc)
 	return upperextent - pc;
 }
 
+// Emits the test psxRecClearMem() starts with, for a store to the constant IOP RAM address
+// mem.  The block LUT entry is resolved here, so only the fnptr compare is left at run time:
+// ZF is clear when the word holds recompiled code and the store has to go through Clear().
+void psxRecTestClearMem(u32 mem)
+{
+	xLoadFarAddr(rax, (void*)iopJITCompile);
+	xLoadFarAddr(rcx, PSX_GETBLOCK(mem & ~3));
+	xCMP(ptrNative[rcx], rax);
+}
+
 static __fi void recClearIOP(u32 Addr, u32 Size)
 {
 	u32 pc = Addr;
@@ -1046,6 +1105,9 @@ void psxRecompileNextInstruction(int delayslot)
 
 	g_pCurInstInfo++;
 
+	if( CHECK_IOP_ANALYSIS )
+		_psxDropDeadConstRegs();
+
 	g_iopCyclePenalty = 0;
 	rpsxBSC[ psxRegs.code >> 26 ]();
 	s_psxBlockCycles += g_iopCyclePenalty;
@@ -1140,6 +1202,8 @@ static void __fastcall iopRecRecompile( const u32 startpc )
 		xFastCall((void*)PreBlockCheck, psxpc);
 	}
 
+	s_pCurBlockStats = BlockProfiler::iop.Begin(HWADDR(startpc));
+
 	// go until the next branch
 	i = startpc;
 	s_nEndBlock = 0xffffffff;
@@ -1301,6 +1365,7 @@ StartRecomp:
 	s_pCurBlockEx->x86size = xGetPtr() - recPtr;
 
 	Perf::iop.map(s_pCurBlockEx->fnptr, s_pCurBlockEx->x86size, s_pCurBlockEx->startpc);
+	BlockProfiler::iop.End(s_pCurBlockStats, s_pCurBlockEx->size, s_pCurBlockEx->x86size, psxScaleBlockCycles());
 
 	recPtr = xGetPtr();
 
@@ -1308,6 +1373,7 @@ StartRecomp:
 
 	s_pCurBlock = NULL;
 	s_pCurBlockEx = NULL;
+	s_pCurBlockStats = NULL;
 }
 
 static void recSetCacheReserve( uint reserveInMegs )
@@ -47,6 +47,7 @@ void _psxDeleteReg(int reg, int flush);
 void _psxFlushCall(int flushtype);
 
 void _psxOnWriteReg(int reg);
+bool _psxIsDeadWrite(int reg);
 
 void _psxMoveGPRtoR(const x86Emitter::xRegister32& to, int fromgpr);
 #if 0
@@ -64,6 +65,7 @@ void psxLoadBranchState();
 extern void psxSetBranchReg(u32 reg);
 extern void psxSetBranchImm( u32 imm );
 extern void psxRecompileNextInstruction(int delayslot);
+extern void psxRecTestClearMem(u32 mem);
 
 ////////////////////////////////////////////////////////////////////
 // IOP Constant Propagation Defines, Vars, and API - From here down!
@@ -222,6 +222,7 @@ void rpsxLUI()
 	if(!_Rt_) return;
 	_psxOnWriteReg(_Rt_);
 	_psxDeleteReg(_Rt_, 0);
+	if (_psxIsDeadWrite(_Rt_)) return;
 	PSX_SET_CONST(_Rt_);
 	g_psxConstRegs[_Rt_] = psxRegs.code << 16;
 }
@@ -633,8 +634,153 @@ REC_FUNC(SWR);
 
 using namespace x86Emitter;
 
+// Loads and stores through a constant address skip the iopMemRead/Write dispatch: RAM, ROM
+// and the scratchpad are accessed through their host pointer in psxMemRLUT/WLUT, and the
+// hardware register pages go straight to their page handler.  SIF, DEV9, SPU2 and unmapped
+// addresses keep using the generic handlers.
+static void* rpsxGetHwHandler(u32 addr, int bits, bool write)
+{
+	static void* const readers[3][3] = {
+		{ (void*)IopMemory::iopHwRead8_Page1, (void*)IopMemory::iopHwRead8_Page3, (void*)IopMemory::iopHwRead8_Page8 },
+		{ (void*)IopMemory::iopHwRead16_Page1, (void*)IopMemory::iopHwRead16_Page3, (void*)IopMemory::iopHwRead16_Page8 },
+		{ (void*)IopMemory::iopHwRead32_Page1, (void*)IopMemory::iopHwRead32_Page3, (void*)IopMemory::iopHwRead32_Page8 },
+	};
+	static void* const writers[3][3] = {
+		{ (void*)IopMemory::iopHwWrite8_Page1, (void*)IopMemory::iopHwWrite8_Page3, (void*)IopMemory::iopHwWrite8_Page8 },
+		{ (void*)IopMemory::iopHwWrite16_Page1, (void*)IopMemory::iopHwWrite16_Page3, (void*)IopMemory::iopHwWrite16_Page8 },
+		{ (void*)IopMemory::iopHwWrite32_Page1, (void*)IopMemory::iopHwWrite32_Page3, (void*)IopMemory::iopHwWrite32_Page8 },
+	};
+
+	int page;
+	switch (addr & 0xf000) {
+		case 0x1000: page = 0; break;
+		case 0x3000: page = 1; break;
+		case 0x8000: page = 2; break;
+		default: return NULL; // plain psxHu memory
+	}
+
+	const int size = bits == 8 ? 0 : bits == 16 ? 1 : 2;
+	return write ? writers[size][page] : readers[size][page];
+}
+
+static bool rpsxLoadConst(int bits, bool sign)
+{
+	if (!CHECK_IOP_ANALYSIS || !PSX_IS_CONST1(_Rs_))
+		return false;
+
+	const u32 addr = (g_psxConstRegs[_Rs_] + _Imm_) & 0x1fffffff;
+	const u32 page = addr >> 16;
+	void* handler = NULL;
+	const u8* host;
+
+	if (page == 0x1f80) {
+		handler = rpsxGetHwHandler(addr, bits, false);
+		host = &psxHu8(addr);
+	}
+	else if (page != 0x1d00 && psxMemRLUT[page])
+		host = (const u8*)psxMemRLUT[page] + (addr & 0xffff);
+	else
+		return false;
+
+	_psxOnWriteReg(_Rt_);
+	_psxDeleteReg(_Rt_, 0);
+
+	// Handlers can have side effects, plain memory reads can be dropped
+	const bool dead = !_Rt_ || _psxIsDeadWrite(_Rt_);
+	if (handler) {
+		xMOV(arg1regd, addr);
+		xFastCall(handler, arg1regd);		// returns value in EAX
+	}
+	if (dead)
+		return true;
+
+	if (handler) {
+		if (bits == 8) {
+			if (sign) xMOVSX(eax, al);
+			else xMOVZX(eax, al);
+		}
+		else if (bits == 16) {
+			if (sign) xMOVSX(eax, ax);
+			else xMOVZX(eax, ax);
+		}
+	}
+	else {
+		xLoadFarAddr(rcx, (void*)host);
+		if (bits == 8) {
+			if (sign) xMOVSX(eax, ptr8[rcx]);
+			else xMOVZX(eax, ptr8[rcx]);
+		}
+		else if (bits == 16) {
+			if (sign) xMOVSX(eax, ptr16[rcx]);
+			else xMOVZX(eax, ptr16[rcx]);
+		}
+		else
+			xMOV(eax, ptr32[rcx]);
+	}
+	xMOV(ptr32[&psxRegs.GPR.r[_Rt_]], eax);
+	return true;
+}
+
+static void rpsxStoreHost(void* host, int bits)
+{
+	_psxMoveGPRtoR(eax, _Rt_);
+	xLoadFarAddr(rcx, host);
+	if (bits == 8) xMOV(ptr8[rcx], al);
+	else if (bits == 16) xMOV(ptr16[rcx], ax);
+	else xMOV(ptr32[rcx], eax);
+}
+
+static bool rpsxStoreConst(int bits, void* generic)
+{
+	if (!CHECK_IOP_ANALYSIS || !PSX_IS_CONST1(_Rs_))
+		return false;
+
+	const u32 addr = (g_psxConstRegs[_Rs_] + _Imm_) & 0x1fffffff;
+	const u32 page = addr >> 16;
+	const bool ram = page < 0x80;
+	if (!ram && page != 0x1f00 && page != 0x1f80)
+		return false;
+
+	if (!PSX_IS_CONST1(_Rt_))
+		_psxDeleteReg(_Rt_, 1);
+
+	if (page == 0x1f80) {
+		if (void* handler = rpsxGetHwHandler(addr, bits, true)) {
+			xMOV(arg1regd, addr);
+			_psxMoveGPRtoR(arg2regd, _Rt_);
+			xFastCall(handler, arg1regd, arg2regd);
+		}
+		else
+			rpsxStoreHost(&psxHu8(addr), bits);
+		return true;
+	}
+
+	// RAM and scratchpad: the generic handler is only needed while the cache is isolated
+	// (the store doesn't reach memory), or to clear the recompiled code at addr.
+	xTEST(ptr32[&psxRegs.CP0.n.Status], 0x10000);
+	j8Ptr[0] = JNZ8(0);
+	if (ram) {
+		psxRecTestClearMem(addr);
+		j8Ptr[1] = JNZ8(0);
+	}
+
+	rpsxStoreHost((u8*)psxMemWLUT[page] + (addr & 0xffff), bits);
+	j8Ptr[2] = JMP8(0);
+
+	x86SetJ8(j8Ptr[0]);
+	if (ram) x86SetJ8(j8Ptr[1]);
+	xMOV(arg1regd, addr);
+	_psxMoveGPRtoR(arg2regd, _Rt_);
+	xFastCall(generic, arg1regd, arg2regd);
+
+	x86SetJ8(j8Ptr[2]);
+	return true;
+}
+
 static void rpsxLB()
 {
+	if (rpsxLoadConst(8, true)) return;
+
 	_psxDeleteReg(_Rs_, 1);
 	_psxOnWriteReg(_Rt_);
 	_psxDeleteReg(_Rt_, 0);
@@ -651,6 +797,8 @@ static void rpsxLB()
 
 static void rpsxLBU()
 {
+	if (rpsxLoadConst(8, false)) return;
+
 	_psxDeleteReg(_Rs_, 1);
 	_psxOnWriteReg(_Rt_);
 	_psxDeleteReg(_Rt_, 0);
@@ -667,6 +815,8 @@ static void rpsxLBU()
 
 static void rpsxLH()
 {
+	if (rpsxLoadConst(16, true)) return;
+
 	_psxDeleteReg(_Rs_, 1);
 	_psxOnWriteReg(_Rt_);
 	_psxDeleteReg(_Rt_, 0);
@@ -683,6 +833,8 @@ static void rpsxLH()
 
 static void rpsxLHU()
 {
+	if (rpsxLoadConst(16, false)) return;
+
 	_psxDeleteReg(_Rs_, 1);
 	_psxOnWriteReg(_Rt_);
 	_psxDeleteReg(_Rt_, 0);
@@ -699,6 +851,8 @@ static void rpsxLHU()
 
 static void rpsxLW()
 {
+	if (rpsxLoadConst(32, false)) return;
+
 	_psxDeleteReg(_Rs_, 1);
 	_psxOnWriteReg(_Rt_);
 	_psxDeleteReg(_Rt_, 0);
@@ -731,6 +885,8 @@ static void rpsxLW()
 
 static void rpsxSB()
 {
+	if (rpsxStoreConst(8, (void*)iopMemWrite8)) return;
+
 	_psxDeleteReg(_Rs_, 1);
 	_psxDeleteReg(_Rt_, 1);
 
@@ -742,6 +898,8 @@ static void rpsxSB()
 
 static void rpsxSH()
 {
+	if (rpsxStoreConst(16, (void*)iopMemWrite16)) return;
+
 	_psxDeleteReg(_Rs_, 1);
 	_psxDeleteReg(_Rt_, 1);
 
@@ -753,6 +911,8 @@ static void rpsxSH()
 
 static void rpsxSW()
 {
+	if (rpsxStoreConst(32, (void*)iopMemWrite32)) return;
+
 	_psxDeleteReg(_Rs_, 1);
 	_psxDeleteReg(_Rt_, 1);
 
@@ -1550,6 +1710,22 @@ void rpsxpropBSC(EEINST* prev, EEINST* pinst)
 			rpsxpropSetRead(_Rs_);
 			break;
 
+		case 9: // addiu
+			// "addiu zero, zero, n" marks an irx import stub, which may call an HLE handler
+			// that reads any register and leaves the block (psxRecompileIrxImport)
+			if (psxRegs.code >> 16 == 0x2400) {
+				_recClearInst(prev);
+				prev->info = 0;
+				break;
+			}
+			// fall through
+		case 8: case 10: case 11: // addi, slti, sltiu
+		case 12: case 13: case 14: // andi, ori, xori
+		case 32: case 33: case 35: case 36: case 37: // lb, lh, lw, lbu, lhu
+			rpsxpropSetWrite(_Rt_);
+			rpsxpropSetRead(_Rs_);
+			break;
+
 		case 15: // lui
 			rpsxpropSetWrite(_Rt_);
 			break;
@@ -1563,14 +1739,23 @@ void rpsxpropBSC(EEINST* prev, EEINST* pinst)
 			rpsxpropSetRead(_Rs_);
 			break;
 
+		case 34: // lwl
+		case 38: // lwr
+			// merges into the old value of rt
+			rpsxpropSetWrite(_Rt_);
+			rpsxpropSetRead(_Rt_);
+			rpsxpropSetRead(_Rs_);
+			break;
+
 		case 50: // LWC2
 		case 58: // SWC2
-			// Operation on COP2 registers/memory. GPRs are left untouched
+			// Operation on COP2 registers/memory. GPRs are left untouched, except for the
+			// base address
+			rpsxpropSetRead(_Rs_);
 			break;
 
 		default:
-			rpsxpropSetWrite(_Rt_);
-			rpsxpropSetRead(_Rs_);
+			// Not recompiled (rpsxNULL), leaves the GPRs alone
 			break;
 	}
 }
@@ -1645,11 +1830,23 @@ void rpsxpropSPECIAL(EEINST* prev, EEINST* pinst)
 			if( _Rt_ ) rpsxpropSetRead(_Rt_);
 			break;
 
-		default:
+		case 4: // sllv
+		case 6: // srlv
+		case 7: // srav
+		case 36: // and
+		case 37: // or
+		case 38: // xor
+		case 39: // nor
+		case 42: // slt
+		case 43: // sltu
 			rpsxpropSetWrite(_Rd_);
 			rpsxpropSetRead(_Rs_);
 			rpsxpropSetRead(_Rt_);
 			break;
+
+		default:
+			// Not recompiled (rpsxNULL), leaves the GPRs alone
+			break;
 	}
 }
 
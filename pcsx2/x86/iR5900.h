@@ -63,6 +63,20 @@ u32 recClearMem(u32 pc);
 u32 REC_CLEARM( u32 mem );
 extern bool g_recompilingDelaySlot;
 
+// EE code cache statistics, the fill levels are in bytes.  Without the generational
+// cache (Recompiler.EEGenerationalCache) the whole cache counts as the old region.
+struct recCodeCacheStats
+{
+	u32  Resets;		// full recompiler resets
+	u32  Collections;	// nursery collections
+	u64  Evicted;		// blocks evicted from the nursery
+	u64  Promoted;		// evicted blocks marked for promotion to the old region
+	uptr OldUsed, OldSize;
+	uptr NurseryUsed, NurserySize;
+};
+
+void recGetCodeCacheStats(recCodeCacheStats& stats);
+
 // used when processing branches
 void SaveBranchState();
 void LoadBranchState();
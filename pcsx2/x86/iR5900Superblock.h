@@ -0,0 +1,98 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstring>
+
+// --------------------------------------------------------------------------------------
+//  SuperblockCompile
+// --------------------------------------------------------------------------------------
+// Compile state of an EE superblock (Recompiler.EESuperblocks, see iR5900-32.cpp): which
+// conditional branches the block scan followed, and going on inline through their
+// fall-through path when the branch recs end it with SetBranchImm().
+//
+// A superblock stays within the page of its startpc, so the followed pcs are kept by
+// offset from it.
+class SuperblockCompile
+{
+public:
+	static const u32 MaxBranches = 8;
+
+	SuperblockCompile()
+		: m_start(0)
+		, m_branches(0)
+	{
+	}
+
+	void Begin(u32 startpc)
+	{
+		m_start = startpc;
+		m_branches = 0;
+		memset(m_follow, 0, sizeof(m_follow));
+	}
+
+	void End() { m_start = 0; }
+
+	bool IsActive() const { return m_start != 0; }
+	u32 GetStart() const { return m_start; }
+	u32 GetBranches() const { return m_branches; }
+
+	// Block scan: whether it goes on through the fall-through path of the conditional
+	// branch at branchpc instead of ending the block there.  The fall-through block must
+	// have run at least 3 times as often as the branch target so far.
+	bool Follow(u32 branchpc, u32 target, u32 fallthroughRuns, u32 targetRuns)
+	{
+		if (!m_start || m_branches >= MaxBranches)
+			return false;
+
+		// Stay in the page, like any block (it's the unit of the write protection).
+		const u32 next = branchpc + 8;
+		if (target == next || (next & ~0xfffu) != (m_start & ~0xfffu))
+			return false;
+
+		if (!fallthroughRuns || fallthroughRuns < targetRuns * 3)
+			return false;
+
+		m_follow[(next - m_start) / 4] = true;
+		m_branches++;
+		return true;
+	}
+
+	// SetBranchImm(): when imm is the fall-through path of a followed branch, moves pc to
+	// it and clears the branch flag so the compile loop goes on with it, and returns true.
+	// The branch recs always end with their fall-through path, and emit the taken side
+	// (which set the flag) before it.  For likely branches it doesn't go through the delay
+	// slot, so pc may still point at it.
+	bool Continue(u32 imm, u32& pc, int& branch, u32 endBlock)
+	{
+		if (!m_start || (imm != pc && imm != pc + 4) || imm >= endBlock)
+			return false;
+
+		const u32 offset = (imm - m_start) / 4;
+		if (!m_follow[offset])
+			return false;
+
+		m_follow[offset] = false;
+		pc = imm;
+		branch = 0;
+		return true;
+	}
+
+protected:
+	u32 m_start; // startpc of the superblock being compiled, 0 if none
+	u32 m_branches;
+	bool m_follow[0x1000 / 4 + 2]; // fall-through pcs compiled inline, by offset
+};
@@ -22,6 +22,8 @@
 #include "R5900OpcodeTables.h"
 #include "iR5900.h"
 #include "BaseblockEx.h"
+#include "BlockProfiler.h"
+#include "iR5900Superblock.h"
 #include "System/RecTypes.h"
 
 #include "vtlb.h"
@@ -42,6 +44,7 @@
 
 #include "Utilities/MemsetFast.inl"
 #include "Utilities/Perf.h"
+#include <unordered_set>
 
 
 using namespace x86Emitter;
@@ -93,6 +96,7 @@ static u32 s_nInstCacheSize = 0;
 
 static BASEBLOCK* s_pCurBlock = NULL;
 static BASEBLOCKEX* s_pCurBlockEx = NULL;
+static BlockProfiler::BlockStats* s_pCurBlockStats = NULL;
 u32 s_nEndBlock = 0; // what pc the current block ends
 u32 s_branchTo;
 static bool s_nBlockFF;
@@ -104,6 +108,45 @@ static EEINST* s_psaveInstInfo = NULL;
 
 static u32 s_savenBlockCycles = 0;
 
+// Superblocks (Recompiler.EESuperblocks):
+// Blocks count their executions, and once one reached TraceThreshold it's recompiled
+// as a superblock: conditional branches which mostly fell through so far don't end the
+// block anymore.  Their taken path becomes a side exit (flushed and linked like any
+// block end) and the fall-through path is compiled inline, keeping the xmm register
+// allocation, const propagation and cycle count of the path leading to it, and
+// skipping the event test and block dispatch in between.
+//
+// The counters are hashed by pc.  They're also how branches are judged biased: the
+// fall-through block must have run at least 3 times as often as the branch target.
+static const u32 TraceThreshold = 256;
+static const u32 TraceCounterCount = 0x10000;
+
+static __aligned16 u32 s_traceCounters[TraceCounterCount];
+static u32 s_traceRequest = 0;	// pc to recompile as a superblock
+static SuperblockCompile s_trace;	// the superblock being compiled, if any
+
+// Generational code cache (Recompiler.EEGenerationalCache):
+// New blocks are compiled into the nursery, the last quarter of recMem.  When it fills
+// up, all of its blocks are evicted at once, and the ones which were entered at least
+// PromoteThreshold times since the last collection are recompiled into the old region
+// (the rest of recMem) the next time they run.  Only a full old region (or const
+// buffer) resets the whole recompiler, so hot code survives the churn of cold code.
+//
+// The entry counters are hashed by pc, like the superblock counters.
+static const u32 PromoteThreshold = 64;
+static const u32 HitCounterCount = 0x10000;
+
+static __aligned16 u32 s_blockHits[HitCounterCount];
+static std::unordered_set<u32> s_promotePcs;	// HW startpcs to compile into the old region
+static bool s_genCache = false;		// latched on reset
+static u8* s_nurseryStart = NULL;	// (also the end of the old region)
+static u8* s_oldPtr = NULL;
+static recCodeCacheStats s_cacheStats;
+
+// Fastmem (Recompiler.EEFastmem) thunks live at the start of recMem, where neither the
+// nursery collections nor the blocks get to them.
+static const u32 FastmemThunkAreaSize = _1mb;
+
 #ifdef PCSX2_DEBUG
 static u32 dumplog = 0;
 #else
@@ -318,6 +361,7 @@ void recCall( void (*func)() )
 static void __fastcall recRecompile( const u32 startpc );
 static void __fastcall dyna_block_discard(u32 start,u32 sz);
 static void __fastcall dyna_page_reset(u32 start,u32 sz);
+static void __fastcall dyna_trace_compile();
 
 // Recompiled code buffer for EE recompiler dispatchers!
 static u8 __pagealigned eeRecDispatchers[__pagesize];
@@ -332,6 +376,7 @@ static DynGenFunc* EnterRecompiledCode	= NULL;
 static DynGenFunc* ExitRecompiledCode	= NULL;
 static DynGenFunc* DispatchBlockDiscard = NULL;
 static DynGenFunc* DispatchPageReset    = NULL;
+static DynGenFunc* DispatchTraceCompile = NULL;
 
 static void recEventTest()
 {
@@ -435,6 +480,16 @@ static DynGenFunc* _DynGen_DispatchPageReset()
 	return (DynGenFunc*)retval;
 }
 
+// Entered from the start of a block which reached the superblock threshold: the block
+// is cleared, and recompiled as a superblock by the dispatch.
+static DynGenFunc* _DynGen_DispatchTraceCompile()
+{
+	u8* retval = xGetPtr();
+	xFastCall((void*)dyna_trace_compile);
+	xJMP((void*)DispatcherReg);
+	return (DynGenFunc*)retval;
+}
+
 static void _DynGen_Dispatchers()
 {
 	// In case init gets called multiple times:
@@ -455,6 +510,7 @@ static void _DynGen_Dispatchers()
 	EnterRecompiledCode  = _DynGen_EnterRecompiledCode();
 	DispatchBlockDiscard = _DynGen_DispatchBlockDiscard();
 	DispatchPageReset    = _DynGen_DispatchPageReset();
+	DispatchTraceCompile = _DynGen_DispatchTraceCompile();
 
 	HostSys::MemProtectStatic( eeRecDispatchers, PageAccess_ExecOnly() );
 
@@ -597,6 +653,8 @@ static void recResetRaw()
 	Perf::ee.reset();
 
 	EE::Profiler.Reset();
+	BlockProfiler::ee.Dump(32);
+	BlockProfiler::ee.Reset(EmuConfig.Profiler.Enabled && EmuConfig.Profiler.RecBlocks_EE);
 
 	recAlloc();
 
@@ -605,9 +663,37 @@ static void recResetRaw()
 
 	Console.WriteLn( Color_StrongBlack, "EE/iR5900-32 Recompiler Reset" );
 
+	if (EmuConfig.Profiler.Enabled && recPtr)
+	{
+		recCodeCacheStats stats;
+		recGetCodeCacheStats(stats);
+		Console.WriteLn( Color_StrongBlue, "EE code cache: %u resets, %u collections, %llu blocks evicted, %llu promoted, old region %.1f/%.1f MB, nursery %.1f/%.1f MB",
+			stats.Resets, stats.Collections, (unsigned long long)stats.Evicted, (unsigned long long)stats.Promoted,
+			stats.OldUsed / (double)_1mb, stats.OldSize / (double)_1mb,
+			stats.NurseryUsed / (double)_1mb, stats.NurserySize / (double)_1mb );
+	}
+	s_cacheStats.Resets++;
+
 	recMem->Reset();
 	ClearRecLUT((BASEBLOCK*)recLutReserve_RAM, recLutSize);
 	memset(recRAMCopy, 0, Ps2MemSize::MainRam);
+	memzero(s_traceCounters);
+	s_traceRequest = 0;
+
+	u8* codeStart = *recMem;
+	if (vtlb_GetFastmemBase())
+	{
+		vtlb_FastmemResetSites(codeStart, FastmemThunkAreaSize);
+		codeStart += FastmemThunkAreaSize;
+	}
+	else
+		vtlb_FastmemResetSites(NULL, 0);
+
+	s_genCache = CHECK_EE_GENCACHE;
+	s_nurseryStart = recMem->GetPtrEnd() - (s_genCache ? recMem->GetReserveSizeInBytes() / 4 : 0);
+	s_oldPtr = codeStart;
+	s_promotePcs.clear();
+	memzero(s_blockHits);
 
 	maxrecmem = 0;
 
@@ -621,7 +707,7 @@ static void recResetRaw()
 
 	x86SetPtr(*recMem);
 
-	recPtr = *recMem;
+	recPtr = s_genCache ? s_nurseryStart : codeStart;
 	recConstBufPtr = recConstBuf;
 
 	g_branch = 0;
@@ -639,6 +725,9 @@ static void recShutdown()
 
 	recRAM = recROM = recROM1 = recROM2 = NULL;
 
+	BlockProfiler::ee.Dump(32);
+	BlockProfiler::ee.Reset(false);
+
 	safe_aligned_free( recConstBuf );
 	safe_free( s_pInstCache );
 	s_nInstCacheSize = 0;
@@ -904,8 +993,23 @@ void SetBranchReg( u32 reg )
 	iBranchTest();
 }
 
+// Superblocks: continues compiling inline when imm is the fall-through path of a branch
+// the scan decided to follow.  g_branch is cleared again (the taken side of the branch
+// set it), so recRecompile goes on with the next instruction.
+static bool recTraceContinue( u32 imm )
+{
+	if (!s_trace.Continue(imm, pc, g_branch, s_nEndBlock))
+		return false;
+
+	g_pCurInstInfo = s_pInstCache + (pc - s_trace.GetStart()) / 4;
+	return true;
+}
+
 void SetBranchImm( u32 imm )
 {
+	if (recTraceContinue(imm))
+		return;
+
 	g_branch = 1;
 
 	pxAssert( imm );
@@ -1534,6 +1638,28 @@ void __fastcall dyna_page_reset(u32 start,u32 sz)
 	mmap_MarkCountedRamPage( start );
 }
 
+static __fi u32* recTraceCounter(u32 startpc)
+{
+	return &s_traceCounters[(startpc >> 2) & (TraceCounterCount - 1)];
+}
+
+// called when a block has run TraceThreshold times, from its start (so cpuRegs.pc is its
+// startpc).  Clears it so that the dispatch recompiles it as a superblock.
+void __fastcall dyna_trace_compile()
+{
+	const u32 startpc = cpuRegs.pc;
+	*recTraceCounter(startpc) = 0;
+	s_traceRequest = startpc;
+	recClear(startpc, 1);
+}
+
+// Superblocks: whether the block scan goes on through the fall-through path of the
+// conditional branch at branchpc, instead of ending the block there.
+static bool recTraceFollowBranch(u32 branchpc, u32 target)
+{
+	return s_trace.Follow(branchpc, target, *recTraceCounter(branchpc + 8), *recTraceCounter(target));
+}
+
 static void memory_protect_recompiled_code(u32 startpc, u32 size)
 {
 	u32 inpage_ptr = HWADDR(startpc);
@@ -1554,6 +1680,7 @@ static void memory_protect_recompiled_code(u32 startpc, u32 size)
 		case ProtMode_None:
         case ProtMode_Write:
 			mmap_MarkCountedRamPage( inpage_ptr );
+			mmap_MarkCodeRange( inpage_ptr, inpage_sz );
 			manual_page[inpage_ptr >> 12] = 0;
 			break;
 
@@ -1642,6 +1769,68 @@ bool skipMPEG_By_Pattern(u32 sPC) {
 	return 0;
 }
 
+void recGetCodeCacheStats(recCodeCacheStats& stats)
+{
+	stats = s_cacheStats;
+
+	if (!recMem || !recPtr)
+		return;
+
+	if (s_genCache)
+	{
+		stats.OldUsed = s_oldPtr - (u8*)*recMem;
+		stats.OldSize = s_nurseryStart - (u8*)*recMem;
+		stats.NurseryUsed = recPtr - s_nurseryStart;
+		stats.NurserySize = recMem->GetPtrEnd() - s_nurseryStart;
+	}
+	else
+	{
+		stats.OldUsed = recPtr - (u8*)*recMem;
+		stats.OldSize = recMem->GetReserveSizeInBytes();
+	}
+}
+
+// Evicts every block of the nursery, and remembers the hot ones to promote them.  Only
+// called from recRecompile (like recResetRaw), so none of the evicted code is running.
+static void recCollectNursery()
+{
+	u32 evicted = 0, promoted = 0;
+
+	for (int i = 0; BASEBLOCKEX* pexblock = recBlocks[i]; )
+	{
+		if (pexblock->fnptr < (uptr)s_nurseryStart)
+		{
+			i++;
+			continue;
+		}
+
+		const u32 startpc = pexblock->startpc;
+		if (s_blockHits[(startpc >> 2) & (HitCounterCount - 1)] >= PromoteThreshold)
+		{
+			s_promotePcs.insert(startpc);
+			promoted++;
+		}
+
+		PC_GETBLOCK(startpc)->SetFnptr((uptr)JITCompile);
+		recBlocks.Remove(i, i);
+		evicted++;
+	}
+
+	// The jumps and fastmem accesses emitted by the evicted blocks are gone as well.
+	recBlocks.RemoveLinks((uptr)s_nurseryStart, (uptr)recMem->GetPtrEnd());
+	vtlb_FastmemClearSites((uptr)s_nurseryStart, (uptr)recMem->GetPtrEnd());
+	memzero(s_blockHits);
+
+	recPtr = s_nurseryStart;
+
+	s_cacheStats.Collections++;
+	s_cacheStats.Evicted += evicted;
+	s_cacheStats.Promoted += promoted;
+
+	eeRecPerfLog.Write( "Code cache collection: %u blocks evicted, %u to promote, old region %u/%u KB",
+		evicted, promoted, (u32)((s_oldPtr - (u8*)*recMem) / _1kb), (u32)((s_nurseryStart - (u8*)*recMem) / _1kb) );
+}
+
 // defined at AppCoreThread.cpp but unclean and should not be public. We're the only
 // consumers of it, so it's declared only here.
 void LoadAllPatchesAndStuff(const Pcsx2Config&);
@@ -1664,16 +1853,33 @@ static void __fastcall recRecompile( const u32 startpc )
 	pxAssert( startpc );
 
 	// if recPtr reached the mem limit reset whole mem
-	if (recPtr >= (recMem->GetPtrEnd() - _64kb)) {
+	if (s_genCache && s_oldPtr >= s_nurseryStart - _64kb) {
 		eeRecNeedsReset = true;
 	}
+	else if (recPtr >= (recMem->GetPtrEnd() - _64kb)) {
+		if (s_genCache)
+			recCollectNursery();
+		else
+			eeRecNeedsReset = true;
+	}
 	else if ((recConstBufPtr - recConstBuf) >= RECCONSTBUF_SIZE - 64) {
 		Console.WriteLn("EE recompiler stack reset");
 		eeRecNeedsReset = true;
 	}
+	else if (vtlb_GetFastmemBase() && vtlb_FastmemThunksLow()) {
+		eeRecNeedsReset = true;
+	}
 
 	if (eeRecNeedsReset) recResetRaw();
 
+	// Hot blocks evicted from the nursery go to the old region
+	u8* nurseryPtr = NULL;
+	if (s_genCache && !s_promotePcs.empty() && s_promotePcs.erase(HWADDR(startpc)))
+	{
+		nurseryPtr = recPtr;
+		recPtr = s_oldPtr;
+	}
+
 	xSetPtr( recPtr );
 	recPtr = xGetAlignedCallTarget();
 
@@ -1692,6 +1898,27 @@ static void __fastcall recRecompile( const u32 startpc )
 
 	pxAssert(s_pCurBlockEx);
 
+	s_trace.End();
+	if (CHECK_EE_SUPERBLOCKS)
+	{
+		if (startpc == s_traceRequest)
+		{
+			s_trace.Begin(startpc);
+		}
+		else
+		{
+			// Counted before anything else, while cpuRegs.pc is still startpc.
+			u32* counter = recTraceCounter(startpc);
+			xADD(ptr32[counter], 1);
+			xCMP(ptr32[counter], TraceThreshold);
+			xJE(DispatchTraceCompile);
+		}
+	}
+	s_traceRequest = 0;
+
+	if (s_genCache && !nurseryPtr)
+		xADD(ptr32[&s_blockHits[(HWADDR(startpc) >> 2) & (HitCounterCount - 1)]], 1);
+
 	if (HWADDR(startpc) == EELOAD_START)
 	{
 		// The EELOAD _start function is the same across all BIOS versions
@@ -1762,6 +1989,8 @@ static void __fastcall recRecompile( const u32 startpc )
 		xFastCall((void*)PreBlockCheck, pc);
 	}
 
+	s_pCurBlockStats = BlockProfiler::ee.Begin(HWADDR(startpc));
+
 	if (EmuConfig.Gamefixes.GoemonTlbHack) {
 		if (pc == 0x33ad48 || pc == 0x35060c) {
 			// 0x33ad48 and 0x35060c are the return address of the function (0x356250) that populate the TLB cache
@@ -1810,7 +2039,8 @@ static void __fastcall recRecompile( const u32 startpc )
 				break;
 			}
 
-			if (pblock->GetFnptr() != (uptr)JITCompile && pblock->GetFnptr() != (uptr)JITCompileInBlock)
+			// Superblocks go on through the blocks they merge.
+			if (!s_trace.IsActive() && pblock->GetFnptr() != (uptr)JITCompile && pblock->GetFnptr() != (uptr)JITCompileInBlock)
 			{
 				willbranch3 = 1;
 				s_nEndBlock = i;
@@ -1835,6 +2065,10 @@ static void __fastcall recRecompile( const u32 startpc )
 					// branches
 					s_branchTo = _Imm_ * 4 + i + 4;
 					if( s_branchTo > startpc && s_branchTo < i ) s_nEndBlock = s_branchTo;
+					else if( recTraceFollowBranch(i, s_branchTo) ) {
+						i += 8;
+						continue;
+					}
 					else  s_nEndBlock = i+8;
 
 					goto StartRecomp;
@@ -1852,6 +2086,12 @@ static void __fastcall recRecompile( const u32 startpc )
 			case 20: case 21: case 22: case 23:
 				s_branchTo = _Imm_ * 4 + i + 4;
 				if( s_branchTo > startpc && s_branchTo < i ) s_nEndBlock = s_branchTo;
+				// BNEL emits its fall-through path first, and BEQ/BEQL with rs == rt always branch.
+				else if( _Opcode_ != 21 && !((_Opcode_ == 4 || _Opcode_ == 20) && _Rs_ == _Rt_) &&
+					recTraceFollowBranch(i, s_branchTo) ) {
+					i += 8;
+					continue;
+				}
 				else  s_nEndBlock = i+8;
 
 				goto StartRecomp;
@@ -2146,13 +2386,27 @@ StartRecomp:
 	}
 #endif
 	Perf::ee.map(s_pCurBlockEx->fnptr, s_pCurBlockEx->x86size, s_pCurBlockEx->startpc);
+	BlockProfiler::ee.End(s_pCurBlockStats, s_pCurBlockEx->size, s_pCurBlockEx->x86size, scaleblockcycles());
 
 	recPtr = xGetPtr();
 
+	if (nurseryPtr)
+	{
+		pxAssert( recPtr < s_nurseryStart );
+		s_oldPtr = recPtr;
+		recPtr = nurseryPtr;
+	}
+
 	pxAssert( (g_cpuHasConstReg&g_cpuFlushedConstReg) == g_cpuHasConstReg );
 
+	if (s_trace.IsActive())
+		eeRecPerfLog.Write( "Superblock @ 0x%08X : size=%d insts, %d branches followed",
+			startpc, s_pCurBlockEx->size, s_trace.GetBranches() );
+
 	s_pCurBlock = NULL;
 	s_pCurBlockEx = NULL;
+	s_pCurBlockStats = NULL;
+	s_trace.End();
 }
 
 // The only *safe* way to throw exceptions from the context of recompiled code.
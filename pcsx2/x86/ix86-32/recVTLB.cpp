@@ -18,11 +18,14 @@
 
 #include "Common.h"
 #include "vtlb.h"
+#include "Cache.h"
 
 #include "iCore.h"
 #include "iR5900.h"
 #include "Utilities/Perf.h"
 
+#include <unordered_map>
+
 using namespace vtlb_private;
 using namespace x86Emitter;
 
@@ -263,22 +266,29 @@ static u8* GetIndirectDispatcherPtr( int mode, int operandsize, int sign = 0 )
 }
 
 // ------------------------------------------------------------------------
-// Generates a JS instruction that targets the appropriate templated instance of
-// the vtlb Indirect Dispatcher.
+// Converts 8 thru 128 bits into the operandsize index used by the dispatchers.
 //
-static void DynGen_IndirectDispatch( int mode, int bits, bool sign = false )
+static int DynGen_SizeIndex( int bits )
 {
-	int szidx = 0;
 	switch( bits )
 	{
-		case 8:		szidx=0;	break;
-		case 16:	szidx=1;	break;
-		case 32:	szidx=2;	break;
-		case 64:	szidx=3;	break;
-		case 128:	szidx=4;	break;
+		case 8:		return 0;
+		case 16:	return 1;
+		case 32:	return 2;
+		case 64:	return 3;
+		case 128:	return 4;
 		jNO_DEFAULT;
 	}
-	xJS( GetIndirectDispatcherPtr( mode, szidx, sign ) );
+	return 0;
+}
+
+// ------------------------------------------------------------------------
+// Generates a JS instruction that targets the appropriate templated instance of
+// the vtlb Indirect Dispatcher.
+//
+static void DynGen_IndirectDispatch( int mode, int bits, bool sign = false )
+{
+	xJS( GetIndirectDispatcherPtr( mode, DynGen_SizeIndex( bits ), sign ) );
 }
 
 // ------------------------------------------------------------------------
@@ -322,6 +332,180 @@ static void DynGen_IndirectTlbDispatcher( int mode, int bits, bool sign )
 	xJMP( rbx );
 }
 
+// ------------------------------------------------------------------------
+// Data cache dispatchers.  When the EE data cache is emulated, accesses to the pages
+// marked by cachedPageMap are routed here instead of to the direct/indirect vtlb code.
+// The tag compare against both ways of the set is done inline; the C++ accessors are
+// only called on a miss (which may need a writeback and a line fill), for handler
+// pages, or while the cache is switched off in COP0.Config.
+//
+static __pagealigned u8 m_CacheDispatchers[__pagesize];
+
+static u8* GetCacheDispatcherPtr( int mode, int operandsize, int sign = 0 )
+{
+	assert(mode || operandsize >= 2 ? !sign : true);
+
+	// Same arrangement as the indirect dispatchers, with more room for the tag compare.
+	const int A = 256;
+
+	return &m_CacheDispatchers[(mode*(7*A)) + (sign*5*A) + (operandsize*A)];
+}
+
+static void* GetCacheAccessor( int mode, int operandsize )
+{
+	static void* const accessors[2][5] =
+	{
+		{ (void*)vtlb_memRead<mem8_t>, (void*)vtlb_memRead<mem16_t>, (void*)vtlb_memRead<mem32_t>,
+			(void*)vtlb_memRead64, (void*)vtlb_memRead128 },
+		{ (void*)vtlb_memWrite<mem8_t>, (void*)vtlb_memWrite<mem16_t>, (void*)vtlb_memWrite<mem32_t>,
+			(void*)vtlb_memWrite64, (void*)vtlb_memWrite128 },
+	};
+
+	return accessors[mode][operandsize];
+}
+
+// In: arg1reg: virtual address, arg2reg: data (data ptr if mode >= 64), rbx: function return ptr
+// Out: eax: result (if mode < 64)
+// Clobbers arg3reg, arg4reg, r10 and r11
+static void DynGen_CacheDispatcher( int mode, int bits, bool sign )
+{
+	xTEST( ptr32[&cpuRegs.CP0.n.Config], 0x10000 );
+	xForwardJZ32 cacheOff;
+
+	// rax = host address of the access
+	xMOV( eax, arg1regd );
+	xSHR( eax, VTLB_PAGE_BITS );
+	xMOV( rax, ptrNative[xComplexAddress(r11, vtlbdata.vmap, rax*wordsize)] );
+	xADD( rax, arg1reg );
+	xForwardJS32 handler;
+
+	// r10 = offset of the set's way 0 tag, r11 = cache base
+	xMOV( r10d, eax );
+	xSHR( r10d, 2 );
+	xAND( r10d, 63 << 4 );
+	xLEA( r11, ptr[getCacheBase()] );
+
+	xMOV( arg3reg, rax );
+	xAND( arg3reg, (s32)CacheTagAddrMask );
+	xOR( arg3reg, (s32)CacheTagValid );
+
+	xMOV( arg4reg, ptrNative[r11 + r10] );
+	xAND( arg4reg, (s32)(CacheTagAddrMask | CacheTagValid) );
+	xCMP( arg4reg, arg3reg );
+	xForwardJE8 way0;
+
+	xMOV( arg4reg, ptrNative[r11 + r10 + sizeof(uptr)] );
+	xAND( arg4reg, (s32)(CacheTagAddrMask | CacheTagValid) );
+	xCMP( arg4reg, arg3reg );
+	xForwardJNE32 miss;
+	xADD( r10d, sizeof(uptr) );
+
+	way0.SetTarget();
+
+	// Hit: the line data lives at base + CacheDataOffset + tag offset * 8
+	xAND( eax, 63 );
+	xADD( rax, r11 );
+	const xAddressVoid data( r10*8 + rax + CacheDataOffset );
+
+	if (!mode)
+	{
+		switch( bits )
+		{
+			case 0:
+				if (sign)
+					xMOVSX( eax, ptr8[data] );
+				else
+					xMOVZX( eax, ptr8[data] );
+			break;
+
+			case 1:
+				if (sign)
+					xMOVSX( eax, ptr16[data] );
+				else
+					xMOVZX( eax, ptr16[data] );
+			break;
+
+			case 2:
+				xMOV( eax, ptr32[data] );
+			break;
+
+			case 3:
+				xMOV( arg3reg, ptrNative[data] );
+				xMOV( ptrNative[arg2reg], arg3reg );
+			break;
+
+			case 4:
+				xMOV( arg3reg, ptrNative[data] );
+				xMOV( ptrNative[arg2reg], arg3reg );
+				xMOV( arg3reg, ptrNative[data + 8] );
+				xMOV( ptrNative[arg2reg + 8], arg3reg );
+			break;
+		}
+	}
+	else
+	{
+		switch( bits )
+		{
+			case 0:
+				xMOV( edx, arg2regd );
+				xMOV( ptr[data], dl );
+			break;
+
+			case 1:
+				xMOV( ptr[data], xRegister16(arg2reg.Id) );
+			break;
+
+			case 2:
+				xMOV( ptr[data], arg2regd );
+			break;
+
+			case 3:
+				xMOV( arg3reg, ptrNative[arg2reg] );
+				xMOV( ptrNative[data], arg3reg );
+			break;
+
+			case 4:
+				xMOV( arg3reg, ptrNative[arg2reg] );
+				xMOV( ptrNative[data], arg3reg );
+				xMOV( arg3reg, ptrNative[arg2reg + 8] );
+				xMOV( ptrNative[data + 8], arg3reg );
+			break;
+		}
+
+		xOR( ptr8[r11 + r10], CacheTagDirty );
+	}
+
+	xJMP( rbx );
+
+	cacheOff.SetTarget();
+	handler.SetTarget();
+	miss.SetTarget();
+
+	xFastCall( GetCacheAccessor( mode, bits ), arg1reg, arg2reg );
+
+	if (!mode)
+	{
+		if (bits == 0)
+		{
+			if (sign)
+				xMOVSX(eax, al);
+			else
+				xMOVZX(eax, al);
+		}
+		else if (bits == 1)
+		{
+			if (sign)
+				xMOVSX(eax, ax);
+			else
+				xMOVZX(eax, ax);
+		}
+	}
+
+	xJMP( rbx );
+
+	pxAssertMsg( xGetPtr() <= GetCacheDispatcherPtr( mode, bits, sign ) + 256, "Cache dispatcher overflow" );
+}
+
 // One-time initialization procedure.  Multiple subsequent calls during the lifespan of the
 // process will be ignored.
 //
@@ -353,6 +537,29 @@ void vtlb_dynarec_init()
 	HostSys::MemProtectStatic( m_IndirectDispatchers, PageAccess_ExecOnly() );
 
 	Perf::any.map((uptr)m_IndirectDispatchers, __pagesize, "TLB Dispatcher");
+
+	if (wordsize == 8)
+	{
+		HostSys::MemProtectStatic( m_CacheDispatchers, PageAccess_ReadWrite() );
+		memset( m_CacheDispatchers, 0xcc, __pagesize);
+
+		for( int mode=0; mode<2; ++mode )
+		{
+			for( int bits=0; bits<5; ++bits )
+			{
+				for (int sign = 0; sign < (!mode && bits < 2 ? 2 : 1); sign++)
+				{
+					xSetPtr( GetCacheDispatcherPtr( mode, bits, !!sign ) );
+
+					DynGen_CacheDispatcher( mode, bits, !!sign );
+				}
+			}
+		}
+
+		HostSys::MemProtectStatic( m_CacheDispatchers, PageAccess_ExecOnly() );
+
+		Perf::any.map((uptr)m_CacheDispatchers, __pagesize, "Cache Dispatcher");
+	}
 }
 
 static void vtlb_SetWriteback(u32 *writeback)
@@ -367,12 +574,333 @@ static void vtlb_SetWriteback(u32 *writeback)
 	*writeback = val;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+// iCachedAccess -- when the EE data cache is emulated, routes accesses to the pages the
+// TLB marks as cached through the cache dispatchers.  The usual vtlb sequence is emitted
+// during the lifetime of the object, and is skipped at runtime for cached pages.
+//
+// The page check is done at runtime even for const addresses, since TLB writes don't
+// clear the blocks that reference the affected pages.  The dispatchers are only
+// generated for x86-64, where r10/r11 are available.
+//
+class iCachedAccess
+{
+protected:
+	int m_mode;
+	int m_bits;
+	bool m_sign;
+	bool m_isConst;
+	u32 m_addr;
+	std::unique_ptr<xForwardJNZ32> m_cached;
+
+public:
+	// Address in arg1reg
+	iCachedAccess( int mode, int bits, bool sign ) :
+		m_mode( mode ), m_bits( bits ), m_sign( sign ), m_isConst( false ), m_addr( 0 )
+	{
+		if (!Enabled()) return;
+
+		xMOV( eax, arg1regd );
+		xSHR( eax, VTLB_PAGE_BITS );
+		xCMP( ptr8[xComplexAddress(rbx, cachedPageMap, rax)], 0 );
+		m_cached.reset( new xForwardJNZ32() );
+	}
+
+	// Const address.  The registers are flushed up front since the dispatcher may call
+	// into C++.
+	iCachedAccess( int mode, int bits, bool sign, u32 addr_const ) :
+		m_mode( mode ), m_bits( bits ), m_sign( sign ), m_isConst( true ), m_addr( addr_const )
+	{
+		if (!Enabled()) return;
+
+		iFlushCall(FLUSH_FULLVTLB);
+		xCMP( ptr8[&cachedPageMap[addr_const >> VTLB_PAGE_BITS]], 0 );
+		m_cached.reset( new xForwardJNZ32() );
+	}
+
+	~iCachedAccess()
+	{
+		if (!m_cached) return;
+
+		xForwardJump32 done;
+		m_cached->SetTarget();
+
+		if (m_isConst)
+			xMOV( arg1regd, m_addr );
+
+		u32* writeback = xLEA_Writeback( rbx );
+		xJMP( GetCacheDispatcherPtr( m_mode, DynGen_SizeIndex( m_bits ), m_sign ) );
+		vtlb_SetWriteback( writeback );
+
+		done.SetTarget();
+	}
+
+	static bool Enabled() { return CHECK_CACHE && wordsize == 8; }
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Fastmem (Recompiler.EEFastmem) -- loads and stores with a non-const address go straight
+// to the fastmem arena (see vtlb.cpp), at base+address.  The first time one of them faults
+// on a page which isn't a view of ram, the fault handler patches the start of the access
+// over to a jump to a thunk doing the usual vmap lookup, which jumps back after the access.
+// Writes to protected code pages are handled by the memory protection instead, and retried.
+//
+// The thunks go into an area of the recompiler cache handed over on every reset.  Its tail
+// is kept for the shared thunks of the accesses faulting once the rest is used up: those
+// aren't patched, they go on faulting and resuming at the shared thunk of their kind (which
+// jumps back to s_fastmemResume) until the recompiler resets.
+//
+struct FastmemSite
+{
+	u8* start;
+	u8* end;
+	u8 mode;
+	u8 bits;
+	bool sign;
+};
+
+static const u32 FastmemThunkMaxSize = 128;
+static const u32 FastmemSharedThunks = 2 * 5 * 2;	// by mode, size index and sign
+static const u32 FastmemSharedReserve = FastmemSharedThunks * FastmemThunkMaxSize;
+
+static std::unordered_map<uptr, FastmemSite> s_fastmemSites;	// by faulting instruction
+static u8* s_fastmemThunkStart = NULL;
+static u8* s_fastmemThunkPtr = NULL;
+static u8* s_fastmemThunkEnd = NULL;
+static u32 s_fastmemEmitted = 0;
+static u32 s_fastmemPatched = 0;
+static u32 s_fastmemShared = 0;
+static u8* s_fastmemSharedThunk[2][5][2];
+static uptr s_fastmemResume = 0;
+
+// In: mem: host address, arg2reg: data (data ptr if bits >= 64)
+// Out: eax: result (if mode == 0 && bits < 64), faults: the instructions accessing mem
+// Clobbers r10 (64/128 bits), edx (8 bit stores)
+static void DynGen_FastmemAccess( int mode, u32 bits, bool sign, const xAddressVoid& mem, u8* (&faults)[2] )
+{
+	faults[1] = NULL;
+
+	if (!mode)
+	{
+		faults[0] = xGetPtr();
+		switch( bits )
+		{
+			case 8:
+				if( sign )
+					xMOVSX( eax, ptr8[mem] );
+				else
+					xMOVZX( eax, ptr8[mem] );
+			break;
+
+			case 16:
+				if( sign )
+					xMOVSX( eax, ptr16[mem] );
+				else
+					xMOVZX( eax, ptr16[mem] );
+			break;
+
+			case 32:
+				xMOV( eax, ptr32[mem] );
+			break;
+
+			case 64:
+				xMOV( r10, ptrNative[mem] );
+				xMOV( ptrNative[arg2reg], r10 );
+			break;
+
+			case 128:
+				xMOV( r10, ptrNative[mem] );
+				xMOV( ptrNative[arg2reg], r10 );
+				faults[1] = xGetPtr();
+				xMOV( r10, ptrNative[mem + 8] );
+				xMOV( ptrNative[arg2reg + 8], r10 );
+			break;
+
+			jNO_DEFAULT
+		}
+	}
+	else
+	{
+		switch( bits )
+		{
+			case 8:
+				xMOV( edx, arg2regd );
+				faults[0] = xGetPtr();
+				xMOV( ptr[mem], dl );
+			break;
+
+			case 16:
+				faults[0] = xGetPtr();
+				xMOV( ptr[mem], xRegister16(arg2reg.Id) );
+			break;
+
+			case 32:
+				faults[0] = xGetPtr();
+				xMOV( ptr[mem], arg2regd );
+			break;
+
+			case 64:
+				xMOV( r10, ptrNative[arg2reg] );
+				faults[0] = xGetPtr();
+				xMOV( ptrNative[mem], r10 );
+			break;
+
+			case 128:
+				xMOV( r10, ptrNative[arg2reg] );
+				faults[0] = xGetPtr();
+				xMOV( ptrNative[mem], r10 );
+				xMOV( r10, ptrNative[arg2reg + 8] );
+				faults[1] = xGetPtr();
+				xMOV( ptrNative[mem + 8], r10 );
+			break;
+
+			jNO_DEFAULT
+		}
+	}
+}
+
+// Emits a fastmem access if enabled.  Same registers as the vmap lookup, plus r10/r11.
+static bool DynGen_Fastmem( int mode, u32 bits, bool sign )
+{
+#ifdef __M_X86_64
+	u8* base = vtlb_GetFastmemBase();
+	if (!base || !s_fastmemThunkStart || iCachedAccess::Enabled()) return false;
+
+	EE::Profiler.EmitMem();
+
+	// The base load also leaves room for the jump patched over the access
+	FastmemSite site = { xGetPtr(), NULL, (u8)mode, (u8)bits, sign };
+	xMOV64( r11, (sptr)base );
+	pxAssert( xGetPtr() - site.start >= 5 );
+
+	u8* faults[2];
+	DynGen_FastmemAccess( mode, bits, sign, r11 + arg1reg, faults );
+	site.end = xGetPtr();
+
+	for (u8* fault : faults)
+	{
+		if (fault) s_fastmemSites[(uptr)fault] = site;
+	}
+	s_fastmemEmitted++;
+	return true;
+#else
+	return false;
+#endif
+}
+
+// Called by the recompiler on reset, with the area for the thunks.
+void vtlb_FastmemResetSites( u8* thunks, u32 size )
+{
+	if (EmuConfig.Profiler.Enabled && s_fastmemEmitted)
+	{
+		Console.WriteLn( Color_StrongBlue, "EE fastmem: %u accesses emitted, %u patched to the vmap lookup, %u through a shared thunk (%u KB of thunks)",
+			s_fastmemEmitted, s_fastmemPatched, s_fastmemShared, (u32)((s_fastmemThunkPtr - s_fastmemThunkStart) / _1kb) );
+	}
+
+	s_fastmemSites.clear();
+	s_fastmemThunkStart = thunks;
+	s_fastmemThunkPtr = thunks;
+	s_fastmemThunkEnd = thunks + size;
+	s_fastmemEmitted = 0;
+	s_fastmemPatched = 0;
+	s_fastmemShared = 0;
+	memzero( s_fastmemSharedThunk );
+}
+
+// Forgets the accesses of [start, end) of the recompiler cache, which is about to be reused.
+void vtlb_FastmemClearSites( uptr start, uptr end )
+{
+	for (auto it = s_fastmemSites.begin(); it != s_fastmemSites.end(); )
+	{
+		if (it->first - start < end - start)
+			it = s_fastmemSites.erase( it );
+		else
+			++it;
+	}
+}
+
+// The recompiler resets once a quarter of the thunk area is left, which is plenty for the
+// accesses faulting until it gets to.
+bool vtlb_FastmemThunksLow()
+{
+	return (s_fastmemThunkEnd - s_fastmemThunkPtr) < (s_fastmemThunkEnd - s_fastmemThunkStart) / 4;
+}
+
+// Emits the vmap lookup of the access of a site into the thunk area, jumping back to resume
+// after it, or to s_fastmemResume if NULL.
+static u8* DynGen_FastmemThunk( const FastmemSite& site, u8* resume )
+{
+	u8* oldPtr = xGetPtr();
+	u8* thunk = s_fastmemThunkPtr;
+	xSetPtr( thunk );
+
+	xMOV( eax, arg1regd );
+	xSHR( eax, VTLB_PAGE_BITS );
+	xMOV( rax, ptrNative[xComplexAddress(rbx, vtlbdata.vmap, rax*wordsize)] );
+	u32* writeback = xLEA_Writeback( rbx );
+	xADD( arg1reg, rax );
+
+	DynGen_IndirectDispatch( site.mode, site.bits, site.sign );
+
+	u8* faults[2];
+	DynGen_FastmemAccess( site.mode, site.bits, site.sign, xAddressVoid( arg1reg ), faults );
+
+	vtlb_SetWriteback( writeback );
+	if (resume)
+		xJMP( resume );
+	else
+		xJMP( ptrNative[&s_fastmemResume] );
+
+	pxAssert( xGetPtr() <= thunk + FastmemThunkMaxSize );
+	s_fastmemThunkPtr = xGetPtr();
+	xSetPtr( oldPtr );
+	return thunk;
+}
+
+// Called from the fault handler with the faulting instruction.  Returns the thunk to resume
+// at, or 0 if it isn't a fastmem access.
+uptr vtlb_FastmemBackpatch( uptr pc )
+{
+	auto it = s_fastmemSites.find( pc );
+	if (it == s_fastmemSites.end())
+		return 0;
+
+	const FastmemSite site = it->second;
+
+	// Out of room for a thunk of its own, the reset is already due (see vtlb_FastmemThunksLow)
+	if ((s_fastmemThunkEnd - s_fastmemThunkPtr) < FastmemThunkMaxSize + FastmemSharedReserve)
+	{
+		u8*& shared = s_fastmemSharedThunk[site.mode][DynGen_SizeIndex( site.bits )][site.sign];
+		if (!shared)
+			shared = DynGen_FastmemThunk( site, NULL );
+
+		s_fastmemResume = (uptr)site.end;
+		s_fastmemShared++;
+		return (uptr)shared;
+	}
+
+	s_fastmemSites.erase( it );
+
+	u8* thunk = DynGen_FastmemThunk( site, site.end );
+
+	u8* oldPtr = xGetPtr();
+	xSetPtr( site.start );
+	xJMP( thunk );
+	xSetPtr( oldPtr );
+
+	s_fastmemPatched++;
+	return (uptr)thunk;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //                            Dynarec Load Implementations
 void vtlb_DynGenRead64(u32 bits)
 {
 	pxAssume( bits == 64 || bits == 128 );
 
+	if (DynGen_Fastmem( 0, bits, false )) return;
+
+	iCachedAccess cached( 0, bits, false );
 	u32* writeback = DynGen_PrepRegs();
 
 	DynGen_IndirectDispatch( 0, bits );
@@ -389,6 +917,9 @@ void vtlb_DynGenRead32(u32 bits, bool sign)
 {
 	pxAssume( bits <= 32 );
 
+	if (DynGen_Fastmem( 0, bits, sign && bits < 32 )) return;
+
+	iCachedAccess cached( 0, bits, sign && bits < 32 );
 	u32* writeback = DynGen_PrepRegs();
 
 	DynGen_IndirectDispatch( 0, bits, sign && bits < 32 );
@@ -403,6 +934,7 @@ void vtlb_DynGenRead32(u32 bits, bool sign)
 void vtlb_DynGenRead64_Const( u32 bits, u32 addr_const )
 {
 	EE::Profiler.EmitConstMem(addr_const);
+	iCachedAccess cached( 0, bits, false, addr_const );
 
 	auto vmv = vtlbdata.vmap[addr_const>>VTLB_PAGE_BITS];
 	if( !vmv.isHandler(addr_const) )
@@ -449,6 +981,7 @@ void vtlb_DynGenRead64_Const( u32 bits, u32 addr_const )
 void vtlb_DynGenRead32_Const( u32 bits, bool sign, u32 addr_const )
 {
 	EE::Profiler.EmitConstMem(addr_const);
+	iCachedAccess cached( 0, bits, sign && bits < 32, addr_const );
 
 	auto vmv = vtlbdata.vmap[addr_const>>VTLB_PAGE_BITS];
 	if( !vmv.isHandler(addr_const) )
@@ -523,6 +1056,9 @@ void vtlb_DynGenRead32_Const( u32 bits, bool sign, u32 addr_const )
 
 void vtlb_DynGenWrite(u32 sz)
 {
+	if (DynGen_Fastmem( 1, sz, false )) return;
+
+	iCachedAccess cached( 1, sz, false );
 	u32* writeback = DynGen_PrepRegs();
 
 	DynGen_IndirectDispatch( 1, sz );
@@ -539,6 +1075,7 @@ void vtlb_DynGenWrite(u32 sz)
 void vtlb_DynGenWrite_Const( u32 bits, u32 addr_const )
 {
 	EE::Profiler.EmitConstMem(addr_const);
+	iCachedAccess cached( 1, bits, false, addr_const );
 
 	auto vmv = vtlbdata.vmap[addr_const>>VTLB_PAGE_BITS];
 	if( !vmv.isHandler(addr_const) )
@@ -58,10 +58,12 @@ void mVUinit(microVU& mVU, uint vuIndex) {
 	mVU.progSize		= (mVU.index ? 0x4000 : 0x1000) / 4;
 	mVU.progMemMask		=  mVU.progSize-1;
 	mVU.cacheSize		=  vuIndex ? mVU1cacheReserve : mVU0cacheReserve;
+	mVU.cacheResets		= 0;
 	mVU.cache			= NULL;
 	mVU.dispCache		= NULL;
 	mVU.startFunct		= NULL;
 	mVU.exitFunct		= NULL;
+	mVU.microSrc		= NULL;
 
 	mVUreserveCache(mVU);
 
@@ -74,6 +76,12 @@ void mVUinit(microVU& mVU, uint vuIndex) {
 // Resets Rec Data
 void mVUreset(microVU& mVU, bool resetReserve) {
 
+	// The background compiler is restarted once the cache is set up again
+	mVUstagingStop(mVU);
+
+	// Remember the game's programs for the next session (and reload them unless the cache ran full)
+	mVUprogCacheSave(mVU, resetReserve);
+
 	// Restore reserve to uncommitted state
 	if (resetReserve) mVU.cache_reserve->Reset();
 
@@ -90,12 +98,19 @@ void mVUreset(microVU& mVU, bool resetReserve) {
 	memset(&mVU.prog.lpState, 0, sizeof(mVU.prog.lpState));
 	mVU.profiler.Reset(mVU.index);
 
+	BlockProfiler::Table& profTable = mVU.index ? BlockProfiler::vu1 : BlockProfiler::vu0;
+	profTable.Dump(32);
+	profTable.Reset(EmuConfig.Profiler.Enabled && (mVU.index ? EmuConfig.Profiler.RecBlocks_VU1 : EmuConfig.Profiler.RecBlocks_VU0));
+	mVUprintSearchStats(mVU);
+	memzero(mVU.prog.search);
+
 	// Program Variables
 	mVU.prog.cleared	=  1;
 	mVU.prog.isSame		= -1;
 	mVU.prog.cur		= NULL;
 	mVU.prog.total		=  0;
 	mVU.prog.curFrame	=  0;
+	mVU.prog.microHashValid = 0;
 
 	// Setup Dynarec Cache Limits for Each Program
 	u8* z = mVU.cache;
@@ -103,6 +118,7 @@ void mVUreset(microVU& mVU, bool resetReserve) {
 	mVU.prog.x86ptr		= z;
 	mVU.prog.x86end		= z + ((mVU.cacheSize - mVUcacheSafeZone) * _1mb);
 	//memset(mVU.prog.x86start, 0xcc, mVU.cacheSize*_1mb);
+	mVUstagingReset(mVU);
 
 	for(u32 i = 0; i < (mVU.progSize / 2); i++) {
 		if(!mVU.prog.prog[i]) {
@@ -127,6 +143,14 @@ void mVUreset(microVU& mVU, bool resetReserve) {
 // Free Allocated Resources
 void mVUclose(microVU& mVU) {
 
+	mVUstagingStop(mVU);
+
+	BlockProfiler::Table& profTable = mVU.index ? BlockProfiler::vu1 : BlockProfiler::vu0;
+	profTable.Dump(32);
+	profTable.Reset(false);
+	mVUprintSearchStats(mVU);
+
+	mVUprogCacheSave(mVU, true);
 	safe_delete  (mVU.cache_reserve);
 
 	// Delete Programs and Block Managers
@@ -142,6 +166,8 @@ void mVUclose(microVU& mVU) {
 
 // Clears Block Data in specified range
 __fi void mVUclear(mV, u32 addr, u32 size) {
+	mVU.prog.microHashValid = std::min(mVU.prog.microHashValid, addr / 4); // Rehash from there on
+	mVUstagingClear(mVU, addr, size);
 	if(!mVU.prog.cleared) {
 		mVU.prog.cleared = 1;		// Next execution searches/creates a new microprogram
 		memzero(mVU.prog.lpState); // Clear pipeline state
@@ -178,9 +204,14 @@ __ri microProgram* mVUcreateProg(microVU& mVU, int startPC) {
 	prog->ranges  = new std::deque<microRange>();
 	prog->startPC = startPC;
 	mVUcacheProg(mVU, *prog); // Cache Micro Program
-	double cacheSize = (double)((uptr)mVU.prog.x86end - (uptr)mVU.prog.x86start);
-	double cacheUsed =((double)((uptr)mVU.prog.x86ptr - (uptr)mVU.prog.x86start)) / (double)_1mb;
-	double cachePerc =((double)((uptr)mVU.prog.x86ptr - (uptr)mVU.prog.x86start)) / cacheSize * 100;
+	// The background compiler fills the staging area, mVU.prog.x86ptr belongs to the VU thread
+	const bool staged = mVU.staging.compiling;
+	u8* x86start = staged ? mVU.staging.x86start : mVU.prog.x86start;
+	u8* x86end   = staged ? mVU.staging.x86end   : mVU.prog.x86end;
+	u8* x86ptr   = staged ? mVU.staging.x86ptr   : mVU.prog.x86ptr;
+	double cacheSize = (double)((uptr)x86end - (uptr)x86start);
+	double cacheUsed =((double)((uptr)x86ptr - (uptr)x86start)) / (double)_1mb;
+	double cachePerc =((double)((uptr)x86ptr - (uptr)x86start)) / cacheSize * 100;
 	ConsoleColors c = mVU.index ? Color_Orange : Color_Magenta;
 	DevCon.WriteLn(c, "microVU%d: Cached Prog = [%03d] [PC=%04x] [List=%02d] (Cache=%3.3f%%) [%3.1fmb]",
 				   mVU.index, prog->idx, startPC*8, mVU.prog.prog[startPC]->size()+1, cachePerc, cacheUsed);
@@ -189,27 +220,89 @@ __ri microProgram* mVUcreateProg(microVU& mVU, int startPC) {
 
 // Caches Micro Program
 __ri void mVUcacheProg(microVU& mVU, microProgram& prog) {
-	if (!mVU.index)	memcpy(prog.data, mVU.regs().Micro, 0x1000);
-	else			memcpy(prog.data, mVU.regs().Micro, 0x4000);
+	if (!mVU.index)	memcpy(prog.data, mVU.getMicro(), 0x1000);
+	else			memcpy(prog.data, mVU.getMicro(), 0x4000);
+	prog.rangesHash = mVUrangesHash(mVU, prog);
 	mVUdumpProg(mVU, prog);
 }
 
+// Words of micro memory covered by a range (as compared by mVUcmpPartial), false if none.
+// Ranges still being recompiled (end = -1) aren't hashed.
+static __fi bool mVUrangeWords(microVU& mVU, const microRange& range, u32& first, u32& last) {
+	if ((range.start < 0) || (range.end < range.start)) return false;
+	first = range.start / 4;
+	last  = std::min<u32>((range.end + 8) / 4, mVU.progSize);
+	return first < last;
+}
+
+// Hash of a word of micro memory at a given position. Hashes of ranges are sums of these,
+// so the hash of any range of micro memory can be taken from running sums.
+static __fi u64 mVUwordHash(u32 idx, u32 word) {
+	u64 x = ((u64)idx << 32) | word;
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdull;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ull;
+	x ^= x >> 33;
+	return x;
+}
+
+// Generate Hash for a compiled range of a program...
+u64 mVUrangeHash(microVU& mVU, const microProgram& prog, const microRange& range) {
+	u32 first, last;
+	u64 hash = 0;
+	if (!mVUrangeWords(mVU, range, first, last)) return 0;
+	for (u32 i = first; i < last; i++) {
+		hash += mVUwordHash(i, prog.data[i]);
+	}
+	return hash;
+}
+
 // Generate Hash for partial program based on compiled ranges...
-u64 mVUrangesHash(microVU& mVU, microProgram& prog) {
-	union {
-		u64 v64;
-		u32 v32[2];
-	} hash = {0};
+u64 mVUrangesHash(microVU& mVU, const microProgram& prog) {
+	u64 hash = 0;
+	std::deque<microRange>::const_iterator it(prog.ranges->begin());
+	for ( ; it != prog.ranges->end(); ++it) {
+		if((it[0].start<0)||(it[0].end<-1)) { DevCon.Error("microVU%d: Negative Range![%d][%d]", mVU.index, it[0].start, it[0].end); }
+		hash += mVUrangeHash(mVU, prog, it[0]);
+	}
+	return hash;
+}
+
+// Hash of mVU.regs().Micro over the compiled ranges of a program, comparable to its rangesHash.
+// The running sums are only brought up to date as far as needed, mVUclear() invalidates them
+// from the cleared address on.
+static u64 mVUmicroRangesHash(microVU& mVU, const microProgram& prog) {
+	u64* sums  = mVU.prog.microHash;
+	u32& valid = mVU.prog.microHashValid;
+	const u32* micro = (const u32*)mVU.regs().Micro;
+	u64 hash = 0;
 
 	std::deque<microRange>::const_iterator it(prog.ranges->begin());
 	for ( ; it != prog.ranges->end(); ++it) {
-		if((it[0].start<0)||(it[0].end<0))  { DevCon.Error("microVU%d: Negative Range![%d][%d]", mVU.index, it[0].start, it[0].end); }
-		for(int i = it[0].start/4; i < it[0].end/4; i++) {
-			hash.v32[0] -= prog.data[i];
-			hash.v32[1] ^= prog.data[i];
+		u32 first, last;
+		if (!mVUrangeWords(mVU, it[0], first, last)) continue;
+		if (last > valid) {
+			for (u32 i = valid; i < last; i++) {
+				sums[i + 1] = sums[i] + mVUwordHash(i, micro[i]);
+			}
+			mVU.prog.search.hashBytes += (last - valid) * 4;
+			valid = last;
 		}
+		hash += sums[last] - sums[first];
 	}
-	return hash.v64;
+	return hash;
+}
+
+// Prints the program search counters when the profiler is enabled
+void mVUprintSearchStats(microVU& mVU) {
+	const microSearchStats& s = mVU.prog.search;
+	if (!EmuConfig.Profiler.Enabled || !s.searches) return;
+	Console.WriteLn(Color_StrongBlue, "microVU%d: %llu program searches, %.1f candidates on average (max %llu), "
+					"%llu compares (%llu hash collisions), %.1f KB compared and %.1f KB hashed per search",
+					mVU.index, (unsigned long long)s.searches, (double)s.candidates / s.searches, (unsigned long long)s.maxLength,
+					(unsigned long long)s.compares, (unsigned long long)s.hashMisses,
+					s.cmpBytes / 1024.0 / s.searches, s.hashBytes / 1024.0 / s.searches);
 }
 
 // Prints the ratio of unique programs to total programs
@@ -220,7 +313,7 @@ void mVUprintUniqueRatio(microVU& mVU) {
 		if (!list) continue;
 		std::deque<microProgram*>::iterator it(list->begin());
 		for ( ; it != list->end(); ++it) {
-			v.push_back(mVUrangesHash(mVU, *it[0]));
+			v.push_back(it[0]->rangesHash);
 		}
 	}
 	u32 total = v.size();
@@ -235,6 +328,7 @@ __ri bool mVUcmpPartial(microVU& mVU, microProgram& prog) {
 	std::deque<microRange>::const_iterator it(prog.ranges->begin());
 	for ( ; it != prog.ranges->end(); ++it) {
 		if((it[0].start<0)||(it[0].end<0))  { DevCon.Error("microVU%d: Negative Range![%d][%d]", mVU.index, it[0].start, it[0].end); }
+		mVU.prog.search.cmpBytes += (it[0].end + 8) - it[0].start;
 		if (memcmp_mmx(cmpOffset(prog.data), cmpOffset(mVU.regs().Micro), ((it[0].end + 8)  -  it[0].start))) {
 			return 0;
 		}
@@ -260,9 +354,20 @@ _mVUt __fi void* mVUsearchProg(u32 startPC, uptr pState) {
 	microProgramQuick& quick = mVU.prog.quick[startPC/8];
 	microProgramList*  list  = mVU.prog.prog [startPC/8];
 	if(!quick.prog) { // If null, we need to search for new program
+		mVUprogCacheLoad(mVU);
+		microSearchStats& stats = mVU.prog.search;
+		stats.searches++;
+		stats.maxLength = std::max<u64>(stats.maxLength, list->size());
+		// Skip the programs whose ranges hash doesn't match micro memory, only the others
+		// need the full compare. The Ibit gamefixes also match programs which do differ.
+		const bool useHash = (list->size() > 1) && !EmuConfig.Gamefixes.ScarfaceIbit && !EmuConfig.Gamefixes.CrashTagTeamRacingIbit;
 		std::deque<microProgram*>::iterator it(list->begin());
 		for ( ; it != list->end(); ++it) {
+			stats.candidates++;
+			if (useHash && (mVUmicroRangesHash(mVU, *it[0]) != it[0]->rangesHash)) continue;
+			stats.compares++;
 			bool b = mVUcmpProg(mVU, *it[0], 0);
+			if (useHash && !b) stats.hashMisses++;
 			if (EmuConfig.Gamefixes.ScarfaceIbit) {
 				if (isVU1 && ((((u32*)mVU.regs().Micro)[startPC / 4 + 1]) == 0x80200118) &&
 						     ((((u32*)mVU.regs().Micro)[startPC / 4 + 3]) == 0x81000062)) {
@@ -291,6 +396,17 @@ _mVUt __fi void* mVUsearchProg(u32 startPC, uptr pState) {
 			}
 		}
 
+		// Pick up the program if the background compiler got it right
+		if (microProgram* staged = mVUstagingAdopt(mVU, startPC/8)) {
+			mVU.prog.cleared = 0;
+			mVU.prog.cur	 = staged;
+			mVU.prog.isSame	 = -1;
+			quick.block		 = staged->block[startPC/8];
+			quick.prog		 = staged;
+			list->push_front(staged);
+			return mVUentryGet(mVU, quick.block, startPC, pState);
+		}
+
 		// If cleared and program not found, make a new program instance
 		mVU.prog.cleared	= 0;
 		mVU.prog.isSame		= 1;
@@ -412,6 +528,11 @@ void recMicroVU1::SetCacheReserve(uint reserveInMegs) const {
 	mVUreserveCache(microVU1); // Need rec-reset after this
 }
 
+void recMicroVU1::MicroUploaded(u32 addr, u32 size) {
+	pxAssert(m_Reserved); // please allocate me first! :|
+	mVUstagingUpload(microVU1);
+}
+
 void recMicroVU1::ResumeXGkick() {
 	pxAssert(m_Reserved); // please allocate me first! :|
 
@@ -23,6 +23,9 @@ using namespace x86Emitter;
 #include <deque>
 #include <algorithm>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 #include "Common.h"
 #include "VU.h"
 #include "MTVU.h"
@@ -30,6 +33,7 @@ using namespace x86Emitter;
 #include "Gif_Unit.h"
 #include "iR5900.h"
 #include "R5900OpcodeTables.h"
+#include "BlockProfiler.h"
 #include "System/RecTypes.h"
 #include "x86emitter/x86emitter.h"
 #include "microVU_Misc.h"
@@ -118,6 +122,11 @@ public:
 		}
 		return NULL;
 	}
+	template<typename T>
+	void forEach(T func) const { // Calls func for every block (quick list first)
+		for(microBlockLink* linkI = qBlockList; linkI != NULL; linkI = linkI->next) func(linkI->block);
+		for(microBlockLink* linkI = fBlockList; linkI != NULL; linkI = linkI->next) func(linkI->block);
+	}
 	void printInfo(int pc, bool printQuick) {
 		int listI = printQuick ? qListI : fListI;
 		if (listI < 7) return;
@@ -147,6 +156,7 @@ struct microProgram {
 	u32				   data [mProgSize];   // Holds a copy of the VU microProgram
 	microBlockManager* block[mProgSize/2]; // Array of Block Managers
 	std::deque<microRange>* ranges;			   // The ranges of the microProgram that have already been recompiled
+	u64 rangesHash; // Hash of the contents of the ranges (kept up to date by mVUsetupRange)
 	u32 startPC; // Start PC of this program
 	int idx;	 // Program index
 };
@@ -158,6 +168,17 @@ struct microProgramQuick {
 	microProgram*		  prog;	 // The microProgram who is the owner of 'block'
 };
 
+// Program search counters, printed with the profiler
+struct microSearchStats {
+	u64 searches;   // Searches for a program after a clear
+	u64 candidates; // Programs looked at (summed over the searches)
+	u64 maxLength;  // Longest program list searched
+	u64 compares;   // Candidates compared against VU micro memory
+	u64 hashMisses; // Candidates whose ranges hash matched but not their contents
+	u64 cmpBytes;   // Bytes compared against VU micro memory
+	u64 hashBytes;  // Bytes of VU micro memory hashed for the search index
+};
+
 struct microProgManager {
 	microIR<mProgSize>	IRinfo;				// IR information
 	microProgramList*	prog [mProgSize/2];	// List of microPrograms indexed by startPC values
@@ -171,6 +192,51 @@ struct microProgManager {
 	u8*					x86start;			// Start of program's rec-cache
 	u8*					x86end;				// Limit of program's rec-cache
 	microRegInfo		lpState;			// Pipeline state from where program left off (useful for continuing execution)
+	u64					microHash[mProgSize+1]; // Running sums of the word hashes of mVU.regs().Micro
+	u32					microHashValid;		// microHash[0..microHashValid] are up to date
+	microSearchStats	search;				// Program search counters
+};
+
+// Counters of the background compiler, printed with the profiler
+struct microStagingStats {
+	u64 requests;     // Programs predicted from MPG transfers
+	u64 skipped;      // Predictions which were already compiled (or couldn't be staged)
+	u64 staged;       // Programs compiled by the worker
+	u64 adopted;      // Staged programs picked up by mVUsearchProg
+	u64 stagedTicks;  // Worker compile time of the staged programs
+	u64 adoptedTicks; // Worker compile time of the adopted ones (compile stalls the VU thread didn't have)
+	u64 syncCompiles; // Searches/JIT calls which still compiled on the VU thread
+	u64 syncTicks;    // Time the VU thread spent compiling
+	u64 waits;        // Searches/JIT calls which had to wait for the worker
+	u64 waitTicks;    // Time the VU thread spent waiting for the worker
+};
+
+struct microStagedProg {
+	microProgram* prog;
+	u64 ticks; // Time the worker spent compiling it
+};
+
+// Background compiler (mVU1 with MTVU, see microVU_Staging.inl)
+struct microStaging {
+	bool			active;		// Worker is running, program searches/compiles have to hold 'lock'
+	bool			compiling;	// Worker is compiling (the program isn't the VU thread's)
+	std::mutex		lock;		// Held while compiling and while touching the program lists
+	std::thread		worker;
+	std::mutex		reqLock;	// Protects the request
+	std::condition_variable reqWake;
+	bool			quit;
+	bool			pending;	// A request is waiting for the worker
+	u32				reqPC;		// Predicted start PC of the request
+	std::vector<u8>	reqMicro;	// Micro memory the request is compiled from
+	u32				runStart;	// Start of the current run of contiguous micro memory writes (VU thread)
+	u32				runEnd;		// End of the current run
+	bool			executed;	// A program ran since the last micro memory write (VU thread)
+	u8*				x86start;	// Start of the staging area of the rec-cache
+	u8*				x86ptr;		// Worker's recompilation position (only touched with 'lock' held)
+	microRegInfo	lpState;	// Worker's copy of the pipeline state the block it compiles starts with
+	u8*				x86end;		// Limit of the staging area
+	std::deque<microStagedProg> progs; // Compiled programs which haven't been picked up yet
+	microStagingStats stats;
 };
 
 static const uint mVUdispCacheSize	= __pagesize; // Dispatcher Cache Size (in bytes)
@@ -193,8 +259,10 @@ struct microVU {
 	u32 progSize;		// VU Micro Memory Size (in u32's)
 	u32 progMemMask;	// VU Micro Memory Size (in u32's)
 	u32 cacheSize;		// VU Cache Size
+	u32 cacheResets;	// Number of times the program cache ran full
 
 	microProgManager				prog;		// Micro Program Data
+	microStaging					staging;	// Background compiler
 	microProfiler					profiler;   // Opcode Profiler
 	std::unique_ptr<microRegAlloc>	regAlloc;	// Reg Alloc Class
 	std::unique_ptr<AsciiFile>		logFile;	// Log File Pointer
@@ -218,8 +286,10 @@ struct microVU {
 	u32		q;			  // Holds current Q instance index
 	u32		totalCycles;  // Total Cycles that mVU is expected to run for
 	u32		cycles;		  // Cycles Counter
+	u8*		microSrc;	  // Micro memory programs are compiled from, if not mVU.regs().Micro
 
 	VURegs& regs() const { return ::vuRegs[index]; }
+	__fi u8* getMicro() const { return microSrc ? microSrc : regs().Micro; }
 
 	__fi REG_VI& getVI(uint reg) const	{ return regs().VI[reg]; }
 	__fi VECTOR& getVF(uint reg) const	{ return regs().VF[reg]; }
@@ -248,8 +318,17 @@ mVUop(mVUopU);
 mVUop(mVUopL);
 
 // Private Functions
+extern microProgram* mVUcreateProg(microVU& mVU, int startPC);
 extern void  mVUcacheProg (microVU& mVU, microProgram&  prog);
 extern void  mVUdeleteProg(microVU& mVU, microProgram*& prog);
+extern u64   mVUrangeHash (microVU& mVU, const microProgram& prog, const microRange& range);
+extern u64   mVUrangesHash(microVU& mVU, const microProgram& prog);
+extern void  mVUprintSearchStats(microVU& mVU);
+extern bool  mVUcmpPartial(microVU& mVU, microProgram& prog);
+extern void  mVUstagingStop (microVU& mVU);
+extern void  mVUstagingReset(microVU& mVU);
+extern void  mVUstagingUpload(microVU& mVU);
+extern void  mVUstagingPrintStats(microVU& mVU);
 _mVUt extern void* mVUsearchProg(u32 startPC, uptr pState);
 extern void* __fastcall mVUexecuteVU0(u32 startPC, u32 cycles);
 extern void* __fastcall mVUexecuteVU1(u32 startPC, u32 cycles);
@@ -279,6 +358,8 @@ void sortVector(T& v) {
 #include "microVU_Tables.inl"
 #include "microVU_Flags.inl"
 #include "microVU_Branch.inl"
+#include "microVU_Staging.inl"
 #include "microVU_Compile.inl"
 #include "microVU_Execute.inl"
 #include "microVU_Macro.inl"
+#include "microVU_ProgCache.inl"
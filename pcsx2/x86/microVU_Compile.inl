@@ -33,7 +33,7 @@ static void __fc mVUprintPC2(u32 pc)			{ Console.WriteLn("Block End PC   = 0x%04
 // Used by mVUsetupRange
 __fi void mVUcheckIsSame(mV) {
 	if (mVU.prog.isSame == -1) {
-		mVU.prog.isSame = !memcmp_mmx((u8*)mVUcurProg.data, mVU.regs().Micro, mVU.microMemSize);
+		mVU.prog.isSame = !memcmp_mmx((u8*)mVUcurProg.data, mVU.getMicro(), mVU.microMemSize);
 	}
 	if (mVU.prog.isSame == 0) {
 		mVUcacheProg(mVU, *mVU.prog.cur);
@@ -42,8 +42,10 @@ __fi void mVUcheckIsSame(mV) {
 }
 
 // Sets up microProgram PC ranges based on whats been recompiled
+// (and keeps the program's rangesHash in sync with them)
 void mVUsetupRange(microVU& mVU, s32 pc, bool isStartPC) {
 	std::deque<microRange>*& ranges = mVUcurProg.ranges;
+	u64& rangesHash = mVUcurProg.rangesHash;
 	pc &= mVU.microMemSize - 8;
 
 	if (isStartPC) { // Check if startPC is already within a block we've recompiled
@@ -74,6 +76,7 @@ void mVUsetupRange(microVU& mVU, s32 pc, bool isStartPC) {
 		s32  rEnd   = mVUrange.end;
 		std::deque<microRange>::iterator it(ranges->begin());
 		for (++it; it != ranges->end(); ++it) {
+			const microRange oldRange = it[0];
 			if((it[0].start >= rStart) && (it[0].start <= rEnd)) { // Starts after this prog but starts before the end of current prog
 				it[0].end   = std::max(it[0].end, rEnd);  // Extend the end of this prog to match this program
 				mergedRange = true;
@@ -83,17 +86,21 @@ void mVUsetupRange(microVU& mVU, s32 pc, bool isStartPC) {
 				it[0].start = std::min(it[0].start, rStart); // Choose the earlier start
 				mergedRange = true;
 			}
+			if ((it[0].start != oldRange.start) || (it[0].end != oldRange.end))
+				rangesHash += mVUrangeHash(mVU, mVUcurProg, it[0]) - mVUrangeHash(mVU, mVUcurProg, oldRange);
 		}
 		if (mergedRange) {
 			//DevCon.WriteLn(Color_Green, "microVU%d: Prog Range Merging", mVU.index);
 			ranges->erase(ranges->begin());
 		}
+		else rangesHash += mVUrangeHash(mVU, mVUcurProg, mVUrange);
 	}
 	else {
 		DevCon.WriteLn(Color_Green, "microVU%d: Prog Range Wrap [%04x] [%d]", mVU.index, mVUrange.start, mVUrange.end);
 		mVUrange.end = mVU.microMemSize;
 		microRange mRange = {0, pc};
 		ranges->push_front(mRange);
+		rangesHash += mVUrangeHash(mVU, mVUcurProg, (*ranges)[1]) + mVUrangeHash(mVU, mVUcurProg, mRange);
 	}
 }
 
@@ -360,11 +367,18 @@ __fi bool doEarlyExit(microVU& mVU) {
 	return true;// IsDevBuild || !isVU1;
 }
 
+// Pipeline state the block being compiled starts with (the worker keeps its own, the VU
+// thread's lpState isn't the one of the staged program)
+__fi microRegInfo& mVUentryState(microVU& mVU) {
+	return mVU.staging.compiling ? mVU.staging.lpState : mVU.prog.lpState;
+}
+
 // Saves Pipeline State for resuming from early exits
 __fi void mVUsavePipelineState(microVU& mVU) {
 	u32* lpS = (u32*)&mVU.prog.lpState;
-	for(size_t i = 0; i < (sizeof(microRegInfo)-4)/4; i++, lpS++) {
-		xMOV(ptr32[lpS], lpS[0]);
+	u32* epS = (u32*)&mVUentryState(mVU);
+	for(size_t i = 0; i < (sizeof(microRegInfo)-4)/4; i++, lpS++, epS++) {
+		xMOV(ptr32[lpS], epS[0]);
 	}
 }
 
@@ -435,8 +449,8 @@ __fi void mVUinitFirstPass(microVU& mVU, uptr pState, u8* thisPtr) {
 	if ((uptr)&mVUregs != pState) {	// Loads up Pipeline State Info
 		memcpy((u8*)&mVUregs, (u8*)pState, sizeof(microRegInfo));
 	}
-	if (doEarlyExit(mVU) && ((uptr)&mVU.prog.lpState != pState)) {
-		memcpy((u8*)&mVU.prog.lpState, (u8*)pState, sizeof(microRegInfo));
+	if (doEarlyExit(mVU) && ((uptr)&mVUentryState(mVU) != pState)) {
+		memcpy((u8*)&mVUentryState(mVU), (u8*)pState, sizeof(microRegInfo));
 	}
 	mVUblock.x86ptrStart	= thisPtr;
 	mVUpBlock				= mVUblocks[mVUstartPC/2]->add(&mVUblock); // Add this block to block manager
@@ -628,6 +642,11 @@ void* mVUcompile(microVU& mVU, u32 startPC, uptr pState)
 	mVUdebugPrintBlocks(mVU, false); // Prints Start/End PC of blocks executed, for debugging...
 	mVUtestCycles(mVU, mFC);              // Update VU Cycles and Exit Early if Necessary
 
+	BlockProfiler::Table& profTable = isVU1 ? BlockProfiler::vu1 : BlockProfiler::vu0;
+	BlockProfiler::BlockStats* profStats = profTable.Begin(startPC, mVU.prog.cur ? mVU.prog.cur->idx : 0);
+	const u32 profCount = mVUcount;
+	const u32 profCycles = mVUcycles;
+
 	// Second Pass
 	iPC = mVUstartPC;
 	setCode();
@@ -724,6 +743,7 @@ void* mVUcompile(microVU& mVU, u32 startPC, uptr pState)
 perf_and_return:
 
 	Perf::vu.map((uptr)thisPtr, x86Ptr - thisPtr, startPC);
+	profTable.End(profStats, profCount, x86Ptr - thisPtr, profCycles);
 
 	return thisPtr;
 }
@@ -748,6 +768,7 @@ __fi void* mVUblockFetch(microVU& mVU, u32 startPC, uptr pState) {
 
 // mVUcompileJIT() - Called By JR/JALR during execution
 _mVUt void* __fastcall mVUcompileJIT(u32 startPC, uptr ptr) {
+	microStagingScope staging(mVUx);
 	if (doJumpAsSameProgram) { // Treat jump as part of same microProgram
 		return mVUblockFetch(mVUx, startPC, ptr);
 	}
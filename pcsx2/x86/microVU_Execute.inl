@@ -143,6 +143,8 @@ _mVUt void* __fastcall mVUexecute(u32 startPC, u32 cycles) {
 	mVU.totalCycles = cycles;
 
 	xSetPtr(mVU.prog.x86ptr); // Set x86ptr to where last program left off
+	microStagingScope staging(mVU);
+	mVU.staging.executed = true;
 	return mVUsearchProg<vuIndex>(startPC & vuLimit, (uptr)&mVU.prog.lpState); // Find and set correct program
 }
 
@@ -159,7 +161,9 @@ _mVUt void mVUcleanUp() {
 	mVU.prog.x86ptr = x86Ptr;
 
 	if ((xGetPtr() < mVU.prog.x86start) || (xGetPtr() >= mVU.prog.x86end)) {
-		Console.WriteLn(vuIndex ? Color_Orange : Color_Magenta, "microVU%d: Program cache limit reached.", mVU.index);
+		mVU.cacheResets++;
+		Console.WriteLn(vuIndex ? Color_Orange : Color_Magenta, "microVU%d: Program cache limit reached (%d programs, reset #%u).",
+			mVU.index, mVU.prog.total, mVU.cacheResets);
 		mVUreset(mVU, false);
 	}
 
@@ -225,7 +225,7 @@ typedef u32 (__fastcall *mVUCall)(void*, void*);
 #define isEvilBlock	 (mVUpBlock->pState.blockType == 2)
 #define isBadOrEvil  (mVUlow.badBranch || mVUlow.evilBranch)
 #define xPC			 ((iPC / 2) * 8)
-#define curI		 ((u32*)mVU.regs().Micro)[iPC] //mVUcurProg.data[iPC]
+#define curI		 ((u32*)mVU.getMicro())[iPC] //mVUcurProg.data[iPC]
 #define setCode()	 { mVU.code = curI; }
 #define bSaveAddr	 (((xPC + 16) & (mVU.microMemSize-8)) / 8)
 #define shufflePQ	 (((mVU.p) ? 0xb0 : 0xe0) | ((mVU.q) ? 0x01 : 0x04))
@@ -0,0 +1,281 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <unordered_set>
+#include "AppConfig.h"
+#include "Elfheader.h"
+
+//------------------------------------------------------------------
+// Micro VU - Persistent Program Cache
+//------------------------------------------------------------------
+// Remembers the microPrograms a game ran (per game CRC) and recompiles them as soon as
+// the game creates its first microProgram in the next session, instead of one by one
+// while the game is running.
+//
+// The recompiled x86 code itself can't be stored, it's full of absolute addresses (VU
+// registers, dispatchers, linked blocks, JIT calls).  So what's stored is the input of
+// the recompiler: the recompiled ranges of micro memory and the pipeline states the
+// program was entered with.  Precompiled programs are appended to the program lists and
+// are then matched by mVUsearchProg() with the normal compare of their ranges against
+// mVU.regs().Micro, so stale or foreign entries are simply never used.
+
+static const u32  mVUprogCacheMagic    = 0x4370566d; // "mVpC"
+static const u32  mVUprogCacheVersion  = 1;
+static const uint mVUprogCacheMaxProgs = 2048;       // Max programs kept per game/VU
+
+struct microCachedProg {
+	u32 startPC;                      // Start PC of the program (same units as microProgram::startPC)
+	std::vector<microRange>   ranges; // Recompiled ranges
+	std::vector<u32>          code;   // Contents of the ranges (back to back)
+	std::vector<microRegInfo> states; // Pipeline states the program was entered with at startPC
+	u64 hash;
+};
+
+struct microProgCache {
+	u32  crc;  // Game the programs belong to (0 = none)
+	bool live; // All programs have been precompiled into the current program lists
+	std::vector<microCachedProg> progs;
+};
+
+static microProgCache mVUprogCache[2];
+
+static u64 mVUprogCacheHash(const microCachedProg& p) {
+	u64 hash = 0xcbf29ce484222325ull; // FNV-1a
+	auto add = [&hash](const void* data, size_t size) {
+		for (size_t i = 0; i < size; i++)
+			hash = (hash ^ ((const u8*)data)[i]) * 0x100000001b3ull;
+	};
+	add(&p.startPC, sizeof(p.startPC));
+	add(p.ranges.data(), p.ranges.size() * sizeof(microRange));
+	add(p.code.data(),   p.code.size()   * sizeof(u32));
+	add(p.states.data(), p.states.size() * sizeof(microRegInfo));
+	return hash;
+}
+
+static wxString mVUprogCacheFile(microVU& mVU, u32 crc, bool create = false) {
+	wxDirName dir(GetSettingsFolder() + wxDirName(L"vucache"));
+	if (create) dir.Mkdir();
+	return dir.Combine(wxFileName(wxsFormat(L"%08X_vu%u.bin", crc, mVU.index))).GetFullPath();
+}
+
+// Builds the cache entry of a program, returns false if it has nothing worth caching
+static bool mVUprogCacheEntry(microVU& mVU, microProgram& prog, microCachedProg& p) {
+	microBlockManager* block = prog.block[prog.startPC];
+	if (!block || prog.ranges->empty()) return false;
+
+	p.startPC = prog.startPC;
+	std::deque<microRange>::const_iterator it(prog.ranges->begin());
+	for ( ; it != prog.ranges->end(); ++it) {
+		if ((it[0].start < 0) || (it[0].end < it[0].start) || ((u32)it[0].end + 8 > mVU.microMemSize))
+			return false; // In progress or wrapping range
+		p.ranges.push_back(it[0]);
+		p.code.insert(p.code.end(), &prog.data[it[0].start / 4], &prog.data[(it[0].end + 8) / 4]);
+	}
+	block->forEach([&p](const microBlock& b) { p.states.push_back(b.pState); });
+	p.hash = mVUprogCacheHash(p);
+	return !p.states.empty();
+}
+
+static void mVUprogCacheWrite(microVU& mVU, const microProgCache& cache) {
+	std::vector<u8> buf;
+	auto put = [&buf](const void* data, size_t size) {
+		buf.insert(buf.end(), (const u8*)data, (const u8*)data + size);
+	};
+	const u32 header[6] = { mVUprogCacheMagic, mVUprogCacheVersion, mVU.index, mVU.microMemSize,
+							sizeof(microRegInfo), (u32)cache.progs.size() };
+	put(header, sizeof(header));
+	for (const microCachedProg& p : cache.progs) {
+		const u32 info[4] = { p.startPC, (u32)p.ranges.size(), (u32)p.code.size(), (u32)p.states.size() };
+		put(info, sizeof(info));
+		put(p.ranges.data(), p.ranges.size() * sizeof(microRange));
+		put(p.code.data(),   p.code.size()   * sizeof(u32));
+		put(p.states.data(), p.states.size() * sizeof(microRegInfo));
+	}
+
+	wxFFile file(mVUprogCacheFile(mVU, cache.crc, true), L"wb");
+	if (!file.IsOpened() || file.Write(buf.data(), buf.size()) != buf.size()) {
+		Console.Warning("microVU%d: Unable to write program cache for %08X", mVU.index, cache.crc);
+		return;
+	}
+	DevCon.WriteLn("microVU%d: Saved %d programs to program cache (%dkb)", mVU.index, (int)cache.progs.size(), (int)(buf.size() / _1kb));
+}
+
+// Writes the game's programs (live and not yet precompiled ones) to disk. Called before
+// the program lists are cleared; if reload is set, the programs are precompiled again
+// by the next program search (they aren't when the rec-cache just ran full).
+static void mVUprogCacheSave(microVU& mVU, bool reload) {
+	microProgCache& cache = mVUprogCache[mVU.index];
+	if (!cache.crc) return;
+
+	std::vector<microCachedProg> progs;
+	std::unordered_set<u64> seen;
+	for (u32 pc = 0; pc < mVU.progSize / 2; pc++) {
+		microProgramList* list = mVU.prog.prog[pc];
+		if (!list) continue;
+		std::deque<microProgram*>::iterator it(list->begin());
+		for ( ; it != list->end(); ++it) {
+			microCachedProg p;
+			if (mVUprogCacheEntry(mVU, *it[0], p) && seen.insert(p.hash).second)
+				progs.push_back(std::move(p));
+		}
+	}
+
+	// Only write the file if something was compiled which isn't in it yet
+	bool changed = false;
+	for (const microCachedProg& p : progs) {
+		if (!std::any_of(cache.progs.begin(), cache.progs.end(), [&p](const microCachedProg& c) { return c.hash == p.hash; })) {
+			changed = true;
+			break;
+		}
+	}
+	// Programs which weren't precompiled (and weren't run) this time are kept
+	if (!cache.live) {
+		for (microCachedProg& p : cache.progs) {
+			if (seen.insert(p.hash).second)
+				progs.push_back(std::move(p));
+		}
+	}
+	if (progs.size() > mVUprogCacheMaxProgs) {
+		progs.resize(mVUprogCacheMaxProgs);
+		changed = true;
+	}
+	cache.progs = std::move(progs);
+	cache.live  = false; // Program lists are about to be cleared
+
+	if (changed) mVUprogCacheWrite(mVU, cache);
+	if (reload) {
+		cache.crc = 0;
+		cache.progs.clear();
+	}
+}
+
+static void mVUprogCacheRead(microVU& mVU, microProgCache& cache) {
+	const wxString path(mVUprogCacheFile(mVU, cache.crc));
+	if (!wxFileExists(path)) return;
+
+	std::vector<u8> buf;
+	wxFFile file(path, L"rb");
+	if (file.IsOpened()) {
+		buf.resize((size_t)file.Length());
+		if (file.Read(buf.data(), buf.size()) != buf.size()) buf.clear();
+	}
+
+	size_t pos = 0;
+	auto get = [&buf, &pos](void* data, size_t size) {
+		if (buf.size() - pos < size) return false;
+		memcpy(data, &buf[pos], size);
+		pos += size;
+		return true;
+	};
+
+	u32 header[6];
+	if (!get(header, sizeof(header)) || (header[0] != mVUprogCacheMagic) || (header[1] != mVUprogCacheVersion)
+	 || (header[2] != mVU.index) || (header[3] != mVU.microMemSize) || (header[4] != sizeof(microRegInfo))) {
+		Console.Warning("microVU%d: Ignoring invalid or outdated program cache %s", mVU.index, WX_STR(path));
+		return;
+	}
+
+	for (u32 i = 0; i < header[5] && i < mVUprogCacheMaxProgs; i++) {
+		u32 info[4];
+		if (!get(info, sizeof(info))) break;
+		if ((info[0] >= mVU.progSize / 2) || (info[1] * sizeof(microRange) > buf.size())
+		 || (info[2] > mVU.progSize) || (info[3] * sizeof(microRegInfo) > buf.size())) break;
+
+		microCachedProg p;
+		p.startPC = info[0];
+		p.ranges.resize(info[1]);
+		p.code.resize(info[2]);
+		p.states.resize(info[3]);
+		if (!get(p.ranges.data(), p.ranges.size() * sizeof(microRange))
+		 || !get(p.code.data(),   p.code.size()   * sizeof(u32))
+		 || !get(p.states.data(), p.states.size() * sizeof(microRegInfo))) break;
+
+		// Ranges have to account for exactly the stored code
+		u32 words = 0;
+		bool valid = true;
+		for (const microRange& r : p.ranges) {
+			if ((r.start < 0) || (r.end < r.start) || ((u32)r.end + 8 > mVU.microMemSize)) { valid = false; break; }
+			words += (r.end + 8 - r.start) / 4;
+		}
+		if (!valid || (words != p.code.size())) break;
+
+		p.hash = mVUprogCacheHash(p);
+		cache.progs.push_back(std::move(p));
+	}
+}
+
+// Recompiles the cached programs. Micro memory and the current program state are
+// borrowed for the recompilation and restored afterwards.
+static void mVUprogCachePrecompile(microVU& mVU, microProgCache& cache) {
+	std::vector<u8> micro(mVU.regs().Micro, mVU.regs().Micro + mVU.microMemSize);
+	microRegInfo  lpState = mVU.prog.lpState;
+	microProgram* cur     = mVU.prog.cur;
+	int isSame            = mVU.prog.isSame;
+	int cleared           = mVU.prog.cleared;
+
+	// Leave half the cache for the programs which aren't cached, filling the whole
+	// cache would just make the game reset it again
+	u8* limit = mVU.prog.x86start + (mVU.prog.x86end - mVU.prog.x86start) / 2;
+	u32 count = 0;
+	for ( ; (count < cache.progs.size()) && (x86Ptr < limit); count++) {
+		const microCachedProg& p = cache.progs[count];
+		const u32* code = p.code.data();
+		memset(mVU.regs().Micro, 0, mVU.microMemSize);
+		for (const microRange& r : p.ranges) {
+			u32 words = (r.end + 8 - r.start) / 4;
+			memcpy(mVU.regs().Micro + r.start, code, words * 4);
+			code += words;
+		}
+
+		mVU.prog.cur    = mVUcreateProg(mVU, p.startPC);
+		mVU.prog.isSame = 1;
+		for (const microRegInfo& state : p.states) {
+			microRegInfo pState = state;
+			mVUblockFetch(mVU, p.startPC * 8, (uptr)&pState);
+		}
+		mVU.prog.prog[p.startPC]->push_back(mVU.prog.cur); // Behind the programs of this session
+	}
+
+	memcpy(mVU.regs().Micro, micro.data(), mVU.microMemSize);
+	mVU.prog.microHashValid = 0;
+	mVU.prog.lpState = lpState;
+	mVU.prog.cur     = cur;
+	mVU.prog.isSame  = isSame;
+	mVU.prog.cleared = cleared;
+	cache.live = (count == cache.progs.size());
+
+	Console.WriteLn(Color_StrongGreen, "microVU%d: Precompiled %d/%d cached programs [%3.1fmb]", mVU.index,
+					count, (int)cache.progs.size(), (double)(x86Ptr - mVU.prog.x86start) / _1mb);
+}
+
+// Loads and precompiles the cached programs of the running game. Called by mVUsearchProg()
+// when it's looking for a program, so it has to be cheap when there's nothing to do.
+__fi void mVUprogCacheLoad(microVU& mVU) {
+	microProgCache& cache = mVUprogCache[mVU.index];
+	if (!CHECK_VU_PROGCACHE || !ElfCRC || (ElfCRC == cache.crc)) return;
+
+	if (cache.crc) mVUprogCacheSave(mVU, false); // Game changed without a reset
+	cache.crc  = ElfCRC;
+	cache.live = false;
+	cache.progs.clear();
+
+	// These gamefixes match programs by more than their recompiled ranges
+	if (EmuConfig.Gamefixes.ScarfaceIbit || EmuConfig.Gamefixes.CrashTagTeamRacingIbit) return;
+
+	mVUprogCacheRead(mVU, cache);
+	if (!cache.progs.empty()) mVUprogCachePrecompile(mVU, cache);
+}
@@ -0,0 +1,261 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+//------------------------------------------------------------------
+// Micro VU - Background Compiler
+//------------------------------------------------------------------
+// With MTVU, a game's VIF MPG transfers reach the VU thread some time before the program
+// they upload is started, while the VU thread then has to compile the program before it
+// can run it.  When a MPG transfer completes, the program is predicted to start where the
+// transfer (the run of contiguous micro memory writes) started, and a worker thread compiles
+// it from a snapshot of micro memory into a staging area at the end of the rec-cache.
+//
+// Staged programs aren't in the program lists, mVUsearchProg() picks one up when none of the
+// listed programs match micro memory, with the normal compare of its ranges.  So a wrong
+// prediction just wastes some staging space.
+//
+// The worker compiles with the same microVU state as the VU thread (IR, regAlloc, ...), so
+// program searches and compiles on the VU thread hold mVU.staging.lock while it's running.
+// The worker compiles from the snapshot (mVU.microSrc), into its own x86 pointer (x86Ptr is
+// thread local) and leaves the VU thread's current program and pipeline state alone: early
+// exits of staged blocks save the pipeline state the worker copied from the block's entry
+// state (mVU.staging.lpState), the VU thread's lpState is never read or written by it.
+
+static const uint mVUstagingCacheSize = 8; // Part of the rec-cache reserved for staged programs (in megabytes)
+static const uint mVUstagingMaxProgs  = 8; // Staged programs waiting to be picked up
+
+// Held by the VU thread around program searches and compiles while the worker is running,
+// also counts the compile stalls which are left on the VU thread.
+class microStagingScope {
+	microVU& mVU;
+	u8*  ptr;
+	u64  start;
+	bool locked;
+
+public:
+	microStagingScope(microVU& _mVU) : mVU(_mVU), ptr(NULL), start(0), locked(false) {
+		if (!mVU.staging.active) return;
+		start = GetCPUTicks();
+		if (!mVU.staging.lock.try_lock()) {
+			mVU.staging.lock.lock();
+			const u64 now = GetCPUTicks();
+			mVU.staging.stats.waits++;
+			mVU.staging.stats.waitTicks += now - start;
+			start = now;
+		}
+		locked = true;
+		ptr    = x86Ptr;
+	}
+
+	~microStagingScope() {
+		if (!locked) return;
+		if (x86Ptr != ptr) { // Something was compiled
+			mVU.staging.stats.syncCompiles++;
+			mVU.staging.stats.syncTicks += GetCPUTicks() - start;
+		}
+		mVU.staging.lock.unlock();
+	}
+};
+
+// Compares the compiled ranges of a program against a micro memory snapshot
+static bool mVUstagingCmp(microVU& mVU, const microProgram& prog, const u8* micro) {
+	std::deque<microRange>::const_iterator it(prog.ranges->begin());
+	for ( ; it != prog.ranges->end(); ++it) {
+		if ((it[0].start < 0) || (it[0].end < it[0].start)) return false;
+		if (memcmp_mmx(cmpOffset(prog.data), cmpOffset(micro), ((it[0].end + 8) - it[0].start)))
+			return false;
+	}
+	return true;
+}
+
+// Compiles the program predicted to start at startPC into the staging area.
+// Called by the worker with mVU.staging.lock held.
+static void mVUstagingCompile(microVU& mVU, u32 startPC, u8* micro) {
+	microStaging& st = mVU.staging;
+	if (st.x86ptr >= st.x86end) { // Full until the next reset
+		st.stats.skipped++;
+		return;
+	}
+
+	// Nothing to do if mVUsearchProg() would find the program already
+	microProgramList* list = mVU.prog.prog[startPC/8];
+	std::deque<microProgram*>::const_iterator it(list->begin());
+	for ( ; it != list->end(); ++it) {
+		if (mVUstagingCmp(mVU, *it[0], micro)) { st.stats.skipped++; return; }
+	}
+	for (const microStagedProg& staged : st.progs) {
+		if ((staged.prog->startPC == startPC/8) && mVUstagingCmp(mVU, *staged.prog, micro)) { st.stats.skipped++; return; }
+	}
+
+	microProgram* cur = mVU.prog.cur;
+	int isSame        = mVU.prog.isSame;
+	microRegInfo pState;
+	memzero(pState); // mVUclear() zeroes the pipeline state the program gets started with
+
+	const u64 start = GetCPUTicks();
+	mVU.microSrc    = micro;
+	st.compiling    = true;
+	memzero(st.lpState);
+	xSetPtr(st.x86ptr);
+	microProgram* prog = mVUcreateProg(mVU, startPC/8);
+	mVU.prog.cur    = prog;
+	mVU.prog.isSame = 1;
+	mVUblockFetch(mVU, startPC, (uptr)&pState);
+	pxAssert(x86Ptr >= st.x86start && x86Ptr < st.x86end + mVUcacheSafeZone * _1mb);
+	st.x86ptr       = x86Ptr;
+	st.compiling    = false;
+	mVU.microSrc    = NULL;
+	mVU.prog.cur    = cur;
+	mVU.prog.isSame = isSame;
+
+	microStagedProg staged = { prog, GetCPUTicks() - start };
+	st.stats.staged++;
+	st.stats.stagedTicks += staged.ticks;
+	if (st.progs.size() >= mVUstagingMaxProgs) { // Oldest prediction was wrong
+		mVUdeleteProg(mVU, st.progs.front().prog);
+		st.progs.pop_front();
+	}
+	st.progs.push_back(staged);
+}
+
+static void mVUstagingLoop(microVU& mVU) {
+	microStaging& st = mVU.staging;
+	std::vector<u8> micro(mVU.microMemSize);
+	std::unique_lock<std::mutex> req(st.reqLock);
+
+	while (true) {
+		st.reqWake.wait(req, [&st] { return st.quit || st.pending; });
+		if (st.quit) break;
+
+		// Only the latest prediction is compiled, it supersedes the ones still waiting
+		const u32 startPC = st.reqPC;
+		micro.swap(st.reqMicro);
+		st.pending = false;
+		req.unlock();
+		{
+			std::lock_guard<std::mutex> guard(st.lock);
+			mVUstagingCompile(mVU, startPC, micro.data());
+		}
+		req.lock();
+	}
+}
+
+static void mVUstagingWorker(microVU* mVU) {
+	PCSX2_PAGEFAULT_PROTECT {
+		mVUstagingLoop(*mVU);
+	} PCSX2_PAGEFAULT_EXCEPT;
+}
+
+// Hands a staged program which matches micro memory over to mVUsearchProg()
+// (startPC in microProgram::startPC units, mVU.staging.lock held)
+static microProgram* mVUstagingAdopt(microVU& mVU, u32 startPC) {
+	microStaging& st = mVU.staging;
+	std::deque<microStagedProg>::iterator it(st.progs.begin());
+	for ( ; it != st.progs.end(); ++it) {
+		if ((it->prog->startPC != startPC) || !mVUcmpPartial(mVU, *it->prog)) continue;
+		microProgram* prog = it->prog;
+		st.stats.adopted++;
+		st.stats.adoptedTicks += it->ticks;
+		st.progs.erase(it);
+		return prog;
+	}
+	return NULL;
+}
+
+// Keeps track of where the current upload started, called for every write to micro memory
+static __fi void mVUstagingClear(microVU& mVU, u32 addr, u32 size) {
+	microStaging& st = mVU.staging;
+	if (!st.active) return;
+	if (st.executed || (addr != st.runEnd)) st.runStart = addr;
+	st.runEnd   = addr + size;
+	st.executed = false;
+}
+
+// Queues the program uploaded by a MPG transfer for the worker (VU thread)
+void mVUstagingUpload(microVU& mVU) {
+	microStaging& st = mVU.staging;
+	if (!st.active) return;
+	{
+		std::lock_guard<std::mutex> guard(st.reqLock);
+		st.reqPC   = st.runStart & (mVU.microMemSize - 8);
+		st.pending = true;
+		memcpy(st.reqMicro.data(), mVU.regs().Micro, mVU.microMemSize);
+	}
+	st.stats.requests++;
+	st.reqWake.notify_one();
+}
+
+void mVUstagingPrintStats(microVU& mVU) {
+	const microStagingStats& s = mVU.staging.stats;
+	if (!EmuConfig.Profiler.Enabled || !s.requests) return;
+	const double ms = 1000.0 / GetTickFrequency();
+	Console.WriteLn(Color_StrongBlue, "microVU%d: %llu predicted programs, %llu staged (%.1f ms), %llu picked up, "
+					"removed %.1f ms of VU thread compile stalls (waited %.1f ms for the worker %llu times, "
+					"compiled for %.1f ms %llu times)",
+					mVU.index, (unsigned long long)s.requests, (unsigned long long)s.staged, s.stagedTicks * ms,
+					(unsigned long long)s.adopted, s.adoptedTicks * ms, s.waitTicks * ms, (unsigned long long)s.waits,
+					s.syncTicks * ms, (unsigned long long)s.syncCompiles);
+}
+
+// Stops the worker and drops the staged programs (program lists are about to be cleared)
+void mVUstagingStop(microVU& mVU) {
+	microStaging& st = mVU.staging;
+	if (!st.active) return;
+	{
+		std::lock_guard<std::mutex> guard(st.reqLock);
+		st.quit = true;
+	}
+	st.reqWake.notify_one();
+	st.worker.join();
+	st.active = false;
+
+	for (const microStagedProg& staged : st.progs) {
+		microProgram* prog = staged.prog;
+		mVUdeleteProg(mVU, prog);
+	}
+	st.progs.clear();
+	mVUstagingPrintStats(mVU);
+	memzero(st.stats);
+}
+
+// Sets up the staging area and starts the worker if enabled. Called by mVUreset() once
+// the rec-cache limits are set up.
+void mVUstagingReset(microVU& mVU) {
+	microStaging& st = mVU.staging;
+	pxAssert(!st.active);
+
+	// The I-bit gamefixes make the recompiled code read micro memory, and match programs
+	// by more than their ranges
+	if (!mVU.index || !THREAD_VU1 || !CHECK_VU_BGCOMPILE || !x86EMIT_MULTITHREADED
+	 || (mVU.cacheSize < mVUstagingCacheSize * 2)
+	 || EmuConfig.Gamefixes.ScarfaceIbit || EmuConfig.Gamefixes.CrashTagTeamRacingIbit) return;
+
+	st.x86start = mVU.cache + (mVU.cacheSize - mVUstagingCacheSize) * _1mb;
+	st.x86ptr   = st.x86start;
+	st.x86end   = st.x86start + (mVUstagingCacheSize - mVUcacheSafeZone) * _1mb;
+	mVU.prog.x86end -= mVUstagingCacheSize * _1mb;
+
+	st.reqMicro.resize(mVU.microMemSize);
+	st.quit      = false;
+	st.pending   = false;
+	st.compiling = false;
+	st.executed  = true;
+	st.runStart  = 0;
+	st.runEnd    = 0;
+	st.active    = true;
+	st.worker    = std::thread(mVUstagingWorker, &mVU);
+}
@@ -28,6 +28,7 @@
 #include "Renderers/OpenGL/GSDeviceOGL.h"
 #include "Renderers/OpenGL/GSRendererOGL.h"
 #include "GSLzma.h"
+#include "GSKernels.h"
 
 #ifdef _WIN32
 
@@ -146,7 +147,13 @@ EXPORT_C_(int) GSinit()
 #if _M_SSE >= 0x501
 	GSVector8i::InitVectors();
 #endif
-	GSVertexTrace::InitVectors();
+
+	if(!GSKernels::Init(static_cast<GSKernelISA>(theApp.GetConfigI("kernel_isa"))))
+	{
+		fprintf(stderr, "GSdx: This CPU does not support the requested kernels\n");
+	}
+
+	printf("GSdx: Using %s kernels\n", g_kernels.name);
 
 	if (g_const == nullptr)
 		return -1;
@@ -1111,6 +1118,12 @@ EXPORT_C GSReplay(HWND hwnd, HINSTANCE hinst, LPSTR lpszCmdLine, int nCmdShow)
 			p.buff.resize(0x2000);
 			file->Read(p.buff.data(), 0x2000);
 			break;
+		case 4:
+			file->Read(&p.addr, 4);
+			file->Read(&p.size, 4);
+			p.buff.resize(p.size + 0x2000);
+			file->Read(p.buff.data(), p.buff.size());
+			break;
 		}
 
 		return p;
@@ -1373,6 +1386,126 @@ inline unsigned long timeGetTime()
 	return (unsigned long)(t.tv_sec*1000 + t.tv_nsec/1000000);
 }
 
+struct GSReplayPacket {uint8 type, param; uint32 size, addr; std::vector<uint8> buff;};
+
+// Reads the packets following the header of a dump, stopping after max_frames vsyncs
+// when max_frames >= 0.  Returns the number of vsyncs read.
+static long ReadReplayPackets(GSDumpFile* file, std::list<GSReplayPacket*>& packets, long max_frames)
+{
+	long frame_number = 0;
+
+	uint8 type;
+	while(file->Read(&type, 1))
+	{
+		GSReplayPacket* p = new GSReplayPacket();
+
+		p->type = type;
+
+		switch(type)
+		{
+		case 0:
+			file->Read(&p->param, 1);
+			file->Read(&p->size, 4);
+
+			switch(p->param)
+			{
+			case 0:
+				p->buff.resize(0x4000);
+				p->addr = 0x4000 - p->size;
+				file->Read(&p->buff[p->addr], p->size);
+				break;
+			case 1:
+			case 2:
+			case 3:
+				p->buff.resize(p->size);
+				file->Read(&p->buff[0], p->size);
+				break;
+			}
+
+			break;
+
+		case 1:
+			file->Read(&p->param, 1);
+			frame_number++;
+
+			break;
+
+		case 2:
+			file->Read(&p->size, 4);
+
+			break;
+
+		case 3:
+			p->buff.resize(0x2000);
+
+			file->Read(&p->buff[0], 0x2000);
+
+			break;
+
+		case 4:
+			file->Read(&p->addr, 4);
+			file->Read(&p->size, 4);
+			p->buff.resize(p->size + 0x2000);
+
+			file->Read(&p->buff[0], p->size + 0x2000);
+
+			break;
+		}
+
+		packets.push_back(p);
+
+		if (max_frames >= 0 && frame_number > max_frames)
+			break;
+	}
+
+	return frame_number;
+}
+
+// Sends a packet read by ReadReplayPackets() to the GS.  regs is the GS register memory.
+static void ReplayPacket(GSReplayPacket* p, uint8* regs, std::vector<uint8>& buff)
+{
+	switch(p->type)
+	{
+		case 0:
+
+			switch(p->param)
+			{
+				case 0: GSgifTransfer1(&p->buff[0], p->addr); break;
+				case 1: GSgifTransfer2(&p->buff[0], p->size / 16); break;
+				case 2: GSgifTransfer3(&p->buff[0], p->size / 16); break;
+				case 3: GSgifTransfer(&p->buff[0], p->size / 16); break;
+			}
+
+			break;
+
+		case 1:
+
+			GSvsync(p->param);
+
+			break;
+
+		case 2:
+
+			if(buff.size() < p->size) buff.resize(p->size);
+
+			GSreadFIFO2(&buff[0], p->size / 16);
+
+			break;
+
+		case 3:
+
+			memcpy(regs, &p->buff[0], 0x2000);
+
+			break;
+
+		case 4:
+
+			// State data, what the GS already is in when replaying from the start
+
+			break;
+	}
+}
+
 // Note
 EXPORT_C GSReplay(char* lpszCmdLine, int renderer)
 {
@@ -1392,9 +1525,7 @@ EXPORT_C GSReplay(char* lpszCmdLine, int renderer)
 		return;
 	}
 
-	struct Packet {uint8 type, param; uint32 size, addr; std::vector<uint8> buff;};
-
-	std::list<Packet*> packets;
+	std::list<GSReplayPacket*> packets;
 	std::vector<uint8> buff;
 	uint8 regs[0x2000];
 
@@ -1445,60 +1576,7 @@ EXPORT_C GSReplay(char* lpszCmdLine, int renderer)
 
 		file->Read(regs, 0x2000);
 
-		uint8 type;
-		while(file->Read(&type, 1))
-		{
-			Packet* p = new Packet();
-
-			p->type = type;
-
-			switch(type)
-			{
-			case 0:
-				file->Read(&p->param, 1);
-				file->Read(&p->size, 4);
-
-				switch(p->param)
-				{
-				case 0:
-					p->buff.resize(0x4000);
-					p->addr = 0x4000 - p->size;
-					file->Read(&p->buff[p->addr], p->size);
-					break;
-				case 1:
-				case 2:
-				case 3:
-					p->buff.resize(p->size);
-					file->Read(&p->buff[0], p->size);
-					break;
-				}
-
-				break;
-
-			case 1:
-				file->Read(&p->param, 1);
-				frame_number++;
-
-				break;
-
-			case 2:
-				file->Read(&p->size, 4);
-
-				break;
-
-			case 3:
-				p->buff.resize(0x2000);
-
-				file->Read(&p->buff[0], 0x2000);
-
-				break;
-			}
-
-			packets.push_back(p);
-
-			if (repack_dump && frame_number > -finished)
-				break;
-		}
+		ReadReplayPackets(file, packets, repack_dump ? -finished : -1);
 
 		delete file;
 	}
@@ -1515,43 +1593,12 @@ EXPORT_C GSReplay(char* lpszCmdLine, int renderer)
 	{
 		for(auto i = packets.begin(); i != packets.end(); i++)
 		{
-			Packet* p = *i;
-
-			switch(p->type)
-			{
-				case 0:
-
-					switch(p->param)
-					{
-						case 0: GSgifTransfer1(&p->buff[0], p->addr); break;
-						case 1: GSgifTransfer2(&p->buff[0], p->size / 16); break;
-						case 2: GSgifTransfer3(&p->buff[0], p->size / 16); break;
-						case 3: GSgifTransfer(&p->buff[0], p->size / 16); break;
-					}
-
-					break;
+			GSReplayPacket* p = *i;
 
-				case 1:
-
-					GSvsync(p->param);
-					frame_number++;
-
-					break;
-
-				case 2:
-
-					if(buff.size() < p->size) buff.resize(p->size);
-
-					GSreadFIFO2(&buff[0], p->size / 16);
-
-					break;
+			ReplayPacket(p, regs, buff);
 
-				case 3:
-
-					memcpy(regs, &p->buff[0], 0x2000);
-
-					break;
-			}
+			if(p->type == 1)
+				frame_number++;
 		}
 
 		if (finished >= 200) {
@@ -1586,4 +1633,349 @@ EXPORT_C GSReplay(char* lpszCmdLine, int renderer)
 	GSclose();
 	GSshutdown();
 }
+
+// Window of the headless benchmark, nothing ever gets shown or presented
+class GSWndHeadless final : public GSWnd
+{
+public:
+	bool Create(const std::string& title, int w, int h) final {return true;}
+	bool Attach(void* handle, bool managed = true) final {return true;}
+	void Detach() final {}
+
+	void* GetDisplay() final {return NULL;}
+	void* GetHandle() final {return NULL;}
+	GSVector4i GetClientRect() final {return GSVector4i(0, 0, 640, 480);}
+	bool SetWindowText(const char* title) final {return true;}
+
+	void Show() final {}
+	void Hide() final {}
+	void HideFrame() final {}
+};
+
+// Nearest-rank percentile of sorted values
+static double Percentile(const std::vector<double>& sorted, double p)
+{
+	size_t rank = (size_t)ceil(p * sorted.size());
+	return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+// Replays a dump runs times without any window nor GPU, on the SW renderer (OGL_SW, drawing
+// with a null device) or the Null renderer, and writes the frame times and GSPerfMon counters
+// to out as a JSON object.  Every run starts again from the state saved in the dump.
+// threads is the SW renderer's extra thread count, -1 for the configured one.  Only the
+// frames from start on are timed, the replay begins at the last chunk of the dump starting
+// before it when it has chunks (GSDumpFile::Seek), at the start of the dump otherwise.
+// Used by the replay loader's --bench mode, returns 0 on success.
+EXPORT_C_(int) GSReplayBenchmark(char* dump, int renderer, int threads, int start, int runs, FILE* out)
+{
+	GSRendererType type = static_cast<GSRendererType>(renderer);
+
+	if (type != GSRendererType::OGL_SW && type != GSRendererType::Null)
+	{
+		fprintf(stderr, "GSReplayBenchmark: unsupported renderer %d\n", renderer);
+		return -1;
+	}
+
+	if (threads == -1)
+		threads = theApp.GetConfigI("extrathreads");
+
+	std::list<GSReplayPacket*> packets;
+	std::vector<uint8> buff;
+	std::vector<uint8> state;
+	uint8 regs[0x2000];
+	uint8 dump_regs[0x2000];
+	uint32 crc = 0;
+	long frames = 0;
+	long first = 0;
+
+	try
+	{
+		std::string f(dump);
+		bool is_xz = (f.size() >= 4) && (f.compare(f.size()-3, 3, ".xz") == 0);
+
+		std::unique_ptr<GSDumpFile> file(is_xz
+			? (GSDumpFile*) new GSDumpLzma(dump, nullptr)
+			: (GSDumpFile*) new GSDumpRaw(dump, nullptr));
+
+		uint32 size = 0;
+		file->Read(&crc, 4);
+		file->Read(&size, 4);
+		state.resize(size);
+		file->Read(state.data(), size);
+		file->Read(dump_regs, 0x2000);
+
+		if (start > 0 && file->Seek(start))
+		{
+			uint8 type;
+			uint32 frame = 0;
+			file->Read(&type, 1);
+			file->Read(&frame, 4);
+			file->Read(&size, 4);
+			state.resize(size);
+			file->Read(state.data(), size);
+			file->Read(dump_regs, 0x2000);
+
+			first = frame;
+		}
+
+		frames = first + ReadReplayPackets(file.get(), packets, -1);
+	}
+	catch (const char*)
+	{
+		fprintf(stderr, "GSReplayBenchmark: failed to read %s\n", dump);
+		for (GSReplayPacket* p : packets) delete p;
+		return -1;
+	}
+
+	GSinit();
+	GSsetBaseMem(regs);
+
+	theApp.SetCurrentRendererType(type);
+
+	if (type == GSRendererType::OGL_SW)
+		s_gs = new GSRendererSW(threads);
+	else
+		s_gs = new GSRendererNull();
+
+	s_gs->m_wnd = std::make_shared<GSWndHeadless>();
+	s_gs->SetRegsMem(s_basemem);
+	s_gs->SetIrqCallback(s_irq);
+	s_gs->SetVSync(0);
+
+	GSDevice* dev = new GSDeviceNull();
+
+	if (!s_gs->CreateDevice(dev))
+	{
+		fprintf(stderr, "GSReplayBenchmark: failed to create the null device\n");
+		delete dev;
+		GSshutdown();
+		for (GSReplayPacket* p : packets) delete p;
+		return -1;
+	}
+
+	std::vector<double> frame_ms;
+	std::vector<double> run_ms;
+
+	// Packets before the first timed frame
+	auto timed = packets.begin();
+	for (long frame = first; timed != packets.end() && frame < start; ++timed)
+	{
+		if ((*timed)->type == 1)
+			frame++;
+	}
+
+	frames -= std::min<long>(std::max<long>(start, first), frames);
+
+	GSPerfMon& pm = s_gs->m_perfmon;
+
+	// Counted while replaying the packets before the first timed frame
+	double untimed[GSPerfMon::CounterLast] = {};
+
+	auto total = [&](GSPerfMon::counter_t c) {return pm.GetTotal(c) - untimed[c];};
+
+	frame_ms.reserve(frames * runs);
+	pm.ResetTotals();
+
+	for (int run = 0; run < runs; run++)
+	{
+		GSsetGameCRC(crc, 0);
+
+		GSFreezeData fd = {(int)state.size(), state.data()};
+		GSfreeze(FREEZE_LOAD, &fd);
+		memcpy(regs, dump_regs, sizeof(regs));
+
+		GSvsync(1);
+
+		for (int c = 0; c < GSPerfMon::CounterLast; c++)
+			untimed[c] -= pm.GetTotal((GSPerfMon::counter_t)c);
+
+		for (auto i = packets.begin(); i != timed; ++i)
+			ReplayPacket(*i, regs, buff);
+
+		for (int c = 0; c < GSPerfMon::CounterLast; c++)
+			untimed[c] += pm.GetTotal((GSPerfMon::counter_t)c);
+
+		auto run_start = std::chrono::steady_clock::now();
+		auto frame_start = run_start;
+
+		for (auto i = timed; i != packets.end(); ++i)
+		{
+			GSReplayPacket* p = *i;
+
+			ReplayPacket(p, regs, buff);
+
+			if (p->type == 1)
+			{
+				auto now = std::chrono::steady_clock::now();
+				frame_ms.push_back(std::chrono::duration<double, std::milli>(now - frame_start).count());
+				frame_start = now;
+			}
+		}
+
+		run_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - run_start).count());
+	}
+
+	std::vector<double> sorted(frame_ms);
+	std::sort(sorted.begin(), sorted.end());
+
+	double mean = 0;
+	for (double ms : frame_ms) mean += ms;
+
+	const double n = std::max<double>(frame_ms.size(), 1);
+
+	fprintf(out, "{\"renderer\": \"%s\", \"threads\": %d, \"runs\": %d, \"start\": %d, \"frames\": %ld, ",
+		type == GSRendererType::OGL_SW ? "sw" : "null", type == GSRendererType::OGL_SW ? threads : 0, runs, std::max(start, 0), frames);
+
+	if (sorted.empty())
+		fprintf(out, "\"frame_ms\": null, ");
+	else
+		fprintf(out, "\"frame_ms\": {\"mean\": %.4f, \"p50\": %.4f, \"p99\": %.4f, \"max\": %.4f}, ",
+			mean / n, Percentile(sorted, 0.5), Percentile(sorted, 0.99), sorted.back());
+
+	fprintf(out, "\"run_ms\": [");
+	for (size_t i = 0; i < run_ms.size(); i++)
+		fprintf(out, "%s%.3f", i ? ", " : "", run_ms[i]);
+	fprintf(out, "], ");
+
+	// Share of the replay time each SW worker spent drawing
+	fprintf(out, "\"worker_busy_pct\": [");
+	for (int i = 0; type == GSRendererType::OGL_SW && i < std::min<int>(std::max(threads, 1), GSPerfMon::WorkerLast); i++)
+		fprintf(out, "%s%d", i ? ", " : "", s_gs->m_perfmon.CPU(GSPerfMon::WorkerDraw0 + i));
+	fprintf(out, "], ");
+
+	fprintf(out, "\"draw_calls\": %.0f, \"perfmon_per_frame\": {\"draw\": %.2f, \"prim\": %.2f, "
+		"\"swizzle_kb\": %.2f, \"unswizzle_kb\": %.2f, \"fillrate_pixels\": %.0f, \"sync_points\": %.2f, "
+		"\"gs_thread_cpu_ms\": %.4f, \"tile_jobs\": %.2f, \"tile_steals\": %.2f}}\n",
+		total(GSPerfMon::Draw) / std::max(runs, 1),
+		total(GSPerfMon::Draw) / n,
+		total(GSPerfMon::Prim) / n,
+		total(GSPerfMon::Swizzle) / 1024 / n,
+		total(GSPerfMon::Unswizzle) / 1024 / n,
+		total(GSPerfMon::Fillrate) / n,
+		total(GSPerfMon::SyncPoint) / n,
+		total(GSPerfMon::Frame) / n,
+		total(GSPerfMon::TileJob) / n,
+		total(GSPerfMon::TileSteal) / n);
+
+	for (GSReplayPacket* p : packets) delete p;
+
+	GSclose();
+	GSshutdown();
+
+	return 0;
+}
+
+// Swizzles and unswizzles a 1024x512 image in the 32/24/16/8/4 bit formats runs times, on the
+// calling thread alone and split in bands of block rows between it and threads SW workers like
+// the SW renderer does with large transfers, and writes the rates (megapixels per second) to
+// out as a JSON object. threads is -1 for the configured count.
+// Used by the replay loader's --swizzle-bench mode, returns 0 on success.
+EXPORT_C_(int) GSSwizzleBenchmark(int threads, int runs, FILE* out)
+{
+	static const struct {int psm; const char* name;} s_format[] =
+	{
+		{PSM_PSMCT32, "32"},
+		{PSM_PSMCT24, "24"},
+		{PSM_PSMCT16, "16"},
+		{PSM_PSMT8, "8"},
+		{PSM_PSMT4, "4"},
+	};
+
+	const int w = 1024;
+	const int h = 512;
+
+	if (GSinit() != 0)
+		return -1;
+
+	if (threads == -1)
+		threads = theApp.GetConfigI("extrathreads");
+
+	runs = std::max(runs, 1);
+
+	GSPerfMon perfmon;
+	std::unique_ptr<IRasterizer> rl(GSRasterizerList::Create<GSDrawScanline>(threads, &perfmon));
+	std::unique_ptr<GSLocalMemory> mem(new GSLocalMemory());
+
+	uint8* src = (uint8*)_aligned_malloc(w * h * 4, 32);
+	uint8* dst = (uint8*)_aligned_malloc(w * h * 4, 32);
+
+	for (int i = 0; i < w * h * 4; i++) src[i] = (uint8)(i * 7 + (i >> 12));
+
+	const int count = rl->GetThreads() * 2;
+
+	// Megapixels per second of f over runs calls
+	auto rate = [&](const std::function<void()>& f) -> double {
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < runs; i++)
+			f();
+		double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+		return (double)w * h * runs / std::max(us, 1.0);
+	};
+
+	fprintf(out, "{\"threads\": %d, \"runs\": %d, \"width\": %d, \"height\": %d, \"formats\": [\n",
+		rl->GetThreads(), runs, w, h);
+
+	for (size_t i = 0; i < countof(s_format); i++)
+	{
+		const GSLocalMemory::psm_t& psm = GSLocalMemory::m_psm[s_format[i].psm];
+
+		GIFRegBITBLTBUF BITBLTBUF = {};
+		BITBLTBUF.DBW = w / 64;
+		BITBLTBUF.DPSM = s_format[i].psm;
+
+		GIFRegTRXPOS TRXPOS = {};
+
+		GIFRegTRXREG TRXREG = {};
+		TRXREG.RRW = w;
+		TRXREG.RRH = h;
+
+		GIFRegTEXA TEXA = {};
+		TEXA.TA1 = 0x80;
+
+		const int len = w * h * psm.trbpp >> 3;
+		const GSOffset* off = mem->GetOffset(0, w / 64, s_format[i].psm);
+		const GSVector4i r(0, 0, w, h);
+
+		ASSERT(mem->CanWriteImageBands(len, BITBLTBUF, TRXPOS, TRXREG));
+
+		double swizzle = rate([&]() {
+			int x = 0, y = 0;
+			(mem.get()->*psm.wi)(x, y, src, len, BITBLTBUF, TRXPOS, TRXREG);
+		});
+
+		double swizzle_bands = rate([&]() {
+			rl->Run(count, [&](int band) {mem->WriteImageBand(band, count, src, BITBLTBUF, TRXPOS, TRXREG);});
+		});
+
+		double unswizzle = rate([&]() {
+			(mem.get()->*psm.rtx)(off, r, dst, w * 4, TEXA);
+		});
+
+		// The texture cache reads lists of blocks, rows of them are close enough
+		double unswizzle_bands = rate([&]() {
+			rl->Run(count, [&](int band) {
+				int bh = ((h / psm.bs.y + count - 1) / count) * psm.bs.y;
+				GSVector4i rb(0, std::min(bh * band, h), w, std::min(bh * (band + 1), h));
+				if (!rb.rempty())
+					(mem.get()->*psm.rtx)(off, rb, dst + rb.top * w * 4, w * 4, TEXA);
+			});
+		});
+
+		fprintf(out, "  {\"psm\": \"%s\", \"swizzle_mpix_s\": {\"serial\": %.1f, \"bands\": %.1f}, "
+			"\"unswizzle_mpix_s\": {\"serial\": %.1f, \"bands\": %.1f}}%s\n",
+			s_format[i].name, swizzle, swizzle_bands, unswizzle, unswizzle_bands, i + 1 < countof(s_format) ? "," : "");
+	}
+
+	fprintf(out, "]}\n");
+
+	_aligned_free(src);
+	_aligned_free(dst);
+
+	rl.reset();
+	mem.reset();
+
+	GSshutdown();
+
+	return 0;
+}
 #endif
@@ -84,8 +84,8 @@ enum GIF_REG
 
 enum GIF_REG_COMPLEX
 {
-	GIF_REG_STQRGBAXYZF2	= 0x00,
-	GIF_REG_STQRGBAXYZ2		= 0x01,
+	GIF_REG_VERTEX_XYZF2	= 0x00,
+	GIF_REG_VERTEX_XYZ2		= 0x01,
 };
 
 enum GIF_A_D_REG
@@ -1120,7 +1120,75 @@ struct alignas(32) GIFPath
 	uint32 type;
 	GSVector4i regs;
 
-	enum {TYPE_UNKNOWN, TYPE_ADONLY, TYPE_STQRGBAXYZF2, TYPE_STQRGBAXYZ2};
+	enum {TYPE_UNKNOWN, TYPE_ADONLY, TYPE_VERTEX_XYZF2, TYPE_VERTEX_XYZ2};
+
+	enum {VERTEX_NONE = 0xff};
+
+	// Where STQ, RGBA, UV and XYZF2/XYZ2 are in the loop of a PACKED tag that only sends vertices,
+	// VERTEX_NONE when it doesn't have one. Kept for the regs/nreg of the last tag, most tags in
+	// a row are the same.
+
+	struct
+	{
+		GSVector4i regs;
+		uint32 nreg;
+		uint32 type;
+		uint32 period; // registers of one vertex, nreg can be a few of them (ffx: 9, dq8: 12)
+		uint8 stq, rgba, uv, xyz;
+	} vertex;
+
+	void UpdateVertexLayout()
+	{
+		vertex.regs = regs;
+		vertex.nreg = nreg;
+		vertex.type = TYPE_UNKNOWN;
+		vertex.period = nreg;
+		vertex.stq = vertex.rgba = vertex.uv = vertex.xyz = VERTEX_NONE;
+
+		uint32 period = 1;
+
+		for(; period < nreg; period++)
+		{
+			if(nreg % period != 0) continue;
+
+			uint32 i = period;
+
+			while(i < nreg && regs.u8[i] == regs.u8[i - period]) i++;
+
+			if(i == nreg) break;
+		}
+
+		for(uint32 i = 0; i < period; i++)
+		{
+			uint8* offset;
+
+			switch(regs.u8[i])
+			{
+			case GIF_REG_STQ: offset = &vertex.stq; break;
+			case GIF_REG_RGBA: offset = &vertex.rgba; break;
+			case GIF_REG_UV: offset = &vertex.uv; break;
+			case GIF_REG_XYZF2: offset = &vertex.xyz; break;
+			case GIF_REG_XYZ2: offset = &vertex.xyz; break;
+			case GIF_REG_NOP: continue; // xeno2: 040f010f02, mgs3: 04010f0f02, 0401020f0f
+			default: return;
+			}
+
+			if(*offset != VERTEX_NONE || vertex.xyz != VERTEX_NONE)
+			{
+				return; // twice in a vertex, or after its kick
+			}
+
+			*offset = (uint8)i;
+		}
+
+		if(vertex.xyz == VERTEX_NONE)
+		{
+			return;
+		}
+
+		vertex.type = regs.u8[vertex.xyz] == GIF_REG_XYZF2 ? TYPE_VERTEX_XYZF2 : TYPE_VERTEX_XYZ2;
+		vertex.period = period;
+	}
 
 	__forceinline void SetTag(const void* mem)
 	{
@@ -1154,34 +1222,17 @@ struct alignas(32) GIFPath
 			}
 			else
 			{
-				switch(nreg)
+				if(nreg != vertex.nreg || !regs.eq(vertex.regs))
+				{
+					UpdateVertexLayout();
+				}
+
+				type = vertex.type;
+
+				if(vertex.period < nreg)
 				{
-				case 1: break;
-				case 2: break;
-				case 3:
-					if(regs.u32[0] == 0x00040102) type = TYPE_STQRGBAXYZF2; // many games, TODO: formats mixed with NOPs (xeno2: 040f010f02, 04010f020f, mgs3: 04010f0f02, 0401020f0f, 04010f020f)
-					if(regs.u32[0] == 0x00050102) type = TYPE_STQRGBAXYZ2; // GoW (has other crazy formats, like ...030503050103)
-					// TODO: common types with UV instead
-					break;
-				case 4: break;
-				case 5: break;
-				case 6: break;
-				case 7: break;
-				case 8: break;
-				case 9:
-					if(regs.u32[0] == 0x02040102 && regs.u32[1] == 0x01020401 && regs.u32[2] == 0x00000004) {type = TYPE_STQRGBAXYZF2; nreg = 3; nloop *= 3;} // ffx
-					break;
-				case 10: break;
-				case 11: break;
-				case 12:
-					if(regs.u32[0] == 0x02040102 && regs.u32[1] == 0x01020401 && regs.u32[2] == 0x04010204) {type = TYPE_STQRGBAXYZF2; nreg = 3; nloop *= 4;} // dq8 (not many, mostly 040102)
-					break;
-				case 13: break;
-				case 14: break;
-				case 15: break;
-				case 16: break;
-				default:
-					__assume(0);
+					nloop *= nreg / vertex.period;
+					nreg = vertex.period;
 				}
 			}
 		}
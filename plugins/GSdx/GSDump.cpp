@@ -25,6 +25,7 @@
 GSDumpBase::GSDumpBase(const std::string& fn)
 	: m_frames(0)
 	, m_extra_frames(2)
+	, m_needs_state(false)
 {
 	m_gs = px_fopen(fn, "wb");
 	if (!m_gs)
@@ -80,7 +81,25 @@ bool GSDumpBase::VSync(int field, bool last, const GSPrivRegSet* regs)
 	if (last)
 		m_extra_frames--;
 
-	return (++m_frames & 1) == 0 && last && (m_extra_frames < 0);
+	bool done = (++m_frames & 1) == 0 && last && (m_extra_frames < 0);
+
+	if (!done)
+		m_needs_state = NextChunk();
+
+	return done;
+}
+
+void GSDumpBase::State(const GSFreezeData& fd, const GSPrivRegSet* regs)
+{
+	uint32 frame = m_frames;
+
+	AppendRawData(4);
+	AppendRawData(&frame, 4);
+	AppendRawData(&fd.size, 4);
+	AppendRawData(fd.data, fd.size);
+	AppendRawData(regs, sizeof(*regs));
+
+	m_needs_state = false;
 }
 
 void GSDumpBase::Write(const void *data, size_t size)
@@ -119,24 +138,22 @@ void GSDump::AppendRawData(uint8 c)
 
 GSDumpXz::GSDumpXz(const std::string& fn, uint32 crc, const GSFreezeData& fd, const GSPrivRegSet* regs)
 	: GSDumpBase(fn + ".gs.xz")
+	, m_threads(std::max(theApp.GetConfigI("dump_compression_threads"), 1))
 {
 	m_strm = LZMA_STREAM_INIT;
-	lzma_ret ret = lzma_easy_encoder(&m_strm, 6 /*level*/, LZMA_CHECK_CRC64);
-	if (ret != LZMA_OK) {
-		fprintf(stderr, "GSDumpXz: Error initializing LZMA encoder ! (error code %u)\n", ret);
-		return;
-	}
+
+	m_out_buff.resize(1024*1024);
+	m_compressor = std::unique_ptr<Compressor>(new Compressor([this](std::shared_ptr<std::vector<uint8>>& chunk) {Compress(*chunk);}));
 
 	AddHeader(crc, fd, regs);
 }
 
 GSDumpXz::~GSDumpXz()
 {
-	Flush();
+	Submit();
 
-	// Finish the stream
-	m_strm.avail_in = 0;
-	Compress(LZMA_FINISH, LZMA_STREAM_END);
+	m_compressor->Wait();
+	m_compressor.reset();
 
 	lzma_end(&m_strm);
 }
@@ -146,13 +163,6 @@ void GSDumpXz::AppendRawData(const void *data, size_t size)
 	size_t old_size = m_in_buff.size();
 	m_in_buff.resize(old_size + size);
 	memcpy(&m_in_buff[old_size], data, size);
-
-	// Enough data was accumulated, time to write/compress it.  If compression
-	// is enabled, it will freeze PCSX2. 1GB should be enough for long dump.
-	//
-	// Note: long dumps are currently not supported so this path won't be executed
-	if (m_in_buff.size() > 1024*1024*1024)
-		Flush();
 }
 
 void GSDumpXz::AppendRawData(uint8 c)
@@ -160,35 +170,70 @@ void GSDumpXz::AppendRawData(uint8 c)
 	m_in_buff.push_back(c);
 }
 
-void GSDumpXz::Flush()
+bool GSDumpXz::NextChunk()
+{
+	if (m_in_buff.size() < CHUNK_SIZE)
+		return false;
+
+	Submit();
+
+	return true;
+}
+
+void GSDumpXz::Submit()
 {
 	if (m_in_buff.empty())
 		return;
 
-	m_strm.next_in = m_in_buff.data();
-	m_strm.avail_in = m_in_buff.size();
-
-	Compress(LZMA_RUN, LZMA_OK);
+	m_compressor->Push(std::make_shared<std::vector<uint8>>(std::move(m_in_buff)));
 
 	m_in_buff.clear();
+	m_in_buff.reserve(CHUNK_SIZE + CHUNK_SIZE / 4);
 }
 
-void GSDumpXz::Compress(lzma_action action, lzma_ret expected_status)
+// Compressor thread, every chunk is an xz stream of its own
+void GSDumpXz::Compress(const std::vector<uint8>& chunk)
 {
-	std::vector<uint8> out_buff(1024*1024);
+	lzma_ret ret;
+
+#if LZMA_VERSION >= 50020002
+	if (m_threads > 1)
+	{
+		lzma_mt mt = {};
+		mt.threads = m_threads;
+		mt.block_size = CHUNK_SIZE / 4;
+		mt.preset = 6;
+		mt.check = LZMA_CHECK_CRC64;
+
+		ret = lzma_stream_encoder_mt(&m_strm, &mt);
+	}
+	else
+#endif
+	{
+		ret = lzma_easy_encoder(&m_strm, 6 /*level*/, LZMA_CHECK_CRC64);
+	}
+
+	if (ret != LZMA_OK) {
+		fprintf(stderr, "GSDumpXz: Error initializing LZMA encoder ! (error code %u)\n", ret);
+		return;
+	}
+
+	m_strm.next_in = chunk.data();
+	m_strm.avail_in = chunk.size();
+
 	do {
-		m_strm.next_out = out_buff.data();
-		m_strm.avail_out = out_buff.size();
+		m_strm.next_out = m_out_buff.data();
+		m_strm.avail_out = m_out_buff.size();
 
-		lzma_ret ret = lzma_code(&m_strm, action);
+		ret = lzma_code(&m_strm, LZMA_FINISH);
 
-		if (ret != expected_status) {
+		if (ret != LZMA_OK && ret != LZMA_STREAM_END) {
 			fprintf (stderr, "GSDumpXz: Error %d\n", (int) ret);
 			return;
 		}
 
-		size_t write_size = out_buff.size() - m_strm.avail_out;
-		Write(out_buff.data(), write_size);
+		size_t write_size = m_out_buff.size() - m_strm.avail_out;
+		Write(m_out_buff.data(), write_size);
 
-	} while (m_strm.avail_out == 0);
+	} while (ret != LZMA_STREAM_END);
 }
@@ -23,6 +23,7 @@
 
 #include "GS.h"
 #include "Renderers/SW/GSVertexSW.h"
+#include "GSThread_CXX11.h"
 #include <lzma.h>
 
 /*
@@ -42,12 +43,21 @@ ReadFIFO2 data (id == 2)
 Regs data (id == 3)
 - [PMODE/0x2000]
 
+State data (id == 4)
+- [4/1] [frame/4] [state size/4] [state data/size] [PMODE/0x2000]
+
+A .gs.xz dump is a series of xz streams, one per chunk of the data above. Chunks end on a
+vsync, and every chunk but the first starts with the state of the GS at that point (frame
+is the number of vsyncs before it), so a reader can start at any of them (GSDumpLzma::Seek).
+Replaying from the start, the state data is the state the GS is already in.
+
 */
 
 class GSDumpBase
 {
 	int m_frames;
 	int m_extra_frames;
+	bool m_needs_state;
 	FILE* m_gs;
 
 protected:
@@ -57,6 +67,9 @@ protected:
 	virtual void AppendRawData(const void *data, size_t size) = 0;
 	virtual void AppendRawData(uint8 c) = 0;
 
+	// After a vsync, true when a new chunk starts there
+	virtual bool NextChunk() {return false;}
+
 public:
 	GSDumpBase(const std::string& fn);
 	virtual ~GSDumpBase();
@@ -64,6 +77,10 @@ public:
 	void ReadFIFO(uint32 size);
 	void Transfer(int index, const uint8* mem, size_t size);
 	bool VSync(int field, bool last, const GSPrivRegSet* regs);
+
+	// The state of the GS is wanted right after the vsync which started a chunk
+	bool NeedsState() const {return m_needs_state;}
+	void State(const GSFreezeData& fd, const GSPrivRegSet* regs);
 };
 
 class GSDump final : public GSDumpBase
@@ -76,16 +93,26 @@ public:
 	virtual ~GSDump() = default;
 };
 
+// Compresses the chunks on a thread of its own, while the next one is recorded. The GS thread
+// only waits when two chunks are already queued.
 class GSDumpXz final : public GSDumpBase
 {
+	static const size_t CHUNK_SIZE = 32 * 1024 * 1024;
+
+	using Compressor = GSJobQueue<std::shared_ptr<std::vector<uint8>>, 3>;
+
 	lzma_stream m_strm;
+	int m_threads;
 
 	std::vector<uint8> m_in_buff;
+	std::vector<uint8> m_out_buff;
+	std::unique_ptr<Compressor> m_compressor;
 
-	void Flush();
-	void Compress(lzma_action action, lzma_ret expected_status);
-	void AppendRawData(const void *data, size_t size);
-	void AppendRawData(uint8 c);
+	void Submit();
+	void Compress(const std::vector<uint8>& chunk);
+	bool NextChunk() final;
+	void AppendRawData(const void *data, size_t size) final;
+	void AppendRawData(uint8 c) final;
 
 public:
 	GSDumpXz(const std::string& fn, uint32 crc, const GSFreezeData& fd, const GSPrivRegSet* regs);
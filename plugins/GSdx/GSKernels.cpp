@@ -0,0 +1,101 @@
+/*
+ *  Copyright (C) 2021 PCSX2 Dev Team
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GNU Make; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "stdafx.h"
+#include "GSKernels.h"
+#include "xbyak/xbyak_util.h"
+
+GSKernelTable GSKernels::m_tables[GSKernelISA_Count];
+GSKernelISA GSKernels::m_isa = GSKernelISA_SSE2;
+
+GSKernelTable g_kernels;
+
+bool GSKernels::IsSupported(GSKernelISA isa)
+{
+	// Not g_cpu, the kernels are also linked without the rest of GSdx (unit tests)
+	static const Xbyak::util::Cpu cpu;
+
+	switch(isa)
+	{
+	case GSKernelISA_SSE2:
+		return true;
+	case GSKernelISA_SSE41:
+		return cpu.has(Xbyak::util::Cpu::tSSE41);
+	case GSKernelISA_AVX:
+		return cpu.has(Xbyak::util::Cpu::tAVX);
+	case GSKernelISA_AVX2:
+		return cpu.has(Xbyak::util::Cpu::tAVX2) && cpu.has(Xbyak::util::Cpu::tBMI1) && cpu.has(Xbyak::util::Cpu::tBMI2);
+	default:
+		return false;
+	}
+}
+
+GSKernelISA GSKernels::GetBestISA()
+{
+	int isa = GSKernelISA_Count - 1;
+
+	while(isa > GSKernelISA_SSE2 && !IsSupported((GSKernelISA)isa))
+	{
+		isa--;
+	}
+
+	return (GSKernelISA)isa;
+}
+
+bool GSKernels::Init(GSKernelISA isa)
+{
+	static void (*const fill[GSKernelISA_Count])(GSKernelTable& t) =
+	{
+		GSKernels_SSE2::Fill,
+		GSKernels_SSE41::Fill,
+		GSKernels_AVX::Fill,
+		GSKernels_AVX2::Fill,
+	};
+
+	// Tables of unsupported instruction sets stay empty, even filling them could use it
+	for(int i = 0; i < GSKernelISA_Count; i++)
+	{
+		if(m_tables[i].name == NULL && IsSupported((GSKernelISA)i))
+		{
+			fill[i](m_tables[i]);
+
+			m_tables[i].InitVectors();
+		}
+	}
+
+	bool supported = true;
+
+	if(isa == GSKernelISA_Auto)
+	{
+		isa = GetBestISA();
+	}
+	else if(!IsSupported(isa))
+	{
+		isa = GetBestISA();
+
+		supported = false;
+	}
+
+	m_isa = isa;
+
+	g_kernels = m_tables[isa];
+
+	return supported;
+}
@@ -0,0 +1,102 @@
+/*
+ *  Copyright (C) 2021 PCSX2 Dev Team
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GNU Make; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#pragma once
+
+// Hot GSVector code compiled once per instruction set (GSKernels.sse2/sse4/avx/avx2.cpp) and
+// picked at startup, so a SSE2 build of GSdx still runs the SSE4.1/AVX/AVX2 versions of it.
+//
+// Each GSKernels.*.cpp compiles GSKernels.inl with its own _M_SSE, inside its own namespace
+// (GSVector, GSBlock, GIFReg types included), so nothing built for one instruction set can be
+// merged by the linker into the code of another. Don't include GSVector.h before this header
+// in those files, and only pass plain types through the table.
+
+enum GSKernelISA
+{
+	GSKernelISA_SSE2, // Built with the flags of the rest of GSdx
+	GSKernelISA_SSE41,
+	GSKernelISA_AVX,
+	GSKernelISA_AVX2,
+	GSKernelISA_Count,
+	GSKernelISA_Auto = -1
+};
+
+// GSVertexTrace::FindMinMax over the vertices, before the offset and scale are applied
+struct alignas(16) GSVertexTraceMinMax
+{
+	__m128 pmin, pmax; // x, y, z, f (z divided by 2)
+	__m128 tmin, tmax; // s, t, q (or u, v)
+	__m128i cmin, cmax; // r, g, b, a in the bytes of z
+};
+
+struct GSKernelTable
+{
+	const char* name;
+
+	void (*InitVectors)();
+
+	// [accurate_stq][color][fst][tme][iip][primclass]
+	void (*FindMinMax[2][2][2][2][2][4])(const void* vertex, const uint32* index, int count, GSVertexTraceMinMax& mm);
+
+	// GSLocalMemory::ReadTexture*, one block to 32 bits, TEXA is GIFRegTEXA::u64
+	void (*ReadBlock32)(const uint8* src, uint8* dst, int dstpitch);
+	void (*ReadAndExpandBlock24[2])(const uint8* src, uint8* dst, int dstpitch, uint64 TEXA); // [AEM]
+	void (*ReadAndExpandBlock16[2])(const uint8* src, uint8* dst, int dstpitch, uint64 TEXA); // [AEM]
+	void (*ReadAndExpandBlock8_32)(const uint8* src, uint8* dst, int dstpitch, const uint32* pal);
+	void (*ReadAndExpandBlock4_32)(const uint8* src, uint8* dst, int dstpitch, const uint64* pal);
+	void (*ReadAndExpandBlock8H_32)(const uint8* src, uint8* dst, int dstpitch, const uint32* pal);
+	void (*ReadAndExpandBlock4HL_32)(const uint8* src, uint8* dst, int dstpitch, const uint32* pal);
+	void (*ReadAndExpandBlock4HH_32)(const uint8* src, uint8* dst, int dstpitch, const uint32* pal);
+
+	// GSLocalMemory::WriteImage*, one block from the image. [alignment / 16] of src and srcpitch.
+	void (*WriteBlock32[3])(uint8* dst, const uint8* src, int srcpitch);
+	void (*WriteBlock16[3])(uint8* dst, const uint8* src, int srcpitch);
+	void (*WriteBlock8[3])(uint8* dst, const uint8* src, int srcpitch);
+	void (*WriteBlock4[3])(uint8* dst, const uint8* src, int srcpitch);
+	void (*UnpackAndWriteBlock24)(const uint8* src, int srcpitch, uint8* dst);
+	void (*UnpackAndWriteBlock8H)(const uint8* src, int srcpitch, uint8* dst);
+	void (*UnpackAndWriteBlock4HL)(const uint8* src, int srcpitch, uint8* dst);
+	void (*UnpackAndWriteBlock4HH)(const uint8* src, int srcpitch, uint8* dst);
+};
+
+namespace GSKernels_SSE2 {void Fill(GSKernelTable& t);}
+namespace GSKernels_SSE41 {void Fill(GSKernelTable& t);}
+namespace GSKernels_AVX {void Fill(GSKernelTable& t);}
+namespace GSKernels_AVX2 {void Fill(GSKernelTable& t);}
+
+class GSKernels
+{
+	static GSKernelTable m_tables[GSKernelISA_Count];
+	static GSKernelISA m_isa;
+
+public:
+	static bool IsSupported(GSKernelISA isa);
+	static GSKernelISA GetBestISA();
+
+	// Selects the kernels of the given instruction set, or the best one the cpu supports.
+	// Returns false (and keeps the best one) if the cpu doesn't support the requested one.
+	static bool Init(GSKernelISA isa = GSKernelISA_Auto);
+
+	static GSKernelISA GetISA() {return m_isa;}
+	static const GSKernelTable& Get(GSKernelISA isa) {return m_tables[isa];}
+};
+
+// Kernels of the selected instruction set
+extern GSKernelTable g_kernels;
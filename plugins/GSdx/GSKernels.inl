@@ -0,0 +1,626 @@
+/*
+ *  Copyright (C) 2021 PCSX2 Dev Team
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GNU Make; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+// Compiled by GSKernels.*.cpp, which define GS_KERNEL_NAMESPACE and GS_KERNEL_ISA (the _M_SSE
+// of the kernels, stdafx.h picks it up instead of the one of the compiler flags).
+
+#include "stdafx.h"
+#include "GSTables.h"
+#include "GSKernels.h"
+
+namespace GS_KERNEL_NAMESPACE
+{
+
+#include "GSVector.h"
+#include "GS.h"
+#include "GSBlock.h"
+
+// Constants of GSVector and GSBlock for this instruction set
+#include "GSVector.cpp"
+#include "GSBlock.cpp"
+
+static void InitVectors()
+{
+	GSVector4i::InitVectors();
+	GSVector4::InitVectors();
+#if _M_SSE >= 0x500
+	GSVector8::InitVectors();
+#endif
+#if _M_SSE >= 0x501
+	GSVector8i::InitVectors();
+#endif
+	GSBlock::InitVectors();
+}
+
+// GSVertex, only m[] is used
+struct alignas(32) Vertex {__m128i m[2];};
+
+template<GS_PRIM_CLASS primclass, uint32 iip, uint32 tme, uint32 fst, uint32 color, uint32 accurate_stq>
+static void FindMinMax(const void* vertex, const uint32* index, int count, GSVertexTraceMinMax& mm)
+{
+	const GSVector4 minmax(FLT_MAX, -FLT_MAX);
+
+	int n = 1;
+
+	switch(primclass)
+	{
+	case GS_POINT_CLASS:
+		n = 1;
+		break;
+	case GS_LINE_CLASS:
+	case GS_SPRITE_CLASS:
+		n = 2;
+		break;
+	case GS_TRIANGLE_CLASS:
+		n = 3;
+		break;
+	}
+
+	GSVector4 tmin = minmax.xxxx();
+	GSVector4 tmax = minmax.yyyy();
+	GSVector4i cmin = GSVector4i::xffffffff();
+	GSVector4i cmax = GSVector4i::zero();
+
+	#if _M_SSE >= 0x401
+
+	GSVector4i pmin = GSVector4i::xffffffff();
+	GSVector4i pmax = GSVector4i::zero();
+
+	#else
+
+	GSVector4 pmin = minmax.xxxx();
+	GSVector4 pmax = minmax.yyyy();
+	
+	#endif
+
+	const Vertex* RESTRICT v = (const Vertex*)vertex;
+
+	for(int i = 0; i < count; i += n)
+	{
+		if(primclass == GS_POINT_CLASS)
+		{
+			GSVector4i c(v[index[i]].m[0]);
+
+			if(color)
+			{
+				cmin = cmin.min_u8(c);
+				cmax = cmax.max_u8(c);
+			}
+
+			if(tme)
+			{
+				if(!fst)
+				{
+					GSVector4 stq = GSVector4::cast(c);
+
+					GSVector4 q = stq.wwww();
+
+					if (accurate_stq)
+						stq = (stq.xyww() / q).xyww(q);
+					else
+						stq = (stq.xyww() * q.rcpnr()).xyww(q);
+
+					tmin = tmin.min(stq);
+					tmax = tmax.max(stq);
+				}
+				else
+				{
+					GSVector4i uv(v[index[i]].m[1]);
+
+					GSVector4 st = GSVector4(uv.uph16()).xyxy();
+
+					tmin = tmin.min(st);
+					tmax = tmax.max(st);
+				}
+			}
+
+			GSVector4i xyzf(v[index[i]].m[1]);
+
+			GSVector4i xy = xyzf.upl16();
+			GSVector4i z = xyzf.yyyy();
+
+			#if _M_SSE >= 0x401
+
+			GSVector4i p = xy.blend16<0xf0>(z.uph32(xyzf));
+
+			pmin = pmin.min_u32(p);
+			pmax = pmax.max_u32(p);
+
+			#else
+
+			GSVector4 p = GSVector4(xy.upl64(z.srl32(1).upl32(xyzf.wwww())));
+
+			pmin = pmin.min(p);
+			pmax = pmax.max(p);
+
+			#endif
+		}
+		else if(primclass == GS_LINE_CLASS)
+		{
+			GSVector4i c0(v[index[i + 0]].m[0]);
+			GSVector4i c1(v[index[i + 1]].m[0]);
+
+			if(color)
+			{
+				if(iip)
+				{
+					cmin = cmin.min_u8(c0.min_u8(c1));
+					cmax = cmax.max_u8(c0.max_u8(c1));
+				}
+				else
+				{
+					cmin = cmin.min_u8(c1);
+					cmax = cmax.max_u8(c1);
+				}
+			}
+
+			if(tme)
+			{
+				if(!fst)
+				{
+					GSVector4 stq0 = GSVector4::cast(c0);
+					GSVector4 stq1 = GSVector4::cast(c1);
+
+					if(accurate_stq)
+					{
+						GSVector4 q = stq0.wwww(stq1);
+
+						stq0 = (stq0.xyww() / q.xxxx()).xyww(stq0);
+						stq1 = (stq1.xyww() / q.zzzz()).xyww(stq1);
+					}
+					else
+					{
+						GSVector4 q = stq0.wwww(stq1).rcpnr();
+
+						stq0 = (stq0.xyww() * q.xxxx()).xyww(stq0);
+						stq1 = (stq1.xyww() * q.zzzz()).xyww(stq1);
+					}
+
+					tmin = tmin.min(stq0.min(stq1));
+					tmax = tmax.max(stq0.max(stq1));
+				}
+				else
+				{
+					GSVector4i uv0(v[index[i + 0]].m[1]);
+					GSVector4i uv1(v[index[i + 1]].m[1]);
+
+					GSVector4 st0 = GSVector4(uv0.uph16()).xyxy();
+					GSVector4 st1 = GSVector4(uv1.uph16()).xyxy();
+
+					tmin = tmin.min(st0.min(st1));
+					tmax = tmax.max(st0.max(st1));
+				}
+			}
+
+			GSVector4i xyzf0(v[index[i + 0]].m[1]);
+			GSVector4i xyzf1(v[index[i + 1]].m[1]);
+
+			GSVector4i xy0 = xyzf0.upl16();
+			GSVector4i z0 = xyzf0.yyyy();
+			GSVector4i xy1 = xyzf1.upl16();
+			GSVector4i z1 = xyzf1.yyyy();
+
+			#if _M_SSE >= 0x401
+
+			GSVector4i p0 = xy0.blend16<0xf0>(z0.uph32(xyzf0));
+			GSVector4i p1 = xy1.blend16<0xf0>(z1.uph32(xyzf1));
+
+			pmin = pmin.min_u32(p0.min_u32(p1));
+			pmax = pmax.max_u32(p0.max_u32(p1));
+
+			#else
+
+			GSVector4 p0 = GSVector4(xy0.upl64(z0.srl32(1).upl32(xyzf0.wwww())));
+			GSVector4 p1 = GSVector4(xy1.upl64(z1.srl32(1).upl32(xyzf1.wwww())));
+
+			pmin = pmin.min(p0.min(p1));
+			pmax = pmax.max(p0.max(p1));
+
+			#endif
+		}
+		else if(primclass == GS_TRIANGLE_CLASS)
+		{
+			GSVector4i c0(v[index[i + 0]].m[0]);
+			GSVector4i c1(v[index[i + 1]].m[0]);
+			GSVector4i c2(v[index[i + 2]].m[0]);
+
+			if(color)
+			{
+				if(iip)
+				{
+					cmin = cmin.min_u8(c2).min_u8(c0.min_u8(c1));
+					cmax = cmax.max_u8(c2).max_u8(c0.max_u8(c1));
+				}
+				else
+				{
+					cmin = cmin.min_u8(c2);
+					cmax = cmax.max_u8(c2);
+				}
+			}
+
+			if(tme)
+			{
+				if(!fst)
+				{
+					GSVector4 stq0 = GSVector4::cast(c0);
+					GSVector4 stq1 = GSVector4::cast(c1);
+					GSVector4 stq2 = GSVector4::cast(c2);
+
+					if(accurate_stq)
+					{
+						GSVector4 q = stq0.wwww(stq1).xzww(stq2);
+
+						stq0 = (stq0.xyww() / q.xxxx()).xyww(stq0);
+						stq1 = (stq1.xyww() / q.yyyy()).xyww(stq1);
+						stq2 = (stq2.xyww() / q.zzzz()).xyww(stq2);
+					}
+					else
+					{
+						GSVector4 q = stq0.wwww(stq1).xzww(stq2).rcpnr();
+
+						stq0 = (stq0.xyww() * q.xxxx()).xyww(stq0);
+						stq1 = (stq1.xyww() * q.yyyy()).xyww(stq1);
+						stq2 = (stq2.xyww() * q.zzzz()).xyww(stq2);
+					}
+
+					tmin = tmin.min(stq2).min(stq0.min(stq1));
+					tmax = tmax.max(stq2).max(stq0.max(stq1));
+				}
+				else
+				{
+					GSVector4i uv0(v[index[i + 0]].m[1]);
+					GSVector4i uv1(v[index[i + 1]].m[1]);
+					GSVector4i uv2(v[index[i + 2]].m[1]);
+
+					GSVector4 st0 = GSVector4(uv0.uph16()).xyxy();
+					GSVector4 st1 = GSVector4(uv1.uph16()).xyxy();
+					GSVector4 st2 = GSVector4(uv2.uph16()).xyxy();
+
+					tmin = tmin.min(st2).min(st0.min(st1));
+					tmax = tmax.max(st2).max(st0.max(st1));
+				}
+			}
+
+			GSVector4i xyzf0(v[index[i + 0]].m[1]);
+			GSVector4i xyzf1(v[index[i + 1]].m[1]);
+			GSVector4i xyzf2(v[index[i + 2]].m[1]);
+
+			GSVector4i xy0 = xyzf0.upl16();
+			GSVector4i z0 = xyzf0.yyyy();
+			GSVector4i xy1 = xyzf1.upl16();
+			GSVector4i z1 = xyzf1.yyyy();
+			GSVector4i xy2 = xyzf2.upl16();
+			GSVector4i z2 = xyzf2.yyyy();
+
+			#if _M_SSE >= 0x401
+
+			GSVector4i p0 = xy0.blend16<0xf0>(z0.uph32(xyzf0));
+			GSVector4i p1 = xy1.blend16<0xf0>(z1.uph32(xyzf1));
+			GSVector4i p2 = xy2.blend16<0xf0>(z2.uph32(xyzf2));
+
+			pmin = pmin.min_u32(p2).min_u32(p0.min_u32(p1));
+			pmax = pmax.max_u32(p2).max_u32(p0.max_u32(p1));
+
+			#else
+
+			GSVector4 p0 = GSVector4(xy0.upl64(z0.srl32(1).upl32(xyzf0.wwww())));
+			GSVector4 p1 = GSVector4(xy1.upl64(z1.srl32(1).upl32(xyzf1.wwww())));
+			GSVector4 p2 = GSVector4(xy2.upl64(z2.srl32(1).upl32(xyzf2.wwww())));
+
+			pmin = pmin.min(p2).min(p0.min(p1));
+			pmax = pmax.max(p2).max(p0.max(p1));
+
+			#endif
+		}
+		else if(primclass == GS_SPRITE_CLASS)
+		{
+			GSVector4i c0(v[index[i + 0]].m[0]);
+			GSVector4i c1(v[index[i + 1]].m[0]);
+
+			if(color)
+			{
+				if(iip)
+				{
+					cmin = cmin.min_u8(c0.min_u8(c1));
+					cmax = cmax.max_u8(c0.max_u8(c1));
+				}
+				else
+				{
+					cmin = cmin.min_u8(c1);
+					cmax = cmax.max_u8(c1);
+				}
+			}
+
+			if(tme)
+			{
+				if(!fst)
+				{
+					GSVector4 stq0 = GSVector4::cast(c0);
+					GSVector4 stq1 = GSVector4::cast(c1);
+
+					if(accurate_stq)
+					{
+						GSVector4 q = stq1.wwww();
+
+						stq0 = (stq0.xyww() / q).xyww(stq1);
+						stq1 = (stq1.xyww() / q).xyww(stq1);
+					}
+					else
+					{
+						GSVector4 q = stq1.wwww().rcpnr();
+
+						stq0 = (stq0.xyww() * q).xyww(stq1);
+						stq1 = (stq1.xyww() * q).xyww(stq1);
+					}
+
+					tmin = tmin.min(stq0.min(stq1));
+					tmax = tmax.max(stq0.max(stq1));
+				}
+				else
+				{
+					GSVector4i uv0(v[index[i + 0]].m[1]);
+					GSVector4i uv1(v[index[i + 1]].m[1]);
+
+					GSVector4 st0 = GSVector4(uv0.uph16()).xyxy();
+					GSVector4 st1 = GSVector4(uv1.uph16()).xyxy();
+
+					tmin = tmin.min(st0.min(st1));
+					tmax = tmax.max(st0.max(st1));
+				}
+			}
+
+			GSVector4i xyzf0(v[index[i + 0]].m[1]);
+			GSVector4i xyzf1(v[index[i + 1]].m[1]);
+
+			GSVector4i xy0 = xyzf0.upl16();
+			GSVector4i z0 = xyzf0.yyyy();
+			GSVector4i xy1 = xyzf1.upl16();
+			GSVector4i z1 = xyzf1.yyyy();
+
+			#if _M_SSE >= 0x401
+
+			GSVector4i p0 = xy0.blend16<0xf0>(z0.uph32(xyzf1));
+			GSVector4i p1 = xy1.blend16<0xf0>(z1.uph32(xyzf1));
+
+			pmin = pmin.min_u32(p0.min_u32(p1));
+			pmax = pmax.max_u32(p0.max_u32(p1));
+
+			#else
+
+			GSVector4 p0 = GSVector4(xy0.upl64(z0.srl32(1).upl32(xyzf1.wwww())));
+			GSVector4 p1 = GSVector4(xy1.upl64(z1.srl32(1).upl32(xyzf1.wwww())));
+
+			pmin = pmin.min(p0.min(p1));
+			pmax = pmax.max(p0.max(p1));
+
+			#endif
+		}
+	}
+
+	// FIXME/WARNING. A division by 2 is done on the depth. I suspect to avoid
+	// negative value. However it means that we lost the lsb bit. m_eq.z could
+	// be true if depth isn't constant but close enough. It also imply that
+	// pmin.z & 1 == 0 and pax.z & 1 == 0
+
+	#if _M_SSE >= 0x401
+
+	pmin = pmin.blend16<0x30>(pmin.srl32(1));
+	pmax = pmax.blend16<0x30>(pmax.srl32(1));
+
+	#endif
+
+	mm.pmin = GSVector4(pmin);
+	mm.pmax = GSVector4(pmax);
+	mm.tmin = tmin;
+	mm.tmax = tmax;
+	mm.cmin = cmin;
+	mm.cmax = cmax;
+}
+
+static void ReadBlock32(const uint8* RESTRICT src, uint8* RESTRICT dst, int dstpitch)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::ReadBlock32(src, dst, dstpitch);
+}
+
+template<bool AEM> static void ReadAndExpandBlock24(const uint8* RESTRICT src, uint8* RESTRICT dst, int dstpitch, uint64 TEXA)
+{
+	ALIGN_STACK(32);
+
+	GIFRegTEXA r;
+	r.u64 = TEXA;
+
+	GSBlock::ReadAndExpandBlock24<AEM>(src, dst, dstpitch, r);
+}
+
+template<bool AEM> static void ReadAndExpandBlock16(const uint8* RESTRICT src, uint8* RESTRICT dst, int dstpitch, uint64 TEXA)
+{
+	ALIGN_STACK(32);
+
+	GIFRegTEXA r;
+	r.u64 = TEXA;
+
+	GSBlock::ReadAndExpandBlock16<AEM>(src, dst, dstpitch, r);
+}
+
+static void ReadAndExpandBlock8_32(const uint8* RESTRICT src, uint8* RESTRICT dst, int dstpitch, const uint32* RESTRICT pal)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::ReadAndExpandBlock8_32(src, dst, dstpitch, pal);
+}
+
+static void ReadAndExpandBlock4_32(const uint8* RESTRICT src, uint8* RESTRICT dst, int dstpitch, const uint64* RESTRICT pal)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::ReadAndExpandBlock4_32(src, dst, dstpitch, pal);
+}
+
+static void ReadAndExpandBlock8H_32(const uint8* RESTRICT src, uint8* RESTRICT dst, int dstpitch, const uint32* RESTRICT pal)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::ReadAndExpandBlock8H_32(src, dst, dstpitch, pal);
+}
+
+static void ReadAndExpandBlock4HL_32(const uint8* RESTRICT src, uint8* RESTRICT dst, int dstpitch, const uint32* RESTRICT pal)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::ReadAndExpandBlock4HL_32(src, dst, dstpitch, pal);
+}
+
+static void ReadAndExpandBlock4HH_32(const uint8* RESTRICT src, uint8* RESTRICT dst, int dstpitch, const uint32* RESTRICT pal)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::ReadAndExpandBlock4HH_32(src, dst, dstpitch, pal);
+}
+
+template<int alignment> static void WriteBlock32(uint8* RESTRICT dst, const uint8* RESTRICT src, int srcpitch)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::WriteBlock32<alignment, 0xffffffff>(dst, src, srcpitch);
+}
+
+template<int alignment> static void WriteBlock16(uint8* RESTRICT dst, const uint8* RESTRICT src, int srcpitch)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::WriteBlock16<alignment>(dst, src, srcpitch);
+}
+
+template<int alignment> static void WriteBlock8(uint8* RESTRICT dst, const uint8* RESTRICT src, int srcpitch)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::WriteBlock8<alignment>(dst, src, srcpitch);
+}
+
+template<int alignment> static void WriteBlock4(uint8* RESTRICT dst, const uint8* RESTRICT src, int srcpitch)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::WriteBlock4<alignment>(dst, src, srcpitch);
+}
+
+static void UnpackAndWriteBlock24(const uint8* RESTRICT src, int srcpitch, uint8* RESTRICT dst)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::UnpackAndWriteBlock24(src, srcpitch, dst);
+}
+
+static void UnpackAndWriteBlock8H(const uint8* RESTRICT src, int srcpitch, uint8* RESTRICT dst)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::UnpackAndWriteBlock8H(src, srcpitch, dst);
+}
+
+static void UnpackAndWriteBlock4HL(const uint8* RESTRICT src, int srcpitch, uint8* RESTRICT dst)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::UnpackAndWriteBlock4HL(src, srcpitch, dst);
+}
+
+static void UnpackAndWriteBlock4HH(const uint8* RESTRICT src, int srcpitch, uint8* RESTRICT dst)
+{
+	ALIGN_STACK(32);
+
+	GSBlock::UnpackAndWriteBlock4HH(src, srcpitch, dst);
+}
+
+// Must only be called if the cpu supports the instruction set, the compiler is free to use it here too
+void Fill(GSKernelTable& t)
+{
+#if _M_SSE >= 0x501
+	t.name = "AVX2";
+#elif _M_SSE >= 0x500
+	t.name = "AVX";
+#elif _M_SSE >= 0x401
+	t.name = "SSE4.1";
+#elif _M_SSE >= 0x301
+	t.name = "SSSE3";
+#else
+	t.name = "SSE2";
+#endif
+
+	t.InitVectors = InitVectors;
+
+	#define InitFindMinMax3(P, IIP, TME, FST, COLOR) \
+		t.FindMinMax[0][COLOR][FST][TME][IIP][P] = FindMinMax<P, IIP, TME, FST, COLOR, 0>; \
+		t.FindMinMax[1][COLOR][FST][TME][IIP][P] = FindMinMax<P, IIP, TME, FST, COLOR, 1>; \
+
+	#define InitFindMinMax2(P, IIP, TME) \
+		InitFindMinMax3(P, IIP, TME, 0, 0) \
+		InitFindMinMax3(P, IIP, TME, 0, 1) \
+		InitFindMinMax3(P, IIP, TME, 1, 0) \
+		InitFindMinMax3(P, IIP, TME, 1, 1) \
+
+	#define InitFindMinMax(P) \
+		InitFindMinMax2(P, 0, 0) \
+		InitFindMinMax2(P, 0, 1) \
+		InitFindMinMax2(P, 1, 0) \
+		InitFindMinMax2(P, 1, 1) \
+
+	InitFindMinMax(GS_POINT_CLASS);
+	InitFindMinMax(GS_LINE_CLASS);
+	InitFindMinMax(GS_TRIANGLE_CLASS);
+	InitFindMinMax(GS_SPRITE_CLASS);
+
+	#undef InitFindMinMax
+	#undef InitFindMinMax2
+	#undef InitFindMinMax3
+
+	t.ReadBlock32 = ReadBlock32;
+	t.ReadAndExpandBlock24[0] = ReadAndExpandBlock24<false>;
+	t.ReadAndExpandBlock24[1] = ReadAndExpandBlock24<true>;
+	t.ReadAndExpandBlock16[0] = ReadAndExpandBlock16<false>;
+	t.ReadAndExpandBlock16[1] = ReadAndExpandBlock16<true>;
+	t.ReadAndExpandBlock8_32 = ReadAndExpandBlock8_32;
+	t.ReadAndExpandBlock4_32 = ReadAndExpandBlock4_32;
+	t.ReadAndExpandBlock8H_32 = ReadAndExpandBlock8H_32;
+	t.ReadAndExpandBlock4HL_32 = ReadAndExpandBlock4HL_32;
+	t.ReadAndExpandBlock4HH_32 = ReadAndExpandBlock4HH_32;
+
+	t.WriteBlock32[0] = WriteBlock32<0>;
+	t.WriteBlock32[1] = WriteBlock32<16>;
+	t.WriteBlock32[2] = WriteBlock32<32>;
+	t.WriteBlock16[0] = WriteBlock16<0>;
+	t.WriteBlock16[1] = WriteBlock16<16>;
+	t.WriteBlock16[2] = WriteBlock16<32>;
+	t.WriteBlock8[0] = WriteBlock8<0>;
+	t.WriteBlock8[1] = WriteBlock8<16>;
+	t.WriteBlock8[2] = WriteBlock8<32>;
+	t.WriteBlock4[0] = WriteBlock4<0>;
+	t.WriteBlock4[1] = WriteBlock4<16>;
+	t.WriteBlock4[2] = WriteBlock4<32>;
+	t.UnpackAndWriteBlock24 = UnpackAndWriteBlock24;
+	t.UnpackAndWriteBlock8H = UnpackAndWriteBlock8H;
+	t.UnpackAndWriteBlock4HL = UnpackAndWriteBlock4HL;
+	t.UnpackAndWriteBlock4HH = UnpackAndWriteBlock4HH;
+}
+
+}
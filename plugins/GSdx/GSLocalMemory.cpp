@@ -26,6 +26,7 @@
 
 #include "stdafx.h"
 #include "GSLocalMemory.h"
+#include "GSKernels.h"
 #include "GSdx.h"
 
 #define ASSERT_BLOCK(r, w, h) \
@@ -751,20 +752,26 @@ void GSLocalMemory::WriteImageBlock(int l, int r, int y, int h, const uint8* src
 	uint32 bp = BITBLTBUF.DBP;
 	uint32 bw = BITBLTBUF.DBW;
 
+	const auto wb =
+		psm == PSM_PSMCT32 || psm == PSM_PSMZ32 ? g_kernels.WriteBlock32[alignment / 16] :
+		psm == PSM_PSMT8 ? g_kernels.WriteBlock8[alignment / 16] :
+		psm == PSM_PSMT4 ? g_kernels.WriteBlock4[alignment / 16] :
+		g_kernels.WriteBlock16[alignment / 16];
+
 	for(int offset = srcpitch * bsy; h >= bsy; h -= bsy, y += bsy, src += offset)
 	{
 		for(int x = l; x < r; x += bsx)
 		{
 			switch(psm)
 			{
-			case PSM_PSMCT32: GSBlock::WriteBlock32<alignment, 0xffffffff>(BlockPtr32(x, y, bp, bw), &src[x * 4], srcpitch); break;
-			case PSM_PSMCT16: GSBlock::WriteBlock16<alignment>(BlockPtr16(x, y, bp, bw), &src[x * 2], srcpitch); break;
-			case PSM_PSMCT16S: GSBlock::WriteBlock16<alignment>(BlockPtr16S(x, y, bp, bw), &src[x * 2], srcpitch); break;
-			case PSM_PSMT8: GSBlock::WriteBlock8<alignment>(BlockPtr8(x, y, bp, bw), &src[x], srcpitch); break;
-			case PSM_PSMT4: GSBlock::WriteBlock4<alignment>(BlockPtr4(x, y, bp, bw), &src[x >> 1], srcpitch); break;
-			case PSM_PSMZ32: GSBlock::WriteBlock32<alignment, 0xffffffff>(BlockPtr32Z(x, y, bp, bw), &src[x * 4], srcpitch); break;
-			case PSM_PSMZ16: GSBlock::WriteBlock16<alignment>(BlockPtr16Z(x, y, bp, bw), &src[x * 2], srcpitch); break;
-			case PSM_PSMZ16S: GSBlock::WriteBlock16<alignment>(BlockPtr16SZ(x, y, bp, bw), &src[x * 2], srcpitch); break;
+			case PSM_PSMCT32: wb(BlockPtr32(x, y, bp, bw), &src[x * 4], srcpitch); break;
+			case PSM_PSMCT16: wb(BlockPtr16(x, y, bp, bw), &src[x * 2], srcpitch); break;
+			case PSM_PSMCT16S: wb(BlockPtr16S(x, y, bp, bw), &src[x * 2], srcpitch); break;
+			case PSM_PSMT8: wb(BlockPtr8(x, y, bp, bw), &src[x], srcpitch); break;
+			case PSM_PSMT4: wb(BlockPtr4(x, y, bp, bw), &src[x >> 1], srcpitch); break;
+			case PSM_PSMZ32: wb(BlockPtr32Z(x, y, bp, bw), &src[x * 4], srcpitch); break;
+			case PSM_PSMZ16: wb(BlockPtr16Z(x, y, bp, bw), &src[x * 2], srcpitch); break;
+			case PSM_PSMZ16S: wb(BlockPtr16SZ(x, y, bp, bw), &src[x * 2], srcpitch); break;
 			// TODO
 			default: __assume(0);
 			}
@@ -1096,11 +1103,13 @@ void GSLocalMemory::WriteImage24(int& tx, int& ty, const uint8* src, int len, GI
 	{
 		th += ty;
 
+		const auto wb = g_kernels.UnpackAndWriteBlock24;
+
 		for(int y = ty; y < th; y += 8, src += srcpitch * 8)
 		{
 			for(int x = tx; x < tw; x += 8)
 			{
-				GSBlock::UnpackAndWriteBlock24(src + (x - tx) * 3, srcpitch, BlockPtr32(x, y, bp, bw));
+				wb(src + (x - tx) * 3, srcpitch, BlockPtr32(x, y, bp, bw));
 			}
 		}
 
@@ -1130,11 +1139,13 @@ void GSLocalMemory::WriteImage8H(int& tx, int& ty, const uint8* src, int len, GI
 	{
 		th += ty;
 
+		const auto wb = g_kernels.UnpackAndWriteBlock8H;
+
 		for(int y = ty; y < th; y += 8, src += srcpitch * 8)
 		{
 			for(int x = tx; x < tw; x += 8)
 			{
-				GSBlock::UnpackAndWriteBlock8H(src + (x - tx), srcpitch, BlockPtr32(x, y, bp, bw));
+				wb(src + (x - tx), srcpitch, BlockPtr32(x, y, bp, bw));
 			}
 		}
 
@@ -1164,11 +1175,13 @@ void GSLocalMemory::WriteImage4HL(int& tx, int& ty, const uint8* src, int len, G
 	{
 		th += ty;
 
+		const auto wb = g_kernels.UnpackAndWriteBlock4HL;
+
 		for(int y = ty; y < th; y += 8, src += srcpitch * 8)
 		{
 			for(int x = tx; x < tw; x += 8)
 			{
-				GSBlock::UnpackAndWriteBlock4HL(src + (x - tx) / 2, srcpitch, BlockPtr32(x, y, bp, bw));
+				wb(src + (x - tx) / 2, srcpitch, BlockPtr32(x, y, bp, bw));
 			}
 		}
 
@@ -1198,11 +1211,13 @@ void GSLocalMemory::WriteImage4HH(int& tx, int& ty, const uint8* src, int len, G
 	{
 		th += ty;
 
+		const auto wb = g_kernels.UnpackAndWriteBlock4HH;
+
 		for(int y = ty; y < th; y += 8, src += srcpitch * 8)
 		{
 			for(int x = tx; x < tw; x += 8)
 			{
-				GSBlock::UnpackAndWriteBlock4HH(src + (x - tx) / 2, srcpitch, BlockPtr32(x, y, bp, bw));
+				wb(src + (x - tx) / 2, srcpitch, BlockPtr32(x, y, bp, bw));
 			}
 		}
 
@@ -1232,11 +1247,13 @@ void GSLocalMemory::WriteImage24Z(int& tx, int& ty, const uint8* src, int len, G
 	{
 		th += ty;
 
+		const auto wb = g_kernels.UnpackAndWriteBlock24;
+
 		for(int y = ty; y < th; y += 8, src += srcpitch * 8)
 		{
 			for(int x = tx; x < tw; x += 8)
 			{
-				GSBlock::UnpackAndWriteBlock24(src + (x - tx) * 3, srcpitch, BlockPtr32Z(x, y, bp, bw));
+				wb(src + (x - tx) * 3, srcpitch, BlockPtr32Z(x, y, bp, bw));
 			}
 		}
 
@@ -1420,6 +1437,57 @@ void GSLocalMemory::WriteImageX(int& tx, int& ty, const uint8* src, int len, GIF
 
 //
 
+bool GSLocalMemory::CanWriteImageBands(int len, const GIFRegBITBLTBUF& BITBLTBUF, const GIFRegTRXPOS& TRXPOS, const GIFRegTRXREG& TRXREG) const
+{
+	const psm_t& psm = m_psm[BITBLTBUF.DPSM];
+
+	int w = (int)TRXREG.RRW;
+	int h = (int)TRXREG.RRH;
+
+	// all the rows, in whole bytes
+
+	if(w == 0 || h == 0 || (w * psm.trbpp & 7) != 0 || len != (w * psm.trbpp >> 3) * h)
+	{
+		return false;
+	}
+
+	// pages of a row of the buffer (half of DBW for 8 and 4 bits), and rows of pages
+
+	int cols = ((int)BITBLTBUF.DBW << 6) / psm.pgs.x;
+	int rows = ((int)TRXPOS.DSAY + h + psm.pgs.y - 1) / psm.pgs.y;
+
+	return cols > 0 && (int)TRXPOS.DSAX + w <= cols * psm.pgs.x && BITBLTBUF.DBP + ((uint32)(rows * cols) << 5) <= MAX_BLOCKS;
+}
+
+void GSLocalMemory::WriteImageBand(int i, int count, const uint8* src, const GIFRegBITBLTBUF& BITBLTBUF, const GIFRegTRXPOS& TRXPOS, const GIFRegTRXREG& TRXREG)
+{
+	const psm_t& psm = m_psm[BITBLTBUF.DPSM];
+
+	int top = (int)TRXPOS.DSAY;
+	int bottom = top + (int)TRXREG.RRH;
+	int srcpitch = (int)TRXREG.RRW * psm.trbpp >> 3;
+
+	// the same number of block rows in each band, the first and the last ones may be cut by the transfer
+
+	int base = top & ~(psm.bs.y - 1);
+	int h = ((bottom - base + count - 1) / count + psm.bs.y - 1) & ~(psm.bs.y - 1);
+
+	int y0 = std::max(base + h * i, top);
+	int y1 = std::min(base + h * (i + 1), bottom);
+
+	if(y0 < y1)
+	{
+		GIFRegBITBLTBUF blit = BITBLTBUF;
+		GIFRegTRXPOS pos = TRXPOS;
+		GIFRegTRXREG reg = TRXREG;
+
+		int tx = (int)TRXPOS.DSAX;
+		int ty = y0;
+
+		(this->*psm.wi)(tx, ty, src + (y0 - top) * srcpitch, (y1 - y0) * srcpitch, blit, pos, reg);
+	}
+}
+
 void GSLocalMemory::ReadImageX(int& tx, int& ty, uint8* dst, int len, GIFRegBITBLTBUF& BITBLTBUF, GIFRegTRXPOS& TRXPOS, GIFRegTRXREG& TRXREG) const
 {
 	if(len <= 0) return;
@@ -1650,31 +1718,24 @@ void GSLocalMemory::ReadImageX(int& tx, int& ty, uint8* dst, int len, GIFRegBITB
 
 void GSLocalMemory::ReadTexture32(const GSOffset* RESTRICT off, const GSVector4i& r, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA)
 {
+	const auto rb = g_kernels.ReadBlock32;
+
 	FOREACH_BLOCK_START(r, 8, 8, 32)
 	{
-		GSBlock::ReadBlock32(src, read_dst, dstpitch);
+		rb(src, read_dst, dstpitch);
 	}
 	FOREACH_BLOCK_END
 }
 
 void GSLocalMemory::ReadTexture24(const GSOffset* RESTRICT off, const GSVector4i& r, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA)
 {
-	if(TEXA.AEM)
+	const auto rb = g_kernels.ReadAndExpandBlock24[TEXA.AEM];
+
+	FOREACH_BLOCK_START(r, 8, 8, 32)
 	{
-		FOREACH_BLOCK_START(r, 8, 8, 32)
-		{
-			GSBlock::ReadAndExpandBlock24<true>(src, read_dst, dstpitch, TEXA);
-		}
-		FOREACH_BLOCK_END
-	}
-	else
-	{
-		FOREACH_BLOCK_START(r, 8, 8, 32)
-		{
-			GSBlock::ReadAndExpandBlock24<false>(src, read_dst, dstpitch, TEXA);
-		}
-		FOREACH_BLOCK_END
+		rb(src, read_dst, dstpitch, TEXA.u64);
 	}
+	FOREACH_BLOCK_END
 }
 
 void GSLocalMemory::ReadTextureGPU24(const GSOffset* RESTRICT off, const GSVector4i& r, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA)
@@ -1698,31 +1759,23 @@ void GSLocalMemory::ReadTextureGPU24(const GSOffset* RESTRICT off, const GSVecto
 
 void GSLocalMemory::ReadTexture16(const GSOffset* RESTRICT off, const GSVector4i& r, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA)
 {
-	if(TEXA.AEM)
-	{
-		FOREACH_BLOCK_START(r, 16, 8, 32)
-		{
-			GSBlock::ReadAndExpandBlock16<true>(src, read_dst, dstpitch, TEXA);
-		}
-		FOREACH_BLOCK_END
-	}
-	else
+	const auto rb = g_kernels.ReadAndExpandBlock16[TEXA.AEM];
+
+	FOREACH_BLOCK_START(r, 16, 8, 32)
 	{
-		FOREACH_BLOCK_START(r, 16, 8, 32)
-		{
-			GSBlock::ReadAndExpandBlock16<false>(src, read_dst, dstpitch, TEXA);
-		}
-		FOREACH_BLOCK_END
+		rb(src, read_dst, dstpitch, TEXA.u64);
 	}
+	FOREACH_BLOCK_END
 }
 
 void GSLocalMemory::ReadTexture8(const GSOffset* RESTRICT off, const GSVector4i& r, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA)
 {
 	const uint32* pal = m_clut;
+	const auto rb = g_kernels.ReadAndExpandBlock8_32;
 
 	FOREACH_BLOCK_START(r, 16, 16, 32)
 	{
-		GSBlock::ReadAndExpandBlock8_32(src, read_dst, dstpitch, pal);
+		rb(src, read_dst, dstpitch, pal);
 	}
 	FOREACH_BLOCK_END
 }
@@ -1730,10 +1783,11 @@ void GSLocalMemory::ReadTexture8(const GSOffset* RESTRICT off, const GSVector4i&
 void GSLocalMemory::ReadTexture4(const GSOffset* RESTRICT off, const GSVector4i& r, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA)
 {
 	const uint64* pal = m_clut;
+	const auto rb = g_kernels.ReadAndExpandBlock4_32;
 
 	FOREACH_BLOCK_START(r, 32, 16, 32)
 	{
-		GSBlock::ReadAndExpandBlock4_32(src, read_dst, dstpitch, pal);
+		rb(src, read_dst, dstpitch, pal);
 	}
 	FOREACH_BLOCK_END
 }
@@ -1741,10 +1795,11 @@ void GSLocalMemory::ReadTexture4(const GSOffset* RESTRICT off, const GSVector4i&
 void GSLocalMemory::ReadTexture8H(const GSOffset* RESTRICT off, const GSVector4i& r, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA)
 {
 	const uint32* pal = m_clut;
+	const auto rb = g_kernels.ReadAndExpandBlock8H_32;
 
 	FOREACH_BLOCK_START(r, 8, 8, 32)
 	{
-		GSBlock::ReadAndExpandBlock8H_32(src, read_dst, dstpitch, pal);
+		rb(src, read_dst, dstpitch, pal);
 	}
 	FOREACH_BLOCK_END
 }
@@ -1752,10 +1807,11 @@ void GSLocalMemory::ReadTexture8H(const GSOffset* RESTRICT off, const GSVector4i
 void GSLocalMemory::ReadTexture4HL(const GSOffset* RESTRICT off, const GSVector4i& r, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA)
 {
 	const uint32* pal = m_clut;
+	const auto rb = g_kernels.ReadAndExpandBlock4HL_32;
 
 	FOREACH_BLOCK_START(r, 8, 8, 32)
 	{
-		GSBlock::ReadAndExpandBlock4HL_32(src, read_dst, dstpitch, pal);
+		rb(src, read_dst, dstpitch, pal);
 	}
 	FOREACH_BLOCK_END
 }
@@ -1763,10 +1819,11 @@ void GSLocalMemory::ReadTexture4HL(const GSOffset* RESTRICT off, const GSVector4
 void GSLocalMemory::ReadTexture4HH(const GSOffset* RESTRICT off, const GSVector4i& r, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA)
 {
 	const uint32* pal = m_clut;
+	const auto rb = g_kernels.ReadAndExpandBlock4HH_32;
 
 	FOREACH_BLOCK_START(r, 8, 8, 32)
 	{
-		GSBlock::ReadAndExpandBlock4HH_32(src, read_dst, dstpitch, pal);
+		rb(src, read_dst, dstpitch, pal);
 	}
 	FOREACH_BLOCK_END
 }
@@ -1777,70 +1834,56 @@ void GSLocalMemory::ReadTextureBlock32(uint32 bp, uint8* dst, int dstpitch, cons
 {
 	ALIGN_STACK(32);
 
-	GSBlock::ReadBlock32(BlockPtr(bp), dst, dstpitch);
+	g_kernels.ReadBlock32(BlockPtr(bp), dst, dstpitch);
 }
 
 void GSLocalMemory::ReadTextureBlock24(uint32 bp, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA) const
 {
 	ALIGN_STACK(32);
 
-	if(TEXA.AEM)
-	{
-		GSBlock::ReadAndExpandBlock24<true>(BlockPtr(bp), dst, dstpitch, TEXA);
-	}
-	else
-	{
-		GSBlock::ReadAndExpandBlock24<false>(BlockPtr(bp), dst, dstpitch, TEXA);
-	}
+	g_kernels.ReadAndExpandBlock24[TEXA.AEM](BlockPtr(bp), dst, dstpitch, TEXA.u64);
 }
 
 void GSLocalMemory::ReadTextureBlock16(uint32 bp, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA) const
 {
 	ALIGN_STACK(32);
 
-	if(TEXA.AEM)
-	{
-		GSBlock::ReadAndExpandBlock16<true>(BlockPtr(bp), dst, dstpitch, TEXA);
-	}
-	else
-	{
-		GSBlock::ReadAndExpandBlock16<false>(BlockPtr(bp), dst, dstpitch, TEXA);
-	}
+	g_kernels.ReadAndExpandBlock16[TEXA.AEM](BlockPtr(bp), dst, dstpitch, TEXA.u64);
 }
 
 void GSLocalMemory::ReadTextureBlock8(uint32 bp, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA) const
 {
 	ALIGN_STACK(32);
 
-	GSBlock::ReadAndExpandBlock8_32(BlockPtr(bp), dst, dstpitch, m_clut);
+	g_kernels.ReadAndExpandBlock8_32(BlockPtr(bp), dst, dstpitch, m_clut);
 }
 
 void GSLocalMemory::ReadTextureBlock4(uint32 bp, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA) const
 {
 	ALIGN_STACK(32);
 
-	GSBlock::ReadAndExpandBlock4_32(BlockPtr(bp), dst, dstpitch, m_clut);
+	g_kernels.ReadAndExpandBlock4_32(BlockPtr(bp), dst, dstpitch, m_clut);
 }
 
 void GSLocalMemory::ReadTextureBlock8H(uint32 bp, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA) const
 {
 	ALIGN_STACK(32);
 
-	GSBlock::ReadAndExpandBlock8H_32(BlockPtr(bp), dst, dstpitch, m_clut);
+	g_kernels.ReadAndExpandBlock8H_32(BlockPtr(bp), dst, dstpitch, m_clut);
 }
 
 void GSLocalMemory::ReadTextureBlock4HL(uint32 bp, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA) const
 {
 	ALIGN_STACK(32);
 
-	GSBlock::ReadAndExpandBlock4HL_32(BlockPtr(bp), dst, dstpitch, m_clut);
+	g_kernels.ReadAndExpandBlock4HL_32(BlockPtr(bp), dst, dstpitch, m_clut);
 }
 
 void GSLocalMemory::ReadTextureBlock4HH(uint32 bp, uint8* dst, int dstpitch, const GIFRegTEXA& TEXA) const
 {
 	ALIGN_STACK(32);
 
-	GSBlock::ReadAndExpandBlock4HH_32(BlockPtr(bp), dst, dstpitch, m_clut);
+	g_kernels.ReadAndExpandBlock4HH_32(BlockPtr(bp), dst, dstpitch, m_clut);
 }
 
 ///////////////////
@@ -870,6 +870,13 @@ public:
 	void WriteImage24Z(int& tx, int& ty, const uint8* src, int len, GIFRegBITBLTBUF& BITBLTBUF, GIFRegTRXPOS& TRXPOS, GIFRegTRXREG& TRXREG);
 	void WriteImageX(int& tx, int& ty, const uint8* src, int len, GIFRegBITBLTBUF& BITBLTBUF, GIFRegTRXPOS& TRXPOS, GIFRegTRXREG& TRXREG);
 
+	// A whole transfer (len bytes from DSAX/DSAY) can be written in bands of block rows by several
+	// threads at once, when none of its blocks belongs to two bands: the buffer is wide enough
+	// and it doesn't wrap around the end of the memory.
+
+	bool CanWriteImageBands(int len, const GIFRegBITBLTBUF& BITBLTBUF, const GIFRegTRXPOS& TRXPOS, const GIFRegTRXREG& TRXREG) const;
+	void WriteImageBand(int i, int count, const uint8* src, const GIFRegBITBLTBUF& BITBLTBUF, const GIFRegTRXPOS& TRXPOS, const GIFRegTRXREG& TRXREG);
+
 	// TODO: ReadImage32/24/...
 
 	void ReadImageX(int& tx, int& ty, uint8* dst, int len, GIFRegBITBLTBUF& BITBLTBUF, GIFRegTRXPOS& TRXPOS, GIFRegTRXREG& TRXREG) const;
@@ -21,6 +21,14 @@
 #include "stdafx.h"
 #include "GSLzma.h"
 
+#ifdef _WIN32
+#define GS_fseeko _fseeki64
+#define GS_ftello _ftelli64
+#else
+#define GS_fseeko fseeko
+#define GS_ftello ftello
+#endif
+
 GSDumpFile::GSDumpFile(char* filename, const char* repack_filename) {
 	m_fp = fopen(filename, "rb");
 	if (m_fp == nullptr) {
@@ -58,7 +66,8 @@ GSDumpLzma::GSDumpLzma(char* filename, const char* repack_filename) : GSDumpFile
 
 	memset(&m_strm, 0, sizeof(lzma_stream));
 
-	lzma_ret ret = lzma_stream_decoder(&m_strm, UINT32_MAX, 0);
+	// GSDumpXz writes a stream per chunk
+	lzma_ret ret = lzma_stream_decoder(&m_strm, UINT32_MAX, LZMA_CONCATENATED);
 
 	if (ret != LZMA_OK) {
 		fprintf(stderr, "Error initializing the decoder! (error code %u)\n", ret);
@@ -70,6 +79,7 @@ GSDumpLzma::GSDumpLzma(char* filename, const char* repack_filename) : GSDumpFile
 	m_inbuf     = (uint8_t*)_aligned_malloc(BUFSIZ, 32);
 	m_avail     = 0;
 	m_start     = 0;
+	m_eof       = false;
 
 	m_strm.avail_in  = 0;
 	m_strm.next_in   = m_inbuf;
@@ -79,8 +89,6 @@ GSDumpLzma::GSDumpLzma(char* filename, const char* repack_filename) : GSDumpFile
 }
 
 void GSDumpLzma::Decompress() {
-	lzma_action action = LZMA_RUN;
-
 	m_strm.next_out  = m_area;
 	m_strm.avail_out = m_buff_size;
 
@@ -95,12 +103,20 @@ void GSDumpLzma::Decompress() {
 		}
 	}
 
+	// With concatenated streams, the decoder only finishes once told the input is over
+	lzma_action action = feof(m_fp) ? LZMA_FINISH : LZMA_RUN;
+
 	lzma_ret ret = lzma_code(&m_strm, action);
 
 	if (ret != LZMA_OK) {
-		if (ret == LZMA_STREAM_END)
+		if (ret == LZMA_STREAM_END) {
 			fprintf(stderr, "LZMA decoder finished without error\n\n");
-		else {
+			m_eof = true;
+		} else if (ret == LZMA_BUF_ERROR && action == LZMA_FINISH) {
+			// Recording stopped in the middle of a chunk, what came before it is fine
+			fprintf(stderr, "LZMA decoder: truncated file, the last chunk is lost\n\n");
+			m_eof = true;
+		} else {
 			fprintf(stderr, "Decoder error: (error code %u)\n", ret);
 			throw "BAD"; // Just exit the program
 		}
@@ -111,7 +127,7 @@ void GSDumpLzma::Decompress() {
 }
 
 bool GSDumpLzma::IsEof() {
-	return feof(m_fp) && m_avail == 0 && m_strm.avail_in == 0;
+	return m_eof && m_avail == 0;
 }
 
 bool GSDumpLzma::Read(void* ptr, size_t size) {
@@ -139,6 +155,123 @@ bool GSDumpLzma::Read(void* ptr, size_t size) {
 	return false;
 }
 
+bool GSDumpLzma::ReadAt(int64 offset, void* ptr, size_t size) {
+	return offset >= 0 && GS_fseeko(m_fp, offset, SEEK_SET) == 0 && fread(ptr, 1, size, m_fp) == size;
+}
+
+// Decodes the start of the chunk at offset, its state data packet
+bool GSDumpLzma::ReadChunkFrame(int64 offset, uint32& frame) {
+	lzma_stream strm = LZMA_STREAM_INIT;
+
+	if (lzma_stream_decoder(&strm, UINT32_MAX, 0) != LZMA_OK || GS_fseeko(m_fp, offset, SEEK_SET) != 0) {
+		lzma_end(&strm);
+		return false;
+	}
+
+	uint8_t in[BUFSIZ];
+	uint8_t packet[5];
+
+	strm.next_out  = packet;
+	strm.avail_out = sizeof(packet);
+
+	lzma_ret ret = LZMA_OK;
+
+	while (strm.avail_out > 0 && ret == LZMA_OK) {
+		if (strm.avail_in == 0) {
+			strm.next_in  = in;
+			strm.avail_in = fread(in, 1, sizeof(in), m_fp);
+
+			if (strm.avail_in == 0)
+				break;
+		}
+
+		ret = lzma_code(&strm, LZMA_RUN);
+	}
+
+	bool found = strm.avail_out == 0 && packet[0] == 4;
+
+	lzma_end(&strm);
+
+	if (found)
+		memcpy(&frame, &packet[1], 4);
+
+	return found;
+}
+
+bool GSDumpLzma::Seek(uint32 frame) {
+	const int64 here = GS_ftello(m_fp);
+
+	// Offsets of the streams, from the last one. Going back from the end of the file, a
+	// stream is found from the size of its index, in its footer, and its index.
+	std::vector<int64> streams;
+
+	int64 pos = GS_fseeko(m_fp, 0, SEEK_END) == 0 ? GS_ftello(m_fp) : -1;
+
+	while (pos > 0) {
+		uint8_t footer[LZMA_STREAM_HEADER_SIZE];
+
+		if (!ReadAt(pos - LZMA_STREAM_HEADER_SIZE, footer, sizeof(footer)))
+			break;
+
+		// Stream padding
+		if (footer[8] == 0 && footer[9] == 0 && footer[10] == 0 && footer[11] == 0) {
+			pos -= 4;
+			continue;
+		}
+
+		lzma_stream_flags flags;
+
+		if (lzma_stream_footer_decode(&flags, footer) != LZMA_OK || flags.backward_size > (uint64)pos)
+			break;
+
+		std::vector<uint8_t> buff(flags.backward_size);
+
+		if (!ReadAt(pos - LZMA_STREAM_HEADER_SIZE - flags.backward_size, buff.data(), buff.size()))
+			break;
+
+		lzma_index* index = nullptr;
+		uint64_t memlimit = UINT64_MAX;
+		size_t in_pos = 0;
+
+		if (lzma_index_buffer_decode(&index, &memlimit, nullptr, buff.data(), &in_pos, buff.size()) != LZMA_OK)
+			break;
+
+		pos -= lzma_index_stream_size(index);
+
+		lzma_index_end(index, nullptr);
+
+		streams.push_back(pos);
+	}
+
+	// The first stream starts with the header of the dump
+	if (pos == 0) {
+		for (int64 offset : streams) {
+			uint32 start;
+
+			if (offset > 0 && ReadChunkFrame(offset, start) && start <= frame) {
+				if (lzma_stream_decoder(&m_strm, UINT32_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+					fprintf(stderr, "Error initializing the decoder!\n");
+					throw "BAD"; // Just exit the program
+				}
+
+				GS_fseeko(m_fp, offset, SEEK_SET);
+
+				m_strm.avail_in = 0;
+				m_strm.next_in  = m_inbuf;
+				m_avail = 0;
+				m_start = 0;
+				m_eof   = false;
+
+				return true;
+			}
+		}
+	}
+
+	GS_fseeko(m_fp, here, SEEK_SET);
+
+	return false;
+}
+
 GSDumpLzma::~GSDumpLzma() {
 	lzma_end(&m_strm);
 
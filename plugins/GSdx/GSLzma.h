@@ -32,6 +32,10 @@ class GSDumpFile {
 	virtual bool IsEof() = 0;
 	virtual bool Read(void* ptr, size_t size) = 0;
 
+	// Moves to the last chunk starting at or before frame, the next packet read is its state
+	// data (see GSDump.h). False when there is no such chunk, nothing moves then.
+	virtual bool Seek(uint32 frame) {return false;}
+
 	GSDumpFile(char* filename, const char* repack_filename);
 	virtual ~GSDumpFile();
 };
@@ -46,8 +50,11 @@ class GSDumpLzma : public GSDumpFile {
 
 	size_t		m_avail;
 	size_t		m_start;
+	bool		m_eof;
 
 	void Decompress();
+	bool ReadAt(int64 offset, void* ptr, size_t size);
+	bool ReadChunkFrame(int64 offset, uint32& frame);
 
 	public:
 
@@ -56,6 +63,7 @@ class GSDumpLzma : public GSDumpFile {
 
 	bool IsEof() final;
 	bool Read(void* ptr, size_t size) final;
+	bool Seek(uint32 frame) final;
 };
 
 class GSDumpRaw : public GSDumpFile {
@@ -29,6 +29,7 @@ GSPerfMon::GSPerfMon()
 {
 	memset(m_counters, 0, sizeof(m_counters));
 	memset(m_stats, 0, sizeof(m_stats));
+	memset(m_totals, 0, sizeof(m_totals));
 	memset(m_total, 0, sizeof(m_total));
 	memset(m_begin, 0, sizeof(m_begin));
 }
@@ -51,6 +52,7 @@ void GSPerfMon::Put(counter_t c, double val)
 		if(m_lastframe != 0)
 		{
 			m_counters[c] += (now - m_lastframe) * 1000 / CLOCKS_PER_SEC;
+			m_totals[c] += (now - m_lastframe) * 1000 / CLOCKS_PER_SEC;
 		}
 
 		m_lastframe = now;
@@ -60,10 +62,16 @@ void GSPerfMon::Put(counter_t c, double val)
 	else
 	{
 		m_counters[c] += val;
+		m_totals[c] += val;
 	}
 #endif
 }
 
+void GSPerfMon::ResetTotals()
+{
+	memset(m_totals, 0, sizeof(m_totals));
+}
+
 void GSPerfMon::Update()
 {
 #ifndef DISABLE_PERF_MON
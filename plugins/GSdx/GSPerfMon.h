@@ -30,18 +30,22 @@ public:
 		Sync, 
 		WorkerDraw0, WorkerDraw1, WorkerDraw2, WorkerDraw3, WorkerDraw4, WorkerDraw5, WorkerDraw6, WorkerDraw7, 
 		WorkerDraw8, WorkerDraw9, WorkerDraw10, WorkerDraw11, WorkerDraw12, WorkerDraw13, WorkerDraw14, WorkerDraw15, 
+		WorkerDraw16, WorkerDraw17, WorkerDraw18, WorkerDraw19, WorkerDraw20, WorkerDraw21, WorkerDraw22, WorkerDraw23,
+		WorkerDraw24, WorkerDraw25, WorkerDraw26, WorkerDraw27, WorkerDraw28, WorkerDraw29, WorkerDraw30, WorkerDraw31,
 		TimerLast,
+		WorkerLast = TimerLast - WorkerDraw0,
 	};
 	
 	enum counter_t 
 	{
-		Frame, Prim, Draw, Swizzle, Unswizzle, Fillrate, Quad, SyncPoint,
+		Frame, Prim, Draw, Swizzle, Unswizzle, Fillrate, Quad, SyncPoint, TileJob, TileSteal,
 		CounterLast,
 	};
 
 protected:
 	double m_counters[CounterLast];
 	double m_stats[CounterLast];
+	double m_totals[CounterLast];
 	uint64 m_begin[TimerLast], m_total[TimerLast], m_start[TimerLast];
 	uint64 m_frame;
 	clock_t m_lastframe;
@@ -59,6 +63,10 @@ public:
 	double Get(counter_t c) {return m_stats[c];}
 	void Update();
 
+	// Sums since the last ResetTotals(), where Get() averages over the last few frames
+	double GetTotal(counter_t c) {return m_totals[c];}
+	void ResetTotals();
+
 	void Start(int timer = Main);
 	void Stop(int timer = Main);
 	int CPU(int timer = Main, bool reset = true);
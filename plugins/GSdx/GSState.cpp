@@ -220,8 +220,8 @@ void GSState::SetFrameSkip(int skip)
 		m_fpGIFRegHandlers[GIF_A_D_REG_XYZF3] = &GSState::GIFRegHandlerNOP;
 		m_fpGIFRegHandlers[GIF_A_D_REG_XYZ3] = &GSState::GIFRegHandlerNOP;
 
-		m_fpGIFPackedRegHandlersC[GIF_REG_STQRGBAXYZF2] = &GSState::GIFPackedRegHandlerNOP;
-		m_fpGIFPackedRegHandlersC[GIF_REG_STQRGBAXYZ2] = &GSState::GIFPackedRegHandlerNOP;
+		m_fpGIFPackedRegHandlersC[GIF_REG_VERTEX_XYZF2] = &GSState::GIFPackedRegHandlerNOP;
+		m_fpGIFPackedRegHandlersC[GIF_REG_VERTEX_XYZ2] = &GSState::GIFPackedRegHandlerNOP;
 	}
 	else
 	{
@@ -299,8 +299,8 @@ void GSState::ResetHandlers()
 		m_fpGIFRegHandlerXYZ[P][1] = &GSState::GIFRegHandlerXYZF2<P, 1, auto_flush>; \
 		m_fpGIFRegHandlerXYZ[P][2] = &GSState::GIFRegHandlerXYZ2<P, 0, auto_flush>; \
 		m_fpGIFRegHandlerXYZ[P][3] = &GSState::GIFRegHandlerXYZ2<P, 1, auto_flush>; \
-		m_fpGIFPackedRegHandlerSTQRGBAXYZF2[P] = &GSState::GIFPackedRegHandlerSTQRGBAXYZF2<P, auto_flush>; \
-		m_fpGIFPackedRegHandlerSTQRGBAXYZ2[P] = &GSState::GIFPackedRegHandlerSTQRGBAXYZ2<P, auto_flush>; \
+		m_fpGIFPackedRegHandlerVertex[P][0] = &GSState::GIFPackedRegHandlerVertex<P, auto_flush, true>; \
+		m_fpGIFPackedRegHandlerVertex[P][1] = &GSState::GIFPackedRegHandlerVertex<P, auto_flush, false>; \
 
 	if (m_userhacks_auto_flush) {
 		SetHandlerXYZ(GS_POINTLIST, true);
@@ -689,80 +689,98 @@ void GSState::GIFPackedRegHandlerNOP(const GIFPackedReg* RESTRICT r)
 {
 }
 
-template<uint32 prim, bool auto_flush>
-void GSState::GIFPackedRegHandlerSTQRGBAXYZF2(const GIFPackedReg* RESTRICT r, uint32 size)
+// The loop of a vertex, the registers in the order of path.vertex (see GIFPath::UpdateVertexLayout),
+// decoded the same way as one register at a time
+
+template<uint32 prim, bool auto_flush, bool xyzf2>
+void GSState::GIFPackedRegHandlerVertex(const GIFPackedReg* RESTRICT r, uint32 size, const GIFPath& path)
 {
-	ASSERT(size > 0 && size % 3 == 0);
+	ASSERT(size > 0 && size % path.nreg == 0);
 
 	const GIFPackedReg* RESTRICT r_end = r + size;
 
-	while(r < r_end)
+	const uint32 nreg = path.nreg;
+	const uint32 stq = path.vertex.stq;
+	const uint32 rgba = path.vertex.rgba;
+	const uint32 uv = path.vertex.uv;
+	const uint32 xyz = path.vertex.xyz;
+
+	if(uv != GIFPath::VERTEX_NONE && m_userhacks_wildhack)
 	{
-		GSVector4i st = GSVector4i::loadl(&r[0].u64[0]);
-		GSVector4i q = GSVector4i::loadl(&r[0].u64[1]);
-		GSVector4i rgba = (GSVector4i::load<false>(&r[1]) & GSVector4i::x000000ff()).ps32().pu16();
-		/*
-		GSVector4i rg = GSVector4i::loadl(&r[1].u64[0]);
-		GSVector4i ba = GSVector4i::loadl(&r[1].u64[1]);
-		GSVector4i rbga = rg.upl8(ba);
-		GSVector4i rgba = rbga.upl8(rbga.zzzz());
-		*/
-		q = q.blend8(GSVector4i::cast(GSVector4::m_one), q == GSVector4i::zero()); // see GIFPackedRegHandlerSTQ
+		m_isPackedUV_HackFlag = true;
+	}
 
-		m_v.m[0] = st.upl64(rgba.upl32(q)); // TODO: only store the last one
+	GSVector4i q = GSVector4i::cast(GSVector4::load(m_q));
 
-		GSVector4i xy = GSVector4i::loadl(&r[2].u64[0]);
-		GSVector4i zf = GSVector4i::loadl(&r[2].u64[1]);
-		xy = xy.upl16(xy.srl<4>()).upl32(GSVector4i::load((int)m_v.UV));
-		zf = zf.srl32(4) & GSVector4i::x00ffffff().upl32(GSVector4i::x000000ff());
+	while(r < r_end)
+	{
+		GSVector4i c;
 
-		m_v.m[1] = xy.upl32(zf); // TODO: only store the last one
+		if(rgba != GIFPath::VERTEX_NONE)
+		{
+			c = (GSVector4i::load<false>(&r[rgba]) & GSVector4i::x000000ff()).ps32().pu16();
+		}
 
-		VertexKick<prim, auto_flush>(r[2].XYZF2.Skip());
+		if(stq != GIFPath::VERTEX_NONE)
+		{
+			GSVector4i st = GSVector4i::loadl(&r[stq].u64[0]);
+			GSVector4i new_q = GSVector4i::loadl(&r[stq].u64[1]);
 
-		r += 3;
-	}
+			new_q = new_q.blend8(GSVector4i::cast(GSVector4::m_one), new_q == GSVector4i::zero()); // see GIFPackedRegHandlerSTQ
+			new_q = GSVector4i::cast(GSVector4::cast(new_q).replace_nan(GSVector4::m_max));
 
-	m_q = r[-3].STQ.Q; // remember the last one, STQ outputs this to the temp Q each time
-}
+			if(rgba != GIFPath::VERTEX_NONE)
+			{
+				m_v.m[0] = st.upl64(c.upl32(rgba < stq ? q : new_q)); // RGBA takes the Q of the STQ before it
+			}
+			else
+			{
+				GSVector4i::storel(&m_v.ST, st);
+			}
 
-template<uint32 prim, bool auto_flush>
-void GSState::GIFPackedRegHandlerSTQRGBAXYZ2(const GIFPackedReg* RESTRICT r, uint32 size)
-{
-	ASSERT(size > 0 && size % 3 == 0);
+			q = new_q;
+		}
+		else if(rgba != GIFPath::VERTEX_NONE)
+		{
+			GSVector4i::storel(&m_v.RGBAQ, c.upl32(q));
+		}
 
-	const GIFPackedReg* RESTRICT r_end = r + size;
+		if(uv != GIFPath::VERTEX_NONE)
+		{
+			GSVector4i v = GSVector4i::loadl(&r[uv]) & GSVector4i::x00003fff();
 
-	while(r < r_end)
-	{
-		GSVector4i st = GSVector4i::loadl(&r[0].u64[0]);
-		GSVector4i q = GSVector4i::loadl(&r[0].u64[1]);
-		GSVector4i rgba = (GSVector4i::load<false>(&r[1]) & GSVector4i::x000000ff()).ps32().pu16();
-		/*
-		GSVector4i rg = GSVector4i::loadl(&r[1].u64[0]);
-		GSVector4i ba = GSVector4i::loadl(&r[1].u64[1]);
-		GSVector4i rbga = rg.upl8(ba);
-		GSVector4i rgba = rbga.upl8(rbga.zzzz());
-		*/
-		q = q.blend8(GSVector4i::cast(GSVector4::m_one), q == GSVector4i::zero()); // see GIFPackedRegHandlerSTQ
+			m_v.UV = (uint32)GSVector4i::store(v.ps32(v));
+		}
 
-		m_v.m[0] = st.upl64(rgba.upl32(q)); // TODO: only store the last one
+		if(xyzf2)
+		{
+			GSVector4i xy = GSVector4i::loadl(&r[xyz].u64[0]);
+			GSVector4i zf = GSVector4i::loadl(&r[xyz].u64[1]);
+			xy = xy.upl16(xy.srl<4>()).upl32(GSVector4i::load((int)m_v.UV));
+			zf = zf.srl32(4) & GSVector4i::x00ffffff().upl32(GSVector4i::x000000ff());
 
-		GSVector4i xy = GSVector4i::loadl(&r[2].u64[0]);
-		GSVector4i z = GSVector4i::loadl(&r[2].u64[1]);
-		GSVector4i xyz = xy.upl16(xy.srl<4>()).upl32(z);
+			m_v.m[1] = xy.upl32(zf);
 
-		m_v.m[1] = xyz.upl64(GSVector4i::loadl(&m_v.UV)); // TODO: only store the last one
+			VertexKick<prim, auto_flush>(r[xyz].XYZF2.Skip());
+		}
+		else
+		{
+			GSVector4i xy = GSVector4i::loadl(&r[xyz].u64[0]);
+			GSVector4i z = GSVector4i::loadl(&r[xyz].u64[1]);
+			xy = xy.upl16(xy.srl<4>()).upl32(z);
 
-		VertexKick<prim, auto_flush>(r[2].XYZ2.Skip());
+			m_v.m[1] = xy.upl64(GSVector4i::loadl(&m_v.UV));
+
+			VertexKick<prim, auto_flush>(r[xyz].XYZ2.Skip());
+		}
 
-		r += 3;
+		r += nreg;
 	}
 
-	m_q = r[-3].STQ.Q; // remember the last one, STQ outputs this to the temp Q each time
+	GSVector4::store(&m_q, GSVector4::cast(q)); // STQ outputs to the temp Q each time, the last one is left there
 }
 
-void GSState::GIFPackedRegHandlerNOP(const GIFPackedReg* RESTRICT r, uint32 size)
+void GSState::GIFPackedRegHandlerNOP(const GIFPackedReg* RESTRICT r, uint32 size, const GIFPath& path)
 {
 }
 
@@ -1537,9 +1555,7 @@ void GSState::FlushWrite()
 
 	//int y = m_tr.y;
 
-	GSLocalMemory::writeImage wi = GSLocalMemory::m_psm[m_env.BITBLTBUF.DPSM].wi;
-
-	(m_mem.*wi)(m_tr.x, m_tr.y, &m_tr.buff[m_tr.start], len, m_env.BITBLTBUF, m_env.TRXPOS, m_env.TRXREG);
+	WriteVideoMem(m_tr.x, m_tr.y, &m_tr.buff[m_tr.start], len, m_env.BITBLTBUF);
 
 	m_tr.start += len;
 
@@ -1750,7 +1766,7 @@ void GSState::Write(const uint8* mem, int len)
 
 		InvalidateVideoMem(blit, r);
 
-		(m_mem.*psm.wi)(m_tr.x, m_tr.y, mem, m_tr.total, blit, m_env.TRXPOS, m_env.TRXREG);
+		WriteVideoMem(m_tr.x, m_tr.y, mem, m_tr.total, blit);
 
 		m_tr.start = m_tr.end = m_tr.total;
 
@@ -1807,6 +1823,13 @@ void GSState::InitReadFIFO(uint8* mem, int len)
 	}
 }
 
+void GSState::WriteVideoMem(int& tx, int& ty, const uint8* mem, int len, GIFRegBITBLTBUF& BITBLTBUF)
+{
+	GSLocalMemory::writeImage wi = GSLocalMemory::m_psm[BITBLTBUF.DPSM].wi;
+
+	(m_mem.*wi)(tx, ty, mem, len, BITBLTBUF, m_env.TRXPOS, m_env.TRXREG);
+}
+
 void GSState::Read(uint8* mem, int len)
 {
 	if(len <= 0) return;
@@ -2188,17 +2211,17 @@ template<int index> void GSState::Transfer(const uint8* mem, uint32 size)
 
 						break;
 					
-					case GIFPath::TYPE_STQRGBAXYZF2: // majority of the vertices are formatted like this
+					case GIFPath::TYPE_VERTEX_XYZF2: // majority of the vertices are formatted like this (STQ RGBA XYZF2)
 
-						(this->*m_fpGIFPackedRegHandlersC[GIF_REG_STQRGBAXYZF2])((GIFPackedReg*)mem, total);
+						(this->*m_fpGIFPackedRegHandlersC[GIF_REG_VERTEX_XYZF2])((GIFPackedReg*)mem, total, path);
 
 						mem += total * sizeof(GIFPackedReg);
 
 						break;
 
-					case GIFPath::TYPE_STQRGBAXYZ2:
+					case GIFPath::TYPE_VERTEX_XYZ2:
 
-						(this->*m_fpGIFPackedRegHandlersC[GIF_REG_STQRGBAXYZ2])((GIFPackedReg*)mem, total);
+						(this->*m_fpGIFPackedRegHandlersC[GIF_REG_VERTEX_XYZ2])((GIFPackedReg*)mem, total, path);
 
 						mem += total * sizeof(GIFPackedReg);
 
@@ -2602,8 +2625,8 @@ void GSState::UpdateVertexKick()
 	m_fpGIFRegHandlers[GIF_A_D_REG_XYZ2] = m_fpGIFRegHandlerXYZ[prim][2];
 	m_fpGIFRegHandlers[GIF_A_D_REG_XYZ3] = m_fpGIFRegHandlerXYZ[prim][3];
 
-	m_fpGIFPackedRegHandlersC[GIF_REG_STQRGBAXYZF2] = m_fpGIFPackedRegHandlerSTQRGBAXYZF2[prim];
-	m_fpGIFPackedRegHandlersC[GIF_REG_STQRGBAXYZ2] = m_fpGIFPackedRegHandlerSTQRGBAXYZ2[prim];
+	m_fpGIFPackedRegHandlersC[GIF_REG_VERTEX_XYZF2] = m_fpGIFPackedRegHandlerVertex[prim][0];
+	m_fpGIFPackedRegHandlersC[GIF_REG_VERTEX_XYZ2] = m_fpGIFPackedRegHandlerVertex[prim][1];
 }
 
 void GSState::GrowVertexBuffer()
@@ -45,12 +45,11 @@ public:
 
 	static void InitVectors();
 
-	__forceinline GSVector4i()
+	// constexpr so static vectors are zeroed at compile time, not by a static initializer which
+	// could use the instruction set of the GSKernels.*.cpp it's in
+	constexpr GSVector4i()
+		: u64{0, 0}
 	{
-		x = 0;
-		y = 0;
-		z = 0;
-		w = 0;
 	}
 
 	__forceinline GSVector4i(int x, int y, int z, int w)
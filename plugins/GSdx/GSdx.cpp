@@ -22,6 +22,7 @@
 #include "stdafx.h"
 #include "GSdx.h"
 #include "GS.h"
+#include "GSKernels.h"
 #include <fstream>
 
 #ifdef _WIN32
@@ -341,12 +342,16 @@ void GSdxApp::Init()
 	m_default_configuration["disable_hw_gl_draw"]                         = "0";
 	m_default_configuration["dithering_ps2"]                              = "2";
 	m_default_configuration["dump"]                                       = "0";
+	m_default_configuration["dump_compression_threads"]                   = "1";
 	m_default_configuration["extrathreads"]                               = "2";
 	m_default_configuration["extrathreads_height"]                        = "4";
+	m_default_configuration["extrathreads_tiles"]                         = "0";
 	m_default_configuration["filter"]                                     = std::to_string(static_cast<int8>(BiFiltering::PS2));
 	m_default_configuration["force_texture_clear"]                        = "0";
 	m_default_configuration["fxaa"]                                       = "0";
+	m_default_configuration["hiz_sw"]                                     = "0";
 	m_default_configuration["interlace"]                                  = "7";
+	m_default_configuration["kernel_isa"]                                 = std::to_string(static_cast<int>(GSKernelISA_Auto));
 	m_default_configuration["large_framebuffer"]                          = "0";
 	m_default_configuration["linear_present"]                             = "1";
 	m_default_configuration["MaxAnisotropy"]                              = "0";
@@ -405,6 +410,7 @@ void GSdxApp::Init()
 	m_default_configuration["shaderfx"]                                   = "0";
 	m_default_configuration["shaderfx_conf"]                              = "shaders/GSdx_FX_Settings.ini";
 	m_default_configuration["shaderfx_glsl"]                              = "shaders/GSdx.fx";
+	m_default_configuration["sw_jit_cache"]                               = "1";
 	m_default_configuration["TVShader"]                                   = "0";
 	m_default_configuration["upscale_multiplier"]                         = "1";
 	m_default_configuration["UserHacks"]                                  = "0";
@@ -512,6 +518,13 @@ void GSdxApp::SetConfigDir(const char* dir)
 	}
 }
 
+std::string GSdxApp::GetConfigDir() const
+{
+	size_t pos = m_ini.find_last_of("/\\");
+
+	return pos != std::string::npos ? m_ini.substr(0, pos + 1) : std::string();
+}
+
 std::string GSdxApp::GetConfigS(const char* entry)
 {
 	char buff[4096] = {0};
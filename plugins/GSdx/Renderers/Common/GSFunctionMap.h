@@ -154,12 +154,23 @@ public:
 	}
 };
 
+// Functions of the current game (since the last BeginSession) compiled ahead of their first
+// use (Prewarm), and on the spot
+struct GSCodeGeneratorStats
+{
+	size_t prewarmed, prewarmed_used, lazy;
+};
+
 template<class CG, class KEY, class VALUE>
 class GSCodeGeneratorFunctionMap : public GSFunctionMap<KEY, VALUE>
 {
 	std::string m_name;
 	void* m_param;
 	std::unordered_map<uint64, VALUE> m_cgmap;
+	std::unordered_set<uint64> m_session; // keys of the current game, prewarmed or compiled while it runs
+	std::unordered_set<uint64> m_prewarmed; // prewarmed and not used yet
+	size_t m_prewarmed_count;
+	size_t m_lazy_count;
 	GSCodeBuffer m_cb;
 	size_t m_total_code_size;
 
@@ -169,6 +180,8 @@ public:
 	GSCodeGeneratorFunctionMap(const char* name, void* param)
 		: m_name(name)
 		, m_param(param)
+		, m_prewarmed_count(0)
+		, m_lazy_count(0)
 		, m_total_code_size(0)
 	{
 	}
@@ -182,15 +195,28 @@ public:
 
 	VALUE GetDefaultFunction(KEY key)
 	{
-		VALUE ret = NULL;
-
 		auto i = m_cgmap.find(key);
 
 		if(i != m_cgmap.end())
 		{
-			ret = i->second;
+			m_session.insert(key); // may have been compiled for a previous game
+			m_prewarmed.erase(key);
+
+			return i->second;
 		}
-		else
+
+		m_lazy_count++;
+
+		return Compile(key);
+	}
+
+private:
+	VALUE Compile(KEY key)
+	{
+		VALUE ret = NULL;
+
+		m_session.insert(key);
+
 		{
 			void* code_ptr = m_cb.GetBuffer(MAX_SIZE);
 
@@ -256,4 +282,52 @@ public:
 
 		return ret;
 	}
+
+public:
+	// Another game starts, the functions compiled for the previous ones stay but aren't its own.
+	// The active functions are forgotten too, so their first use goes through GetDefaultFunction.
+	void BeginSession()
+	{
+		for(auto& i : this->m_map_active) delete i.second;
+
+		this->m_map_active.clear();
+		this->m_active = NULL;
+
+		m_session.clear();
+		m_prewarmed.clear();
+		m_prewarmed_count = 0;
+		m_lazy_count = 0;
+	}
+
+	// Compiles the function of a key before it's needed, so the draw using it doesn't have to
+	void Prewarm(KEY key)
+	{
+		if(m_cgmap.find(key) == m_cgmap.end())
+		{
+			Compile(key);
+
+			m_prewarmed.insert(key);
+			m_prewarmed_count++;
+		}
+		else
+		{
+			m_session.insert(key);
+		}
+	}
+
+	// Keys of the current game, prewarmed or compiled while it runs
+	void GetKeys(std::vector<uint64>& keys) const
+	{
+		for(uint64 key : m_session)
+		{
+			keys.push_back(key);
+		}
+	}
+
+	void GetStats(GSCodeGeneratorStats& stats) const
+	{
+		stats.prewarmed += m_prewarmed_count;
+		stats.prewarmed_used += m_prewarmed_count - m_prewarmed.size();
+		stats.lazy += m_lazy_count;
+	}
 };
@@ -383,7 +383,7 @@ void GSRenderer::VSync(int field)
 
 				int sum = 0;
 
-				for(int i = 0; i < 16; i++)
+				for(int i = 0; i < GSPerfMon::WorkerLast; i++)
 				{
 					sum += m_perfmon.CPU(GSPerfMon::WorkerDraw0 + i);
 				}
@@ -473,7 +473,19 @@ void GSRenderer::VSync(int field)
 	else if(m_dump)
 	{
 		if(m_dump->VSync(field, !m_control_key, m_regs))
+		{
 			m_dump.reset();
+		}
+		else if(m_dump->NeedsState())
+		{
+			GSFreezeData fd = {0, nullptr};
+			Freeze(&fd, true);
+			std::vector<uint8> state(fd.size);
+			fd.data = state.data();
+			Freeze(&fd, false);
+
+			m_dump->State(fd, m_regs);
+		}
 	}
 	// capture
 
@@ -41,14 +41,8 @@ public:
 protected:
 	const GSState* m_state;
 
-	static GSVector4 s_minmax;
-
-	typedef void (GSVertexTrace::*FindMinMaxPtr)(const void* vertex, const uint32* index, int count);
-
-	FindMinMaxPtr m_fmm[2][2][2][2][2][4];
-
-	template<GS_PRIM_CLASS primclass, uint32 iip, uint32 tme, uint32 fst, uint32 color, uint32 accurate_stq>
-	void FindMinMax(const void* vertex, const uint32* index, int count);
+	// The loop over the vertices is in GSKernels
+	void FindMinMax(const void* vertex, const uint32* index, int count, GS_PRIM_CLASS primclass, uint32 iip, uint32 tme, uint32 fst, uint32 color);
 
 public:
 	GS_PRIM_CLASS m_primclass;
@@ -72,8 +66,6 @@ public:
 	GSVector2 m_lod; // x = min, y = max
 
 public:
-	static void InitVectors();
-
 	GSVertexTrace(const GSState* state);
 	virtual ~GSVertexTrace() {}
 
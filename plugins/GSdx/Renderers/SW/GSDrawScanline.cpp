@@ -109,6 +109,37 @@ void GSDrawScanline::BeginDraw(const GSRasterizerData* data)
 	m_sp = m_sp_map[sel];
 }
 
+void GSDrawScanline::BeginJitSession()
+{
+	m_sp_map.BeginSession();
+	m_ds_map.BeginSession();
+}
+
+void GSDrawScanline::GetJitKeys(GSJitKeys& keys) const
+{
+	m_sp_map.GetKeys(keys.sp);
+	m_ds_map.GetKeys(keys.ds);
+}
+
+void GSDrawScanline::Prewarm(const GSJitKeys& keys)
+{
+	for(uint64 key : keys.sp)
+	{
+		m_sp_map.Prewarm(key);
+	}
+
+	for(uint64 key : keys.ds)
+	{
+		m_ds_map.Prewarm(key);
+	}
+}
+
+void GSDrawScanline::GetJitStats(GSCodeGeneratorStats& stats) const
+{
+	m_sp_map.GetStats(stats);
+	m_ds_map.GetStats(stats);
+}
+
 void GSDrawScanline::EndDraw(uint64 frame, uint64 ticks, int actual, int total)
 {
 	m_ds_map.UpdateStats(frame, ticks, actual, total);
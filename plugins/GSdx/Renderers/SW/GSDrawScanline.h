@@ -87,4 +87,9 @@ public:
 #endif
 
 	void PrintStats() {m_ds_map.PrintStats();}
+
+	void BeginJitSession();
+	void GetJitKeys(GSJitKeys& keys) const;
+	void Prewarm(const GSJitKeys& keys);
+	void GetJitStats(GSCodeGeneratorStats& stats) const;
 };
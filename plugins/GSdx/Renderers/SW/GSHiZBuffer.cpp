@@ -0,0 +1,374 @@
+/*
+ *  Copyright (C) 2021 PCSX2 Dev Team
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GNU Make; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "stdafx.h"
+#include "GSHiZBuffer.h"
+#include "GSLocalMemory.h"
+#include "GSUtil.h"
+
+GSHiZBuffer::GSHiZBuffer()
+{
+	memset(m_zmin, 0, sizeof(m_zmin));
+	memset(m_page, 0, sizeof(m_page));
+	memset(m_pages, 0, sizeof(m_pages));
+
+	Reset();
+}
+
+void GSHiZBuffer::Reset()
+{
+	Invalidate(NULL);
+
+	m_bp = 0xffffffff;
+	m_bw = 0;
+	m_psm = 0;
+	m_zmax = 0;
+	m_rect = GSVector4i::zero();
+}
+
+void GSHiZBuffer::Bind(uint32 bp, uint32 bw, uint32 psm)
+{
+	if(bp == m_bp && bw == m_bw && psm == m_psm)
+	{
+		return;
+	}
+
+	Reset();
+
+	m_bp = bp;
+	m_bw = bw;
+	m_psm = psm;
+	m_zmax = 0xffffffff >> (GSLocalMemory::m_psm[psm].fmt * 8);
+
+	// Tiles further than the width of the buffer, or after the end of the memory, are the same
+	// memory as other tiles. Drawing there must forget everything (see Update).
+
+	GSLocalMemory::pixelAddress bn = GSLocalMemory::m_psm[psm].bn;
+
+	int w = std::min<int>(bw * 64, 2048);
+	int h = 0;
+
+	if(w > 0 && (bp & 31) == 0)
+	{
+		for(int y = 0; y < 2048; y += TILE_SIZE)
+		{
+			if((bn(w - 1, y + TILE_SIZE - 1, bp, bw) >> 5) >= MAX_PAGES)
+			{
+				break;
+			}
+
+			for(int x = 0; x < 2048; x += TILE_SIZE)
+			{
+				m_page[(y >> TILE_SHIFT) * TILE_COLS + (x >> TILE_SHIFT)] = (uint16)((bn(x, y, bp, bw) >> 5) % MAX_PAGES);
+			}
+
+			h = y + TILE_SIZE;
+		}
+	}
+
+	m_rect = GSVector4i(0, 0, w, h);
+}
+
+void GSHiZBuffer::Invalidate(const uint32* pages)
+{
+	uint32 mask[MAX_PAGES / 32];
+	uint32 any = 0;
+
+	if(pages == NULL)
+	{
+		// all of them
+
+		for(int i = 0; i < MAX_PAGES / 32; i++)
+		{
+			any |= mask[i] = m_pages[i];
+		}
+	}
+	else
+	{
+		memset(mask, 0, sizeof(mask));
+
+		for(const uint32* RESTRICT p = pages; *p != GSOffset::EOP; p++)
+		{
+			uint32 bit = m_pages[*p >> 5] & (1u << (*p & 31));
+
+			mask[*p >> 5] |= bit;
+			any |= bit;
+		}
+	}
+
+	if(any == 0)
+	{
+		return;
+	}
+
+	for(int i = 0; i < TILE_COLS * TILE_COLS; i++)
+	{
+		if(m_zmin[i] != 0 && (mask[m_page[i] >> 5] & (1u << (m_page[i] & 31))) != 0)
+		{
+			m_zmin[i] = 0;
+		}
+	}
+
+	for(int i = 0; i < MAX_PAGES / 32; i++)
+	{
+		m_pages[i] &= ~mask[i];
+	}
+}
+
+bool GSHiZBuffer::Overlaps(const uint32* pages) const
+{
+	for(const uint32* RESTRICT p = pages; *p != GSOffset::EOP; p++)
+	{
+		if(m_pages[*p >> 5] & (1u << (*p & 31)))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void GSHiZBuffer::SetBound(int i, uint32 z)
+{
+	m_zmin[i] = z;
+
+	if(z != 0)
+	{
+		m_pages[m_page[i] >> 5] |= 1u << (m_page[i] & 31);
+	}
+}
+
+bool GSHiZBuffer::GetPrim(const GSVertex* RESTRICT vertex, const uint32* RESTRICT index, GS_PRIM_CLASS primclass, const GSVector4i& r, const GSVector2i& offset, Prim& prim) const
+{
+	int n = GSUtil::GetClassVertexCount(primclass);
+
+	int xmin = INT_MAX, ymin = INT_MAX, xmax = INT_MIN, ymax = INT_MIN;
+	uint32 zmin = 0xffffffff, zmax = 0;
+
+	for(int i = 0; i < n; i++)
+	{
+		const GSVertex& v = vertex[index[i]];
+
+		int x = (int)v.XYZ.X - offset.x;
+		int y = (int)v.XYZ.Y - offset.y;
+
+		xmin = std::min(xmin, x);
+		ymin = std::min(ymin, y);
+		xmax = std::max(xmax, x);
+		ymax = std::max(ymax, y);
+		zmin = std::min(zmin, v.XYZ.Z);
+		zmax = std::max(zmax, v.XYZ.Z);
+	}
+
+	// One more pixel around it, whatever rule decides which pixels on the edges are drawn
+
+	GSVector4i bbox((xmin >> 4) - 1, (ymin >> 4) - 1, ((xmax + 15) >> 4) + 2, ((ymax + 15) >> 4) + 2);
+
+	bbox = bbox.rintersect(r);
+
+	if(bbox.rempty())
+	{
+		return false;
+	}
+
+	prim.tiles.x = bbox.x >> TILE_SHIFT;
+	prim.tiles.y = bbox.y >> TILE_SHIFT;
+	prim.tiles.z = (bbox.z + TILE_SIZE - 1) >> TILE_SHIFT;
+	prim.tiles.w = (bbox.w + TILE_SIZE - 1) >> TILE_SHIFT;
+
+	// Sprites are drawn with the depth of a vertex. The rasterizer interpolates the depth of
+	// the others as floats, they may end up a little outside of the range of their vertices.
+
+	uint32 margin = primclass != GS_SPRITE_CLASS ? (zmax >> 16) + 16 : 0;
+
+	prim.zmin = std::min(zmin > margin ? zmin - margin : 0, m_zmax);
+	prim.zmax = (uint32)std::min<uint64>((uint64)zmax + margin, m_zmax);
+
+	return true;
+}
+
+bool GSHiZBuffer::Covers(const GSVertex* RESTRICT vertex, const uint32* RESTRICT index, GS_PRIM_CLASS primclass, const GSVector4i& r, const GSVector2i& offset, int x, int y) const
+{
+	GSVector4i tile(x << TILE_SHIFT, y << TILE_SHIFT, (x + 1) << TILE_SHIFT, (y + 1) << TILE_SHIFT);
+
+	if(!tile.rintersect(r).eq(tile))
+	{
+		return false; // scissored
+	}
+
+	// Corners one pixel outside of the tile, in 1/16 of pixels
+
+	tile = (tile + GSVector4i(-1, -1, 1, 1)) << 4;
+
+	if(primclass == GS_SPRITE_CLASS)
+	{
+		const GSVertex& v0 = vertex[index[0]];
+		const GSVertex& v1 = vertex[index[1]];
+
+		int x0 = (int)v0.XYZ.X - offset.x;
+		int y0 = (int)v0.XYZ.Y - offset.y;
+		int x1 = (int)v1.XYZ.X - offset.x;
+		int y1 = (int)v1.XYZ.Y - offset.y;
+
+		return std::min(x0, x1) <= tile.x && std::max(x0, x1) >= tile.z
+			&& std::min(y0, y1) <= tile.y && std::max(y0, y1) >= tile.w;
+	}
+
+	if(primclass == GS_TRIANGLE_CLASS)
+	{
+		int64 px[3], py[3];
+
+		for(int i = 0; i < 3; i++)
+		{
+			px[i] = (int64)vertex[index[i]].XYZ.X - offset.x;
+			py[i] = (int64)vertex[index[i]].XYZ.Y - offset.y;
+		}
+
+		int64 area = (px[1] - px[0]) * (py[2] - py[0]) - (py[1] - py[0]) * (px[2] - px[0]);
+
+		if(area == 0)
+		{
+			return false;
+		}
+
+		// The triangle is convex, it covers the tile when it has all four corners inside
+
+		const int64 cx[4] = {tile.x, tile.z, tile.x, tile.z};
+		const int64 cy[4] = {tile.y, tile.y, tile.w, tile.w};
+
+		for(int i = 0; i < 3; i++)
+		{
+			int j = i < 2 ? i + 1 : 0;
+
+			for(int k = 0; k < 4; k++)
+			{
+				int64 e = (px[j] - px[i]) * (cy[k] - py[i]) - (py[j] - py[i]) * (cx[k] - px[i]);
+
+				if(area > 0 ? e <= 0 : e >= 0)
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+int GSHiZBuffer::Cull(const GSVertex* vertex, uint32* index, int index_count, GS_PRIM_CLASS primclass, const GSVector4i& r, const GSVector2i& offset, uint32 ztst)
+{
+	ASSERT(ztst == ZTST_GEQUAL || ztst == ZTST_GREATER);
+
+	if(!r.rintersect(m_rect).eq(r))
+	{
+		return index_count;
+	}
+
+	int n = GSUtil::GetClassVertexCount(primclass);
+	int count = 0;
+
+	for(int i = 0; i < index_count; i += n)
+	{
+		Prim prim;
+
+		bool visible = true;
+
+		if(GetPrim(vertex, &index[i], primclass, r, offset, prim))
+		{
+			visible = false;
+
+			for(int y = prim.tiles.y; y < prim.tiles.w && !visible; y++)
+			{
+				for(int x = prim.tiles.x; x < prim.tiles.z; x++)
+				{
+					if(prim.zmax >= m_zmin[y * TILE_COLS + x])
+					{
+						visible = true;
+
+						break;
+					}
+				}
+			}
+		}
+
+		if(visible)
+		{
+			for(int j = 0; j < n; j++)
+			{
+				index[count++] = index[i + j];
+			}
+		}
+	}
+
+	return count;
+}
+
+void GSHiZBuffer::Update(const GSVertex* vertex, const uint32* index, int index_count, GS_PRIM_CLASS primclass, const GSVector4i& r, const GSVector2i& offset, uint32 ztst, bool cover)
+{
+	if(!r.rintersect(m_rect).eq(r))
+	{
+		Invalidate(NULL);
+
+		return;
+	}
+
+	int n = GSUtil::GetClassVertexCount(primclass);
+
+	for(int i = 0; i < index_count; i += n)
+	{
+		Prim prim;
+
+		if(!GetPrim(vertex, &index[i], primclass, r, offset, prim))
+		{
+			continue;
+		}
+
+		for(int y = prim.tiles.y; y < prim.tiles.w; y++)
+		{
+			for(int x = prim.tiles.x; x < prim.tiles.z; x++)
+			{
+				int t = y * TILE_COLS + x;
+
+				bool covered = cover && Covers(vertex, &index[i], primclass, r, offset, x, y);
+
+				if(ztst == ZTST_ALWAYS)
+				{
+					// Anything written has the depth of the primitive
+
+					if(covered || prim.zmin < m_zmin[t])
+					{
+						SetBound(t, prim.zmin);
+					}
+				}
+				else
+				{
+					// Every pixel ends up with the greater of its depth and the primitive's
+
+					if(covered && prim.zmin > m_zmin[t])
+					{
+						SetBound(t, prim.zmin);
+					}
+				}
+			}
+		}
+	}
+}
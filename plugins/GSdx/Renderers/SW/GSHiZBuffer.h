@@ -0,0 +1,80 @@
+/*
+ *  Copyright (C) 2021 PCSX2 Dev Team
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GNU Make; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#pragma once
+
+#include "GS.h"
+#include "Renderers/Common/GSVertex.h"
+
+// Coarse depth of the z buffer in use, a lower bound of the depth of every 32x32 tile of it.
+// The GS passes pixels with a greater (or equal) depth, so a primitive whose depth is below
+// the bound of all the tiles it touches can't draw anything and is dropped before it gets to
+// the rasterizer.
+//
+// The bounds are kept up to date on the GS thread as draws are queued, from their primitives
+// alone: depth only grows under a GEQUAL/GREATER test, and a tile gets a higher bound when a
+// primitive covers all of it and nothing can keep its pixels from being written. Anything
+// else writing to the pages of a tile (transfers, frame buffers on top of the z buffer) puts
+// its bound back to 0, which culls nothing.
+
+class GSHiZBuffer
+{
+	static const int TILE_SHIFT = 5;
+	static const int TILE_SIZE = 1 << TILE_SHIFT;
+	static const int TILE_COLS = 2048 >> TILE_SHIFT;
+
+	struct Prim
+	{
+		GSVector4i tiles; // touched, exclusive
+		uint32 zmin, zmax;
+	};
+
+	uint32 m_zmin[TILE_COLS * TILE_COLS];
+	uint16 m_page[TILE_COLS * TILE_COLS];
+	uint32 m_pages[MAX_PAGES / 32]; // pages of the tiles with a bound above 0
+
+	uint32 m_bp, m_bw, m_psm;
+	uint32 m_zmax; // of the format
+	GSVector4i m_rect; // where the tiles don't alias each other, in pixels
+
+	bool GetPrim(const GSVertex* RESTRICT vertex, const uint32* RESTRICT index, GS_PRIM_CLASS primclass, const GSVector4i& r, const GSVector2i& offset, Prim& prim) const;
+	bool Covers(const GSVertex* RESTRICT vertex, const uint32* RESTRICT index, GS_PRIM_CLASS primclass, const GSVector4i& r, const GSVector2i& offset, int x, int y) const;
+	void SetBound(int i, uint32 z);
+
+public:
+	GSHiZBuffer();
+
+	void Reset();
+
+	// The z buffer of the next draws (FRAME.FBW is its width too)
+	void Bind(uint32 bp, uint32 bw, uint32 psm);
+
+	// Pages written by something else than the z test of the bound buffer
+	void Invalidate(const uint32* pages);
+	bool Overlaps(const uint32* pages) const;
+
+	// r is the scissored bounding box of the draw, offset is XYOFFSET. Removes the primitives
+	// failing ztst (GEQUAL or GREATER) everywhere and returns the number of indices left.
+	int Cull(const GSVertex* vertex, uint32* index, int index_count, GS_PRIM_CLASS primclass, const GSVector4i& r, const GSVector2i& offset, uint32 ztst);
+
+	// After a draw writing z. cover when every pixel passing ztst is sure to be written (no
+	// alpha test skipping z, DATE or antialiasing).
+	void Update(const GSVertex* vertex, const uint32* index, int index_count, GS_PRIM_CLASS primclass, const GSVector4i& r, const GSVector2i& offset, uint32 ztst, bool cover);
+};
@@ -26,6 +26,34 @@
 
 int GSRasterizerData::s_counter = 0;
 
+GSRasterizerWork::GSRasterizerWork(int count, const std::function<void(int)>& func)
+	: m_func(func)
+	, m_count(count)
+	, m_next(0)
+	, m_done(0)
+{
+}
+
+void GSRasterizerWork::Run()
+{
+	for(int i = m_next++; i < m_count; i = m_next++)
+	{
+		m_func(i);
+
+		m_done++;
+	}
+}
+
+void GSRasterizerWork::Wait()
+{
+	// the parts are short, the others are about to finish theirs
+
+	while(m_done < m_count)
+	{
+		std::this_thread::yield();
+	}
+}
+
 static int compute_best_thread_height(int threads) {
 	// - for more threads screen segments should be smaller to better distribute the pixels
 	// - but not too small to keep the threading overhead low
@@ -43,6 +71,7 @@ GSRasterizer::GSRasterizer(IDrawScanline* ds, int id, int threads, GSPerfMon* pe
 	: m_perfmon(perfmon)
 	, m_ds(ds)
 	, m_id(id)
+	, m_timer(GSPerfMon::WorkerDraw0 + id)
 	, m_threads(threads)
 {
 	memset(&m_pixels, 0, sizeof(m_pixels));
@@ -133,9 +162,30 @@ int GSRasterizer::GetPixels(bool reset)
 
 void GSRasterizer::Draw(GSRasterizerData* data)
 {
-	GSPerfMonAutoTimer pmat(m_perfmon, GSPerfMon::WorkerDraw0 + m_id);
+	if(data->work)
+	{
+		data->work->Run();
 
-	if(data->vertex != NULL && data->vertex_count == 0 || data->index != NULL && data->index_count == 0) return;
+		return;
+	}
+
+	Draw(data, data->scissor, data->index, data->index_count);
+}
+
+void GSRasterizer::Run(int count, const std::function<void(int)>& func)
+{
+	for(int i = 0; i < count; i++)
+	{
+		func(i);
+	}
+}
+
+// Draws the primitives of index (a subset of data->index when binned) clipped to scissor
+void GSRasterizer::Draw(GSRasterizerData* data, const GSVector4i& scissor, const uint32* index, int index_count)
+{
+	GSPerfMonAutoTimer pmat(m_perfmon, m_timer);
+
+	if(data->vertex != NULL && data->vertex_count == 0 || index != NULL && index_count == 0) return;
 
 	m_pixels.actual = 0;
 	m_pixels.total = 0;
@@ -147,16 +197,15 @@ void GSRasterizer::Draw(GSRasterizerData* data)
 	const GSVertexSW* vertex = data->vertex;
 	const GSVertexSW* vertex_end = data->vertex + data->vertex_count;
 
-	const uint32* index = data->index;
-	const uint32* index_end = data->index + data->index_count;
+	const uint32* index_end = index + index_count;
 
 	uint32 tmp_index[] = {0, 1, 2};
 
-	bool scissor_test = !data->bbox.eq(data->bbox.rintersect(data->scissor));
+	bool scissor_test = !data->bbox.eq(data->bbox.rintersect(scissor));
 
-	m_scissor = data->scissor;
-	m_fscissor_x = GSVector4(data->scissor).xzxz();
-	m_fscissor_y = GSVector4(data->scissor).ywyw();
+	m_scissor = scissor;
+	m_fscissor_x = GSVector4(scissor).xzxz();
+	m_fscissor_y = GSVector4(scissor).ywyw();
 
 	switch(data->primclass)
 	{
@@ -164,11 +213,11 @@ void GSRasterizer::Draw(GSRasterizerData* data)
 
 		if(scissor_test)
 		{
-			DrawPoint<true>(vertex, data->vertex_count, index, data->index_count);
+			DrawPoint<true>(vertex, data->vertex_count, index, index_count);
 		}
 		else
 		{
-			DrawPoint<false>(vertex, data->vertex_count, index, data->index_count);
+			DrawPoint<false>(vertex, data->vertex_count, index, index_count);
 		}
 
 		break;
@@ -1156,6 +1205,16 @@ GSRasterizerList::GSRasterizerList(int threads, GSPerfMon* perfmon)
 	}
 }
 
+// Every worker compiles its own copy of the functions it uses
+static void RemoveDuplicateJitKeys(GSJitKeys& keys)
+{
+	std::sort(keys.sp.begin(), keys.sp.end());
+	keys.sp.erase(std::unique(keys.sp.begin(), keys.sp.end()), keys.sp.end());
+
+	std::sort(keys.ds.begin(), keys.ds.end());
+	keys.ds.erase(std::unique(keys.ds.begin(), keys.ds.end()), keys.ds.end());
+}
+
 GSRasterizerList::~GSRasterizerList()
 {
 	_aligned_free(m_scanline);
@@ -1213,3 +1272,509 @@ int GSRasterizerList::GetPixels(bool reset)
 
 	return pixels;
 }
+
+void GSRasterizerList::GetJitKeys(GSJitKeys& keys) const
+{
+	for(const auto& r : m_r)
+	{
+		r->GetJitKeys(keys);
+	}
+
+	RemoveDuplicateJitKeys(keys);
+}
+
+void GSRasterizerList::BeginJitSession()
+{
+	for(auto& r : m_r)
+	{
+		r->BeginJitSession();
+	}
+}
+
+void GSRasterizerList::Prewarm(const GSJitKeys& keys)
+{
+	for(auto& r : m_r)
+	{
+		r->Prewarm(keys);
+	}
+}
+
+void GSRasterizerList::GetJitStats(GSCodeGeneratorStats& stats) const
+{
+	for(const auto& r : m_r)
+	{
+		r->GetJitStats(stats);
+	}
+}
+
+void GSRasterizerList::Run(int count, const std::function<void(int)>& func)
+{
+	ASSERT(IsSynced());
+
+	std::shared_ptr<GSRasterizerData> data(new GSRasterizerData());
+
+	data->work = std::make_shared<GSRasterizerWork>(count, func);
+
+	for(size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i]->Push(data);
+	}
+
+	data->work->Run();
+	data->work->Wait();
+
+	// the workers which didn't get to it in time have nothing left to do
+
+	for(size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i]->Wait();
+	}
+}
+
+//
+
+GSRasterizerTiles::GSRasterizerTiles(int threads, GSPerfMon* perfmon)
+	: m_perfmon(perfmon)
+	, m_tiles(new Tile[TILE_COLS * TILE_COLS])
+	, m_pending(0)
+	, m_ready(0)
+	, m_idle(0)
+	, m_exit(false)
+{
+	for(int i = 0; i < TILE_COLS * TILE_COLS; i++)
+	{
+		int x = (i % TILE_COLS) << TILE_SHIFT;
+		int y = (i / TILE_COLS) << TILE_SHIFT;
+
+		m_tiles[i].scheduled = false;
+		m_tiles[i].rect = GSVector4i(x, y, x + TILE_SIZE, y + TILE_SIZE);
+	}
+}
+
+GSRasterizerTiles::~GSRasterizerTiles()
+{
+	Sync();
+
+	{
+		std::lock_guard<std::mutex> l(m_lock);
+		m_exit = true;
+	}
+	m_notempty.notify_all();
+
+	for(auto& w : m_workers)
+	{
+		w->thread.join();
+	}
+}
+
+void GSRasterizerTiles::Start()
+{
+	for(size_t i = 0; i < m_r.size(); i++)
+	{
+		m_workers.push_back(std::unique_ptr<Worker>(new Worker()));
+		m_workers[i]->steals = 0;
+	}
+
+	// Threads last, they steal from each other's queues
+	for(size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i]->thread = std::thread(&GSRasterizerTiles::ThreadProc, this, (int)i);
+	}
+}
+
+void GSRasterizerTiles::ThreadProc(int id)
+{
+	GSRasterizer* r = m_r[id].get();
+
+	std::shared_ptr<GSRasterizerWork> work; // the last one run, m_work is only cleared once it is done
+
+	while(true)
+	{
+		int tile;
+
+		if(PopTile(id, tile))
+		{
+			DrawTile(r, tile);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> l(m_lock);
+
+		m_idle++;
+
+		// Pairs with the m_ready/m_idle check in PushJob
+		while(m_ready == 0 && !m_exit && (m_work == NULL || m_work == work))
+		{
+			m_notempty.wait(l);
+		}
+
+		m_idle--;
+
+		if(m_exit && m_ready == 0)
+		{
+			return;
+		}
+
+		if(m_work != NULL && m_work != work)
+		{
+			work = m_work;
+
+			l.unlock();
+
+			work->Run();
+		}
+	}
+}
+
+bool GSRasterizerTiles::PopTile(int id, int& tile)
+{
+	if(m_ready == 0)
+	{
+		return false;
+	}
+
+	const int count = (int)m_workers.size();
+
+	// Own queue from the front, the others from the back
+	for(int i = 0; i < count; i++)
+	{
+		Worker* w = m_workers[(id + i) % count].get();
+
+		std::lock_guard<std::mutex> l(w->lock);
+
+		if(!w->tiles.empty())
+		{
+			if(i == 0)
+			{
+				tile = w->tiles.front();
+				w->tiles.pop_front();
+			}
+			else
+			{
+				tile = w->tiles.back();
+				w->tiles.pop_back();
+				m_workers[id]->steals.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			m_ready--;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void GSRasterizerTiles::DrawTile(GSRasterizer* r, int tile)
+{
+	Tile& t = m_tiles[tile];
+
+	while(true)
+	{
+		Job job;
+
+		{
+			std::lock_guard<std::mutex> l(t.lock);
+
+			if(t.jobs.empty())
+			{
+				t.scheduled = false;
+				break;
+			}
+
+			job = std::move(t.jobs.front());
+			t.jobs.pop_front();
+		}
+
+		GSRasterizerData* data = job.bins->data.get();
+
+		r->Draw(data, data->scissor.rintersect(t.rect), job.index, job.index_count);
+
+		// The renderer waits for the data to be released
+		job.bins.reset();
+
+		if(--m_pending == 0)
+		{
+			{
+				std::lock_guard<std::mutex> l(m_wait_lock);
+			}
+			m_empty.notify_one();
+		}
+	}
+}
+
+void GSRasterizerTiles::PushJob(int tile, const std::shared_ptr<Bins>& bins, const uint32* index, int index_count)
+{
+	Tile& t = m_tiles[tile];
+
+	m_pending++;
+
+	{
+		std::lock_guard<std::mutex> l(t.lock);
+
+		t.jobs.push_back(Job{bins, index, index_count});
+
+		if(t.scheduled)
+		{
+			return; // the worker drawing it will get there
+		}
+
+		t.scheduled = true;
+	}
+
+	// Tiles stick to the same worker, unless stolen
+	Worker* w = m_workers[tile % m_workers.size()].get();
+
+	{
+		std::lock_guard<std::mutex> l(w->lock);
+		w->tiles.push_back(tile);
+	}
+
+	m_ready++;
+
+	if(m_idle > 0)
+	{
+		{
+			std::lock_guard<std::mutex> l(m_lock);
+		}
+		m_notempty.notify_one();
+	}
+}
+
+void GSRasterizerTiles::Queue(const std::shared_ptr<GSRasterizerData>& data)
+{
+	GSVector4i r = data->bbox.rintersect(data->scissor);
+
+	ASSERT(r.top >= 0 && r.top < 2048 && r.bottom >= 0 && r.bottom < 2048);
+
+	if(r.rempty())
+	{
+		return;
+	}
+
+	GSVector4i tr(r.left >> TILE_SHIFT, r.top >> TILE_SHIFT, (r.right + TILE_SIZE - 1) >> TILE_SHIFT, (r.bottom + TILE_SIZE - 1) >> TILE_SHIFT);
+
+	int cols = tr.width();
+	int rows = tr.height();
+	int n = 0;
+
+	switch(data->primclass)
+	{
+	case GS_POINT_CLASS: n = 1; break;
+	case GS_LINE_CLASS: n = 2; break;
+	case GS_TRIANGLE_CLASS: n = 3; break;
+	case GS_SPRITE_CLASS: n = 2; break;
+	default: __assume(0);
+	}
+
+	std::shared_ptr<Bins> bins = std::make_shared<Bins>();
+
+	bins->data = data;
+
+	if(cols * rows == 1 || data->index == NULL || data->index_count <= n)
+	{
+		// Nothing to bin, every tile goes through all the primitives
+
+		for(int y = tr.top; y < tr.bottom; y++)
+		{
+			for(int x = tr.left; x < tr.right; x++)
+			{
+				PushJob(y * TILE_COLS + x, bins, data->index, data->index_count);
+			}
+		}
+
+		m_perfmon->Put(GSPerfMon::TileJob, cols * rows);
+
+		return;
+	}
+
+	const GSVertexSW* vertex = data->vertex;
+	const uint32* index = data->index;
+	const int prims = data->index_count / n;
+
+	m_prim_tiles.resize(prims);
+	m_bin_offset.assign(cols * rows + 1, 0);
+
+	// Tiles touched by each primitive, with a pixel of margin for the rounding and the edges
+
+	const GSVector4i margin(-1, -1, 2, 2);
+	const GSVector4i origin = tr.xyxy();
+
+	for(int i = 0; i < prims; i++, index += n)
+	{
+		GSVector4 pmin = vertex[index[0]].p;
+		GSVector4 pmax = pmin;
+
+		for(int j = 1; j < n; j++)
+		{
+			pmin = pmin.min(vertex[index[j]].p);
+			pmax = pmax.max(vertex[index[j]].p);
+		}
+
+		GSVector4i b = (GSVector4i(pmin.xyxy(pmax).floor()) + margin).rintersect(r);
+
+		if(b.rempty())
+		{
+			m_prim_tiles[i] = GSVector4i::zero();
+			continue;
+		}
+
+		b = GSVector4i(b.left >> TILE_SHIFT, b.top >> TILE_SHIFT, ((b.right - 1) >> TILE_SHIFT) + 1, ((b.bottom - 1) >> TILE_SHIFT) + 1) - origin;
+
+		m_prim_tiles[i] = b;
+
+		for(int y = b.top; y < b.bottom; y++)
+		{
+			for(int x = b.left; x < b.right; x++)
+			{
+				m_bin_offset[y * cols + x + 1] += n;
+			}
+		}
+	}
+
+	for(int i = 0; i < cols * rows; i++)
+	{
+		m_bin_offset[i + 1] += m_bin_offset[i];
+	}
+
+	bins->index.resize(m_bin_offset[cols * rows]);
+
+	// Fill the bins in primitive order
+
+	std::vector<int> fill(m_bin_offset.begin(), m_bin_offset.end() - 1);
+
+	index = data->index;
+
+	for(int i = 0; i < prims; i++, index += n)
+	{
+		const GSVector4i& b = m_prim_tiles[i];
+
+		for(int y = b.top; y < b.bottom; y++)
+		{
+			for(int x = b.left; x < b.right; x++)
+			{
+				int& pos = fill[y * cols + x];
+
+				for(int j = 0; j < n; j++)
+				{
+					bins->index[pos++] = index[j];
+				}
+			}
+		}
+	}
+
+	int jobs = 0;
+
+	for(int y = 0; y < rows; y++)
+	{
+		for(int x = 0; x < cols; x++)
+		{
+			int i = y * cols + x;
+			int count = m_bin_offset[i + 1] - m_bin_offset[i];
+
+			if(count > 0)
+			{
+				PushJob((tr.top + y) * TILE_COLS + tr.left + x, bins, &bins->index[m_bin_offset[i]], count);
+
+				jobs++;
+			}
+		}
+	}
+
+	m_perfmon->Put(GSPerfMon::TileJob, jobs);
+}
+
+void GSRasterizerTiles::Sync()
+{
+	if(!IsSynced())
+	{
+		std::unique_lock<std::mutex> l(m_wait_lock);
+
+		while(m_pending > 0)
+		{
+			m_empty.wait(l);
+		}
+
+		m_perfmon->Put(GSPerfMon::SyncPoint, 1);
+	}
+
+	for(auto& w : m_workers)
+	{
+		if(int steals = w->steals.exchange(0, std::memory_order_relaxed))
+		{
+			m_perfmon->Put(GSPerfMon::TileSteal, steals);
+		}
+	}
+}
+
+void GSRasterizerTiles::Run(int count, const std::function<void(int)>& func)
+{
+	ASSERT(IsSynced());
+
+	std::shared_ptr<GSRasterizerWork> work = std::make_shared<GSRasterizerWork>(count, func);
+
+	{
+		std::lock_guard<std::mutex> l(m_lock);
+		m_work = work;
+	}
+	m_notempty.notify_all();
+
+	work->Run();
+	work->Wait();
+
+	{
+		std::lock_guard<std::mutex> l(m_lock);
+		m_work.reset();
+	}
+}
+
+bool GSRasterizerTiles::IsSynced() const
+{
+	return m_pending == 0;
+}
+
+int GSRasterizerTiles::GetPixels(bool reset)
+{
+	int pixels = 0;
+
+	for(size_t i = 0; i < m_r.size(); i++)
+	{
+		pixels += m_r[i]->GetPixels(reset);
+	}
+
+	return pixels;
+}
+
+void GSRasterizerTiles::GetJitKeys(GSJitKeys& keys) const
+{
+	for(const auto& r : m_r)
+	{
+		r->GetJitKeys(keys);
+	}
+
+	RemoveDuplicateJitKeys(keys);
+}
+
+void GSRasterizerTiles::BeginJitSession()
+{
+	for(auto& r : m_r)
+	{
+		r->BeginJitSession();
+	}
+}
+
+void GSRasterizerTiles::Prewarm(const GSJitKeys& keys)
+{
+	for(auto& r : m_r)
+	{
+		r->Prewarm(keys);
+	}
+}
+
+void GSRasterizerTiles::GetJitStats(GSCodeGeneratorStats& stats) const
+{
+	for(const auto& r : m_r)
+	{
+		r->GetJitStats(stats);
+	}
+}
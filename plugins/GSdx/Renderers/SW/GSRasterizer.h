@@ -28,6 +28,22 @@
 #include "GSPerfMon.h"
 #include "GSThread_CXX11.h"
 
+// Independent parts of some work other than drawing (swizzling a large transfer), taken by
+// the workers and the thread which waits for them, see IRasterizer::Run
+class GSRasterizerWork
+{
+	std::function<void(int)> m_func;
+	int m_count;
+	std::atomic<int> m_next;
+	std::atomic<int> m_done;
+
+public:
+	GSRasterizerWork(int count, const std::function<void(int)>& func);
+
+	void Run(); // parts until there are none left
+	void Wait();
+};
+
 class alignas(32) GSRasterizerData : public GSAlignedClass<32>
 {
 	static int s_counter;
@@ -45,6 +61,7 @@ public:
 	uint64 start;
 	int pixels;
 	int counter;
+	std::shared_ptr<GSRasterizerWork> work; // instead of drawing
 
 	GSRasterizerData() 
 		: scissor(GSVector4i::zero())
@@ -68,6 +85,12 @@ public:
 	}
 };
 
+// Selectors of the SetupPrim and DrawScanline functions compiled by the JIT
+struct GSJitKeys
+{
+	std::vector<uint64> sp, ds;
+};
+
 class IDrawScanline : public GSAlignedClass<32>
 {
 public:
@@ -106,6 +129,11 @@ public:
 
 	virtual void PrintStats() = 0;
 
+	virtual void BeginJitSession() = 0;
+	virtual void GetJitKeys(GSJitKeys& keys) const = 0;
+	virtual void Prewarm(const GSJitKeys& keys) = 0;
+	virtual void GetJitStats(GSCodeGeneratorStats& stats) const = 0;
+
 	__forceinline bool HasEdge() const {return m_de != NULL;}
 	__forceinline bool IsSolidRect() const {return m_dr != NULL;}
 };
@@ -120,6 +148,19 @@ public:
 	virtual bool IsSynced() const = 0;
 	virtual int GetPixels(bool reset = true) = 0;
 	virtual void PrintStats() = 0;
+
+	// Only while synced, the draw scanlines of the workers aren't thread safe. Every worker
+	// compiles its own functions, the stats are the sum of theirs. Keys and stats are those of
+	// the current game, BeginJitSession starts the next one.
+	virtual void BeginJitSession() = 0;
+	virtual void GetJitKeys(GSJitKeys& keys) const = 0;
+	virtual void Prewarm(const GSJitKeys& keys) = 0;
+	virtual void GetJitStats(GSCodeGeneratorStats& stats) const = 0;
+
+	// Calls func(0) to func(count - 1) on the workers and the calling thread, returns when they
+	// are all done. Only while synced, so nothing is drawn in the meantime.
+	virtual int GetThreads() const = 0;
+	virtual void Run(int count, const std::function<void(int)>& func) = 0;
 };
 
 class alignas(32) GSRasterizer : public IRasterizer
@@ -128,6 +169,7 @@ protected:
 	GSPerfMon* m_perfmon;
 	IDrawScanline* m_ds;
 	int m_id;
+	int m_timer;
 	int m_threads;
 	int m_thread_height;
 	uint8* m_scanline;
@@ -159,6 +201,8 @@ protected:
 	__forceinline void DrawScanline(int pixels, int left, int top, const GSVertexSW& scan);
 	__forceinline void DrawEdge(int pixels, int left, int top, const GSVertexSW& scan);
 
+	friend class GSRasterizerTiles;
+
 public:
 	GSRasterizer(IDrawScanline* ds, int id, int threads, GSPerfMon* perfmon);
 	virtual ~GSRasterizer();
@@ -168,6 +212,7 @@ public:
 	__forceinline int FindMyNextScanline(int top) const;
 
 	void Draw(GSRasterizerData* data);
+	void Draw(GSRasterizerData* data, const GSVector4i& scissor, const uint32* index, int index_count);
 
 	// IRasterizer
 
@@ -176,6 +221,12 @@ public:
 	bool IsSynced() const {return true;}
 	int GetPixels(bool reset);
 	void PrintStats() {m_ds->PrintStats();}
+	void GetJitKeys(GSJitKeys& keys) const {m_ds->GetJitKeys(keys);}
+	void BeginJitSession() {m_ds->BeginJitSession();}
+	void Prewarm(const GSJitKeys& keys) {m_ds->Prewarm(keys);}
+	void GetJitStats(GSCodeGeneratorStats& stats) const {m_ds->GetJitStats(stats);}
+	int GetThreads() const {return 1;}
+	void Run(int count, const std::function<void(int)>& func);
 };
 
 class GSRasterizerList : public IRasterizer
@@ -197,7 +248,7 @@ public:
 
 	template<class DS> static IRasterizer* Create(int threads, GSPerfMon* perfmon)
 	{
-		threads = std::max<int>(threads, 0);
+		threads = std::min<int>(std::max<int>(threads, 0), GSPerfMon::WorkerLast);
 
 		if(threads == 0)
 		{
@@ -224,4 +275,122 @@ public:
 	bool IsSynced() const;
 	int GetPixels(bool reset);
 	void PrintStats() {}
+	void GetJitKeys(GSJitKeys& keys) const;
+	void BeginJitSession();
+	void Prewarm(const GSJitKeys& keys);
+	void GetJitStats(GSCodeGeneratorStats& stats) const;
+	int GetThreads() const {return (int)m_workers.size();}
+	void Run(int count, const std::function<void(int)>& func);
+};
+
+// Tile binning mode: draws are split along a grid of screen tiles, each primitive only
+// goes to the tiles its bounding box touches. Every tile keeps its own FIFO of work so
+// that its pixels are still drawn in order, and a tile with pending work is handed to
+// one worker at a time. Workers own a queue of such tiles and steal from the others
+// when theirs runs dry, small draws don't leave most of the threads idle.
+
+class GSRasterizerTiles : public IRasterizer
+{
+protected:
+	static const int TILE_SHIFT = 6;
+	static const int TILE_SIZE = 1 << TILE_SHIFT;
+	static const int TILE_COLS = 2048 >> TILE_SHIFT;
+
+	// Indices of the primitives binned into each tile, kept alive with the draw
+	struct Bins
+	{
+		std::shared_ptr<GSRasterizerData> data;
+		std::vector<uint32> index;
+	};
+
+	struct Job
+	{
+		std::shared_ptr<Bins> bins;
+		const uint32* index;
+		int index_count;
+	};
+
+	struct Tile
+	{
+		std::mutex lock;
+		std::deque<Job> jobs;
+		bool scheduled; // sitting in a worker queue or being drawn
+		GSVector4i rect;
+	};
+
+	struct Worker
+	{
+		std::mutex lock;
+		std::deque<int> tiles;
+		std::atomic<int> steals;
+		std::thread thread;
+	};
+
+	GSPerfMon* m_perfmon;
+	std::vector<std::unique_ptr<GSRasterizer>> m_r;
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::unique_ptr<Tile[]> m_tiles;
+
+	std::atomic<int> m_pending; // queued jobs not drawn yet
+	std::atomic<int> m_ready;   // tiles waiting in the worker queues
+	std::atomic<int> m_idle;
+	bool m_exit;
+	std::mutex m_lock;
+	std::condition_variable m_notempty;
+	std::mutex m_wait_lock;
+	std::condition_variable m_empty;
+	std::shared_ptr<GSRasterizerWork> m_work; // of Run, m_lock
+
+	// GS thread only, reused between draws
+	std::vector<GSVector4i> m_prim_tiles;
+	std::vector<int> m_bin_offset;
+
+	GSRasterizerTiles(int threads, GSPerfMon* perfmon);
+
+	void Start();
+	void ThreadProc(int id);
+	bool PopTile(int id, int& tile);
+	void DrawTile(GSRasterizer* r, int tile);
+	void PushJob(int tile, const std::shared_ptr<Bins>& bins, const uint32* index, int index_count);
+
+public:
+	virtual ~GSRasterizerTiles();
+
+	template<class DS> static IRasterizer* Create(int threads, GSPerfMon* perfmon)
+	{
+		threads = std::min<int>(threads, GSPerfMon::WorkerLast);
+
+		if(threads <= 1)
+		{
+			return GSRasterizerList::Create<DS>(threads, perfmon);
+		}
+
+		GSRasterizerTiles* rt = new GSRasterizerTiles(threads, perfmon);
+
+		for(int i = 0; i < threads; i++)
+		{
+			// Every worker may draw any line of the screen, the tiles do the splitting
+			GSRasterizer* r = new GSRasterizer(new DS(), 0, 1, perfmon);
+			r->m_timer = GSPerfMon::WorkerDraw0 + i;
+			rt->m_r.push_back(std::unique_ptr<GSRasterizer>(r));
+		}
+
+		rt->Start();
+
+		return rt;
+	}
+
+	// IRasterizer
+
+	void Queue(const std::shared_ptr<GSRasterizerData>& data);
+	void Sync();
+	bool IsSynced() const;
+	int GetPixels(bool reset);
+	void PrintStats() {}
+	void GetJitKeys(GSJitKeys& keys) const;
+	void BeginJitSession();
+	void Prewarm(const GSJitKeys& keys);
+	void GetJitStats(GSCodeGeneratorStats& stats) const;
+	int GetThreads() const {return (int)m_workers.size();}
+	void Run(int count, const std::function<void(int)>& func);
 };
@@ -42,6 +42,7 @@ void GSRendererSW::InitVectors()
 
 GSRendererSW::GSRendererSW(int threads)
 	: m_fzb(NULL)
+	, m_jit_crc(0)
 {
 	m_nativeres = true; // ignore ini, sw is always native
 
@@ -49,7 +50,14 @@ GSRendererSW::GSRendererSW(int threads)
 
 	memset(m_texture, 0, sizeof(m_texture));
 
-	m_rl = GSRasterizerList::Create<GSDrawScanline>(threads, &m_perfmon);
+	if(theApp.GetConfigB("extrathreads_tiles"))
+	{
+		m_rl = GSRasterizerTiles::Create<GSDrawScanline>(threads, &m_perfmon);
+	}
+	else
+	{
+		m_rl = GSRasterizerList::Create<GSDrawScanline>(threads, &m_perfmon);
+	}
 
 	m_output = (uint8*)_aligned_malloc(1024 * 1024 * sizeof(uint32), 32);
 
@@ -83,10 +91,21 @@ GSRendererSW::GSRendererSW(int threads)
 		m_userhacks_auto_flush = true;
 		ResetHandlers();
 	}
+
+	m_jit_cache = !GLLoader::in_replayer && theApp.GetConfigB("sw_jit_cache");
+
+	m_hiz_enabled = theApp.GetConfigB("hiz_sw");
 }
 
 GSRendererSW::~GSRendererSW()
 {
+	if(m_jit_cache)
+	{
+		m_rl->Sync();
+
+		SaveJitCache();
+	}
+
 	delete m_tc;
 
 	for(size_t i = 0; i < countof(m_texture); i++)
@@ -99,12 +118,144 @@ GSRendererSW::~GSRendererSW()
 	_aligned_free(m_output);
 }
 
+void GSRendererSW::SetGameCRC(uint32 crc, int options)
+{
+	GSRenderer::SetGameCRC(crc, options);
+
+	if(m_jit_cache && crc != m_jit_crc)
+	{
+		Sync(-1);
+
+		SaveJitCache();
+
+		m_jit_crc = crc;
+
+		m_rl->BeginJitSession();
+
+		LoadJitCache(crc);
+	}
+}
+
+// Selectors of the draw functions a game used, so the next time it runs they are compiled
+// when it starts and not in the middle of its frames, where each one is a small hitch.
+// They are compiled here on the GS thread before anything is drawn rather than on a thread
+// of their own, the function maps of the rasterizer workers aren't thread safe and the
+// game would start drawing with most of them before a background thread is done anyway.
+// Keys are per game, the same game with different settings may use a few others.
+
+#define JIT_CACHE_HEADER "GSdx SW JIT cache 1" // GSScanlineSelector changes must bump this
+
+std::string GSRendererSW::GetJitCachePath(uint32 crc) const
+{
+	return theApp.GetConfigDir() + "GSdx_jit" + DIRECTORY_SEPARATOR + format("%08X.txt", crc);
+}
+
+void GSRendererSW::LoadJitCache(uint32 crc)
+{
+	if(crc == 0)
+	{
+		return;
+	}
+
+	FILE* fp = px_fopen(GetJitCachePath(crc), "r");
+
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	GSJitKeys keys;
+	char line[256];
+
+	if(fgets(line, sizeof(line), fp) != NULL && strncmp(line, JIT_CACHE_HEADER "\n", sizeof(JIT_CACHE_HEADER)) == 0)
+	{
+		while(fgets(line, sizeof(line), fp) != NULL)
+		{
+			char type[3];
+			unsigned long long key;
+
+			if(sscanf(line, "%2s %llx", type, &key) != 2)
+			{
+				continue;
+			}
+
+			if(strcmp(type, "sp") == 0)
+			{
+				keys.sp.push_back(key);
+			}
+			else if(strcmp(type, "ds") == 0)
+			{
+				keys.ds.push_back(key);
+			}
+		}
+	}
+
+	fclose(fp);
+
+	m_rl->Prewarm(keys);
+}
+
+void GSRendererSW::SaveJitCache()
+{
+	if(m_jit_crc == 0)
+	{
+		return;
+	}
+
+	GSCodeGeneratorStats stats;
+
+	memset(&stats, 0, sizeof(stats));
+
+	m_rl->GetJitStats(stats);
+
+	printf("GSdx: SW JIT %08X, %zu functions prewarmed, %zu of them used, %zu compiled during draws\n",
+		m_jit_crc, stats.prewarmed, stats.prewarmed_used, stats.lazy);
+
+	if(stats.lazy == 0)
+	{
+		return; // nothing new since it was loaded
+	}
+
+	GSJitKeys keys;
+
+	m_rl->GetJitKeys(keys);
+
+	std::string dir = theApp.GetConfigDir() + "GSdx_jit";
+
+	GSmkdir(dir.c_str());
+
+	FILE* fp = px_fopen(GetJitCachePath(m_jit_crc), "w");
+
+	if(fp == NULL)
+	{
+		fprintf(stderr, "GSdx: can't write the SW JIT cache to %s\n", dir.c_str());
+
+		return;
+	}
+
+	fprintf(fp, JIT_CACHE_HEADER "\n");
+
+	for(uint64 key : keys.sp)
+	{
+		fprintf(fp, "sp %016llx\n", (unsigned long long)key);
+	}
+
+	for(uint64 key : keys.ds)
+	{
+		fprintf(fp, "ds %016llx\n", (unsigned long long)key);
+	}
+
+	fclose(fp);
+}
+
 void GSRendererSW::Reset()
 {
 	Sync(-1);
 
 	m_tc->RemoveAll();
 
+	m_hiz.Reset();
+
 	GSRenderer::Reset();
 }
 
@@ -432,6 +583,11 @@ void GSRendererSW::Draw()
 		return;
 	}
 
+	if(m_hiz_enabled && !UpdateHiZ(sd, r))
+	{
+		return;
+	}
+
 	if(0) if(LOG)
 	{
 		int n = GSUtil::GetVertexCount(PRIM->PRIM);
@@ -699,6 +855,8 @@ void GSRendererSW::InvalidateVideoMem(const GIFRegBITBLTBUF& BITBLTBUF, const GS
 	}
 
 	m_tc->InvalidatePages(m_tmp_pages, off->psm); // if texture update runs on a thread and Sync(5) happens then this must come later
+
+	m_hiz.Invalidate(m_tmp_pages);
 }
 
 void GSRendererSW::InvalidateLocalMem(const GIFRegBITBLTBUF& BITBLTBUF, const GSVector4i& r, bool clut)
@@ -723,6 +881,29 @@ void GSRendererSW::InvalidateLocalMem(const GIFRegBITBLTBUF& BITBLTBUF, const GS
 	}
 }
 
+void GSRendererSW::WriteVideoMem(int& tx, int& ty, const uint8* mem, int len, GIFRegBITBLTBUF& BITBLTBUF)
+{
+	// Large transfers (FMV frames, streamed textures) are swizzled in bands by the workers, but
+	// only when they are idle. Waiting for their draws would cost more than it saves.
+
+	const int threads = m_rl->GetThreads();
+
+	if(threads > 1 && len >= 256 * 1024 && m_rl->IsSynced()
+	&& tx == (int)m_env.TRXPOS.DSAX && ty == (int)m_env.TRXPOS.DSAY
+	&& m_mem.CanWriteImageBands(len, BITBLTBUF, m_env.TRXPOS, m_env.TRXREG))
+	{
+		const int count = threads * 2;
+
+		m_rl->Run(count, [&](int i) {m_mem.WriteImageBand(i, count, mem, BITBLTBUF, m_env.TRXPOS, m_env.TRXREG);});
+
+		ty += m_env.TRXREG.RRH;
+
+		return;
+	}
+
+	GSRenderer::WriteVideoMem(tx, ty, mem, len, BITBLTBUF);
+}
+
 void GSRendererSW::UsePages(const uint32* pages, const int type)
 {
 	for(const uint32* p = pages; *p != GSOffset::EOP; p++) {
@@ -954,6 +1135,55 @@ bool GSRendererSW::CheckSourcePages(SharedData* sd)
 	return false;
 }
 
+// Drops the primitives hidden by the z buffer, false if none is left
+
+bool GSRendererSW::UpdateHiZ(SharedData* data, const GSVector4i& r)
+{
+	const GSScanlineGlobalData& gd = data->global;
+	const GSDrawingContext* context = m_context;
+
+	GSVector4i rect = r;
+	GSVector2i offset((int)context->XYOFFSET.OFX, (int)context->XYOFFSET.OFY);
+
+	rect.z = std::min<int>(rect.z, (int)context->FRAME.FBW * 64);
+
+	if(gd.sel.zb)
+	{
+		m_hiz.Bind(context->ZBUF.Block(), context->FRAME.FBW, context->ZBUF.PSM);
+	}
+
+	if(gd.sel.fwrite)
+	{
+		context->offset.fb->GetPages(rect, m_tmp_pages);
+	}
+
+	// Unless the frame buffer is on top of the z buffer, then the depth may change as it's drawn
+
+	if(gd.sel.ztest && gd.sel.ztst >= ZTST_GEQUAL && !(gd.sel.fwrite && m_hiz.Overlaps(m_tmp_pages)))
+	{
+		data->index_count = m_hiz.Cull(m_vertex.buff, data->index, data->index_count, m_vt.m_primclass, rect, offset, gd.sel.ztst);
+
+		if(data->index_count == 0)
+		{
+			return false;
+		}
+	}
+
+	if(gd.sel.zwrite)
+	{
+		bool cover = !gd.sel.date && !gd.sel.aa1 && (gd.sel.atst == ATST_ALWAYS || gd.sel.afail == AFAIL_ZB_ONLY);
+
+		m_hiz.Update(m_vertex.buff, data->index, data->index_count, m_vt.m_primclass, rect, offset, gd.sel.ztst, cover);
+	}
+
+	if(gd.sel.fwrite)
+	{
+		m_hiz.Invalidate(m_tmp_pages);
+	}
+
+	return true;
+}
+
 #include "GSTextureSW.h"
 
 bool GSRendererSW::GetScanlineGlobalData(SharedData* data)
@@ -1536,7 +1766,7 @@ void GSRendererSW::SharedData::UpdateSource()
 {
 	for(size_t i = 0; m_tex[i].t != NULL; i++)
 	{
-		if(m_tex[i].t->Update(m_tex[i].r))
+		if(m_tex[i].t->Update(m_tex[i].r, m_parent->m_rl))
 		{
 			global.tex[i] = m_tex[i].t->m_buff;
 		}
@@ -23,6 +23,7 @@
 
 #include "Renderers/SW/GSTextureCacheSW.h"
 #include "Renderers/SW/GSDrawScanline.h"
+#include "Renderers/SW/GSHiZBuffer.h"
 
 class GSRendererSW : public GSRenderer
 {
@@ -78,6 +79,10 @@ protected:
 	std::atomic<uint32> m_fzb_pages[512]; // uint16 frame/zbuf pages interleaved
 	std::atomic<uint16> m_tex_pages[512];
 	uint32 m_tmp_pages[512 + 1];
+	GSHiZBuffer m_hiz;
+	bool m_hiz_enabled;
+	bool m_jit_cache;
+	uint32 m_jit_crc; // game of the functions compiled so far, 0 before one is known
 
 	void Reset();
 	void VSync(int field);
@@ -90,6 +95,7 @@ protected:
 	void Sync(int reason);
 	void InvalidateVideoMem(const GIFRegBITBLTBUF& BITBLTBUF, const GSVector4i& r);
 	void InvalidateLocalMem(const GIFRegBITBLTBUF& BITBLTBUF, const GSVector4i& r, bool clut = false);
+	void WriteVideoMem(int& tx, int& ty, const uint8* mem, int len, GIFRegBITBLTBUF& BITBLTBUF);
 
 	void UsePages(const uint32* pages, const int type);
 	void ReleasePages(const uint32* pages, const int type);
@@ -98,10 +104,17 @@ protected:
 	bool CheckSourcePages(SharedData* sd);
 
 	bool GetScanlineGlobalData(SharedData* data);
+	bool UpdateHiZ(SharedData* data, const GSVector4i& r);
+
+	std::string GetJitCachePath(uint32 crc) const;
+	void LoadJitCache(uint32 crc);
+	void SaveJitCache();
 
 public:
 	static void InitVectors();
 
 	GSRendererSW(int threads);
 	virtual ~GSRendererSW();
+
+	void SetGameCRC(uint32 crc, int options);
 };
@@ -189,7 +189,7 @@ GSTextureCacheSW::Texture::~Texture()
 	}
 }
 
-bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect)
+bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect, IRasterizer* rl)
 {
 	if(m_complete)
 	{
@@ -234,6 +234,12 @@ bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect)
 
 	GSLocalMemory::readTextureBlock rtxbP = psm.rtxbP;
 
+	// blocks left for the workers of rl, in bands of rows
+
+	std::vector<std::pair<uint32, uint8*>> list;
+
+	bool parallel = rl != NULL && rl->GetThreads() > 1 && (r.width() / bs.x) * (r.height() / bs.y) >= 256 && rl->IsSynced();
+
 	uint32 pitch = (1 << m_tw) << shift;
 
 	uint8* dst = (uint8*)m_buff + pitch * r.top;
@@ -264,7 +270,14 @@ bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect)
 				{
 					m_valid[row] |= col;
 
-					(mem.*rtxbP)(block, &dst[x << shift], pitch, m_TEXA);
+					if(parallel)
+					{
+						list.push_back(std::make_pair(block, &dst[x << shift]));
+					}
+					else
+					{
+						(mem.*rtxbP)(block, &dst[x << shift], pitch, m_TEXA);
+					}
 
 					blocks++;
 				}
@@ -288,7 +301,14 @@ bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect)
 				{
 					m_valid[row] |= col;
 
-					(mem.*rtxbP)(block, &dst[x << shift], pitch, m_TEXA);
+					if(parallel)
+					{
+						list.push_back(std::make_pair(block, &dst[x << shift]));
+					}
+					else
+					{
+						(mem.*rtxbP)(block, &dst[x << shift], pitch, m_TEXA);
+					}
 
 					blocks++;
 				}
@@ -296,6 +316,20 @@ bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect)
 		}
 	}
 
+	if(!list.empty())
+	{
+		const int count = rl->GetThreads() * 2;
+		const int size = (int)list.size();
+
+		rl->Run(count, [&](int i)
+		{
+			for(int j = size * i / count, end = size * (i + 1) / count; j < end; j++)
+			{
+				(mem.*rtxbP)(list[j].first, list[j].second, pitch, m_TEXA);
+			}
+		});
+	}
+
 	if(blocks > 0)
 	{
 		m_state->m_perfmon.Put(GSPerfMon::Unswizzle, bs.x * bs.y * blocks << shift);
@@ -23,6 +23,7 @@
 
 #include "Renderers/Common/GSRenderer.h"
 #include "Renderers/Common/GSFastList.h"
+#include "Renderers/SW/GSRasterizer.h"
 
 class GSTextureCacheSW
 {
@@ -52,7 +53,7 @@ public:
 		Texture(GSState* state, uint32 tw0, const GIFRegTEX0& TEX0, const GIFRegTEXA& TEXA);
 		virtual ~Texture();
 
-		bool Update(const GSVector4i& r);
+		bool Update(const GSVector4i& r, IRasterizer* rl = NULL); // rl reads large updates when it is idle
 		bool Save(const std::string& fn, bool dds = false) const;
 	};
 
@@ -345,6 +345,7 @@ void populate_sw_table(GtkWidget* sw_table)
 	GtkWidget* aa_check           = CreateCheckBox("Edge Anti-aliasing (Del)", "aa1");
 	GtkWidget* mipmap_check       = CreateCheckBox("Mipmapping", "mipmap");
 	GtkWidget* autoflush_sw_check = CreateCheckBox("Auto Flush", "autoflush_sw");
+	GtkWidget* tiles_check        = CreateCheckBox("Tile Binning", "extrathreads_tiles");
 
 	AddTooltip(aa_check, IDC_AA1);
 	AddTooltip(mipmap_check, IDC_MIPMAP_SW);
@@ -354,7 +355,7 @@ void populate_sw_table(GtkWidget* sw_table)
 	s_table_line = 0;
 	InsertWidgetInTable(sw_table , threads_label , threads_spin);
 	InsertWidgetInTable(sw_table , autoflush_sw_check , aa_check);
-	InsertWidgetInTable(sw_table , mipmap_check);
+	InsertWidgetInTable(sw_table , mipmap_check , tiles_check);
 }
 
 void populate_shader_table(GtkWidget* shader_table)
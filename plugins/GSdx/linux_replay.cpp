@@ -19,9 +19,18 @@
  */
 
 #include <dlfcn.h>
+#include <dirent.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <string>
+#include <vector>
 
 static void* handle;
 
@@ -31,6 +40,19 @@ void help()
 	fprintf(stderr, "ARG1 GSdx plugin\n");
 	fprintf(stderr, "ARG2 .gs file\n");
 	fprintf(stderr, "ARG3 Ini directory\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Benchmark: --bench [options] plugin dump_dir [ini_dir]\n");
+	fprintf(stderr, "Replays every .gs/.gs.xz file of dump_dir without any window and prints JSON stats\n");
+	fprintf(stderr, "  -n N       replay each dump N times (default 3)\n");
+	fprintf(stderr, "  -r sw|null renderer (default sw)\n");
+	fprintf(stderr, "  -t N       SW renderer extra threads (default from the ini)\n");
+	fprintf(stderr, "  -s N       only time the frames from N on, .gs.xz dumps recorded in chunks start at the nearest one\n");
+	fprintf(stderr, "  -o file    write the JSON to file instead of stdout\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Swizzle benchmark: --swizzle-bench [options] plugin [ini_dir]\n");
+	fprintf(stderr, "Times large transfers in and out of the GS memory, alone and split between the SW renderer threads\n");
+	fprintf(stderr, "  -n N       repeat each transfer N times (default 100)\n");
+	fprintf(stderr, "  -t N       SW renderer extra threads (default from the ini)\n");
 	if (handle) {
 		dlclose(handle);
 	}
@@ -46,10 +68,279 @@ char* read_env(const char* var) {
 	return v;
 }
 
+static std::string json_string(const std::string& s)
+{
+	std::string r("\"");
+	for (char c : s) {
+		if (c == '"' || c == '\\') {
+			r += '\\';
+			r += c;
+		} else if ((unsigned char)c < 0x20) {
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", c);
+			r += buf;
+		} else {
+			r += c;
+		}
+	}
+	return r + "\"";
+}
+
+static bool is_dump(const std::string& name)
+{
+	auto ends_with = [&](const char* ext) {
+		size_t len = strlen(ext);
+		return name.size() > len && name.compare(name.size() - len, len, ext) == 0;
+	};
+	return ends_with(".gs") || ends_with(".gs.xz");
+}
+
+// Replays a single dump in a child process, so that a crash only fails this dump and
+// its peak RSS is reported on its own. Returns true when the child produced its stats.
+static bool bench_dump(const char* plugin, const char* ini, const std::string& dump, int renderer, int threads, int start,
+	int runs, std::string& stats, long& peak_rss_kb)
+{
+	int fd[2];
+	if (pipe(fd) != 0) {
+		perror("pipe");
+		return false;
+	}
+
+	fflush(stdout);
+	fflush(stderr);
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		close(fd[0]);
+		close(fd[1]);
+		return false;
+	}
+
+	if (pid == 0) {
+		close(fd[0]);
+		// Keep the plugin logs out of the JSON
+		dup2(2, 1);
+
+		void* child_handle = dlopen(plugin, RTLD_LAZY|RTLD_GLOBAL);
+		if (child_handle == NULL) {
+			fprintf(stderr, "Failed to dlopen plugin %s: %s\n", plugin, dlerror());
+			_exit(1);
+		}
+
+		__attribute__((stdcall)) void (*GSsetSettingsDir_ptr)(const char*);
+		__attribute__((stdcall)) int (*GSReplayBenchmark_ptr)(char*, int, int, int, int, FILE*);
+
+		GSsetSettingsDir_ptr = reinterpret_cast<decltype(GSsetSettingsDir_ptr)>(dlsym(child_handle, "GSsetSettingsDir"));
+		GSReplayBenchmark_ptr = reinterpret_cast<decltype(GSReplayBenchmark_ptr)>(dlsym(child_handle, "GSReplayBenchmark"));
+
+		if (GSReplayBenchmark_ptr == NULL) {
+			fprintf(stderr, "%s has no GSReplayBenchmark\n", plugin);
+			_exit(1);
+		}
+
+		if (ini)
+			GSsetSettingsDir_ptr(ini);
+
+		FILE* out = fdopen(fd[1], "w");
+		std::vector<char> path(dump.begin(), dump.end());
+		path.push_back(0);
+
+		int ret = GSReplayBenchmark_ptr(path.data(), renderer, threads, start, runs, out);
+
+		fclose(out);
+		_exit(ret == 0 ? 0 : 1);
+	}
+
+	close(fd[1]);
+
+	stats.clear();
+	char buf[4096];
+	ssize_t len;
+	while ((len = read(fd[0], buf, sizeof(buf))) != 0) {
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		stats.append(buf, len);
+	}
+	close(fd[0]);
+
+	while (!stats.empty() && (stats.back() == '\n' || stats.back() == ' '))
+		stats.pop_back();
+
+	int status = 0;
+	struct rusage usage = {};
+	if (wait4(pid, &status, 0, &usage) < 0) {
+		perror("wait4");
+		return false;
+	}
+
+	peak_rss_kb = usage.ru_maxrss;
+
+	if (WIFSIGNALED(status))
+		fprintf(stderr, "%s: replay killed by signal %d\n", dump.c_str(), WTERMSIG(status));
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0 && !stats.empty();
+}
+
+static int bench(int argc, char* argv[])
+{
+	int runs = 3;
+	int renderer = 13; // GSRendererType::OGL_SW
+	int threads = -1;
+	int start = 0;
+	const char* output = NULL;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "n:r:t:s:o:")) != -1) {
+		switch (opt) {
+			case 'n':
+				runs = std::max(atoi(optarg), 1);
+				break;
+			case 'r':
+				if (!strcmp(optarg, "sw"))
+					renderer = 13;
+				else if (!strcmp(optarg, "null"))
+					renderer = 11; // GSRendererType::Null
+				else
+					help();
+				break;
+			case 't':
+				threads = atoi(optarg);
+				break;
+			case 's':
+				start = std::max(atoi(optarg), 0);
+				break;
+			case 'o':
+				output = optarg;
+				break;
+			default:
+				help();
+		}
+	}
+
+	if (argc - optind < 2 || argc - optind > 3)
+		help();
+
+	const char* plugin = argv[optind];
+	std::string dir(argv[optind + 1]);
+	const char* ini = (argc - optind == 3) ? argv[optind + 2] : getenv("GSDUMP_CONF");
+
+	std::vector<std::string> dumps;
+	if (DIR* d = opendir(dir.c_str())) {
+		while (struct dirent* entry = readdir(d)) {
+			if (is_dump(entry->d_name))
+				dumps.push_back(dir + "/" + entry->d_name);
+		}
+		closedir(d);
+	} else {
+		fprintf(stderr, "Failed to open %s\n", dir.c_str());
+		help();
+	}
+	std::sort(dumps.begin(), dumps.end());
+
+	if (dumps.empty()) {
+		fprintf(stderr, "No dump found in %s\n", dir.c_str());
+		return 1;
+	}
+
+	FILE* out = output ? fopen(output, "w") : stdout;
+	if (out == NULL) {
+		fprintf(stderr, "Failed to open %s\n", output);
+		return 1;
+	}
+
+	fprintf(out, "{\"plugin\": %s, \"renderer\": \"%s\", \"runs\": %d, \"dumps\": [\n",
+		json_string(plugin).c_str(), renderer == 13 ? "sw" : "null", runs);
+
+	int failed = 0;
+	for (size_t i = 0; i < dumps.size(); i++) {
+		fprintf(stderr, "[%zu/%zu] %s\n", i + 1, dumps.size(), dumps[i].c_str());
+
+		std::string stats;
+		long peak_rss_kb = 0;
+		bool ok = bench_dump(plugin, ini, dumps[i], renderer, threads, start, runs, stats, peak_rss_kb);
+		if (!ok)
+			failed++;
+
+		fprintf(out, "  {\"dump\": %s, \"status\": \"%s\", \"peak_rss_kb\": %ld, \"stats\": %s}%s\n",
+			json_string(dumps[i]).c_str(), ok ? "ok" : "failed", peak_rss_kb, ok ? stats.c_str() : "null",
+			i + 1 < dumps.size() ? "," : "");
+		fflush(out);
+	}
+
+	fprintf(out, "]}\n");
+
+	if (out != stdout)
+		fclose(out);
+
+	return failed ? 1 : 0;
+}
+
+static int swizzle_bench(int argc, char* argv[])
+{
+	int runs = 100;
+	int threads = -1;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "n:t:")) != -1) {
+		switch (opt) {
+			case 'n':
+				runs = std::max(atoi(optarg), 1);
+				break;
+			case 't':
+				threads = atoi(optarg);
+				break;
+			default:
+				help();
+		}
+	}
+
+	if (argc - optind < 1 || argc - optind > 2)
+		help();
+
+	const char* plugin = argv[optind];
+	const char* ini = (argc - optind == 2) ? argv[optind + 1] : getenv("GSDUMP_CONF");
+
+	handle = dlopen(plugin, RTLD_LAZY|RTLD_GLOBAL);
+	if (handle == NULL) {
+		fprintf(stderr, "Failed to dlopen plugin %s: %s\n", plugin, dlerror());
+		return 1;
+	}
+
+	__attribute__((stdcall)) void (*GSsetSettingsDir_ptr)(const char*);
+	__attribute__((stdcall)) int (*GSSwizzleBenchmark_ptr)(int, int, FILE*);
+
+	GSsetSettingsDir_ptr = reinterpret_cast<decltype(GSsetSettingsDir_ptr)>(dlsym(handle, "GSsetSettingsDir"));
+	GSSwizzleBenchmark_ptr = reinterpret_cast<decltype(GSSwizzleBenchmark_ptr)>(dlsym(handle, "GSSwizzleBenchmark"));
+
+	if (GSSwizzleBenchmark_ptr == NULL) {
+		fprintf(stderr, "%s has no GSSwizzleBenchmark\n", plugin);
+		return 1;
+	}
+
+	if (ini)
+		GSsetSettingsDir_ptr(ini);
+
+	int ret = GSSwizzleBenchmark_ptr(threads, runs, stdout);
+
+	dlclose(handle);
+
+	return ret == 0 ? 0 : 1;
+}
+
 int main ( int argc, char *argv[] )
 {
 	if (argc < 1) help();
 
+	if (argc > 1 && !strcmp(argv[1], "--bench"))
+		return bench(argc - 1, argv + 1);
+
+	if (argc > 1 && !strcmp(argv[1], "--swizzle-bench"))
+		return swizzle_bench(argc - 1, argv + 1);
+
 	char* plugin;
 	char* gs;
 	if (argc > 2) {
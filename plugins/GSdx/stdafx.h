@@ -100,6 +100,7 @@ typedef int64 sint64;
 #include <array>
 #include <vector>
 #include <list>
+#include <deque>
 #include <map>
 #include <set>
 #include <queue>
@@ -255,6 +256,14 @@ typedef int64 sint64;
 
 #endif
 
+// GSKernels.*.cpp are built for their own instruction set, whatever the rest of GSdx uses
+#ifdef GS_KERNEL_ISA
+
+	#undef _M_SSE
+	#define _M_SSE GS_KERNEL_ISA
+
+#endif
+
 #if _M_SSE >= 0x200
 
 	#include <xmmintrin.h>
@@ -0,0 +1,268 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2021 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Times the replay of a compile/clear trace through BaseBlocks and through its previous
+// implementation (std::multimap links, memmoved block array), and checks that both link
+// every jump to the same place.  Not a unit test: built by the "benchmarks" target and
+// run with ctest -C Benchmark.
+
+#include "PrecompiledHeader.h"
+#include "BaseblockEx.h"
+#include "baseblocks_trace.h"
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+
+using namespace BaseBlocksTrace;
+
+namespace
+{
+	// The block array BaseBlocks used before it kept a gap.
+	class LegacyBaseBlockArray
+	{
+		s32 _Reserved;
+		s32 _Size;
+		BASEBLOCKEX* blocks;
+
+		void reserve(s32 size)
+		{
+			BASEBLOCKEX* newMem = new BASEBLOCKEX[size];
+			if (blocks)
+			{
+				memcpy(newMem, blocks, _Reserved * sizeof(BASEBLOCKEX));
+				delete[] blocks;
+			}
+			blocks = newMem;
+			_Reserved = size;
+		}
+
+	public:
+		LegacyBaseBlockArray(s32 size)
+			: _Reserved(0)
+			, _Size(0)
+			, blocks(NULL)
+		{
+			reserve(size);
+		}
+		~LegacyBaseBlockArray() { delete[] blocks; }
+
+		BASEBLOCKEX* insert(u32 startpc, uptr fnptr)
+		{
+			if (_Size + 1 >= _Reserved)
+				reserve(_Reserved + 0x2000);
+
+			int imin = 0, imax = _Size, imid;
+			while (imin < imax)
+			{
+				imid = (imin + imax) >> 1;
+				if (blocks[imid].startpc > startpc)
+					imax = imid;
+				else
+					imin = imid + 1;
+			}
+
+			if (imin < _Size)
+				memmove(blocks + imin + 1, blocks + imin, (_Size - imin) * sizeof(BASEBLOCKEX));
+
+			memset((blocks + imin), 0, sizeof(BASEBLOCKEX));
+			blocks[imin].startpc = startpc;
+			blocks[imin].fnptr = fnptr;
+			_Size++;
+			return &blocks[imin];
+		}
+
+		BASEBLOCKEX& operator[](int idx) const { return *(blocks + idx); }
+		u32 size() const { return _Size; }
+
+		void erase(s32 first, s32 last)
+		{
+			if (last < _Size)
+				memmove(blocks + first, blocks + last, (_Size - last) * sizeof(BASEBLOCKEX));
+			_Size -= last - first;
+		}
+	};
+
+	// BaseBlocks with the std::multimap link table it used before, as reference for the
+	// trace replay (both results and timings).
+	class LegacyBaseBlocks
+	{
+		typedef std::multimap<u32, uptr>::iterator linkiter_t;
+
+		std::multimap<u32, uptr> links;
+		uptr recompiler;
+		LegacyBaseBlockArray blocks;
+
+	public:
+		LegacyBaseBlocks()
+			: recompiler(0)
+			, blocks(0x4000)
+		{
+		}
+
+		void SetJITCompile(void (*recompiler_)()) { recompiler = (uptr)recompiler_; }
+
+		BASEBLOCKEX* New(u32 startpc, uptr fnptr)
+		{
+			std::pair<linkiter_t, linkiter_t> range = links.equal_range(startpc);
+			for (linkiter_t i = range.first; i != range.second; ++i)
+				*(u32*)i->second = fnptr - (i->second + 4);
+			return blocks.insert(startpc, fnptr);
+		}
+
+		int LastIndex(u32 startpc) const
+		{
+			if (0 == blocks.size())
+				return -1;
+
+			int imin = 0, imax = blocks.size() - 1, imid;
+			while (imin != imax)
+			{
+				imid = (imin + imax + 1) >> 1;
+				if (blocks[imid].startpc > startpc)
+					imax = imid - 1;
+				else
+					imin = imid;
+			}
+			return imin;
+		}
+
+		BASEBLOCKEX* operator[](int idx)
+		{
+			if (idx < 0 || idx >= (int)blocks.size())
+				return 0;
+			return &blocks[idx];
+		}
+
+		BASEBLOCKEX* Get(u32 startpc)
+		{
+			int idx = LastIndex(startpc);
+			if ((idx == -1) || (startpc < blocks[idx].startpc) ||
+				((blocks[idx].size) && (startpc >= blocks[idx].startpc + blocks[idx].size * 4)))
+				return 0;
+			return &blocks[idx];
+		}
+
+		void Remove(int first, int last)
+		{
+			for (int idx = first; idx <= last; idx++)
+			{
+				std::pair<linkiter_t, linkiter_t> range = links.equal_range(blocks[idx].startpc);
+				for (linkiter_t i = range.first; i != range.second; ++i)
+					*(u32*)i->second = recompiler - (i->second + 4);
+			}
+			blocks.erase(first, last + 1);
+		}
+
+		void Link(u32 pc, s32* jumpptr)
+		{
+			BASEBLOCKEX* targetblock = Get(pc);
+			if (targetblock && targetblock->startpc == pc)
+				*jumpptr = (s32)(targetblock->fnptr - (sptr)(jumpptr + 1));
+			else
+				*jumpptr = (s32)(recompiler - (sptr)(jumpptr + 1));
+			links.insert(std::pair<u32, uptr>(pc, (uptr)jumpptr));
+		}
+	};
+
+	// Replays a trace through BaseBlocks or LegacyBaseBlocks, like the recompilers use them.
+	template <typename Blocks>
+	class TraceReplay
+	{
+		Blocks blocks;
+		std::vector<u8> code;   // fnptrs of the compiled blocks
+		std::vector<s32> jumps; // rel32 of the linked jumps
+		size_t codeUsed, jumpsUsed;
+
+	public:
+		TraceReplay(size_t ops)
+			: code(ops + 1)
+			, jumps(ops * 2)
+			, codeUsed(0)
+			, jumpsUsed(0)
+		{
+			blocks.SetJITCompile(FakeJIT);
+		}
+
+		// Mirrors recRecompile()
+		void Compile(const TraceOp& op)
+		{
+			BASEBLOCKEX* block = blocks.Get(op.pc);
+			if (block && block->startpc == op.pc)
+				return;
+
+			block = blocks.New(op.pc, (uptr)&code[codeUsed++]);
+			block->size = op.size;
+			for (u32 target : op.targets)
+				blocks.Link(target, &jumps[jumpsUsed++]);
+		}
+
+		// Mirrors recClear(), minus the block being compiled
+		void Clear(const TraceOp& op)
+		{
+			int last = blocks.LastIndex(op.pc + op.size * 4 - 4);
+			int first = last;
+			while (first >= 0 && blocks[first]->startpc + blocks[first]->size * 4 > op.pc)
+				first--;
+			if (first < last)
+				blocks.Remove(first + 1, last);
+		}
+
+		double Run(const std::vector<TraceOp>& trace)
+		{
+			auto start = std::chrono::steady_clock::now();
+			for (const TraceOp& op : trace)
+			{
+				if (op.clear)
+					Clear(op);
+				else
+					Compile(op);
+			}
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// Where every linked jump goes: the code offset of its target block, or -1 for the JIT
+		std::vector<s64> Targets() const
+		{
+			std::vector<s64> targets(jumpsUsed);
+			for (size_t i = 0; i < jumpsUsed; i++)
+			{
+				u32 target = (u32)jumps[i] + (u32)((uptr)&jumps[i] + 4);
+				targets[i] = (target == (u32)(uptr)FakeJIT) ? -1 : (s64)(u32)(target - (u32)(uptr)code.data());
+			}
+			return targets;
+		}
+	};
+} // namespace
+
+int main()
+{
+	const std::vector<TraceOp> trace = MakeTrace(200000);
+
+	std::unique_ptr<TraceReplay<BaseBlocks>> current(new TraceReplay<BaseBlocks>(trace.size()));
+	std::unique_ptr<TraceReplay<LegacyBaseBlocks>> legacy(new TraceReplay<LegacyBaseBlocks>(trace.size()));
+
+	double time = current->Run(trace);
+	double legacyTime = legacy->Run(trace);
+	std::printf("Replayed %zu compile/clear ops: %.2f ms, previous implementation %.2f ms\n",
+				trace.size(), time, legacyTime);
+
+	if (current->Targets() != legacy->Targets())
+	{
+		std::printf("The jumps aren't linked to the same targets\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,210 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2021 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "BaseblockEx.h"
+#include <gtest/gtest.h>
+#include "baseblocks_trace.h"
+#include <map>
+
+using namespace BaseBlocksTrace;
+
+namespace
+{
+	// Replays a trace through BaseBlocks next to a plain std::map of the blocks which should
+	// be alive, and the pc every jump was linked to.
+	class TraceReplay
+	{
+		struct Block
+		{
+			size_t code; // offset of its fnptr
+			u32 size;
+		};
+
+		BaseBlocks blocks;
+		std::map<u32, Block> expected; // by startpc, the blocks which should be alive
+		std::vector<u8> code;   // fnptrs of the compiled blocks
+		std::vector<s32> jumps; // rel32 of the linked jumps
+		std::vector<u32> jumpPcs;
+		size_t codeUsed;
+
+	public:
+		TraceReplay(size_t ops)
+			: code(ops + 1)
+			, jumps(ops * 2)
+			, codeUsed(0)
+		{
+			blocks.SetJITCompile(FakeJIT);
+		}
+
+		// Mirrors recRecompile()
+		void Compile(const TraceOp& op)
+		{
+			BASEBLOCKEX* block = blocks.Get(op.pc);
+			if (block && block->startpc == op.pc)
+				return;
+
+			expected[op.pc] = {codeUsed, op.size};
+			block = blocks.New(op.pc, (uptr)&code[codeUsed++]);
+			block->size = op.size;
+			for (u32 target : op.targets)
+			{
+				blocks.Link(target, &jumps[jumpPcs.size()]);
+				jumpPcs.push_back(target);
+			}
+		}
+
+		// Mirrors recClear(), minus the block being compiled
+		void Clear(const TraceOp& op)
+		{
+			int last = blocks.LastIndex(op.pc + op.size * 4 - 4);
+			int first = last;
+			while (first >= 0 && blocks[first]->startpc + blocks[first]->size * 4 > op.pc)
+				first--;
+			if (first < last)
+				blocks.Remove(first + 1, last);
+
+			auto it = expected.upper_bound(op.pc + op.size * 4 - 4);
+			while (it != expected.begin())
+			{
+				--it;
+				if (it->first + it->second.size * 4 <= op.pc)
+					break;
+				it = expected.erase(it);
+			}
+		}
+
+		void Run(const std::vector<TraceOp>& trace)
+		{
+			for (const TraceOp& op : trace)
+			{
+				if (op.clear)
+					Clear(op);
+				else
+					Compile(op);
+			}
+		}
+
+		void Check()
+		{
+			// Same blocks, in startpc order
+			int idx = 0;
+			for (const auto& block : expected)
+			{
+				ASSERT_NE(blocks[idx], nullptr) << "block " << idx;
+				ASSERT_EQ(blocks[idx]->startpc, block.first) << "block " << idx;
+				ASSERT_EQ(blocks[idx]->fnptr, (uptr)&code[block.second.code]) << "block " << idx;
+				idx++;
+			}
+			EXPECT_EQ(blocks[idx], nullptr);
+
+			// A jump goes to the block starting at its pc, or to the JIT when there is none
+			for (size_t i = 0; i < jumpPcs.size(); i++)
+			{
+				auto block = expected.find(jumpPcs[i]);
+				uptr want = (block != expected.end()) ? (uptr)&code[block->second.code] : (uptr)FakeJIT;
+				u32 target = (u32)jumps[i] + (u32)((uptr)&jumps[i] + 4);
+				ASSERT_EQ(target, (u32)want) << "jump " << i << " to pc " << jumpPcs[i];
+			}
+		}
+	};
+} // namespace
+
+TEST(BaseBlocksTests, LinkTable)
+{
+	BaseBlockLinks links;
+	std::multimap<u32, uptr> expected;
+
+	// Enough pcs to grow the table a few times
+	std::mt19937 rng(42);
+	for (uptr i = 0; i < 100000; i++)
+	{
+		u32 pc = (rng() % 0x200000) & ~3u;
+		links.Add(pc, i);
+		expected.insert(std::make_pair(pc, i));
+	}
+	ASSERT_EQ(links.size(), expected.size());
+
+	for (u32 pc = 0; pc < 0x200000; pc += 4)
+	{
+		std::vector<uptr> got;
+		links.ForEach(pc, [&got](uptr jumpptr) { got.push_back(jumpptr); });
+		std::sort(got.begin(), got.end());
+
+		std::vector<uptr> want;
+		auto range = expected.equal_range(pc);
+		for (auto it = range.first; it != range.second; ++it)
+			want.push_back(it->second);
+		ASSERT_EQ(got, want) << "pc " << pc;
+	}
+
+	links.Clear();
+	EXPECT_EQ(links.size(), 0u);
+	bool any = false;
+	links.ForEach(expected.begin()->first, [&any](uptr) { any = true; });
+	EXPECT_FALSE(any);
+}
+
+// Links removed by jump range (evicted code) must disappear from every pc, and the table
+// must keep working for the pcs left without links.
+TEST(BaseBlocksTests, LinkTableRemove)
+{
+	BaseBlockLinks links;
+	std::multimap<u32, uptr> expected;
+
+	std::mt19937 rng(7);
+	for (uptr i = 0; i < 50000; i++)
+	{
+		u32 pc = (rng() % 0x40000) & ~3u;
+		links.Add(pc, i);
+		if (i < 20000 || i >= 35000)
+			expected.insert(std::make_pair(pc, i));
+	}
+
+	links.Remove(20000, 35000);
+	ASSERT_EQ(links.size(), expected.size());
+
+	// Keep adding after the removal, some of it to pcs which lost all their links
+	for (uptr i = 50000; i < 60000; i++)
+	{
+		u32 pc = (rng() % 0x40000) & ~3u;
+		links.Add(pc, i);
+		expected.insert(std::make_pair(pc, i));
+	}
+
+	for (u32 pc = 0; pc < 0x40000; pc += 4)
+	{
+		std::vector<uptr> got;
+		links.ForEach(pc, [&got](uptr jumpptr) { got.push_back(jumpptr); });
+		std::sort(got.begin(), got.end());
+
+		std::vector<uptr> want;
+		auto range = expected.equal_range(pc);
+		for (auto it = range.first; it != range.second; ++it)
+			want.push_back(it->second);
+		ASSERT_EQ(got, want) << "pc " << pc;
+	}
+}
+
+// Replays a compile/clear trace: the blocks left must be the ones which weren't cleared, and
+// every jump must end up linked to the block at its pc, or to the JIT.
+TEST(BaseBlocksTests, TraceReplay)
+{
+	const std::vector<TraceOp> trace = MakeTrace(200000);
+
+	std::unique_ptr<TraceReplay> replay(new TraceReplay(trace.size()));
+	replay->Run(trace);
+	replay->Check();
+}
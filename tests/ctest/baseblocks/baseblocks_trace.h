@@ -0,0 +1,62 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2021 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <random>
+#include <vector>
+
+// Compile/clear traces replayed through BaseBlocks by baseblocks_test and baseblocks_bench.
+namespace BaseBlocksTrace
+{
+	struct TraceOp
+	{
+		bool clear;
+		u32 pc;
+		u32 size;       // in instructions
+		u32 targets[2]; // branch targets of a compiled block
+	};
+
+	// Synthetic compile/clear trace shaped like a game with self-modifying code: blocks
+	// get compiled all over 1MB of code, most clears hit a small region which is then
+	// recompiled over and over, and blocks branch mostly to nearby code.
+	inline std::vector<TraceOp> MakeTrace(u32 count)
+	{
+		std::mt19937 rng(0x5ca1ab1e);
+		const u32 codeSize = 0x100000;
+		const u32 hotBase = 0x40000, hotSize = 0x4000;
+
+		std::vector<TraceOp> trace(count);
+		for (TraceOp& op : trace)
+		{
+			op.clear = (rng() % 4) == 0;
+			if (op.clear)
+			{
+				op.pc = ((rng() % 8) ? hotBase + rng() % hotSize : rng() % codeSize) & ~3u;
+				op.size = 1 + rng() % 16;
+			}
+			else
+			{
+				op.pc = ((rng() % 2) ? hotBase + rng() % hotSize : rng() % codeSize) & ~3u;
+				op.size = 4 + rng() % 60;
+				for (u32& target : op.targets)
+					target = (op.pc + (rng() % 0x2000) - 0x1000) & (codeSize - 4);
+			}
+		}
+		return trace;
+	}
+
+	inline void FakeJIT() {}
+} // namespace BaseBlocksTrace
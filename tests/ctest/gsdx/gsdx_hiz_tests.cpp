@@ -0,0 +1,198 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2021 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+#include "GSLocalMemory.h"
+#include "GSUtil.h"
+#include "Renderers/SW/GSHiZBuffer.h"
+#include <gtest/gtest.h>
+
+// GSLocalMemory.cpp and GSUtil.cpp can't be linked without the rest of GSdx, these are the
+// parts of them GSHiZBuffer uses: the z formats and the vertex count of the classes.
+
+GSLocalMemory::psm_t GSLocalMemory::m_psm[64];
+
+int GSUtil::GetClassVertexCount(uint32 primclass)
+{
+	switch (primclass)
+	{
+		case GS_POINT_CLASS: return 1;
+		case GS_LINE_CLASS: return 2;
+		case GS_TRIANGLE_CLASS: return 3;
+		case GS_SPRITE_CLASS: return 2;
+		default: return 0;
+	}
+}
+
+namespace
+{
+	const uint32 BW = 10; // 640 pixels
+
+	class GSHiZBufferTest : public ::testing::Test
+	{
+	protected:
+		GSHiZBuffer hiz;
+		GSVertex vertex[2];
+		uint32 index[2];
+		const GSVector4i r{0, 0, 640, 448};
+		const GSVector2i offset{0, 0};
+
+		GSHiZBufferTest()
+		{
+			GSLocalMemory::m_psm[PSM_PSMZ32].fmt = 0;
+			GSLocalMemory::m_psm[PSM_PSMZ32].bn = &GSLocalMemory::BlockNumber32Z;
+			GSLocalMemory::m_psm[PSM_PSMZ24].fmt = 1;
+			GSLocalMemory::m_psm[PSM_PSMZ24].bn = &GSLocalMemory::BlockNumber32Z;
+			GSLocalMemory::m_psm[PSM_PSMZ16].fmt = 2;
+			GSLocalMemory::m_psm[PSM_PSMZ16].bn = &GSLocalMemory::BlockNumber16Z;
+
+			hiz.Bind(0, BW, PSM_PSMZ32);
+		}
+
+		// A sprite from (x0, y0) to (x1, y1), in pixels
+		void Sprite(int x0, int y0, int x1, int y1, uint32 z)
+		{
+			memset(vertex, 0, sizeof(vertex));
+
+			vertex[0].XYZ.X = (uint16)(x0 << 4);
+			vertex[0].XYZ.Y = (uint16)(y0 << 4);
+			vertex[0].XYZ.Z = z;
+			vertex[1].XYZ.X = (uint16)(x1 << 4);
+			vertex[1].XYZ.Y = (uint16)(y1 << 4);
+			vertex[1].XYZ.Z = z;
+
+			index[0] = 0;
+			index[1] = 1;
+		}
+
+		void Update(uint32 ztst, bool cover)
+		{
+			hiz.Update(vertex, index, 2, GS_SPRITE_CLASS, r, offset, ztst, cover);
+		}
+
+		// Whether a sprite inside of the tile at (32, 32) with depth z passes GEQUAL
+		bool Visible(uint32 z)
+		{
+			Sprite(40, 40, 50, 50, z);
+
+			return hiz.Cull(vertex, index, 2, GS_SPRITE_CLASS, r, offset, ZTST_GEQUAL) == 2;
+		}
+
+		// Covers the tile at (32, 32), and touches the ones around it
+		void CoverTile(uint32 ztst, uint32 z)
+		{
+			Sprite(16, 16, 80, 80, z);
+			Update(ztst, true);
+		}
+	};
+} // namespace
+
+TEST_F(GSHiZBufferTest, GEqualRaisesCoveredTiles)
+{
+	EXPECT_TRUE(Visible(0));
+
+	CoverTile(ZTST_GEQUAL, 1000);
+
+	EXPECT_FALSE(Visible(999));
+	EXPECT_TRUE(Visible(1000));
+
+	// The tiles around it are only touched
+	Sprite(8, 8, 12, 12, 500);
+	EXPECT_EQ(hiz.Cull(vertex, index, 2, GS_SPRITE_CLASS, r, offset, ZTST_GEQUAL), 2);
+}
+
+TEST_F(GSHiZBufferTest, GEqualDoesntRaiseUncovered)
+{
+	// Covering the tile, but pixels may not be written (alpha test...)
+	CoverTile(ZTST_GEQUAL, 1000);
+	CoverTile(ZTST_GEQUAL, 2000);
+	EXPECT_FALSE(Visible(1999));
+
+	Sprite(16, 16, 80, 80, 3000);
+	Update(ZTST_GEQUAL, false);
+	EXPECT_FALSE(Visible(1999));
+	EXPECT_TRUE(Visible(2000));
+
+	// Not covering the tile
+	Sprite(36, 36, 60, 60, 3000);
+	Update(ZTST_GEQUAL, true);
+	EXPECT_TRUE(Visible(2000));
+
+	// Never lowers it
+	CoverTile(ZTST_GEQUAL, 100);
+	EXPECT_FALSE(Visible(1999));
+}
+
+TEST_F(GSHiZBufferTest, AlwaysLowers)
+{
+	CoverTile(ZTST_GEQUAL, 1000);
+	EXPECT_FALSE(Visible(500));
+
+	// Not covering the tile, it may still have pixels at 1000
+	Sprite(36, 36, 60, 60, 100);
+	Update(ZTST_ALWAYS, false);
+	EXPECT_FALSE(Visible(99));
+	EXPECT_TRUE(Visible(100));
+
+	// Covering it, down or up to the depth of the sprite
+	CoverTile(ZTST_ALWAYS, 2000);
+	EXPECT_FALSE(Visible(1999));
+
+	CoverTile(ZTST_ALWAYS, 10);
+	EXPECT_TRUE(Visible(10));
+	EXPECT_FALSE(Visible(9));
+}
+
+TEST_F(GSHiZBufferTest, InvalidateOverlappingPages)
+{
+	CoverTile(ZTST_GEQUAL, 1000);
+
+	uint32 page = GSLocalMemory::m_psm[PSM_PSMZ32].bn(32, 32, 0, BW) >> 5;
+	uint32 other[] = {page + 1, GSOffset::EOP};
+	uint32 pages[] = {page, GSOffset::EOP};
+
+	EXPECT_FALSE(hiz.Overlaps(other));
+	hiz.Invalidate(other);
+	EXPECT_FALSE(Visible(999));
+
+	EXPECT_TRUE(hiz.Overlaps(pages));
+	hiz.Invalidate(pages);
+	EXPECT_TRUE(Visible(0));
+	EXPECT_FALSE(hiz.Overlaps(pages));
+}
+
+TEST_F(GSHiZBufferTest, ClampToFormat)
+{
+	// The bound of a depth above the maximum of the format is the maximum, the GS drops the
+	// upper bits of the depth it writes
+	hiz.Bind(0, BW, PSM_PSMZ24);
+	CoverTile(ZTST_GEQUAL, 0x1000010);
+	EXPECT_TRUE(Visible(0xffffff));
+	EXPECT_FALSE(Visible(0xfffffe));
+
+	hiz.Bind(0, BW, PSM_PSMZ16);
+	CoverTile(ZTST_GEQUAL, 0x10010);
+	EXPECT_TRUE(Visible(0xffff));
+	EXPECT_FALSE(Visible(0xfffe));
+}
+
+TEST_F(GSHiZBufferTest, BindForgets)
+{
+	CoverTile(ZTST_GEQUAL, 1000);
+	EXPECT_FALSE(Visible(999));
+
+	hiz.Bind(0x100, BW, PSM_PSMZ32);
+	EXPECT_TRUE(Visible(0));
+}
@@ -0,0 +1,271 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2021 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+#include "GSKernels.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace
+{
+	// GSVertex
+	struct alignas(32) Vertex
+	{
+		float S, T;
+		uint8 R, G, B, A;
+		float Q;
+		uint16 X, Y;
+		uint32 Z;
+		uint16 U, V;
+		uint32 FOG;
+	};
+
+	static_assert(sizeof(Vertex) == 32, "Vertex should match GSVertex");
+
+	class GSKernelsTest : public ::testing::TestWithParam<GSKernelISA>
+	{
+	protected:
+		std::mt19937 rng{1234};
+
+		const GSKernelTable& ref = GSKernels::Get(GSKernelISA_SSE2);
+		const GSKernelTable& k = GSKernels::Get(GetParam());
+
+		void SetUp() override
+		{
+			if (!GSKernels::Init(GetParam()))
+				GTEST_SKIP() << "The cpu doesn't support these kernels";
+
+			ASSERT_STREQ(g_kernels.name, k.name);
+		}
+
+		void Random(void* dst, size_t size)
+		{
+			for (size_t i = 0; i < size; i++)
+				static_cast<uint8*>(dst)[i] = static_cast<uint8>(rng());
+		}
+
+		float RandomFloat(float min, float max)
+		{
+			return std::uniform_real_distribution<float>(min, max)(rng);
+		}
+
+		void RandomVertices(Vertex* v, int count)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				Random(&v[i], sizeof(v[i]));
+				v[i].S = RandomFloat(-1024.0f, 1024.0f);
+				v[i].T = RandomFloat(-1024.0f, 1024.0f);
+				v[i].Q = RandomFloat(0.001f, 4.0f);
+				v[i].FOG &= 0x7fffffff; // Signed with SSE2
+			}
+		}
+	};
+
+	bool Equal(const __m128i& a, const __m128i& b)
+	{
+		return memcmp(&a, &b, sizeof(a)) == 0;
+	}
+
+	bool Equal(const __m128& a, const __m128& b)
+	{
+		return memcmp(&a, &b, sizeof(a)) == 0;
+	}
+
+	// rcp is only specified to 12 bits, the cpu may give different results for its SSE and AVX encodings
+	void ExpectNear(const __m128& a, const __m128& b)
+	{
+		alignas(16) float fa[4], fb[4];
+		_mm_store_ps(fa, a);
+		_mm_store_ps(fb, b);
+		for (int i = 0; i < 4; i++)
+			EXPECT_FLOAT_EQ(fa[i], fb[i]) << "lane " << i;
+	}
+
+	std::string ISAName(const ::testing::TestParamInfo<GSKernelISA>& info)
+	{
+		static const char* const names[GSKernelISA_Count] = {"SSE2", "SSE41", "AVX", "AVX2"};
+		return names[info.param];
+	}
+} // namespace
+
+TEST_P(GSKernelsTest, FindMinMax)
+{
+	const int count = 3 * 256;
+	Vertex vertex[count];
+	uint32 index[count];
+	RandomVertices(vertex, count);
+	for (uint32& i : index)
+		i = rng() % count;
+
+	for (int accurate_stq = 0; accurate_stq < 2; accurate_stq++)
+	for (int color = 0; color < 2; color++)
+	for (int fst = 0; fst < 2; fst++)
+	for (int tme = 0; tme < 2; tme++)
+	for (int iip = 0; iip < 2; iip++)
+	for (int primclass = 0; primclass < 4; primclass++)
+	{
+		SCOPED_TRACE(testing::Message() << "primclass " << primclass << " iip " << iip << " tme " << tme
+			<< " fst " << fst << " color " << color << " accurate_stq " << accurate_stq);
+
+		GSVertexTraceMinMax a, b;
+		ref.FindMinMax[accurate_stq][color][fst][tme][iip][primclass](vertex, index, count, a);
+		k.FindMinMax[accurate_stq][color][fst][tme][iip][primclass](vertex, index, count, b);
+
+		EXPECT_TRUE(Equal(a.pmin, b.pmin));
+		EXPECT_TRUE(Equal(a.pmax, b.pmax));
+		if (color)
+		{
+			EXPECT_TRUE(Equal(a.cmin, b.cmin));
+			EXPECT_TRUE(Equal(a.cmax, b.cmax));
+		}
+		if (tme)
+		{
+			if (fst || accurate_stq)
+			{
+				EXPECT_TRUE(Equal(a.tmin, b.tmin));
+				EXPECT_TRUE(Equal(a.tmax, b.tmax));
+			}
+			else
+			{
+				ExpectNear(a.tmin, b.tmin);
+				ExpectNear(a.tmax, b.tmax);
+			}
+		}
+	}
+}
+
+TEST_P(GSKernelsTest, ReadBlock)
+{
+	alignas(32) uint8 src[256];
+	alignas(32) uint32 a[16 * 32], b[16 * 32];
+	alignas(32) uint32 pal[256];
+	alignas(32) uint64 pal64[256];
+
+	for (int i = 0; i < 16; i++)
+	{
+		Random(src, sizeof(src));
+		Random(pal, sizeof(pal));
+		Random(pal64, sizeof(pal64));
+
+		uint64 TEXA;
+		Random(&TEXA, sizeof(TEXA));
+
+		memset(a, 0, sizeof(a));
+		memset(b, 0, sizeof(b));
+		ref.ReadBlock32(src, (uint8*)a, 8 * 4);
+		k.ReadBlock32(src, (uint8*)b, 8 * 4);
+		EXPECT_EQ(memcmp(a, b, sizeof(a)), 0) << "ReadBlock32";
+
+		for (int aem = 0; aem < 2; aem++)
+		{
+			memset(a, 0, sizeof(a));
+			memset(b, 0, sizeof(b));
+			ref.ReadAndExpandBlock24[aem](src, (uint8*)a, 8 * 4, TEXA);
+			k.ReadAndExpandBlock24[aem](src, (uint8*)b, 8 * 4, TEXA);
+			EXPECT_EQ(memcmp(a, b, sizeof(a)), 0) << "ReadAndExpandBlock24 AEM " << aem;
+
+			memset(a, 0, sizeof(a));
+			memset(b, 0, sizeof(b));
+			ref.ReadAndExpandBlock16[aem](src, (uint8*)a, 16 * 4, TEXA);
+			k.ReadAndExpandBlock16[aem](src, (uint8*)b, 16 * 4, TEXA);
+			EXPECT_EQ(memcmp(a, b, sizeof(a)), 0) << "ReadAndExpandBlock16 AEM " << aem;
+		}
+
+		memset(a, 0, sizeof(a));
+		memset(b, 0, sizeof(b));
+		ref.ReadAndExpandBlock8_32(src, (uint8*)a, 16 * 4, pal);
+		k.ReadAndExpandBlock8_32(src, (uint8*)b, 16 * 4, pal);
+		EXPECT_EQ(memcmp(a, b, sizeof(a)), 0) << "ReadAndExpandBlock8_32";
+
+		memset(a, 0, sizeof(a));
+		memset(b, 0, sizeof(b));
+		ref.ReadAndExpandBlock4_32(src, (uint8*)a, 32 * 4, pal64);
+		k.ReadAndExpandBlock4_32(src, (uint8*)b, 32 * 4, pal64);
+		EXPECT_EQ(memcmp(a, b, sizeof(a)), 0) << "ReadAndExpandBlock4_32";
+
+		memset(a, 0, sizeof(a));
+		memset(b, 0, sizeof(b));
+		ref.ReadAndExpandBlock8H_32(src, (uint8*)a, 8 * 4, pal);
+		k.ReadAndExpandBlock8H_32(src, (uint8*)b, 8 * 4, pal);
+		EXPECT_EQ(memcmp(a, b, sizeof(a)), 0) << "ReadAndExpandBlock8H_32";
+
+		memset(a, 0, sizeof(a));
+		memset(b, 0, sizeof(b));
+		ref.ReadAndExpandBlock4HL_32(src, (uint8*)a, 8 * 4, pal);
+		k.ReadAndExpandBlock4HL_32(src, (uint8*)b, 8 * 4, pal);
+		EXPECT_EQ(memcmp(a, b, sizeof(a)), 0) << "ReadAndExpandBlock4HL_32";
+
+		memset(a, 0, sizeof(a));
+		memset(b, 0, sizeof(b));
+		ref.ReadAndExpandBlock4HH_32(src, (uint8*)a, 8 * 4, pal);
+		k.ReadAndExpandBlock4HH_32(src, (uint8*)b, 8 * 4, pal);
+		EXPECT_EQ(memcmp(a, b, sizeof(a)), 0) << "ReadAndExpandBlock4HH_32";
+	}
+}
+
+TEST_P(GSKernelsTest, WriteBlock)
+{
+	// An image with a pitch of 64 bytes, read from src + 1 by the kernels not expecting it aligned
+	alignas(32) uint8 src[64 * 16 + 32];
+	alignas(32) uint8 init[256], a[256], b[256];
+
+	const int offset[3] = {1, 0, 0};
+
+	using WriteBlock = void (*)(uint8* dst, const uint8* src, int srcpitch);
+	using UnpackAndWriteBlock = void (*)(const uint8* src, int srcpitch, uint8* dst);
+
+	auto write = [&](WriteBlock r, WriteBlock w, int i, const char* name)
+	{
+		memset(a, 0, sizeof(a));
+		memset(b, 0, sizeof(b));
+		r(a, src + offset[i], 64);
+		w(b, src + offset[i], 64);
+		EXPECT_EQ(memcmp(a, b, sizeof(a)), 0) << name << " alignment " << i * 16;
+	};
+
+	// Merged into what the block has already
+	auto unpack = [&](UnpackAndWriteBlock r, UnpackAndWriteBlock w, const char* name)
+	{
+		memcpy(a, init, sizeof(a));
+		memcpy(b, init, sizeof(b));
+		r(src, 64, a);
+		w(src, 64, b);
+		EXPECT_EQ(memcmp(a, b, sizeof(a)), 0) << name;
+	};
+
+	for (int n = 0; n < 16; n++)
+	{
+		Random(src, sizeof(src));
+		Random(init, sizeof(init));
+
+		for (int i = 0; i < 3; i++)
+		{
+			write(ref.WriteBlock32[i], k.WriteBlock32[i], i, "WriteBlock32");
+			write(ref.WriteBlock16[i], k.WriteBlock16[i], i, "WriteBlock16");
+			write(ref.WriteBlock8[i], k.WriteBlock8[i], i, "WriteBlock8");
+			write(ref.WriteBlock4[i], k.WriteBlock4[i], i, "WriteBlock4");
+		}
+
+		unpack(ref.UnpackAndWriteBlock24, k.UnpackAndWriteBlock24, "UnpackAndWriteBlock24");
+		unpack(ref.UnpackAndWriteBlock8H, k.UnpackAndWriteBlock8H, "UnpackAndWriteBlock8H");
+		unpack(ref.UnpackAndWriteBlock4HL, k.UnpackAndWriteBlock4HL, "UnpackAndWriteBlock4HL");
+		unpack(ref.UnpackAndWriteBlock4HH, k.UnpackAndWriteBlock4HH, "UnpackAndWriteBlock4HH");
+	}
+}
+
+INSTANTIATE_TEST_SUITE_P(GSKernels, GSKernelsTest,
+	::testing::Values(GSKernelISA_SSE2, GSKernelISA_SSE41, GSKernelISA_AVX, GSKernelISA_AVX2),
+	ISAName);
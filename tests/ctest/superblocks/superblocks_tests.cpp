@@ -0,0 +1,288 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2021 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <x86emitter.h>
+#include "Utilities/General.h"
+#include "iR5900Superblock.h"
+#include <cstddef>
+#include <vector>
+
+using namespace x86Emitter;
+
+namespace
+{
+	// The EE recompiler can't be linked without the rest of the core, so this compiles a
+	// tiny MIPS-like ISA with the same protocol: the compile loop of recRecompile(), and
+	// branch recs shaped like recBEQ_process() and recBNE_process() which emit their taken
+	// side first and end with SetBranchImm(pc) for the fall-through path.
+	enum ToyOp
+	{
+		ADDI, // r[rt] += imm
+		BEQ,
+		BNE,
+	};
+
+	struct ToyInst
+	{
+		ToyOp op;
+		u8 rs, rt;
+		s32 imm; // branches: in instructions, from the delay slot
+	};
+
+	struct ToyRegs
+	{
+		u32 pc;
+		u32 r[4];
+	};
+
+	const u32 ToyBase = 0x00100000;
+
+	// rdx holds the address of the ToyRegs while the compiled code runs.
+	xIndirect32 ToyPc() { return ptr32[rdx + (sptr)offsetof(ToyRegs, pc)]; }
+	xIndirect32 ToyReg(int n) { return ptr32[rdx + (sptr)(offsetof(ToyRegs, r) + n * 4)]; }
+
+	class ToyRec
+	{
+		const std::vector<ToyInst>& prog;
+		int branch;
+		u32 endBlock;
+
+		const ToyInst& Fetch(u32 at) const { return prog[(at - ToyBase) / 4]; }
+
+	public:
+		SuperblockCompile trace;
+		u32 pc;
+
+		ToyRec(const std::vector<ToyInst>& prog_)
+			: prog(prog_)
+			, branch(0)
+			, endBlock(0)
+			, pc(0)
+		{
+		}
+
+		void SetBranchImm(u32 imm)
+		{
+			if (trace.Continue(imm, pc, branch, endBlock))
+				return;
+
+			branch = 1;
+			xMOV(ToyPc(), imm);
+			xRET();
+		}
+
+		void CompileNext()
+		{
+			const ToyInst& inst = Fetch(pc);
+			pc += 4;
+
+			if (inst.op == ADDI)
+			{
+				xADD(ToyReg(inst.rt), inst.imm);
+				return;
+			}
+
+			const u32 branchTo = pc + inst.imm * 4;
+
+			xMOV(eax, ToyReg(inst.rs));
+			xCMP(eax, ToyReg(inst.rt));
+			xForwardJump32 fallthrough(inst.op == BEQ ? Jcc_NotEqual : Jcc_Equal);
+
+			CompileNext(); // delay slot
+			SetBranchImm(branchTo);
+
+			fallthrough.SetTarget();
+
+			// recopy the next inst
+			pc -= 4;
+			CompileNext();
+			SetBranchImm(pc);
+		}
+
+		// Scans like recRecompile(): a branch ends the block unless the superblock follows
+		// it, fallthroughRuns/targetRuns standing in for the execution counters.
+		void Compile(u32 startpc, bool superblock, u32 fallthroughRuns, u32 targetRuns)
+		{
+			if (superblock)
+				trace.Begin(startpc);
+
+			endBlock = ToyBase + (u32)prog.size() * 4;
+			for (u32 i = startpc; i < endBlock; i += 4)
+			{
+				const ToyInst& inst = Fetch(i);
+				if (inst.op == ADDI)
+					continue;
+
+				const u32 target = i + 4 + inst.imm * 4;
+				if (trace.Follow(i, target, fallthroughRuns, targetRuns))
+				{
+					i += 4;
+					continue;
+				}
+
+				endBlock = i + 8;
+				break;
+			}
+
+			pc = startpc;
+			branch = 0;
+			xMOV(rdx, arg1reg);
+			while (!branch && pc < endBlock)
+				CompileNext();
+			if (!branch)
+				SetBranchImm(pc);
+		}
+	};
+
+	// r1 gets a different bit from every instruction, so which of them ran is visible.
+	//
+	//   0: addi r1, 1
+	//   1: beq  r0, r2, 8   -> 10
+	//   2: addi r1, 2
+	//   3: addi r1, 4
+	//   4: bne  r0, r3, 7   -> 12
+	//   5: addi r1, 8
+	//   6: addi r1, 16
+	//   7: addi r1, 32
+	std::vector<ToyInst> ToyProgram()
+	{
+		return {
+			{ADDI, 0, 1, 1},
+			{BEQ, 0, 2, 8},
+			{ADDI, 0, 1, 2},
+			{ADDI, 0, 1, 4},
+			{BNE, 0, 3, 7},
+			{ADDI, 0, 1, 8},
+			{ADDI, 0, 1, 16},
+			{ADDI, 0, 1, 32},
+		};
+	}
+
+	class SuperblockTests : public ::testing::Test
+	{
+	protected:
+		u8* code;
+		ToyRegs regs;
+
+		void SetUp() override
+		{
+			code = (u8*)HostSys::Mmap(0, __pagesize);
+			ASSERT_NE(code, nullptr);
+			memset(code, 0xcc, __pagesize);
+			xSetPtr(code);
+		}
+
+		void TearDown() override
+		{
+			HostSys::Munmap(code, __pagesize);
+		}
+
+		void Run(u32 r0, u32 r2, u32 r3)
+		{
+			regs = {};
+			regs.r[0] = r0;
+			regs.r[2] = r2;
+			regs.r[3] = r3;
+
+			((void(__fastcall*)(ToyRegs*))code)(&regs);
+		}
+	};
+} // namespace
+
+// Both followed branches are compiled inline: the block goes on to the end of the program
+// and every path through it runs the right instructions and leaves at the right pc.
+TEST_F(SuperblockTests, FollowedBranches)
+{
+	const std::vector<ToyInst> prog = ToyProgram();
+	ToyRec rec(prog);
+	rec.Compile(ToyBase, true, 10, 1);
+
+	ASSERT_EQ(rec.trace.GetBranches(), 2u);
+	ASSERT_EQ(rec.pc, ToyBase + 8 * 4) << "the block stopped at a followed branch";
+
+	// beq taken
+	Run(5, 5, 0);
+	EXPECT_EQ(regs.pc, ToyBase + 10 * 4);
+	EXPECT_EQ(regs.r[1], 1u | 2);
+
+	// beq not taken, bne taken
+	Run(5, 0, 0);
+	EXPECT_EQ(regs.pc, ToyBase + 12 * 4);
+	EXPECT_EQ(regs.r[1], 1u | 2 | 4 | 8);
+
+	// neither taken
+	Run(5, 0, 5);
+	EXPECT_EQ(regs.pc, ToyBase + 8 * 4);
+	EXPECT_EQ(regs.r[1], 1u | 2 | 4 | 8 | 16 | 32);
+}
+
+// Without the bias (or outside of a superblock) the first branch ends the block as usual.
+TEST_F(SuperblockTests, UnbiasedBranch)
+{
+	const std::vector<ToyInst> prog = ToyProgram();
+	ToyRec rec(prog);
+	rec.Compile(ToyBase, true, 10, 5);
+
+	EXPECT_EQ(rec.trace.GetBranches(), 0u);
+	EXPECT_EQ(rec.pc, ToyBase + 3 * 4);
+
+	Run(5, 0, 0);
+	EXPECT_EQ(regs.pc, ToyBase + 3 * 4);
+	EXPECT_EQ(regs.r[1], 1u | 2);
+}
+
+TEST(SuperblockCompileTests, Follow)
+{
+	SuperblockCompile trace;
+	EXPECT_FALSE(trace.Follow(ToyBase, ToyBase + 0x100, 10, 1)) << "not compiling a superblock";
+
+	trace.Begin(ToyBase);
+	EXPECT_FALSE(trace.Follow(ToyBase, ToyBase + 0x100, 0, 0)) << "the fall-through never ran";
+	EXPECT_FALSE(trace.Follow(ToyBase, ToyBase + 8, 10, 1)) << "the target is the fall-through";
+	EXPECT_FALSE(trace.Follow(ToyBase + 0xff8, ToyBase, 10, 1)) << "the fall-through is in the next page";
+
+	for (u32 i = 0; i < SuperblockCompile::MaxBranches; i++)
+		EXPECT_TRUE(trace.Follow(ToyBase + i * 16, ToyBase + 0x800, 3, 1));
+	EXPECT_FALSE(trace.Follow(ToyBase + 0x200, ToyBase + 0x800, 3, 1)) << "too many branches";
+}
+
+TEST(SuperblockCompileTests, Continue)
+{
+	SuperblockCompile trace;
+	trace.Begin(ToyBase);
+	ASSERT_TRUE(trace.Follow(ToyBase + 4, ToyBase + 0x100, 10, 1));
+
+	u32 pc = ToyBase + 12;
+	int branch = 1;
+	EXPECT_FALSE(trace.Continue(ToyBase + 0x100, pc, branch, ToyBase + 0x40)) << "taken side";
+	EXPECT_FALSE(trace.Continue(ToyBase + 12, pc, branch, ToyBase + 12)) << "past the block end";
+	EXPECT_EQ(branch, 1);
+
+	ASSERT_TRUE(trace.Continue(ToyBase + 12, pc, branch, ToyBase + 0x40));
+	EXPECT_EQ(pc, ToyBase + 12);
+	EXPECT_EQ(branch, 0) << "the compile loop must go on";
+
+	// Likely branches: pc still at the delay slot
+	pc = ToyBase + 8;
+	branch = 1;
+	EXPECT_FALSE(trace.Continue(ToyBase + 12, pc, branch, ToyBase + 0x40)) << "only continued once";
+
+	trace.Begin(ToyBase);
+	ASSERT_TRUE(trace.Follow(ToyBase + 4, ToyBase + 0x100, 10, 1));
+	ASSERT_TRUE(trace.Continue(pc + 4, pc, branch, ToyBase + 0x40));
+	EXPECT_EQ(pc, ToyBase + 12);
+	EXPECT_EQ(branch, 0);
+}